@@ -0,0 +1,285 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "GameLog.h"
+
+// 힙 할당 없이 만들 수 있는 GameLog 표현.
+// server / type / code는 종류가 많지 않으므로 GameLogSymbolTable에서 받은 id로, paramStr는 짧으면 레코드 안에, 길면 GameLogArena에 둔다.
+// 레코드 하나가 캐시 라인 하나(64바이트)이며 memcpy로 복사할 수 있다.
+
+using GameLogSymbolId = uint32_t;
+constexpr GameLogSymbolId INVALID_GAMELOG_SYMBOL = 0xFFFFFFFF;
+
+// 문자열 -> id 저장소. LogTypeRegistry와 같이 조회는 atomic load만으로 락 없이, 등록은 mutex 안에서 한다.
+// 한 번 등록된 문자열은 지워지지 않으며 Name()이 돌려준 view는 테이블이 살아있는 동안 유효하다.
+class GameLogSymbolTable {
+public:
+    static constexpr size_t MAX_SYMBOLS = 4096;
+
+    GameLogSymbolTable(void)
+    {
+        for (auto& slot : slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+        for (auto& entry : entries)
+            entry.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~GameLogSymbolTable(void)
+    {
+        for (auto& entry : entries)
+            delete entry.load(std::memory_order_relaxed);
+    }
+
+    GameLogSymbolTable(const GameLogSymbolTable&) = delete;
+    GameLogSymbolTable& operator=(const GameLogSymbolTable&) = delete;
+
+    // 등록되지 않은 문자열이면 INVALID_GAMELOG_SYMBOL
+    GameLogSymbolId Find(std::string_view name) const
+    {
+        const uint64_t hash = Hash(name);
+        for (size_t probe = 0; probe < SLOT_COUNT; ++probe) {
+            const Entry* entry = slots[(hash + probe) & (SLOT_COUNT - 1)].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                return INVALID_GAMELOG_SYMBOL;
+            }
+            if (entry->hash == hash && entry->name == name) {
+                return entry->id;
+            }
+        }
+        return INVALID_GAMELOG_SYMBOL;
+    }
+
+    // 이미 있다면 기존 id, 없다면 새로 등록한 id. 테이블이 가득 찼다면 INVALID_GAMELOG_SYMBOL
+    GameLogSymbolId Intern(std::string_view name)
+    {
+        GameLogSymbolId id = Find(name);
+        if (id != INVALID_GAMELOG_SYMBOL) {
+            return id;
+        }
+
+        std::lock_guard<std::mutex> guard(registerLock);
+
+        // lock을 잡기 전에 다른 스레드가 등록했을 수 있으므로 다시 찾는다.
+        const uint64_t hash = Hash(name);
+        size_t index = 0;
+        for (size_t probe = 0; probe < SLOT_COUNT; ++probe) {
+            index = (hash + probe) & (SLOT_COUNT - 1);
+            const Entry* entry = slots[index].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                break;
+            }
+            if (entry->hash == hash && entry->name == name) {
+                return entry->id;
+            }
+        }
+
+        if (symbolCount >= MAX_SYMBOLS) {
+            return INVALID_GAMELOG_SYMBOL;
+        }
+
+        id = static_cast<GameLogSymbolId>(symbolCount);
+        Entry* entry = new Entry{ hash, std::string(name), id };
+
+        // id -> 이름을 먼저 공개해야 Find로 id를 얻은 스레드가 바로 Name을 호출해도 빈 문자열을 보지 않는다.
+        entries[id].store(entry, std::memory_order_release);
+        slots[index].store(entry, std::memory_order_release);
+
+        symbolCount++;
+        return id;
+    }
+
+    // 등록되지 않은 id라면 빈 문자열
+    std::string_view Name(GameLogSymbolId id) const
+    {
+        if (id >= MAX_SYMBOLS) {
+            return {};
+        }
+        const Entry* entry = entries[id].load(std::memory_order_acquire);
+        return entry != nullptr ? std::string_view(entry->name) : std::string_view();
+    }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string name;
+        GameLogSymbolId id;
+    };
+
+    // 적재율을 0.5 이하로 유지
+    static constexpr size_t SLOT_COUNT = MAX_SYMBOLS * 2;
+
+    // FNV-1a
+    static uint64_t Hash(std::string_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char ch : name) {
+            hash ^= static_cast<uint8_t>(ch);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::atomic<const Entry*> slots[SLOT_COUNT];
+    std::atomic<const Entry*> entries[MAX_SYMBOLS];     // id -> Entry (소유)
+
+    std::mutex registerLock;
+    size_t symbolCount = 0;                     // registerLock으로 보호
+};
+
+// 긴 paramStr를 담는 bump allocator. 스레드 하나가 소유하며 Reset 전까지 돌려준 메모리는 옮겨지지 않는다.
+// 레코드를 다 쓴 뒤(배치를 DB에 넘긴 뒤 등) Reset으로 한꺼번에 비운다.
+class GameLogArena {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    GameLogArena(void) = default;
+    GameLogArena(const GameLogArena&) = delete;
+    GameLogArena& operator=(const GameLogArena&) = delete;
+
+    char* Allocate(size_t size)
+    {
+        if (size > remaining) {
+            NewChunk(size);
+        }
+
+        char* out = cursor;
+        cursor += size;
+        remaining -= size;
+        used += size;
+        return out;
+    }
+
+    // 첫 청크만 남기고 비운다.
+    void Reset(void)
+    {
+        if (chunks.size() > 1) {
+            chunks.resize(1);
+            chunkSizes.resize(1);
+        }
+        cursor = chunks.empty() ? nullptr : chunks[0].get();
+        remaining = chunks.empty() ? 0 : chunkSizes[0];
+        used = 0;
+    }
+
+    // 마지막 Reset 이후 Allocate로 나간 바이트
+    size_t BytesUsed(void) const { return used; }
+
+private:
+    void NewChunk(size_t minimum)
+    {
+        const size_t size = minimum > CHUNK_SIZE ? minimum : CHUNK_SIZE;
+        chunks.emplace_back(new char[size]);
+        chunkSizes.push_back(size);
+        cursor = chunks.back().get();
+        remaining = size;
+    }
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<size_t> chunkSizes;
+    char* cursor = nullptr;
+    size_t remaining = 0;
+    size_t used = 0;
+};
+
+// GameLog 한 건의 고정 크기 표현. 문자열은 symbols / arena를 통해서만 다시 읽을 수 있다.
+struct CompactGameLog {
+    static constexpr size_t INLINE_PARAM_CAPACITY = 24;     // 이 길이까지의 paramStr는 레코드 안에 둔다.
+    static constexpr size_t MAX_PARAM_LENGTH = 0xFFFF;      // 넘는 부분은 잘리고 FLAG_PARAM_TRUNCATED가 붙는다.
+
+    enum Flag : uint8_t {
+        FLAG_PARAM_IN_ARENA = 0x01,     // paramStr가 arena에 있음
+        FLAG_PARAM_TRUNCATED = 0x02     // arena가 없거나 MAX_PARAM_LENGTH를 넘어서 잘림
+    };
+
+    uint64_t accountNo;
+    int32_t param1;
+    int32_t param2;
+    int32_t param3;
+    int32_t param4;
+    GameLogSymbolId server;
+    GameLogSymbolId type;
+    GameLogSymbolId code;
+    uint16_t paramLength;
+    uint8_t flags;
+    uint8_t reserved;
+    union {
+        char paramInline[INLINE_PARAM_CAPACITY];
+        const char* paramArena;
+    };
+
+    CompactGameLog(void) = default;
+
+    // server / type / code는 symbols에 등록하고, paramStr가 INLINE_PARAM_CAPACITY보다 길면 arena에 복사한다.
+    // arena가 nullptr이라면 긴 paramStr는 INLINE_PARAM_CAPACITY에서 잘린다.
+    CompactGameLog(GameLogSymbolTable& symbols, GameLogArena* arena, std::string_view server, std::string_view type, std::string_view code,
+        uint64_t accountNo, int32_t param1, int32_t param2, int32_t param3, int32_t param4, std::string_view paramStr)
+        : accountNo(accountNo), param1(param1), param2(param2), param3(param3), param4(param4),
+        server(symbols.Intern(server)), type(symbols.Intern(type)), code(symbols.Intern(code)),
+        paramLength(0), flags(0), reserved(0)
+    {
+        SetParamStr(arena, paramStr);
+    }
+
+    // 미리 Intern해둔 id를 받는다. 같은 server / type / code로 자주 남기는 곳은 id를 들고 있으면 매번 문자열을 찾는 비용이 없다.
+    CompactGameLog(GameLogArena* arena, GameLogSymbolId server, GameLogSymbolId type, GameLogSymbolId code,
+        uint64_t accountNo, int32_t param1, int32_t param2, int32_t param3, int32_t param4, std::string_view paramStr)
+        : accountNo(accountNo), param1(param1), param2(param2), param3(param3), param4(param4),
+        server(server), type(type), code(code), paramLength(0), flags(0), reserved(0)
+    {
+        SetParamStr(arena, paramStr);
+    }
+
+    CompactGameLog(GameLogSymbolTable& symbols, GameLogArena* arena, const GameLog& log)
+        : CompactGameLog(symbols, arena, log.server, log.type, log.code,
+            log.accountNo, log.param1, log.param2, log.param3, log.param4, log.paramStr) {}
+
+    std::string_view ParamStr(void) const
+    {
+        return std::string_view((flags & FLAG_PARAM_IN_ARENA) ? paramArena : paramInline, paramLength);
+    }
+
+    // 기존 GameLog로 되돌린다. (sink 등 GameLog를 받는 곳과의 호환용)
+    GameLog ToGameLog(const GameLogSymbolTable& symbols) const
+    {
+        return GameLog(std::string(symbols.Name(server)), std::string(symbols.Name(type)), std::string(symbols.Name(code)),
+            accountNo, param1, param2, param3, param4, std::string(ParamStr()));
+    }
+
+private:
+    void SetParamStr(GameLogArena* arena, std::string_view paramStr)
+    {
+        size_t length = paramStr.size();
+        if (length > MAX_PARAM_LENGTH) {
+            length = MAX_PARAM_LENGTH;
+            flags |= FLAG_PARAM_TRUNCATED;
+        }
+
+        if (length <= INLINE_PARAM_CAPACITY || arena == nullptr) {
+            if (length > INLINE_PARAM_CAPACITY) {
+                length = INLINE_PARAM_CAPACITY;
+                flags |= FLAG_PARAM_TRUNCATED;
+            }
+            std::memcpy(paramInline, paramStr.data(), length);
+        }
+        else {
+            char* copy = arena->Allocate(length);
+            std::memcpy(copy, paramStr.data(), length);
+            paramArena = copy;
+            flags |= FLAG_PARAM_IN_ARENA;
+        }
+        paramLength = static_cast<uint16_t>(length);
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<CompactGameLog>, "CompactGameLog는 memcpy로 복사할 수 있어야 한다.");
+static_assert(sizeof(CompactGameLog) == 64, "CompactGameLog는 캐시 라인 하나 크기여야 한다.");
@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+// 게임 로그 한 건. 유저의 행동과 그 결과를 DB에 남긴다.
+struct GameLog {
+    std::string server;     // 서버 이름
+    std::string type;       // 컨텐츠. 같은 code 번호라도 현재 유저가 위치한 컨텐츠에 따라 다른 행동이 될 수 있다. BATTLE, CASH_SHOP... 등등
+    std::string code;       // 행동, 예를 들어서 돈 획득 관련으로 [ 몬스터를 잡아서 돈 획득 ], [ 상점에 아이템을 팔아서 돈 획득 ], [ 유저 간 거래를 통한 돈 획득 ]
+    uint64_t accountNo = 0; // 계정 번호, 어떤 유저가 대상인지에 대해 저장.
+    int32_t param1 = 0;     // 행동에 따른 추가적인 정보들 1 ~ 4, 필요할시 더 추가하는데 보통 4개면 충분. 적게 쓰지 더 많이 쓰이면 추가
+    int32_t param2 = 0;
+    int32_t param3 = 0;
+    int32_t param4 = 0;
+    std::string paramStr;   // 특정 수치로 나타내기 힘든 것은 문자열로 표현
+    uint64_t timestamp = 0; // 기록 시각 (LogClockNow). 0이면 GameLogPipeline::Submit이 넣은 시각으로 채운다.
+
+    // 큐의 빈 칸 / 저널에서 읽어올 때 사용
+    GameLog(void) = default;
+
+    // 문자열은 값으로 받아서 옮긴다. 임시 문자열이나 std::move로 넘기면 복사 없이 버퍼를 넘겨받는다.
+    GameLog(std::string server, std::string type, std::string code,
+        uint64_t accountNo, int32_t param1, int32_t param2, int32_t param3, int32_t param4,
+        std::string paramStr)
+        : server(std::move(server)), type(std::move(type)), code(std::move(code)), accountNo(accountNo), param1(param1),
+        param2(param2), param3(param3), param4(param4), paramStr(std::move(paramStr)) {}
+};
@@ -0,0 +1,362 @@
+﻿#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "CompactGameLog.h"
+#include "GameLog.h"
+#include "GameLogStore.h"
+
+// GameLog와 CompactGameLog를 만드는 비용 비교.
+//
+//     GameLogBenchmark [records]
+//     GameLogBenchmark --verify
+//
+// 게임 코드가 로그를 남기는 모양 그대로(리터럴 / 짧은 문자열에서 레코드를 만들어 배치 버퍼에 쌓음) records개를 만들고,
+// 초당 레코드 수와 레코드 하나가 차지하는 바이트(구조체 + 힙 / arena), 레코드 하나당 힙 할당 횟수를 출력한다.
+// --verify는 GameLogStore의 검색 결과를 모든 행을 하나씩 비교한 결과와 맞춰본다. (SIMD 비교 경로 점검)
+
+namespace {
+    // 전역 operator new를 바꿔서 할당 횟수와 바이트를 센다. (측정 구간에서만 켬)
+    bool countAllocations = false;
+    uint64_t allocationCount = 0;
+    uint64_t allocationBytes = 0;
+}
+
+void* operator new(size_t size)
+{
+    if (countAllocations) {
+        allocationCount++;
+        allocationBytes += size;
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+struct SampleEvent {
+    const char* server;
+    const char* type;
+    const char* code;
+    const char* paramStr;
+};
+
+// 실제 게임 로그와 비슷한 길이의 문자열들. code와 paramStr는 대부분 SSO(보통 15자) 길이를 넘는다.
+const SampleEvent SAMPLE_EVENTS[] = {
+    { "Server1", "BATTLE", "MONSTER_KILLED_GOLD", "MonsterType: Dragon" },
+    { "Server1", "CASH_SHOP", "CASH_ITEM_PURCHASE", "Item: Premium Package (30 days)" },
+    { "Server2", "TRADE", "USER_TRADE_GOLD", "Partner: 77812" },
+    { "Server2", "SHOP", "NPC_SHOP_SELL_ITEM", "ItemId: 120044, Enchant: +7" },
+    { "Server3", "QUEST", "QUEST_REWARD_GOLD", "" },
+    { "Server3", "BATTLE", "PVP_KILL_REWARD", "Map: Arena of the Fallen Kings, Season 12" },
+};
+constexpr size_t SAMPLE_COUNT = sizeof(SAMPLE_EVENTS) / sizeof(SAMPLE_EVENTS[0]);
+
+// 배치 하나 분량을 쌓았다가 비우는 것을 반복 (파이프라인의 batcher와 같은 사용 패턴)
+constexpr size_t BATCH_SIZE = 256;
+
+struct BenchResult {
+    double seconds = 0;
+    uint64_t allocations = 0;
+    uint64_t heapBytes = 0;
+    uint64_t arenaBytes = 0;
+};
+
+BenchResult RunGameLog(size_t records)
+{
+    std::vector<GameLog> batch;
+    batch.reserve(BATCH_SIZE);
+
+    BenchResult result;
+    countAllocations = true;
+    allocationCount = allocationBytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < records; ++i) {
+        const SampleEvent& event = SAMPLE_EVENTS[i % SAMPLE_COUNT];
+        batch.emplace_back(event.server, event.type, event.code, 100000 + i,
+            static_cast<int32_t>(i), 1000, static_cast<int32_t>(i * 3), 2500, event.paramStr);
+
+        if (batch.size() == BATCH_SIZE) {
+            batch.clear();
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    countAllocations = false;
+    result.allocations = allocationCount;
+    result.heapBytes = allocationBytes;
+    return result;
+}
+
+BenchResult RunCompactGameLog(size_t records, GameLogSymbolTable& symbols)
+{
+    std::vector<CompactGameLog> batch;
+    batch.reserve(BATCH_SIZE);
+    GameLogArena arena;
+
+    BenchResult result;
+    countAllocations = true;
+    allocationCount = allocationBytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < records; ++i) {
+        const SampleEvent& event = SAMPLE_EVENTS[i % SAMPLE_COUNT];
+        batch.emplace_back(symbols, &arena, event.server, event.type, event.code, 100000 + i,
+            static_cast<int32_t>(i), 1000, static_cast<int32_t>(i * 3), 2500, event.paramStr);
+
+        if (batch.size() == BATCH_SIZE) {
+            result.arenaBytes += arena.BytesUsed();
+            batch.clear();
+            arena.Reset();
+        }
+    }
+    result.arenaBytes += arena.BytesUsed();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    countAllocations = false;
+    result.allocations = allocationCount;
+    result.heapBytes = allocationBytes;
+    return result;
+}
+
+// 호출하는 쪽이 id를 미리 받아둔 경우
+BenchResult RunCompactGameLogIds(size_t records, GameLogSymbolTable& symbols)
+{
+    GameLogSymbolId ids[SAMPLE_COUNT][3];
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        ids[i][0] = symbols.Intern(SAMPLE_EVENTS[i].server);
+        ids[i][1] = symbols.Intern(SAMPLE_EVENTS[i].type);
+        ids[i][2] = symbols.Intern(SAMPLE_EVENTS[i].code);
+    }
+
+    std::vector<CompactGameLog> batch;
+    batch.reserve(BATCH_SIZE);
+    GameLogArena arena;
+
+    BenchResult result;
+    countAllocations = true;
+    allocationCount = allocationBytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < records; ++i) {
+        const size_t sample = i % SAMPLE_COUNT;
+        batch.emplace_back(&arena, ids[sample][0], ids[sample][1], ids[sample][2], 100000 + i,
+            static_cast<int32_t>(i), 1000, static_cast<int32_t>(i * 3), 2500, SAMPLE_EVENTS[sample].paramStr);
+
+        if (batch.size() == BATCH_SIZE) {
+            result.arenaBytes += arena.BytesUsed();
+            batch.clear();
+            arena.Reset();
+        }
+    }
+    result.arenaBytes += arena.BytesUsed();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    countAllocations = false;
+    result.allocations = allocationCount;
+    result.heapBytes = allocationBytes;
+    return result;
+}
+
+void PrintResult(const char* name, size_t recordSize, size_t records, const BenchResult& result)
+{
+    const double perRecordBytes = recordSize + static_cast<double>(result.heapBytes + result.arenaBytes) / records;
+    std::printf("%-16s %10.2f M records/s   %6.1f bytes/record (struct %zu + heap %.1f + arena %.1f)   %.3f allocations/record\n",
+        name, records / result.seconds / 1e6, perRecordBytes, recordSize,
+        static_cast<double>(result.heapBytes) / records, static_cast<double>(result.arenaBytes) / records,
+        static_cast<double>(result.allocations) / records);
+}
+
+// GameLogStore 점검. 무작위 행을 넣고 무작위 조건으로 찾은 결과가 모든 행을 하나씩 비교한 결과와 같은지 본다.
+// 시각 / accountNo는 부호 비트가 켜진 값과 아래 32비트가 같은 값을 섞어서, 64비트 비교를 32비트 비교로 만든 경로(SSE2)를 건드린다.
+constexpr size_t VERIFY_ROWS = 25000;
+constexpr size_t VERIFY_QUERIES = 800;
+constexpr size_t VERIFY_SEGMENT_ROWS = 4000;    // 세그먼트 여러 개 + 아직 기록하지 않은 로그
+
+const uint64_t VERIFY_ACCOUNTS[] = {
+    5, 6, 0x100000005ull, 0x200000006ull, 0x8000000000000005ull, 0xFFFFFFFF00000005ull, 0xFFFFFFFFFFFFFFFFull, 77812,
+};
+const char* const VERIFY_TYPES[] = { "BATTLE", "TRADE", "SHOP", "QUEST" };
+const char* const VERIFY_CODES[] = { "MONSTER_KILLED_GOLD", "USER_TRADE_GOLD", "NPC_SHOP_SELL_ITEM", "QUEST_REWARD_GOLD", "PVP_KILL_REWARD" };
+
+template <typename T, size_t N>
+const T& Pick(const T (&values)[N], std::mt19937_64& random)
+{
+    return values[random() % N];
+}
+
+// 시각은 몇 개의 좁은 구간에 몰리게 해서 경계 값과 같은 시각이 자주 나오게 한다.
+uint64_t RandomTime(std::mt19937_64& random)
+{
+    const uint64_t bases[] = { 0, 0x00000000FFFFFF00ull, 0x7FFFFFFFFFFFFF00ull, 0x8000000000000000ull, 0xFFFFFFFFFFFFFF00ull };
+    return Pick(bases, random) + random() % 0x100;
+}
+
+bool SameRow(const GameLogStoreRow& lhs, const GameLogStoreRow& rhs)
+{
+    return lhs.timestamp == rhs.timestamp && lhs.log.server == rhs.log.server && lhs.log.type == rhs.log.type
+        && lhs.log.code == rhs.log.code && lhs.log.accountNo == rhs.log.accountNo && lhs.log.param1 == rhs.log.param1
+        && lhs.log.param2 == rhs.log.param2 && lhs.log.param3 == rhs.log.param3 && lhs.log.param4 == rhs.log.param4
+        && lhs.log.paramStr == rhs.log.paramStr;
+}
+
+bool MatchesQuery(const GameLogQuery& query, const GameLogStoreRow& row)
+{
+    return row.timestamp >= query.timeFrom && row.timestamp <= query.timeTo
+        && (!query.matchAccount || row.log.accountNo == query.accountNo)
+        && (query.type.empty() || row.log.type == query.type)
+        && (query.code.empty() || row.log.code == query.code);
+}
+
+int RunStoreVerify(void)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "GameLogBenchmarkVerify";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    std::mt19937_64 random(20240611);
+    std::vector<GameLogStoreRow> all;
+    all.reserve(VERIFY_ROWS);
+
+    int failures = 0;
+    {
+        GameLogStore store(directory.wstring(), VERIFY_SEGMENT_ROWS);
+        for (size_t i = 0; i < VERIFY_ROWS; ++i) {
+            GameLogStoreRow& row = all.emplace_back();
+            row.timestamp = RandomTime(random);
+            row.log = GameLog(i % 2 ? "Server1" : "Server2", Pick(VERIFY_TYPES, random), Pick(VERIFY_CODES, random),
+                Pick(VERIFY_ACCOUNTS, random), static_cast<int32_t>(i), static_cast<int32_t>(random()), -1, 2500,
+                i % 3 ? "" : "ItemId: " + std::to_string(i));
+            store.Append(row.log, row.timestamp);
+        }
+
+        std::vector<GameLogStoreRow> expected;
+        std::vector<GameLogStoreRow> found;
+        for (size_t q = 0; q < VERIFY_QUERIES; ++q) {
+            GameLogQuery query;
+            query.matchAccount = random() % 2 == 0;
+            query.accountNo = random() % 8 == 0 ? 0x300000005ull : Pick(VERIFY_ACCOUNTS, random);
+            switch (random() % 4) {
+            case 0:     // 전체
+                break;
+            case 1:     // 있는 시각을 양 끝으로
+                query.timeFrom = all[random() % all.size()].timestamp;
+                query.timeTo = all[random() % all.size()].timestamp;
+                break;
+            default:
+                query.timeFrom = RandomTime(random);
+                query.timeTo = random() % 4 == 0 ? query.timeFrom : RandomTime(random);
+                break;
+            }
+            if (random() % 2 == 0)
+                query.type = random() % 8 == 0 ? "GUILD" : Pick(VERIFY_TYPES, random);
+            if (random() % 2 == 0)
+                query.code = random() % 8 == 0 ? "GUILD_DONATE_GOLD" : Pick(VERIFY_CODES, random);
+            query.limit = random() % 4 == 0 ? random() % 50 : 0;
+
+            expected.clear();
+            for (const GameLogStoreRow& row : all) {
+                if (query.limit != 0 && expected.size() >= query.limit)
+                    break;
+                if (MatchesQuery(query, row))
+                    expected.push_back(row);
+            }
+
+            found.clear();
+            store.Query(query, found);
+
+            bool same = found.size() == expected.size();
+            for (size_t i = 0; same && i < found.size(); ++i)
+                same = SameRow(found[i], expected[i]);
+            if (!same) {
+                if (failures++ < 10) {
+                    std::printf("query %zu mismatch: account %d/%llx time %llx..%llx type '%s' code '%s' limit %zu -> %zu rows, expected %zu\n",
+                        q, query.matchAccount, static_cast<unsigned long long>(query.accountNo),
+                        static_cast<unsigned long long>(query.timeFrom), static_cast<unsigned long long>(query.timeTo),
+                        query.type.c_str(), query.code.c_str(), query.limit, found.size(), expected.size());
+                }
+            }
+        }
+
+        std::printf("store verify (%zu rows, %zu segments, %zu queries): %d mismatches -> %s\n",
+            VERIFY_ROWS, store.SegmentCount(), VERIFY_QUERIES, failures, failures == 0 ? "OK" : "FAILED");
+    }
+
+    std::filesystem::remove_all(directory, error);
+    return failures == 0 ? 0 : 1;
+}
+
+int Usage(void)
+{
+    std::fprintf(stderr, "usage: GameLogBenchmark [records] | --verify\n");
+    return 2;
+}
+
+// 1 이상의 10진수만 받는다. (strtoull은 "-1"이나 "abc"도 받아버리므로 직접 확인)
+bool ParseRecords(const char* text, size_t& records)
+{
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value == 0) {
+        return false;
+    }
+    records = static_cast<size_t>(value);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::strcmp(argv[1], "--verify") == 0) {
+        return RunStoreVerify();
+    }
+
+    size_t records = 5000000;
+    if (argc > 2 || (argc == 2 && !ParseRecords(argv[1], records))) {
+        return Usage();
+    }
+
+    GameLogSymbolTable symbols;
+
+    // 변환이 손실 없이 되돌아오는지 확인
+    GameLogArena arena;
+    for (const SampleEvent& event : SAMPLE_EVENTS) {
+        GameLog original(event.server, event.type, event.code, 42, 1, 2, 3, 4, event.paramStr);
+        GameLog restored = CompactGameLog(symbols, &arena, original).ToGameLog(symbols);
+        if (restored.server != original.server || restored.type != original.type || restored.code != original.code
+            || restored.paramStr != original.paramStr || restored.accountNo != original.accountNo || restored.param4 != original.param4) {
+            std::printf("round trip mismatch: %s\n", event.code);
+            return 1;
+        }
+    }
+
+    // 한 번씩 돌려서 캐시 / 심볼 테이블을 데운다.
+    RunGameLog(BATCH_SIZE * 4);
+    RunCompactGameLog(BATCH_SIZE * 4, symbols);
+
+    const BenchResult before = RunGameLog(records);
+    const BenchResult after = RunCompactGameLog(records, symbols);
+    const BenchResult afterIds = RunCompactGameLogIds(records, symbols);
+
+    std::printf("%zu records, batch %zu\n", records, BATCH_SIZE);
+    PrintResult("GameLog", sizeof(GameLog), records, before);
+    PrintResult("CompactGameLog", sizeof(CompactGameLog), records, after);
+    PrintResult("  (symbol ids)", sizeof(CompactGameLog), records, afterIds);
+    std::printf("speedup x%.2f (x%.2f with ids), size x%.2f smaller\n", before.seconds / after.seconds, before.seconds / afterIds.seconds,
+        (sizeof(GameLog) + static_cast<double>(before.heapBytes) / records)
+        / (sizeof(CompactGameLog) + static_cast<double>(after.heapBytes + after.arenaBytes) / records));
+    return 0;
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <iostream>
+#include <memory>
+
+#include "GameLog.h"
+#include "GameLogPipeline.h"
+
+class GameLogManager {
+public:
+    /*
+        Code : 몬스터 잡아서 돈 획득 / Param1 : 잡은 몬스터 / Param2: 1000원 획득 /  Param3: 총 231000원 보유
+
+	    예시와 같이 어떤 행위를 통해서 무엇을 하였고, 무엇을 얻었고, 어떻게 되었는지를 아주아주 상세히 기록하여
+	    로그만 보더라도 이 유저가 무엇을 했는지, 무엇을 얻었는지, 출처는 어디인지를 모두 확인할 수 있어야 한다.
+    */
+    static void SaveToDatabase(const GameLog& log) {
+        SaveToDatabase(GameLog(log));
+    }
+
+    // 파이프라인이 시작되었다면 큐에 넣고 바로 반환한다. (DB 기록은 batcher 스레드에서 배치 단위로)
+    static void SaveToDatabase(GameLog&& log) {
+        if (GameLogPipeline* pipeline = Pipeline().get()) {
+            pipeline->Submit(std::move(log));
+            return;
+        }
+
+        // 파이프라인이 없다면 콘솔에만 출력
+        std::cout << "GameLog Saved: " << log.server << ", " << log.type << ", " << log.code
+            << ", AccountNo: " << log.accountNo << ", Params: (" << log.param1 << ", "
+            << log.param2 << ", " << log.param3 << ", " << log.param4 << "), Str: "
+            << log.paramStr << "\n";
+    }
+
+    // 배치 파이프라인 시작. sink는 DB 연결 등 실제 저장소에 맞게 GameLogSink를 구현해서 넘긴다.
+    // 로그를 남기기 전, 초기화 시점에 호출한다.
+    static void Start(std::unique_ptr<GameLogSink> sink, const GameLogPipelineConfig& config = GameLogPipelineConfig()) {
+        Stop();
+        Pipeline() = std::make_unique<GameLogPipeline>(std::move(sink), config);
+    }
+
+    // 큐에 남은 로그를 모두 넘기고 파이프라인을 멈춘다. 종료 시점에 호출한다.
+    static void Stop(void) {
+        Pipeline().reset();
+    }
+
+    static void Flush(void) {
+        if (GameLogPipeline* pipeline = Pipeline().get()) {
+            pipeline->Flush();
+        }
+    }
+
+    static GameLogPipelineStats GetStats(void) {
+        GameLogPipeline* pipeline = Pipeline().get();
+        return pipeline != nullptr ? pipeline->GetStats() : GameLogPipelineStats();
+    }
+
+private:
+    static std::unique_ptr<GameLogPipeline>& Pipeline(void) {
+        static std::unique_ptr<GameLogPipeline> pipeline;
+        return pipeline;
+    }
+};
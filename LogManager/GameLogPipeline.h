@@ -0,0 +1,712 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameLog.h"
+#include "LogQueue.h"
+#include "LogTime.h"
+
+// 게임 로그(GameLog)를 DB 등에 배치 단위로 넘기는 파이프라인.
+//
+//     게임 스레드 --Submit--> BoundedLogQueue --batcher 스레드--> GameLogSink::WriteBatch
+//                                                     | 실패 / 느림
+//                                                     +--> GameLogJournal (디스크) --나중에 다시--> GameLogSink
+//
+// batcher는 batchSize개가 모이거나 첫 로그가 들어온 뒤 batchWindow가 지나면 배치 하나를 넘긴다.
+// 실패한 배치는 retryBackoff부터 두 배씩 늘려가며 maxAttempts번까지 다시 시도하고, 그래도 실패하면 저널에 옮겨둔다.
+// 그 뒤로는 sink가 살아날 때까지 재시도 없이 바로 저널에 옮긴다.
+// sink가 느려서(slowSinkThreshold) 큐가 절반 넘게 찼을 때도 sink를 기다리지 않고 저널에 옮겨 큐를 비운다.
+// 저널은 replayInterval마다(sink가 정상이라면 큐가 한가할 때만), 그리고 다음 실행의 시작 시점에 sink로 다시 보낸다.
+
+// 배치를 받는 출력 대상. batcher 스레드 하나에서만 호출된다.
+class GameLogSink {
+public:
+    virtual ~GameLogSink(void) = default;
+
+    // 배치 전체를 기록하면 true. false라면 배치 전체를 다시 보낸다. (일부만 기록된 상태를 남기지 않아야 함)
+    virtual bool WriteBatch(const GameLog* logs, size_t count) = 0;
+};
+
+// 한 줄에 로그 하나를 탭으로 구분해서 남기는 파일 sink. 배치마다 flush한다.
+// server / type / code / accountNo / param1 ~ 4 / paramStr (문자열 안의 탭, 줄바꿈, \는 \t, \n, \\로 바꿈)
+class GameLogFileSink : public GameLogSink {
+public:
+    explicit GameLogFileSink(const std::wstring& fileName)
+        : stream(std::filesystem::path(fileName), std::ios::binary | std::ios::app) {}
+
+    bool WriteBatch(const GameLog* logs, size_t count) override
+    {
+        if (!stream.is_open()) {
+            return false;
+        }
+
+        buffer.clear();
+        for (size_t i = 0; i < count; ++i) {
+            const GameLog& log = logs[i];
+            AppendEscaped(log.server);
+            buffer += '\t';
+            AppendEscaped(log.type);
+            buffer += '\t';
+            AppendEscaped(log.code);
+            buffer += '\t';
+            buffer += std::to_string(log.accountNo);
+            for (int32_t param : { log.param1, log.param2, log.param3, log.param4 }) {
+                buffer += '\t';
+                buffer += std::to_string(param);
+            }
+            buffer += '\t';
+            AppendEscaped(log.paramStr);
+            buffer += '\n';
+        }
+
+        stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        stream.flush();
+        if (!stream.good()) {
+            stream.clear();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void AppendEscaped(const std::string& text)
+    {
+        for (char c : text) {
+            switch (c) {
+            case '\t': buffer += "\\t"; break;
+            case '\n': buffer += "\\n"; break;
+            case '\\': buffer += "\\\\"; break;
+            default: buffer += c; break;
+            }
+        }
+    }
+
+    std::ofstream stream;
+    std::string buffer;
+};
+
+// DB를 흉내내는 메모리 sink. 실제 DB 연결을 붙이기 전 파이프라인 확인 / 부하 테스트용.
+// SetLatency로 배치마다 걸리는 시간을, SetFailing으로 장애를 흉내낼 수 있다.
+class GameLogMockDatabaseSink : public GameLogSink {
+public:
+    bool WriteBatch(const GameLog* logs, size_t count) override
+    {
+        const auto latency = std::chrono::milliseconds(latencyMillis.load(std::memory_order_relaxed));
+        if (latency.count() > 0) {
+            std::this_thread::sleep_for(latency);
+        }
+
+        if (failing.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        rows.insert(rows.end(), logs, logs + count);
+        return true;
+    }
+
+    void SetLatency(std::chrono::milliseconds latency) { latencyMillis.store(latency.count(), std::memory_order_relaxed); }
+    void SetFailing(bool fail) { failing.store(fail, std::memory_order_relaxed); }
+
+    size_t RowCount(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return rows.size();
+    }
+
+    std::vector<GameLog> Rows(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return rows;
+    }
+
+private:
+    std::atomic<int64_t> latencyMillis{ 0 };
+    std::atomic<bool> failing{ false };
+
+    std::mutex lock;
+    std::vector<GameLog> rows;
+};
+
+// sink로 보내지 못한 로그를 모아두는 파일. batcher 스레드만 사용한다.
+// 파일 := { uint32 magic / uint32 count / GameLog * count } *      (정수는 little endian 가정, 문자열은 uint32 길이 + 바이트)
+// GameLog := server / type / code / accountNo / param1 ~ 4 / paramStr / timestamp   (GLJ1 묶음에는 timestamp가 없다)
+// 기록 도중 종료되어 잘린 마지막 묶음은 읽을 때 버린다.
+class GameLogJournal {
+public:
+    // 이전 실행에서 잘린 묶음이 남아있다면 뒤에 이어 쓴 묶음을 읽을 수 없으므로, 읽을 수 있는 로그만으로 다시 쓴다.
+    explicit GameLogJournal(const std::wstring& fileName) : path(fileName)
+    {
+        std::vector<GameLog> logs;
+        if (ReadAll(logs)) {
+            Rewrite(logs.data(), logs.size());
+        }
+    }
+
+    bool Append(const GameLog* logs, size_t count)
+    {
+        std::string bytes;
+        AppendChunk(bytes, logs, count);
+
+        std::ofstream stream(path, std::ios::binary | std::ios::app);
+        stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!stream.good()) {
+            return false;
+        }
+
+        pendingRecords += count;
+        return true;
+    }
+
+    // 저널의 로그를 모두 읽는다.
+    bool ReadAll(std::vector<GameLog>& logs) const
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream.is_open()) {
+            return false;
+        }
+
+        std::string bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        const char* p = bytes.data();
+        const char* end = p + bytes.size();
+
+        while (end - p >= 8) {
+            uint32_t magic = 0, count = 0;
+            std::memcpy(&magic, p, 4);
+            std::memcpy(&count, p + 4, 4);
+            if (magic != CHUNK_MAGIC && magic != CHUNK_MAGIC_V1) {
+                break;
+            }
+
+            const char* cursor = p + 8;
+            const size_t before = logs.size();
+            bool complete = true;
+            for (uint32_t i = 0; i < count && complete; ++i) {
+                GameLog log;
+                complete = ReadLog(cursor, end, log, magic == CHUNK_MAGIC);
+                if (complete) {
+                    logs.push_back(std::move(log));
+                }
+            }
+            if (!complete) {
+                logs.resize(before);
+                break;
+            }
+            p = cursor;
+        }
+        return true;
+    }
+
+    // 저널을 logs로 바꿔 쓴다. (비어있다면 파일을 지움)
+    bool Rewrite(const GameLog* logs, size_t count)
+    {
+        std::error_code error;
+        if (count == 0) {
+            std::filesystem::remove(path, error);
+            pendingRecords = 0;
+            return !error;
+        }
+
+        std::string bytes;
+        AppendChunk(bytes, logs, count);
+
+        std::filesystem::path temp = path;
+        temp += L".tmp";
+        {
+            std::ofstream stream(temp, std::ios::binary | std::ios::trunc);
+            stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!stream.good()) {
+                return false;
+            }
+        }
+        std::filesystem::rename(temp, path, error);
+        if (error) {
+            return false;
+        }
+
+        pendingRecords = count;
+        return true;
+    }
+
+    uint64_t PendingRecords(void) const { return pendingRecords; }
+
+private:
+    static constexpr uint32_t CHUNK_MAGIC = 0x324A4C47;     // "GLJ2"
+    static constexpr uint32_t CHUNK_MAGIC_V1 = 0x314A4C47;  // "GLJ1". 이전 버전이 남긴 저널. timestamp 없이 읽는다.
+
+    static void AppendUInt32(std::string& out, uint32_t value) { out.append(reinterpret_cast<const char*>(&value), 4); }
+
+    static void AppendString(std::string& out, const std::string& text)
+    {
+        AppendUInt32(out, static_cast<uint32_t>(text.size()));
+        out += text;
+    }
+
+    static void AppendChunk(std::string& out, const GameLog* logs, size_t count)
+    {
+        AppendUInt32(out, CHUNK_MAGIC);
+        AppendUInt32(out, static_cast<uint32_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            const GameLog& log = logs[i];
+            AppendString(out, log.server);
+            AppendString(out, log.type);
+            AppendString(out, log.code);
+            out.append(reinterpret_cast<const char*>(&log.accountNo), 8);
+            for (int32_t param : { log.param1, log.param2, log.param3, log.param4 }) {
+                AppendUInt32(out, static_cast<uint32_t>(param));
+            }
+            AppendString(out, log.paramStr);
+            out.append(reinterpret_cast<const char*>(&log.timestamp), 8);
+        }
+    }
+
+    static bool ReadString(const char*& p, const char* end, std::string& text)
+    {
+        uint32_t length = 0;
+        if (end - p < 4) return false;
+        std::memcpy(&length, p, 4);
+        p += 4;
+        if (static_cast<size_t>(end - p) < length) return false;
+        text.assign(p, length);
+        p += length;
+        return true;
+    }
+
+    static bool ReadLog(const char*& p, const char* end, GameLog& log, bool hasTimestamp)
+    {
+        if (!ReadString(p, end, log.server) || !ReadString(p, end, log.type) || !ReadString(p, end, log.code)) {
+            return false;
+        }
+        if (end - p < 8 + 16) {
+            return false;
+        }
+        std::memcpy(&log.accountNo, p, 8);
+        std::memcpy(&log.param1, p + 8, 4);
+        std::memcpy(&log.param2, p + 12, 4);
+        std::memcpy(&log.param3, p + 16, 4);
+        std::memcpy(&log.param4, p + 20, 4);
+        p += 24;
+        if (!ReadString(p, end, log.paramStr)) {
+            return false;
+        }
+        if (hasTimestamp) {
+            if (end - p < 8) {
+                return false;
+            }
+            std::memcpy(&log.timestamp, p, 8);
+            p += 8;
+        }
+        return true;
+    }
+
+    std::filesystem::path path;
+    uint64_t pendingRecords = 0;
+};
+
+struct GameLogPipelineConfig {
+    size_t queueDepth = 8192;                                   // 큐에 담아둘 수 있는 최대 로그 수 (2의 거듭제곱으로 올림)
+    QueueFullPolicy fullPolicy = QueueFullPolicy::POLICY_BLOCK; // 큐가 가득 찼을 때의 처리 방식 (backpressure)
+    size_t batchSize = 256;                                     // 배치 하나의 최대 로그 수
+    std::chrono::milliseconds batchWindow{ 100 };               // 첫 로그가 들어온 뒤 배치를 넘기기까지 기다리는 최대 시간
+    int maxAttempts = 3;                                        // 배치 하나를 sink로 보내보는 최대 횟수
+    std::chrono::milliseconds retryBackoff{ 10 };               // 첫 재시도 전 대기 시간. 재시도마다 두 배
+    std::chrono::milliseconds slowSinkThreshold{ 200 };         // 배치 하나가 이보다 오래 걸리면 느린 sink로 본다.
+    std::chrono::milliseconds replayInterval{ 1000 };           // 저널을 sink로 다시 보내보는 간격
+    std::wstring journalFileName = L"GameLogJournal.bin";       // 보내지 못한 로그를 모아두는 파일
+};
+
+// 파이프라인 카운터. GetStats()가 돌려주는 시점의 값이다.
+struct GameLogPipelineStats {
+    static constexpr size_t HISTOGRAM_BUCKETS = 24;
+
+    uint64_t submitted = 0;             // 큐에 들어간 로그
+    uint64_t dropped = 0;               // POLICY_DROP으로 버려진 로그
+    uint64_t overwritten = 0;           // POLICY_OVERWRITE_OLDEST로 밀려난 로그
+    uint64_t batches = 0;               // sink에 기록된 배치
+    uint64_t written = 0;               // sink에 기록된 로그 (저널에서 다시 보낸 것 포함)
+    uint64_t failedAttempts = 0;        // 실패한 WriteBatch 호출
+    uint64_t spilledRecords = 0;        // 저널에 옮겨진 로그
+    uint64_t replayedRecords = 0;       // 저널에서 sink로 다시 보낸 로그
+    uint64_t journalPending = 0;        // 지금 저널에 남아있는 로그
+    uint64_t lostRecords = 0;           // sink와 저널 모두에 실패해서 잃어버린 로그
+
+    uint64_t batchSizeHistogram[HISTOGRAM_BUCKETS] = {};     // [i] : 크기가 2^(i-1) 초과 2^i 이하인 배치 수 ([0]은 1)
+    uint64_t latencyHistogram[HISTOGRAM_BUCKETS] = {};       // [i] : WriteBatch 한 번이 2^(i-1) 초과 2^i us 이하였던 횟수 (마지막 칸은 그 이상 전부)
+    uint64_t totalLatencyMicros = 0;
+    uint64_t maxLatencyMicros = 0;
+};
+
+class GameLogPipeline {
+public:
+    GameLogPipeline(std::unique_ptr<GameLogSink> sink, const GameLogPipelineConfig& config)
+        : config(config), sink(std::move(sink)), queue(config.queueDepth), journal(config.journalFileName)
+    {
+        if (this->config.batchSize == 0) this->config.batchSize = 1;
+        if (this->config.maxAttempts < 1) this->config.maxAttempts = 1;
+
+        journalPending.store(journal.PendingRecords());
+        running = true;
+        batcherThread = std::thread(&GameLogPipeline::BatcherThreadProc, this);
+    }
+
+    ~GameLogPipeline(void) { Stop(); }
+
+    GameLogPipeline(const GameLogPipeline&) = delete;
+    GameLogPipeline& operator=(const GameLogPipeline&) = delete;
+
+    // 큐에 넣는다. POLICY_DROP으로 버려졌거나 이미 Stop된 경우 false
+    // log.timestamp가 0이면 지금 시각을 넣는다. 재시도나 저널 재전송을 거쳐도 이 시각이 그대로 sink까지 간다.
+    bool Submit(GameLog&& log)
+    {
+        if (log.timestamp == 0) {
+            log.timestamp = LogClockNow();
+        }
+
+        activeProducers.fetch_add(1);
+
+        if (!accepting.load()) {
+            activeProducers.fetch_sub(1);
+            return false;
+        }
+
+        bool pushed = queue.TryPush(std::move(log));
+        if (!pushed) {
+            switch (config.fullPolicy) {
+            case QueueFullPolicy::POLICY_DROP:
+                counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                break;
+
+            case QueueFullPolicy::POLICY_OVERWRITE_OLDEST:
+                do {
+                    GameLog oldest;
+                    if (queue.TryPop(oldest)) {
+                        counters.overwritten.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } while (!queue.TryPush(std::move(log)));
+                pushed = true;
+                break;
+
+            case QueueFullPolicy::POLICY_BLOCK:
+            default:
+            {
+                std::unique_lock<std::mutex> lock(batcherMutex);
+                blockedProducers.fetch_add(1);
+                queueNotFull.wait(lock, [&] { return queue.TryPush(std::move(log)); });
+                blockedProducers.fetch_sub(1);
+                pushed = true;
+                break;
+            }
+            }
+        }
+
+        if (pushed) {
+            counters.submitted.fetch_add(1, std::memory_order_relaxed);
+
+            // 배치 하나가 찼다면 batchWindow를 기다리지 않도록 깨운다.
+            if (batcherSleeping.load() && queue.ApproxSize() >= config.batchSize) {
+                std::lock_guard<std::mutex> lock(batcherMutex);
+                batcherWakeup.notify_one();
+            }
+        }
+
+        activeProducers.fetch_sub(1);
+        return pushed;
+    }
+
+    // 지금까지 Submit된 로그가 sink(또는 저널)에 넘어갈 때까지 대기
+    void Flush(void)
+    {
+        std::unique_lock<std::mutex> lock(batcherMutex);
+        if (!running) {
+            return;
+        }
+
+        const uint64_t target = ++flushRequested;
+        batcherWakeup.notify_one();
+        flushDone.wait(lock, [&] { return flushCompleted >= target || !running; });
+    }
+
+    // 새 로그를 받지 않고, 큐에 남은 로그를 모두 넘긴 뒤 batcher 스레드를 종료한다. 보내지 못한 로그는 저널에 남는다.
+    void Stop(void)
+    {
+        if (!accepting.exchange(false)) {
+            return;
+        }
+
+        while (activeProducers.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(batcherMutex);
+            running = false;
+        }
+        batcherWakeup.notify_one();
+        flushDone.notify_all();
+        batcherThread.join();
+    }
+
+    GameLogPipelineStats GetStats(void) const
+    {
+        GameLogPipelineStats stats;
+        stats.submitted = counters.submitted.load(std::memory_order_relaxed);
+        stats.dropped = counters.dropped.load(std::memory_order_relaxed);
+        stats.overwritten = counters.overwritten.load(std::memory_order_relaxed);
+        stats.batches = counters.batches.load(std::memory_order_relaxed);
+        stats.written = counters.written.load(std::memory_order_relaxed);
+        stats.failedAttempts = counters.failedAttempts.load(std::memory_order_relaxed);
+        stats.spilledRecords = counters.spilledRecords.load(std::memory_order_relaxed);
+        stats.replayedRecords = counters.replayedRecords.load(std::memory_order_relaxed);
+        stats.journalPending = journalPending.load(std::memory_order_relaxed);
+        stats.lostRecords = counters.lostRecords.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < GameLogPipelineStats::HISTOGRAM_BUCKETS; ++i) {
+            stats.batchSizeHistogram[i] = counters.batchSizeHistogram[i].load(std::memory_order_relaxed);
+            stats.latencyHistogram[i] = counters.latencyHistogram[i].load(std::memory_order_relaxed);
+        }
+        stats.totalLatencyMicros = counters.totalLatencyMicros.load(std::memory_order_relaxed);
+        stats.maxLatencyMicros = counters.maxLatencyMicros.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // batcher 스레드만 쓰고, GetStats는 아무 스레드에서나 읽는다.
+    struct Counters {
+        std::atomic<uint64_t> submitted{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<uint64_t> overwritten{ 0 };
+        std::atomic<uint64_t> batches{ 0 };
+        std::atomic<uint64_t> written{ 0 };
+        std::atomic<uint64_t> failedAttempts{ 0 };
+        std::atomic<uint64_t> spilledRecords{ 0 };
+        std::atomic<uint64_t> replayedRecords{ 0 };
+        std::atomic<uint64_t> lostRecords{ 0 };
+        std::atomic<uint64_t> batchSizeHistogram[GameLogPipelineStats::HISTOGRAM_BUCKETS] = {};
+        std::atomic<uint64_t> latencyHistogram[GameLogPipelineStats::HISTOGRAM_BUCKETS] = {};
+        std::atomic<uint64_t> totalLatencyMicros{ 0 };
+        std::atomic<uint64_t> maxLatencyMicros{ 0 };
+    };
+
+    // value가 들어갈 2의 거듭제곱 칸. (0, 1 -> 0 / 2 -> 1 / 3, 4 -> 2 ...)
+    static size_t HistogramBucket(uint64_t value)
+    {
+        size_t bucket = 0;
+        while (bucket + 1 < GameLogPipelineStats::HISTOGRAM_BUCKETS && (1ull << bucket) < value) {
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void BatcherThreadProc(void)
+    {
+        std::vector<GameLog> batch;
+        batch.reserve(config.batchSize);
+
+        // 지난 실행에서 남은 저널부터 보낸다.
+        ReplayJournal();
+
+        Clock::time_point batchStart{};
+        Clock::time_point lastReplay = Clock::now();
+
+        for (;;) {
+            PopInto(batch);
+            if (!batch.empty() && batchStart == Clock::time_point{}) {
+                batchStart = Clock::now();
+            }
+
+            std::unique_lock<std::mutex> lock(batcherMutex);
+            const bool stopping = !running;
+            const uint64_t flushTarget = flushRequested;
+            const bool flushing = flushTarget > flushCompleted;
+            lock.unlock();
+
+            const auto now = Clock::now();
+
+            // sink가 죽어있다면 살아났는지 확인할 겸, 정상이라면 큐가 한가할 때 저널을 비워본다.
+            if (journalPending.load(std::memory_order_relaxed) != 0 && now - lastReplay >= config.replayInterval && (sinkDown || batch.empty())) {
+                ReplayJournal();
+                lastReplay = Clock::now();
+                continue;
+            }
+
+            if (!batch.empty() && (batch.size() >= config.batchSize || flushing || stopping || now - batchStart >= config.batchWindow)) {
+                Dispatch(batch);
+                batch.clear();
+                batchStart = Clock::time_point{};
+                continue;       // 큐에 더 남아있을 수 있다.
+            }
+
+            if (batch.empty() && (stopping || flushing) && queue.Empty()) {
+                lock.lock();
+                flushCompleted = flushTarget;
+                flushDone.notify_all();
+                if (stopping) {
+                    break;
+                }
+                continue;
+            }
+
+            const auto wait = batch.empty() ? config.batchWindow : config.batchWindow - (now - batchStart);
+            lock.lock();
+            batcherSleeping.store(true);
+            batcherWakeup.wait_for(lock, wait, [&] {
+                return !running || flushRequested > flushCompleted || queue.ApproxSize() + batch.size() >= config.batchSize;
+            });
+            batcherSleeping.store(false);
+        }
+    }
+
+    void PopInto(std::vector<GameLog>& batch)
+    {
+        const size_t before = batch.size();
+
+        GameLog log;
+        while (batch.size() < config.batchSize && queue.TryPop(log)) {
+            batch.push_back(std::move(log));
+        }
+
+        // 자리가 났으니 대기중인 생산자를 깨운다.
+        if (batch.size() != before && blockedProducers.load() > 0) {
+            std::lock_guard<std::mutex> lock(batcherMutex);
+            queueNotFull.notify_all();
+        }
+    }
+
+    // 배치 하나를 sink로 보낸다. 실패하거나 sink가 밀려있다면 저널에 옮긴다.
+    void Dispatch(const std::vector<GameLog>& batch)
+    {
+        if (sinkDown) {
+            Spill(batch.data(), batch.size());
+            return;
+        }
+
+        // 느린 sink 때문에 큐가 절반 넘게 찼다면 기다리지 않고 저널로 옮겨 생산자를 풀어준다.
+        if (lastWriteSlow && queue.ApproxSize() * 2 >= queue.Capacity()) {
+            Spill(batch.data(), batch.size());
+            lastWriteSlow = false;      // 다음 배치는 다시 sink로 보내본다.
+            return;
+        }
+
+        if (!WriteWithRetry(batch.data(), batch.size())) {
+            Spill(batch.data(), batch.size());
+        }
+    }
+
+    bool WriteWithRetry(const GameLog* logs, size_t count)
+    {
+        auto backoff = config.retryBackoff;
+        for (int attempt = 0; attempt < config.maxAttempts; ++attempt) {
+            if (attempt != 0) {
+                std::this_thread::sleep_for(backoff);
+                backoff *= 2;
+            }
+
+            const auto start = Clock::now();
+            const bool ok = sink->WriteBatch(logs, count);
+            const auto elapsed = Clock::now() - start;
+            RecordLatency(elapsed);
+
+            if (ok) {
+                lastWriteSlow = elapsed >= config.slowSinkThreshold;
+                Add(counters.batches, 1);
+                Add(counters.written, count);
+                Add(counters.batchSizeHistogram[HistogramBucket(count)], 1);
+                return true;
+            }
+            Add(counters.failedAttempts, 1);
+        }
+
+        sinkDown = true;
+        return false;
+    }
+
+    void RecordLatency(Clock::duration elapsed)
+    {
+        const uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        Add(counters.latencyHistogram[HistogramBucket(micros)], 1);
+        Add(counters.totalLatencyMicros, micros);
+        if (micros > counters.maxLatencyMicros.load(std::memory_order_relaxed)) {
+            counters.maxLatencyMicros.store(micros, std::memory_order_relaxed);
+        }
+    }
+
+    void Spill(const GameLog* logs, size_t count)
+    {
+        if (journal.Append(logs, count)) {
+            Add(counters.spilledRecords, count);
+        }
+        else {
+            Add(counters.lostRecords, count);
+        }
+        journalPending.store(journal.PendingRecords(), std::memory_order_relaxed);
+    }
+
+    // 저널의 로그를 배치 크기로 나눠 보낸다. 도중에 실패하면 남은 로그만 저널에 다시 쓴다.
+    void ReplayJournal(void)
+    {
+        if (journal.PendingRecords() == 0) {
+            return;
+        }
+
+        std::vector<GameLog> logs;
+        if (!journal.ReadAll(logs)) {
+            return;
+        }
+
+        size_t sent = 0;
+        sinkDown = false;
+        while (sent < logs.size()) {
+            const size_t count = std::min(config.batchSize, logs.size() - sent);
+            if (!WriteWithRetry(logs.data() + sent, count)) {
+                break;
+            }
+            sent += count;
+            Add(counters.replayedRecords, count);
+        }
+
+        journal.Rewrite(logs.data() + sent, logs.size() - sent);
+        journalPending.store(journal.PendingRecords(), std::memory_order_relaxed);
+    }
+
+    GameLogPipelineConfig config;
+    std::unique_ptr<GameLogSink> sink;
+    BoundedLogQueue<GameLog> queue;
+    GameLogJournal journal;             // batcher 스레드만 사용
+    bool lastWriteSlow = false;         // batcher 스레드만 사용. 마지막으로 성공한 WriteBatch가 slowSinkThreshold를 넘었는지
+    bool sinkDown = false;              // batcher 스레드만 사용. 재시도까지 실패한 뒤 저널 재전송이 성공하기 전까지 true
+
+    Counters counters;
+    std::atomic<uint64_t> journalPending{ 0 };
+
+    std::thread batcherThread;
+    std::mutex batcherMutex;                        // 아래 condition_variable 들과 running / flush 번호를 보호
+    std::condition_variable batcherWakeup;          // 배치가 찼거나 Flush / Stop이 요청되면 batcher를 깨움
+    std::condition_variable queueNotFull;           // 큐가 가득 차서 대기중인 생산자를 깨움
+    std::condition_variable flushDone;              // Flush 대기를 깨움
+    bool running = false;
+    uint64_t flushRequested = 0;
+    uint64_t flushCompleted = 0;
+    std::atomic<bool> accepting{ true };
+    std::atomic<bool> batcherSleeping{ false };
+    std::atomic<int> blockedProducers{ 0 };
+    std::atomic<int> activeProducers{ 0 };
+};
@@ -0,0 +1,104 @@
+﻿#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "GameLogStore.h"
+#include "LogTime.h"
+
+// GameLogStore(GameLogStoreSink가 쓴 segment_*.gls)에서 조건에 맞는 게임 로그를 찾는 도구.
+//
+//     GameLogSearch <directory> [--account N] [--time "YYYY-MM-DD HH:MM:SS" "YYYY-MM-DD HH:MM:SS"] [--type T] [--code C] [--limit N]
+//
+// --account : 이 계정 번호의 로그만 (세그먼트의 accountNo 인덱스를 사용)
+// --time    : 로컬 시각 기준으로 FROM 이상 TO 이하(TO의 초 끝까지)인 로그만
+// --type / --code : 값이 같은 로그만
+// 결과는 시각 / server / type / code / accountNo / param1 ~ 4 / paramStr를 탭으로 구분해서 한 줄씩,
+// 살펴본 / 건너뛴 세그먼트 수와 걸린 시간은 stderr로 출력한다.
+
+int Usage(void)
+{
+    std::fprintf(stderr, "usage: GameLogSearch <directory> [--account N] [--time \"YYYY-MM-DD HH:MM:SS\" \"YYYY-MM-DD HH:MM:SS\"] "
+        "[--type T] [--code C] [--limit N]\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    const char* directory = nullptr;
+    GameLogQuery query;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--account") == 0 && i + 1 < argc) {
+            query.matchAccount = true;
+            query.accountNo = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--time") == 0 && i + 2 < argc) {
+            std::time_t from = 0, to = 0;
+            if (!ParseLocalTime(argv[++i], from) || !ParseLocalTime(argv[++i], to)) return Usage();
+            query.timeFrom = static_cast<LogTimestamp>(from) * 1000000000ull;
+            query.timeTo = static_cast<LogTimestamp>(to) * 1000000000ull + 999999999ull;
+        }
+        else if (std::strcmp(argv[i], "--type") == 0 && i + 1 < argc) {
+            query.type = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--code") == 0 && i + 1 < argc) {
+            query.code = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            query.limit = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            return Usage();
+        }
+        else if (directory == nullptr) {
+            directory = argv[i];
+        }
+        else {
+            return Usage();
+        }
+    }
+
+    if (directory == nullptr) {
+        return Usage();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    GameLogStore store(std::filesystem::path(directory).wstring());
+    std::vector<GameLogStoreRow> rows;
+    GameLogQueryStats stats;
+    store.Query(query, rows, &stats);
+
+    const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    LogTimestampCache timestampCache;
+    std::string line;
+    for (const GameLogStoreRow& row : rows) {
+        const GameLog& log = row.log;
+
+        // 시각 문자열은 ASCII이므로 그대로 좁힌다.
+        const wchar_t* time = timestampCache.FormatMicros(row.timestamp);
+        line.assign(time, time + LogTimestampCache::MICRO_TEXT_LENGTH);
+        for (const std::string* field : { &log.server, &log.type, &log.code }) {
+            line += '\t';
+            line += *field;
+        }
+        line += '\t';
+        line += std::to_string(log.accountNo);
+        for (int32_t param : { log.param1, log.param2, log.param3, log.param4 }) {
+            line += '\t';
+            line += std::to_string(param);
+        }
+        line += '\t';
+        line += log.paramStr;
+        line += '\n';
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    }
+
+    std::fprintf(stderr, "%zu rows, %zu / %zu segments skipped, %zu rows scanned, %.2f ms\n",
+        stats.rowsMatched, stats.segmentsSkipped, stats.segments, stats.rowsScanned, elapsed);
+    return 0;
+}
@@ -0,0 +1,798 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "GameLog.h"
+#include "GameLogPipeline.h"
+#include "LogTime.h"
+#include "MappedFile.h"
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GAMELOGSTORE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(GAMELOGSTORE_SSE2) && defined(__AVX2__)
+#define GAMELOGSTORE_AVX2 1
+#include <immintrin.h>
+#endif
+
+// GameLog를 열(column) 단위로 모아두고 "accountNo X의 T1 ~ T2 사이 로그"를 빠르게 찾는 저장소.
+//
+//     directory/segment_000001.gls, segment_000002.gls, ...
+//
+// Append한 로그는 메모리에 열 단위로 쌓이다가 segmentRows개가 차면(또는 Seal) 세그먼트 파일 하나로 기록된다.
+// 기록된 세그먼트는 바뀌지 않으며(append-only) 메모리에 매핑해서 읽는다.
+//
+// 세그먼트 하나는 머리(SegmentHeader) 뒤에 8바이트 정렬된 열들이 이어진다.
+//     시각 / accountNo (uint64) , server / type / code (세그먼트 사전의 id, uint32) , param1 ~ 4 (int32)
+//     paramStr (끝 위치 uint32 + 바이트) , 사전 (끝 위치 uint32 + 바이트) , accountNo 인덱스 (정렬된 accountNo + 행 번호)
+// 머리에는 시각 / accountNo의 최소 / 최대값이 있어서 조건에 맞지 않는 세그먼트는 열을 읽지 않고 건너뛴다.
+// accountNo 조건이 있으면 인덱스를 이분 탐색하고, 없으면 시각 / type / code 열을 SIMD로 비교한다.
+
+// 조건. 비어있는 문자열은 모든 값과 맞는다. 시각은 양 끝 포함
+struct GameLogQuery {
+    bool matchAccount = false;
+    uint64_t accountNo = 0;
+    LogTimestamp timeFrom = 0;
+    LogTimestamp timeTo = UINT64_MAX;
+    std::string type;
+    std::string code;
+    size_t limit = 0;                   // 최대 결과 수 (0이면 제한 없음)
+};
+
+struct GameLogQueryStats {
+    size_t segments = 0;                // 살펴본 세그먼트 (아직 기록하지 않은 로그 포함)
+    size_t segmentsSkipped = 0;         // 머리 / 사전 / 인덱스만 보고 건너뛴 세그먼트
+    size_t rowsScanned = 0;             // 조건을 비교한 행
+    size_t rowsMatched = 0;
+};
+
+struct GameLogStoreRow {
+    LogTimestamp timestamp = 0;
+    GameLog log;
+};
+
+namespace GameLogSegmentFormat {
+    inline constexpr char MAGIC[8] = { 'G', 'L', 'S', 'E', 'G', '0', '0', '1' };
+    constexpr uint32_t ANY_SYMBOL = 0xFFFFFFFF;     // 조건에서 "모든 값"
+    constexpr uint32_t NO_SYMBOL = 0xFFFFFFFE;      // 사전에 없는 문자열 (맞는 행이 없음)
+
+    enum Column : uint32_t {
+        COLUMN_TIME,
+        COLUMN_ACCOUNT,
+        COLUMN_SERVER,
+        COLUMN_TYPE,
+        COLUMN_CODE,
+        COLUMN_PARAM1,
+        COLUMN_PARAM2,
+        COLUMN_PARAM3,
+        COLUMN_PARAM4,
+        COLUMN_PARAM_ENDS,          // 행마다 paramStr가 끝나는 위치
+        COLUMN_PARAM_BYTES,
+        COLUMN_SYMBOL_ENDS,         // 사전 문자열마다 끝나는 위치
+        COLUMN_SYMBOL_BYTES,
+        COLUMN_INDEX_ACCOUNTS,      // 정렬된 accountNo
+        COLUMN_INDEX_ROWS,          // 위 accountNo의 행 번호 (같은 accountNo 안에서는 행 순서)
+        COLUMN_COUNT
+    };
+
+    struct ColumnRange {
+        uint64_t offset;
+        uint64_t bytes;
+    };
+
+    struct SegmentHeader {
+        char magic[8];
+        uint32_t rowCount;
+        uint32_t symbolCount;
+        uint64_t minTime;
+        uint64_t maxTime;
+        uint64_t minAccount;
+        uint64_t maxAccount;
+        ColumnRange columns[COLUMN_COUNT];
+    };
+
+    static_assert(std::is_trivially_copyable_v<SegmentHeader>, "SegmentHeader는 파일에 그대로 쓴다.");
+
+    // 열마다 한 칸의 바이트 수. 0이라면 길이가 정해지지 않은 바이트 열
+    inline size_t ElementSize(uint32_t column)
+    {
+        switch (column) {
+        case COLUMN_TIME:
+        case COLUMN_ACCOUNT:
+        case COLUMN_INDEX_ACCOUNTS:
+            return 8;
+        case COLUMN_PARAM_BYTES:
+        case COLUMN_SYMBOL_BYTES:
+            return 0;
+        default:
+            return 4;
+        }
+    }
+
+    inline size_t AlignUp(size_t value) { return (value + 7) & ~static_cast<size_t>(7); }
+}
+
+// 행 단위 조건 비교. 세그먼트와 아직 기록하지 않은 로그가 함께 쓴다.
+namespace GameLogScan {
+    using namespace GameLogSegmentFormat;
+
+    struct Predicate {
+        LogTimestamp timeFrom = 0;
+        LogTimestamp timeTo = UINT64_MAX;
+        bool matchAccount = false;
+        uint64_t accountNo = 0;
+        uint32_t typeId = ANY_SYMBOL;
+        uint32_t codeId = ANY_SYMBOL;
+    };
+
+    inline bool MatchesRow(const Predicate& predicate, uint64_t time, uint64_t account, uint32_t type, uint32_t code)
+    {
+        return time - predicate.timeFrom <= predicate.timeTo - predicate.timeFrom
+            && (!predicate.matchAccount || account == predicate.accountNo)
+            && (predicate.typeId == ANY_SYMBOL || type == predicate.typeId)
+            && (predicate.codeId == ANY_SYMBOL || code == predicate.codeId);
+    }
+
+    inline void EmitMask(uint32_t mask, size_t base, std::vector<uint32_t>& rows)
+    {
+        for (uint32_t bit = 0; mask != 0; ++bit, mask >>= 1) {
+            if (mask & 1)
+                rows.push_back(static_cast<uint32_t>(base + bit));
+        }
+    }
+
+#if defined(GAMELOGSTORE_AVX2)
+    // 4행. 시각 범위는 (time - from) <= (to - from)를 부호 없는 64비트로 비교한다. (부호 비트를 뒤집어서 부호 있는 비교로)
+    inline uint32_t TimeMask4(const uint64_t* times, __m256i from, __m256i span)
+    {
+        const __m256i flip = _mm256_set1_epi64x(INT64_MIN);
+        const __m256i delta = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(times)), from);
+        const __m256i outside = _mm256_cmpgt_epi64(_mm256_xor_si256(delta, flip), _mm256_xor_si256(span, flip));
+        return ~static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(outside))) & 0xF;
+    }
+
+    inline uint32_t EqualMask4(const uint64_t* values, __m256i value)
+    {
+        const __m256i equal = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values)), value);
+        return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(equal)));
+    }
+
+    inline uint32_t EqualMask8(const uint32_t* ids, __m256i id)
+    {
+        const __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids)), id);
+        return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+    }
+#elif defined(GAMELOGSTORE_SSE2)
+    // SSE2에는 64비트 비교가 없으므로 32비트 비교로 만든다. 반쪽마다 부호 비트를 뒤집으면 부호 없는 비교가 된다.
+    inline __m128i GreaterThanU64(__m128i lhs, __m128i rhs)
+    {
+        const __m128i flip = _mm_set1_epi32(INT32_MIN);
+        lhs = _mm_xor_si128(lhs, flip);
+        rhs = _mm_xor_si128(rhs, flip);
+
+        const __m128i greater = _mm_cmpgt_epi32(lhs, rhs);
+        const __m128i equal = _mm_cmpeq_epi32(lhs, rhs);
+        const __m128i greaterHigh = _mm_shuffle_epi32(greater, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m128i equalHigh = _mm_shuffle_epi32(equal, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m128i greaterLow = _mm_shuffle_epi32(greater, _MM_SHUFFLE(2, 2, 0, 0));
+        return _mm_or_si128(greaterHigh, _mm_and_si128(equalHigh, greaterLow));
+    }
+
+    // 2행
+    inline uint32_t TimeMask2(const uint64_t* times, __m128i from, __m128i span)
+    {
+        const __m128i delta = _mm_sub_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(times)), from);
+        return ~static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(GreaterThanU64(delta, span)))) & 0x3;
+    }
+
+    inline uint32_t EqualMask2(const uint64_t* values, __m128i value)
+    {
+        const __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values)), value);
+        const __m128i both = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(both)));
+    }
+
+    inline uint32_t EqualMask4(const uint32_t* ids, __m128i id)
+    {
+        const __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ids)), id);
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+    }
+#endif
+
+    // [0, count) 중 조건에 맞는 행 번호를 rows 뒤에 붙인다.
+    inline void ScanRows(const Predicate& predicate, const uint64_t* times, const uint64_t* accounts,
+        const uint32_t* types, const uint32_t* codes, size_t count, std::vector<uint32_t>& rows)
+    {
+        size_t i = 0;
+
+#if defined(GAMELOGSTORE_AVX2)
+        const __m256i from = _mm256_set1_epi64x(static_cast<long long>(predicate.timeFrom));
+        const __m256i span = _mm256_set1_epi64x(static_cast<long long>(predicate.timeTo - predicate.timeFrom));
+        const __m256i account = _mm256_set1_epi64x(static_cast<long long>(predicate.accountNo));
+        const __m256i type = _mm256_set1_epi32(static_cast<int>(predicate.typeId));
+        const __m256i code = _mm256_set1_epi32(static_cast<int>(predicate.codeId));
+
+        for (; i + 8 <= count; i += 8) {
+            uint32_t mask = TimeMask4(times + i, from, span) | (TimeMask4(times + i + 4, from, span) << 4);
+            if (predicate.matchAccount)
+                mask &= EqualMask4(accounts + i, account) | (EqualMask4(accounts + i + 4, account) << 4);
+            if (predicate.typeId != ANY_SYMBOL)
+                mask &= EqualMask8(types + i, type);
+            if (predicate.codeId != ANY_SYMBOL)
+                mask &= EqualMask8(codes + i, code);
+            EmitMask(mask, i, rows);
+        }
+#elif defined(GAMELOGSTORE_SSE2)
+        const __m128i from = _mm_set1_epi64x(static_cast<long long>(predicate.timeFrom));
+        const __m128i span = _mm_set1_epi64x(static_cast<long long>(predicate.timeTo - predicate.timeFrom));
+        const __m128i account = _mm_set1_epi64x(static_cast<long long>(predicate.accountNo));
+        const __m128i type = _mm_set1_epi32(static_cast<int>(predicate.typeId));
+        const __m128i code = _mm_set1_epi32(static_cast<int>(predicate.codeId));
+
+        for (; i + 4 <= count; i += 4) {
+            uint32_t mask = TimeMask2(times + i, from, span) | (TimeMask2(times + i + 2, from, span) << 2);
+            if (predicate.matchAccount)
+                mask &= EqualMask2(accounts + i, account) | (EqualMask2(accounts + i + 2, account) << 2);
+            if (predicate.typeId != ANY_SYMBOL)
+                mask &= EqualMask4(types + i, type);
+            if (predicate.codeId != ANY_SYMBOL)
+                mask &= EqualMask4(codes + i, code);
+            EmitMask(mask, i, rows);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            if (MatchesRow(predicate, times[i], accounts[i], types[i], codes[i]))
+                rows.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    // Source(GameLogSegment / GameLogSegmentBuilder)에서 조건에 맞는 행을 out 뒤에 query.limit개까지 붙인다. 붙인 수를 반환한다.
+    template <typename Source>
+    size_t QueryRows(const Source& source, const GameLogQuery& query, std::vector<GameLogStoreRow>& out, GameLogQueryStats& stats)
+    {
+        stats.segments++;
+
+        Predicate predicate;
+        predicate.timeFrom = query.timeFrom;
+        predicate.timeTo = query.timeTo;
+        predicate.matchAccount = query.matchAccount;
+        predicate.accountNo = query.accountNo;
+        predicate.typeId = query.type.empty() ? ANY_SYMBOL : source.FindSymbol(query.type);
+        predicate.codeId = query.code.empty() ? ANY_SYMBOL : source.FindSymbol(query.code);
+
+        if (query.timeFrom > query.timeTo || source.Rows() == 0
+            || query.timeTo < source.MinTime() || query.timeFrom > source.MaxTime()
+            || (query.matchAccount && (query.accountNo < source.MinAccount() || query.accountNo > source.MaxAccount()))
+            || predicate.typeId == NO_SYMBOL || predicate.codeId == NO_SYMBOL) {
+            stats.segmentsSkipped++;
+            return 0;
+        }
+
+        const uint64_t* times = source.Times();
+        const uint64_t* accounts = source.Accounts();
+        const uint32_t* types = source.Types();
+        const uint32_t* codes = source.Codes();
+
+        std::vector<uint32_t> rows;
+        const uint32_t* indexFirst = nullptr;
+        const uint32_t* indexLast = nullptr;
+        if (query.matchAccount && source.FindAccount(query.accountNo, indexFirst, indexLast)) {
+            if (indexFirst == indexLast) {
+                stats.segmentsSkipped++;
+                return 0;
+            }
+
+            for (const uint32_t* row = indexFirst; row != indexLast; ++row) {
+                if (*row < source.Rows() && MatchesRow(predicate, times[*row], accounts[*row], types[*row], codes[*row]))
+                    rows.push_back(*row);
+            }
+            stats.rowsScanned += static_cast<size_t>(indexLast - indexFirst);
+        }
+        else {
+            ScanRows(predicate, times, accounts, types, codes, source.Rows(), rows);
+            stats.rowsScanned += source.Rows();
+        }
+
+        size_t added = 0;
+        for (uint32_t row : rows) {
+            if (query.limit != 0 && added >= query.limit) {
+                break;
+            }
+            GameLogStoreRow& result = out.emplace_back();
+            result.timestamp = times[row];
+            result.log = source.Row(row);
+            result.log.timestamp = times[row];
+            added++;
+        }
+        stats.rowsMatched += added;
+        return added;
+    }
+}
+
+// 메모리에 쌓아둔, 아직 기록하지 않은 세그먼트
+class GameLogSegmentBuilder {
+public:
+    void Add(const GameLog& log, LogTimestamp timestamp)
+    {
+        if (times.empty()) {
+            minTime = maxTime = timestamp;
+            minAccount = maxAccount = log.accountNo;
+        }
+        minTime = std::min(minTime, timestamp);
+        maxTime = std::max(maxTime, timestamp);
+        minAccount = std::min(minAccount, log.accountNo);
+        maxAccount = std::max(maxAccount, log.accountNo);
+
+        times.push_back(timestamp);
+        accounts.push_back(log.accountNo);
+        servers.push_back(Intern(log.server));
+        types.push_back(Intern(log.type));
+        codes.push_back(Intern(log.code));
+        params[0].push_back(log.param1);
+        params[1].push_back(log.param2);
+        params[2].push_back(log.param3);
+        params[3].push_back(log.param4);
+        paramBytes += log.paramStr;
+        paramEnds.push_back(static_cast<uint32_t>(paramBytes.size()));
+    }
+
+    // 용량은 남겨둔다.
+    void Clear(void)
+    {
+        times.clear();
+        accounts.clear();
+        servers.clear();
+        types.clear();
+        codes.clear();
+        for (auto& column : params)
+            column.clear();
+        paramEnds.clear();
+        paramBytes.clear();
+        symbols.clear();
+        symbolIds.clear();
+    }
+
+    // fileName.tmp에 쓴 뒤 이름을 바꾸므로 읽는 쪽은 다 쓰인 파일만 본다.
+    bool Write(const std::wstring& fileName) const
+    {
+        using namespace GameLogSegmentFormat;
+
+        const uint32_t rowCount = static_cast<uint32_t>(times.size());
+
+        // accountNo 인덱스. 같은 accountNo 안에서는 행 순서(대부분 시각 순서)를 유지한다.
+        std::vector<std::pair<uint64_t, uint32_t>> index(rowCount);
+        for (uint32_t row = 0; row < rowCount; ++row)
+            index[row] = { accounts[row], row };
+        std::sort(index.begin(), index.end());
+
+        std::vector<uint64_t> indexAccounts(rowCount);
+        std::vector<uint32_t> indexRows(rowCount);
+        for (uint32_t i = 0; i < rowCount; ++i) {
+            indexAccounts[i] = index[i].first;
+            indexRows[i] = index[i].second;
+        }
+
+        std::vector<uint32_t> symbolEnds;
+        symbolEnds.reserve(symbols.size());
+        std::string symbolText;
+        for (const std::string& symbol : symbols) {
+            symbolText += symbol;
+            symbolEnds.push_back(static_cast<uint32_t>(symbolText.size()));
+        }
+
+        const void* columnData[COLUMN_COUNT] = {
+            times.data(), accounts.data(), servers.data(), types.data(), codes.data(),
+            params[0].data(), params[1].data(), params[2].data(), params[3].data(),
+            paramEnds.data(), paramBytes.data(), symbolEnds.data(), symbolText.data(),
+            indexAccounts.data(), indexRows.data()
+        };
+
+        SegmentHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.rowCount = rowCount;
+        header.symbolCount = static_cast<uint32_t>(symbols.size());
+        header.minTime = minTime;
+        header.maxTime = maxTime;
+        header.minAccount = minAccount;
+        header.maxAccount = maxAccount;
+
+        size_t offset = AlignUp(sizeof(SegmentHeader));
+        for (uint32_t column = 0; column < COLUMN_COUNT; ++column) {
+            size_t bytes = ElementSize(column) * rowCount;
+            if (column == COLUMN_PARAM_BYTES) bytes = paramBytes.size();
+            else if (column == COLUMN_SYMBOL_ENDS) bytes = symbolEnds.size() * 4;
+            else if (column == COLUMN_SYMBOL_BYTES) bytes = symbolText.size();
+
+            header.columns[column] = { offset, bytes };
+            offset = AlignUp(offset + bytes);
+        }
+
+        const std::filesystem::path path(fileName);
+        std::filesystem::path tempPath = path;
+        tempPath += L".tmp";
+
+        {
+            std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+            if (!stream.is_open()) {
+                return false;
+            }
+
+            static const char padding[8] = {};
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            stream.write(padding, static_cast<std::streamsize>(AlignUp(sizeof(header)) - sizeof(header)));
+            for (uint32_t column = 0; column < COLUMN_COUNT; ++column) {
+                const size_t bytes = static_cast<size_t>(header.columns[column].bytes);
+                stream.write(static_cast<const char*>(columnData[column]), static_cast<std::streamsize>(bytes));
+                stream.write(padding, static_cast<std::streamsize>(AlignUp(bytes) - bytes));
+            }
+
+            stream.flush();
+            if (!stream.good()) {
+                stream.close();
+                std::error_code error;
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    // QueryRows가 쓰는 접근자
+    size_t Rows(void) const { return times.size(); }
+    LogTimestamp MinTime(void) const { return minTime; }
+    LogTimestamp MaxTime(void) const { return maxTime; }
+    uint64_t MinAccount(void) const { return minAccount; }
+    uint64_t MaxAccount(void) const { return maxAccount; }
+    const uint64_t* Times(void) const { return times.data(); }
+    const uint64_t* Accounts(void) const { return accounts.data(); }
+    const uint32_t* Types(void) const { return types.data(); }
+    const uint32_t* Codes(void) const { return codes.data(); }
+
+    uint32_t FindSymbol(std::string_view name) const
+    {
+        auto found = symbolIds.find(std::string(name));
+        return found != symbolIds.end() ? found->second : GameLogSegmentFormat::NO_SYMBOL;
+    }
+
+    // 인덱스는 기록할 때 만들므로 여기서는 전체를 비교한다.
+    bool FindAccount(uint64_t, const uint32_t*&, const uint32_t*&) const { return false; }
+
+    GameLog Row(uint32_t row) const
+    {
+        const uint32_t begin = row == 0 ? 0 : paramEnds[row - 1];
+        return GameLog(symbols[servers[row]], symbols[types[row]], symbols[codes[row]], accounts[row],
+            params[0][row], params[1][row], params[2][row], params[3][row], paramBytes.substr(begin, paramEnds[row] - begin));
+    }
+
+private:
+    uint32_t Intern(const std::string& name)
+    {
+        auto found = symbolIds.find(name);
+        if (found != symbolIds.end()) {
+            return found->second;
+        }
+
+        const uint32_t id = static_cast<uint32_t>(symbols.size());
+        symbols.push_back(name);
+        symbolIds.emplace(name, id);
+        return id;
+    }
+
+    std::vector<uint64_t> times;
+    std::vector<uint64_t> accounts;
+    std::vector<uint32_t> servers;
+    std::vector<uint32_t> types;
+    std::vector<uint32_t> codes;
+    std::vector<int32_t> params[4];
+    std::vector<uint32_t> paramEnds;
+    std::string paramBytes;
+
+    std::vector<std::string> symbols;                       // 사전. id -> 문자열
+    std::unordered_map<std::string, uint32_t> symbolIds;
+
+    LogTimestamp minTime = 0;
+    LogTimestamp maxTime = 0;
+    uint64_t minAccount = 0;
+    uint64_t maxAccount = 0;
+};
+
+// 기록된 세그먼트 하나. 파일을 매핑한 채로 열을 그대로 읽는다.
+class GameLogSegment {
+public:
+    // 머리와 열의 범위가 맞지 않는 파일이면 false
+    bool Open(const std::wstring& fileName)
+    {
+        using namespace GameLogSegmentFormat;
+
+        if (!file.Open(fileName) || file.Size() < sizeof(SegmentHeader)) {
+            return false;
+        }
+
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            return false;
+        }
+
+        for (uint32_t column = 0; column < COLUMN_COUNT; ++column) {
+            const ColumnRange& range = header.columns[column];
+            if (range.offset % 8 != 0 || range.offset > file.Size() || range.bytes > file.Size() - range.offset) {
+                return false;
+            }
+
+            size_t expected = ElementSize(column) * header.rowCount;
+            if (column == COLUMN_SYMBOL_ENDS) expected = static_cast<size_t>(header.symbolCount) * 4;
+            if (ElementSize(column) != 0 && range.bytes != expected) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t Rows(void) const { return header.rowCount; }
+    LogTimestamp MinTime(void) const { return header.minTime; }
+    LogTimestamp MaxTime(void) const { return header.maxTime; }
+    uint64_t MinAccount(void) const { return header.minAccount; }
+    uint64_t MaxAccount(void) const { return header.maxAccount; }
+    const uint64_t* Times(void) const { return Column<uint64_t>(GameLogSegmentFormat::COLUMN_TIME); }
+    const uint64_t* Accounts(void) const { return Column<uint64_t>(GameLogSegmentFormat::COLUMN_ACCOUNT); }
+    const uint32_t* Types(void) const { return Column<uint32_t>(GameLogSegmentFormat::COLUMN_TYPE); }
+    const uint32_t* Codes(void) const { return Column<uint32_t>(GameLogSegmentFormat::COLUMN_CODE); }
+
+    // 사전은 세그먼트마다 수십 개 정도이므로 차례로 찾는다.
+    uint32_t FindSymbol(std::string_view name) const
+    {
+        for (uint32_t id = 0; id < header.symbolCount; ++id) {
+            if (Symbol(id) == name) {
+                return id;
+            }
+        }
+        return GameLogSegmentFormat::NO_SYMBOL;
+    }
+
+    // accountNo의 행 번호 범위 [first, last). 없으면 first == last
+    bool FindAccount(uint64_t accountNo, const uint32_t*& first, const uint32_t*& last) const
+    {
+        using namespace GameLogSegmentFormat;
+
+        const uint64_t* accounts = Column<uint64_t>(COLUMN_INDEX_ACCOUNTS);
+        const uint32_t* rows = Column<uint32_t>(COLUMN_INDEX_ROWS);
+        const auto range = std::equal_range(accounts, accounts + header.rowCount, accountNo);
+        first = rows + (range.first - accounts);
+        last = rows + (range.second - accounts);
+        return true;
+    }
+
+    GameLog Row(uint32_t row) const
+    {
+        using namespace GameLogSegmentFormat;
+
+        const uint32_t* paramEnds = Column<uint32_t>(COLUMN_PARAM_ENDS);
+        return GameLog(std::string(Symbol(Column<uint32_t>(COLUMN_SERVER)[row])), std::string(Symbol(Column<uint32_t>(COLUMN_TYPE)[row])),
+            std::string(Symbol(Column<uint32_t>(COLUMN_CODE)[row])), Column<uint64_t>(COLUMN_ACCOUNT)[row],
+            Column<int32_t>(COLUMN_PARAM1)[row], Column<int32_t>(COLUMN_PARAM2)[row], Column<int32_t>(COLUMN_PARAM3)[row], Column<int32_t>(COLUMN_PARAM4)[row],
+            std::string(Bytes(COLUMN_PARAM_BYTES, row == 0 ? 0 : paramEnds[row - 1], paramEnds[row])));
+    }
+
+private:
+    template <typename T>
+    const T* Column(uint32_t column) const
+    {
+        return reinterpret_cast<const T*>(file.Data() + header.columns[column].offset);
+    }
+
+    // 바이트 열의 [begin, end). 범위가 맞지 않으면 (손상된 파일) 빈 문자열
+    std::string_view Bytes(uint32_t column, uint32_t begin, uint32_t end) const
+    {
+        if (begin > end || end > header.columns[column].bytes) {
+            return {};
+        }
+        return std::string_view(reinterpret_cast<const char*>(file.Data() + header.columns[column].offset) + begin, end - begin);
+    }
+
+    std::string_view Symbol(uint32_t id) const
+    {
+        using namespace GameLogSegmentFormat;
+
+        if (id >= header.symbolCount) {
+            return {};
+        }
+        const uint32_t* ends = Column<uint32_t>(COLUMN_SYMBOL_ENDS);
+        return Bytes(COLUMN_SYMBOL_BYTES, id == 0 ? 0 : ends[id - 1], ends[id]);
+    }
+
+    MappedFile file;
+    GameLogSegmentFormat::SegmentHeader header = {};
+};
+
+// 세그먼트 파일들과 아직 기록하지 않은 로그. Append / Seal / Query는 여러 스레드에서 불러도 된다.
+class GameLogStore {
+public:
+    static constexpr size_t DEFAULT_SEGMENT_ROWS = 64 * 1024;
+
+    // directory에 이미 있는 세그먼트는 모두 열고, 그 다음 번호부터 새 세그먼트를 쓴다.
+    explicit GameLogStore(const std::wstring& directory, size_t segmentRows = DEFAULT_SEGMENT_ROWS)
+        : directory(directory), segmentRows(segmentRows != 0 ? segmentRows : DEFAULT_SEGMENT_ROWS)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(directory), error);
+
+        std::vector<std::pair<uint32_t, std::filesystem::path>> found;
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(directory), error)) {
+            const std::wstring name = entry.path().filename().wstring();
+            unsigned int number = 0;
+            if (name.size() == 18 && name.compare(0, 8, L"segment_") == 0 && name.compare(14, 4, L".gls") == 0
+                && std::swscanf(name.c_str() + 8, L"%6u", &number) == 1) {
+                found.emplace_back(number, entry.path());
+            }
+            else if (entry.path().extension() == L".tmp") {
+                // 쓰는 도중에 끝난 세그먼트
+                std::filesystem::remove(entry.path(), error);
+            }
+        }
+        std::sort(found.begin(), found.end());
+
+        for (const auto& [number, path] : found) {
+            auto segment = std::make_shared<GameLogSegment>();
+            if (segment->Open(path.wstring())) {
+                segments.push_back(std::move(segment));
+            }
+            nextSegmentNumber = number + 1;
+        }
+    }
+
+    // 남은 로그를 세그먼트로 기록한다.
+    ~GameLogStore(void) { Seal(); }
+
+    GameLogStore(const GameLogStore&) = delete;
+    GameLogStore& operator=(const GameLogStore&) = delete;
+
+    bool Append(const GameLog& log, LogTimestamp timestamp = LogClockNow())
+    {
+        return Append(&log, 1, timestamp);
+    }
+
+    // 쌓인 로그가 segmentRows를 넘었다면 먼저 세그먼트로 기록한다.
+    // 기록에 실패하면 logs는 넣지 않고 false (GameLogSink::WriteBatch와 같이 다시 보내면 된다)
+    bool Append(const GameLog* logs, size_t count, LogTimestamp timestamp)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (builder.Rows() >= segmentRows && !SealLocked()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            builder.Add(logs[i], timestamp);
+        return true;
+    }
+
+    // 각 로그의 timestamp로 넣는다. timestamp가 0인 로그(파이프라인을 거치지 않은 로그)는 지금 시각.
+    bool Append(const GameLog* logs, size_t count)
+    {
+        const LogTimestamp now = LogClockNow();
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (builder.Rows() >= segmentRows && !SealLocked()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            builder.Add(logs[i], logs[i].timestamp != 0 ? logs[i].timestamp : now);
+        return true;
+    }
+
+    // 쌓인 로그를 바로 세그먼트로 기록한다.
+    bool Seal(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return SealLocked();
+    }
+
+    // 조건에 맞는 로그를 세그먼트 순서(기록한 순서)대로 out 뒤에 붙인다. 아직 기록하지 않은 로그도 포함한다.
+    size_t Query(const GameLogQuery& query, std::vector<GameLogStoreRow>& out, GameLogQueryStats* stats = nullptr) const
+    {
+        GameLogQueryStats localStats;
+        GameLogQueryStats& counters = stats != nullptr ? *stats : localStats;
+
+        std::vector<std::shared_ptr<const GameLogSegment>> snapshot;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            snapshot = segments;
+        }
+
+        // 세그먼트는 바뀌지 않으므로 lock 없이 읽는다.
+        const size_t before = out.size();
+        for (const auto& segment : snapshot) {
+            if (query.limit != 0 && out.size() - before >= query.limit) {
+                return out.size() - before;
+            }
+            GameLogScan::QueryRows(*segment, LimitFrom(query, out.size() - before), out, counters);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (query.limit == 0 || out.size() - before < query.limit) {
+            GameLogScan::QueryRows(builder, LimitFrom(query, out.size() - before), out, counters);
+        }
+        return out.size() - before;
+    }
+
+    size_t SegmentCount(void) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return segments.size();
+    }
+
+private:
+    // 세그먼트마다 남은 limit만큼만 찾는다.
+    static GameLogQuery LimitFrom(const GameLogQuery& query, size_t found)
+    {
+        GameLogQuery copy = query;
+        copy.limit = query.limit == 0 ? 0 : query.limit - found;
+        return copy;
+    }
+
+    bool SealLocked(void)
+    {
+        if (builder.Rows() == 0) {
+            return true;
+        }
+
+        wchar_t name[32];
+        std::swprintf(name, sizeof(name) / sizeof(wchar_t), L"segment_%06u.gls", nextSegmentNumber);
+        const std::wstring fileName = (std::filesystem::path(directory) / name).wstring();
+
+        if (!builder.Write(fileName)) {
+            return false;
+        }
+        nextSegmentNumber++;
+
+        auto segment = std::make_shared<GameLogSegment>();
+        if (segment->Open(fileName)) {
+            segments.push_back(std::move(segment));
+        }
+        builder.Clear();
+        return true;
+    }
+
+    const std::wstring directory;
+    const size_t segmentRows;
+
+    mutable std::mutex lock;
+    GameLogSegmentBuilder builder;                                  // lock으로 보호
+    std::vector<std::shared_ptr<const GameLogSegment>> segments;    // lock으로 보호
+    uint32_t nextSegmentNumber = 1;
+};
+
+// 파이프라인의 배치를 GameLogStore에 넣는 sink. 시각은 GameLogPipeline::Submit이 채운 GameLog::timestamp다.
+// (재시도하거나 저널에서 다시 보낸 로그도 처음 넣은 시각으로 남는다)
+class GameLogStoreSink : public GameLogSink {
+public:
+    explicit GameLogStoreSink(std::shared_ptr<GameLogStore> store) : store(std::move(store)) {}
+
+    bool WriteBatch(const GameLog* logs, size_t count) override
+    {
+        return store->Append(logs, count);
+    }
+
+private:
+    std::shared_ptr<GameLogStore> store;
+};
@@ -0,0 +1,363 @@
+﻿#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// HEXDUMP_NO_SIMD를 정의하면 스칼라 경로만 쓴다. (HexDumpCheckScalar)
+#if !defined(HEXDUMP_NO_SIMD) && (defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define HEXDUMP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(HEXDUMP_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#define HEXDUMP_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(HEXDUMP_SSSE3) && defined(__AVX2__)
+#define HEXDUMP_AVX2 1
+#include <immintrin.h>
+#endif
+
+// LogHex와 소스.cpp의 HexDump가 함께 쓰는 헥스 덤프 변환기. 한 줄의 형식은 다음과 같다.
+//
+//     00000010: 48 65 6c 6c 6f 2c 20 00 00 00 00 00 00 00 00 00  | Hello, .........
+//
+// 주소(8자리 이상 소문자 16진수) ": " / 바이트마다 "xx " (데이터가 없는 칸은 "   ") / " | " /
+// 출력 가능한 ASCII(0x20 ~ 0x7E)는 그대로, 나머지는 '.' (데이터가 없는 칸은 ' ') / "\n"
+//
+// 16바이트 한 줄을 SSE2(또는 SSSE3 / AVX2)로 한 번에 변환해서 미리 크기를 잡아둔 버퍼에 바로 쓴다.
+// 컴파일 옵션에서 쓸 수 있는 명령어 집합을 고르며, x86이 아니라면 스칼라 코드로 같은 결과를 낸다.
+
+constexpr size_t HEX_DUMP_BYTES_PER_LINE = 16;
+
+namespace HexDumpDetail {
+    constexpr size_t HEX_COLUMN_LENGTH = HEX_DUMP_BYTES_PER_LINE * 3;    // "xx " * 16
+    constexpr size_t SEPARATOR_LENGTH = 3;                              // " | "
+    constexpr size_t MAX_LINE_LENGTH = 16 + 2 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH + HEX_DUMP_BYTES_PER_LINE + 1;
+
+    inline constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+    // 잘린 덤프의 가운데 줄 "... N bytes omitted ..." (HexDumpParser도 이 형식으로 찾는다)
+    inline constexpr char OMITTED_PREFIX[] = "... ";
+    inline constexpr char OMITTED_SUFFIX[] = " bytes omitted ...";
+    constexpr size_t OMITTED_PREFIX_LENGTH = sizeof(OMITTED_PREFIX) - 1;
+    constexpr size_t OMITTED_SUFFIX_LENGTH = sizeof(OMITTED_SUFFIX) - 1;
+
+    // std::setw(8) << std::setfill('0') << std::hex 와 같은 주소 자릿수
+    inline size_t AddressLength(uint64_t offset)
+    {
+        size_t digits = 8;
+        while (digits < 16 && (offset >> (digits * 4)) != 0)
+            ++digits;
+        return digits;
+    }
+
+    inline char* WriteAddress(char* out, uint64_t offset, size_t digits)
+    {
+        for (size_t i = 0; i < digits; ++i)
+            out[i] = HEX_DIGITS[(offset >> ((digits - 1 - i) * 4)) & 0xF];
+        out += digits;
+        *out++ = ':';
+        *out++ = ' ';
+        return out;
+    }
+
+    inline void ConvertRowScalar(const uint8_t* src, char* hex, char* ascii)
+    {
+        for (size_t i = 0; i < HEX_DUMP_BYTES_PER_LINE; ++i) {
+            const uint8_t byte = src[i];
+            hex[i * 3] = HEX_DIGITS[byte >> 4];
+            hex[i * 3 + 1] = HEX_DIGITS[byte & 0xF];
+            hex[i * 3 + 2] = ' ';
+            ascii[i] = (byte >= 0x20 && byte <= 0x7E) ? static_cast<char>(byte) : '.';
+        }
+    }
+
+#if defined(HEXDUMP_SSE2)
+    // 니블(0 ~ 15) -> '0' ~ '9', 'a' ~ 'f'
+    inline __m128i NibbleToHex(__m128i nibbles)
+    {
+        const __m128i over9 = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+        const __m128i base = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+        return _mm_add_epi8(base, _mm_and_si128(over9, _mm_set1_epi8('a' - '0' - 10)));
+    }
+
+    // 0x20 ~ 0x7E는 그대로, 나머지는 '.'
+    // 부호 있는 비교이므로 0x80 이상의 바이트는 음수로 보여 자연스럽게 걸러진다.
+    inline __m128i PrintableMask(__m128i bytes)
+    {
+        const __m128i printable = _mm_and_si128(
+            _mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)),
+            _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+        return _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+    }
+#endif
+
+#if defined(HEXDUMP_SSSE3)
+    // 바이트 쌍 순서로 늘어놓은 헥스 문자(hi0 lo0 hi1 lo1 ...) 32개를 "xx " 16개(48자)로 펼치는 셔플 마스크.
+    // -1 자리는 0이 되고 나중에 ' '와 OR 된다. (앞 16바이트 = 0 ~ 7번 바이트, 뒤 16바이트 = 8 ~ 15번 바이트)
+    alignas(16) inline constexpr int8_t SPREAD_CHUNK0[16] = { 0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7, -1, 8, 9, -1, 10 };
+    alignas(16) inline constexpr int8_t SPREAD_CHUNK1_LOW[16] = { 11, -1, 12, 13, -1, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+    alignas(16) inline constexpr int8_t SPREAD_CHUNK1_HIGH[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, 2, 3, -1, 4, 5 };
+    alignas(16) inline constexpr int8_t SPREAD_CHUNK2[16] = { -1, 6, 7, -1, 8, 9, -1, 10, 11, -1, 12, 13, -1, 14, 15, -1 };
+    alignas(16) inline constexpr int8_t SPACE_CHUNK0[16] = { 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0 };
+    alignas(16) inline constexpr int8_t SPACE_CHUNK1[16] = { 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0 };
+    alignas(16) inline constexpr int8_t SPACE_CHUNK2[16] = { ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ' };
+
+    inline __m128i LoadMask(const int8_t* mask)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+    }
+#endif
+
+#if defined(HEXDUMP_AVX2)
+    inline __m256i BroadcastMask(const int8_t* mask)
+    {
+        return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(mask)));
+    }
+
+    // 두 줄(32바이트)을 한 번에 변환한다. 256비트 셔플은 128비트 lane 단위로 동작하므로 lane 하나가 한 줄이다.
+    inline void ConvertTwoRowsAvx2(const uint8_t* src, char* hex0, char* ascii0, char* hex1, char* ascii1)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        const __m256i lowMask = _mm256_set1_epi8(0x0F);
+        const __m256i hexTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS)));
+
+        const __m256i high = _mm256_shuffle_epi8(hexTable, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), lowMask));
+        const __m256i low = _mm256_shuffle_epi8(hexTable, _mm256_and_si256(bytes, lowMask));
+
+        const __m256i pairs0 = _mm256_unpacklo_epi8(high, low);     // 각 줄의 0 ~ 7번 바이트
+        const __m256i pairs1 = _mm256_unpackhi_epi8(high, low);     // 각 줄의 8 ~ 15번 바이트
+
+        const __m256i chunk0 = _mm256_or_si256(_mm256_shuffle_epi8(pairs0, BroadcastMask(SPREAD_CHUNK0)), BroadcastMask(SPACE_CHUNK0));
+        const __m256i chunk1 = _mm256_or_si256(
+            _mm256_or_si256(_mm256_shuffle_epi8(pairs0, BroadcastMask(SPREAD_CHUNK1_LOW)), _mm256_shuffle_epi8(pairs1, BroadcastMask(SPREAD_CHUNK1_HIGH))),
+            BroadcastMask(SPACE_CHUNK1));
+        const __m256i chunk2 = _mm256_or_si256(_mm256_shuffle_epi8(pairs1, BroadcastMask(SPREAD_CHUNK2)), BroadcastMask(SPACE_CHUNK2));
+
+        const __m256i printable = _mm256_and_si256(
+            _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(0x1F)),
+            _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7F), bytes));
+        const __m256i ascii = _mm256_blendv_epi8(_mm256_set1_epi8('.'), bytes, printable);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex0), _mm256_castsi256_si128(chunk0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex0 + 16), _mm256_castsi256_si128(chunk1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex0 + 32), _mm256_castsi256_si128(chunk2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ascii0), _mm256_castsi256_si128(ascii));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex1), _mm256_extracti128_si256(chunk0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex1 + 16), _mm256_extracti128_si256(chunk1, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex1 + 32), _mm256_extracti128_si256(chunk2, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ascii1), _mm256_extracti128_si256(ascii, 1));
+    }
+#endif
+
+    // 16바이트 한 줄의 헥스 칸(48자)과 ASCII 칸(16자)을 채운다.
+    inline void ConvertRow(const uint8_t* src, char* hex, char* ascii)
+    {
+#if defined(HEXDUMP_SSE2)
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        const __m128i lowMask = _mm_set1_epi8(0x0F);
+
+        const __m128i high = NibbleToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask));
+        const __m128i low = NibbleToHex(_mm_and_si128(bytes, lowMask));
+
+        const __m128i pairs0 = _mm_unpacklo_epi8(high, low);
+        const __m128i pairs1 = _mm_unpackhi_epi8(high, low);
+
+#if defined(HEXDUMP_SSSE3)
+        const __m128i chunk0 = _mm_or_si128(_mm_shuffle_epi8(pairs0, LoadMask(SPREAD_CHUNK0)), LoadMask(SPACE_CHUNK0));
+        const __m128i chunk1 = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(pairs0, LoadMask(SPREAD_CHUNK1_LOW)), _mm_shuffle_epi8(pairs1, LoadMask(SPREAD_CHUNK1_HIGH))),
+            LoadMask(SPACE_CHUNK1));
+        const __m128i chunk2 = _mm_or_si128(_mm_shuffle_epi8(pairs1, LoadMask(SPREAD_CHUNK2)), LoadMask(SPACE_CHUNK2));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex), chunk0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 16), chunk1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 32), chunk2);
+#else
+        // SSE2에는 바이트 셔플이 없으므로 "xx" 쌍을 2바이트씩 옮기고 사이에 ' '를 넣는다.
+        alignas(16) char pairs[32];
+        _mm_store_si128(reinterpret_cast<__m128i*>(pairs), pairs0);
+        _mm_store_si128(reinterpret_cast<__m128i*>(pairs + 16), pairs1);
+        for (size_t i = 0; i < HEX_DUMP_BYTES_PER_LINE; ++i) {
+            std::memcpy(hex + i * 3, pairs + i * 2, 2);
+            hex[i * 3 + 2] = ' ';
+        }
+#endif
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ascii), PrintableMask(bytes));
+#else
+        ConvertRowScalar(src, hex, ascii);
+#endif
+    }
+
+    // 한 줄을 out에 쓰고 끝 위치를 반환한다. 마지막 줄처럼 count가 16보다 작으면 남는 칸을 공백으로 채운다.
+    inline char* WriteRow(char* out, uint64_t offset, const uint8_t* src, size_t count)
+    {
+        out = WriteAddress(out, offset, AddressLength(offset));
+
+        char* hex = out;
+        char* ascii = out + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH;
+
+        if (count == HEX_DUMP_BYTES_PER_LINE) {
+            ConvertRow(src, hex, ascii);
+        }
+        else {
+            uint8_t padded[HEX_DUMP_BYTES_PER_LINE] = {};
+            std::memcpy(padded, src, count);
+            ConvertRow(padded, hex, ascii);
+            std::memset(hex + count * 3, ' ', (HEX_DUMP_BYTES_PER_LINE - count) * 3);
+            std::memset(ascii + count, ' ', HEX_DUMP_BYTES_PER_LINE - count);
+        }
+
+        std::memcpy(hex + HEX_COLUMN_LENGTH, " | ", SEPARATOR_LENGTH);
+        ascii[HEX_DUMP_BYTES_PER_LINE] = '\n';
+        return ascii + HEX_DUMP_BYTES_PER_LINE + 1;
+    }
+
+    // data의 [offset, end) 구간을 줄 단위로 dest에 쓰고 끝 위치를 반환한다. offset은 16의 배수여야 한다.
+    // 주소는 baseAddress + offset (잘라낸 버퍼의 뒷부분처럼 data가 원래 버퍼의 중간부터일 때. 16의 배수)
+    inline char* WriteRows(char* dest, const uint8_t* data, size_t offset, size_t end, uint64_t baseAddress = 0)
+    {
+#if defined(HEXDUMP_AVX2)
+        for (; offset + 2 * HEX_DUMP_BYTES_PER_LINE <= end; offset += 2 * HEX_DUMP_BYTES_PER_LINE) {
+            const uint64_t address = baseAddress + offset;
+            char* row0 = WriteAddress(dest, address, AddressLength(address));
+            char* row1 = row0 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH + HEX_DUMP_BYTES_PER_LINE + 1;
+            row1 = WriteAddress(row1, address + HEX_DUMP_BYTES_PER_LINE, AddressLength(address + HEX_DUMP_BYTES_PER_LINE));
+
+            char* ascii0 = row0 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH;
+            char* ascii1 = row1 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH;
+            ConvertTwoRowsAvx2(data + offset, row0, ascii0, row1, ascii1);
+
+            std::memcpy(row0 + HEX_COLUMN_LENGTH, " | ", SEPARATOR_LENGTH);
+            std::memcpy(row1 + HEX_COLUMN_LENGTH, " | ", SEPARATOR_LENGTH);
+            ascii0[HEX_DUMP_BYTES_PER_LINE] = '\n';
+            ascii1[HEX_DUMP_BYTES_PER_LINE] = '\n';
+            dest = ascii1 + HEX_DUMP_BYTES_PER_LINE + 1;
+        }
+#endif
+
+        for (; offset < end; offset += HEX_DUMP_BYTES_PER_LINE) {
+            const size_t count = (end - offset < HEX_DUMP_BYTES_PER_LINE) ? end - offset : HEX_DUMP_BYTES_PER_LINE;
+            dest = WriteRow(dest, baseAddress + offset, data + offset, count);
+        }
+        return dest;
+    }
+
+    // ASCII만 들어있는 char 배열을 CharT로 넓힌다.
+    template <typename CharT>
+    inline void Widen(const char* src, size_t length, CharT* out)
+    {
+        size_t i = 0;
+#if defined(HEXDUMP_SSE2)
+        if constexpr (sizeof(CharT) == 2) {
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= length; i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+            }
+        }
+#endif
+        for (; i < length; ++i)
+            out[i] = static_cast<CharT>(static_cast<unsigned char>(src[i]));
+    }
+}
+
+// size 바이트를 덤프했을 때의 문자 수. baseAddress는 첫 줄의 주소 (16의 배수)
+inline size_t HexDumpLength(size_t size, uint64_t baseAddress = 0)
+{
+    using namespace HexDumpDetail;
+
+    const size_t fixedLength = 2 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH + HEX_DUMP_BYTES_PER_LINE + 1;
+    const size_t lines = (size + HEX_DUMP_BYTES_PER_LINE - 1) / HEX_DUMP_BYTES_PER_LINE;
+    if (lines == 0) {
+        return 0;
+    }
+
+    size_t length = lines * (8 + fixedLength);
+
+    // 주소가 8자리를 넘는 줄 (4GB 이상)
+    const uint64_t lastAddress = baseAddress + (lines - 1) * HEX_DUMP_BYTES_PER_LINE;
+    for (uint64_t boundary = 0x100000000ull; boundary <= lastAddress && boundary != 0; boundary <<= 4) {
+        const uint64_t shorterLines = boundary > baseAddress ? (boundary - baseAddress) / HEX_DUMP_BYTES_PER_LINE : 0;
+        length += lines - static_cast<size_t>(shorterLines);
+    }
+    return length;
+}
+
+// data의 헥스 덤프를 out 뒤에 붙인다. 필요한 크기를 먼저 계산해서 한 번만 늘린다.
+// baseAddress : 첫 줄의 주소 (16의 배수). 잘라낸 버퍼의 뒷부분을 원래 위치의 주소로 보일 때 쓴다.
+template <typename CharT, typename Traits, typename Allocator>
+inline void AppendHexDump(std::basic_string<CharT, Traits, Allocator>& out, const void* data, size_t size, uint64_t baseAddress = 0)
+{
+    using namespace HexDumpDetail;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const size_t oldSize = out.size();
+    out.resize(oldSize + HexDumpLength(size, baseAddress));
+    CharT* cursor = out.data() + oldSize;
+
+    if constexpr (sizeof(CharT) == 1) {
+        WriteRows(reinterpret_cast<char*>(cursor), bytes, 0, size, baseAddress);
+    }
+    else {
+        // CHUNK_LINES 줄씩 char 버퍼에 만든 뒤 넓혀서 옮긴다.
+        constexpr size_t CHUNK_LINES = 64;
+        char chunk[CHUNK_LINES * MAX_LINE_LENGTH];
+
+        for (size_t offset = 0; offset < size; offset += CHUNK_LINES * HEX_DUMP_BYTES_PER_LINE) {
+            const size_t end = (size - offset < CHUNK_LINES * HEX_DUMP_BYTES_PER_LINE) ? size : offset + CHUNK_LINES * HEX_DUMP_BYTES_PER_LINE;
+            const size_t length = static_cast<size_t>(WriteRows(chunk, bytes, offset, end, baseAddress) - chunk);
+            Widen(chunk, length, cursor);
+            cursor += length;
+        }
+    }
+}
+
+// 앞 / 뒤만 남긴 버퍼의 헥스 덤프. 가운데는 "... N bytes omitted ..." 한 줄이 되고, 뒷부분의 주소는 원래 버퍼의 위치다.
+// head : 버퍼의 처음 headBytes (16의 배수), tail : 버퍼의 마지막 tailBytes (totalBytes - tailBytes가 16의 배수)
+// headBytes + tailBytes == totalBytes라면 AppendHexDump와 같다.
+template <typename CharT, typename Traits, typename Allocator>
+inline void AppendTruncatedHexDump(std::basic_string<CharT, Traits, Allocator>& out, const void* head, size_t headBytes,
+    const void* tail, size_t tailBytes, uint64_t totalBytes)
+{
+    using namespace HexDumpDetail;
+
+    AppendHexDump(out, head, headBytes);
+
+    const uint64_t omitted = totalBytes - headBytes - tailBytes;
+    if (omitted > 0) {
+        // writer 스레드에서 불리므로 힙을 쓰지 않고 스택에서 만든다.
+        char line[OMITTED_PREFIX_LENGTH + 20 + OMITTED_SUFFIX_LENGTH + 1];
+        std::memcpy(line, OMITTED_PREFIX, OMITTED_PREFIX_LENGTH);
+        char* cursor = std::to_chars(line + OMITTED_PREFIX_LENGTH, line + OMITTED_PREFIX_LENGTH + 20, omitted).ptr;
+        std::memcpy(cursor, OMITTED_SUFFIX, OMITTED_SUFFIX_LENGTH);
+        cursor += OMITTED_SUFFIX_LENGTH;
+        *cursor++ = '\n';
+        out.append(line, cursor);
+    }
+
+    AppendHexDump(out, tail, tailBytes, totalBytes - tailBytes);
+}
+
+// maxBytes에 맞춰 버퍼의 앞 / 뒤 중 남길 길이를 정한다. 둘 다 16바이트 줄 경계에 맞추며, 합은 maxBytes를 넘지 않는다.
+// maxBytes가 0이거나 length가 maxBytes 이하라면 모두 남긴다. (headBytes = length, tailBytes = 0)
+inline void HexDumpTruncation(size_t length, size_t maxBytes, size_t& headBytes, size_t& tailBytes)
+{
+    if (maxBytes == 0 || length <= maxBytes) {
+        headBytes = length;
+        tailBytes = 0;
+        return;
+    }
+
+    headBytes = (maxBytes / 2) / HEX_DUMP_BYTES_PER_LINE * HEX_DUMP_BYTES_PER_LINE;
+    const size_t tailStart = (length - (maxBytes - headBytes) + HEX_DUMP_BYTES_PER_LINE - 1) / HEX_DUMP_BYTES_PER_LINE * HEX_DUMP_BYTES_PER_LINE;
+    tailBytes = tailStart < length ? length - tailStart : 0;
+}
@@ -0,0 +1,198 @@
+﻿#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HexDump.h"
+#include "HexDumpParser.h"
+
+// 헥스 덤프 점검. (LogManager --hex-check, HexDumpCheckScalar / SSE2 / SSSE3 / AVX2)
+// HexDump.h / HexDumpParser.h는 빌드 옵션에 따라 SIMD 경로가 정해지므로, CMake가 이 파일을 경로마다 따로 빌드한다.
+// HEXDUMP_CHECK_MAIN이 정의되면 점검만 하는 실행 파일이 되고, 아니면 LogManager에 RunHexCheck를 넘겨준다.
+
+namespace {
+    // 덤프를 HexDumpParser에 넘기는 조각 크기. 한 번에 / 한 글자씩 / 줄(16바이트 줄은 75자 이상) 중간에서 끊기는 크기
+    constexpr size_t FEED_CHUNKS[] = { SIZE_MAX, 1, 7, 64, 4096 };
+
+    const char* HexDumpLevelName(void)
+    {
+#if defined(HEXDUMP_AVX2)
+        return "AVX2";
+#elif defined(HEXDUMP_SSSE3)
+        return "SSSE3";
+#elif defined(HEXDUMP_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    template <typename Parser>
+    void FeedInChunks(Parser& parser, const std::string& text, size_t chunk)
+    {
+        for (size_t offset = 0; offset < text.size(); offset += chunk) {
+            parser.Feed(text.data() + offset, std::min(chunk, text.size() - offset));
+        }
+        parser.Finish();
+    }
+}
+
+// HexDump.h의 변환기(이 빌드가 고른 SSE2 / SSSE3 / AVX2 또는 스칼라 경로)가 예전 LogHex의 스트림 코드와 같은 줄을 만드는지 확인한다.
+// 만든 덤프는 HexDumpParser로 조각 크기를 바꿔가며 되돌려서 원래 바이트와 비교한다.
+// 크기마다 0 ~ 255가 모두 나오는 임의의 바이트를 정렬이 다른 16가지 위치에서, char / wchar_t 출력으로 비교한다.
+// 예전 코드는 char를 그대로 int로 넓혀서 0x80 이상의 바이트를 "ffffff80"처럼 찍었으므로, 기준은 바이트를 unsigned로 읽도록만 고쳤다.
+std::string OldHexDump(const char* data, size_t size, uint64_t baseAddress)
+{
+    const size_t bytesPerLine = 16;
+
+    std::ostringstream logLine;
+    for (size_t i = 0; i < size; i += bytesPerLine) {
+        logLine << std::setw(8) << std::setfill('0') << std::hex << baseAddress + i << ": ";
+
+        for (size_t j = 0; j < bytesPerLine; ++j) {
+            if (i + j < size)
+                logLine << std::setw(2) << static_cast<int>(static_cast<unsigned char>(data[i + j])) << " ";
+            else
+                logLine << "   ";
+        }
+
+        logLine << " | ";
+        for (size_t j = 0; j < bytesPerLine; ++j) {
+            if (i + j < size) {
+                unsigned char ch = data[i + j];
+                logLine << (std::isprint(ch) ? static_cast<char>(ch) : '.');
+            }
+            else {
+                logLine << " ";
+            }
+        }
+        logLine << "\n";
+    }
+    return logLine.str();
+}
+
+int RunHexCheck(void)
+{
+    std::printf("hex check: %s\n", HexDumpLevelName());
+
+    constexpr size_t sizes[] = { 0, 1, 15, 16, 17, 299 };
+    constexpr uint64_t baseAddresses[] = { 0, 0x100000000ull };     // 8자리를 넘는 주소 (잘라낸 덤프의 뒷부분)
+
+    std::mt19937 random(20261017);
+    std::vector<char> buffer(299 + 16);
+
+    bool passed = true;
+    for (size_t size : sizes) {
+        int mismatches = 0;
+        for (size_t offset = 0; offset < 16; ++offset) {
+            for (size_t i = 0; i < buffer.size(); ++i)
+                buffer[i] = static_cast<char>(random());
+            const char* data = buffer.data() + offset;
+
+            for (uint64_t baseAddress : baseAddresses) {
+                const std::string expected = OldHexDump(data, size, baseAddress);
+
+                std::string narrow;
+                AppendHexDump(narrow, data, size, baseAddress);
+
+                std::wstring wide;
+                AppendHexDump(wide, data, size, baseAddress);
+
+                const bool ok = narrow == expected && wide == std::wstring(expected.begin(), expected.end()) &&
+                    HexDumpLength(size, baseAddress) == expected.size();
+                mismatches += ok ? 0 : 1;
+            }
+
+            // 같은 덤프를 HexDumpParser로 되돌린다. 주소 0부터 시작하는 덤프만 블록이 된다.
+            std::string text = "[HexCheck] packet\n";
+            AppendHexDump(text, data, size, 0);
+            text += "[HexCheck] next\n";
+            for (size_t chunk : FEED_CHUNKS) {
+                uint64_t blocks = 0;
+                bool ok = true;
+                auto check = [&](const HexDumpBlock& block) {
+                    blocks++;
+                    ok &= block.header == "[HexCheck] packet" && block.size == size && block.asciiMismatches == 0 &&
+                        block.omittedBytes == 0 && std::memcmp(block.data, data, size) == 0;
+                };
+                HexDumpParser<decltype(check)> parser(check);
+                FeedInChunks(parser, text, chunk);
+                mismatches += ok && blocks == (size > 0 ? 1 : 0) && parser.GetBadRowCount() == 0 ? 0 : 1;
+            }
+        }
+
+        std::printf("hex check (%zu bytes): %d mismatches -> %s\n", size, mismatches, mismatches == 0 ? "OK" : "FAILED");
+        passed &= mismatches == 0;
+    }
+
+    // 잘린 덤프(앞 / 뒤만 남기고 가운데는 "... N bytes omitted ..." 한 줄)를 HexDumpParser가 한 블록으로 되돌리는지 확인한다.
+    // { 버퍼 크기, LogHex 최대 바이트 } : 앞부분이 없는 경우(최대 16바이트)와 잘리지 않는 경우를 포함
+    constexpr size_t truncations[][2] = { { 1000, 256 }, { 1000, 16 }, { 40, 16 }, { 300, 64 }, { 4099, 1000 }, { 64, 64 } };
+    for (const auto& [size, maxBytes] : truncations) {
+        std::vector<uint8_t> data(size);
+        for (uint8_t& byte : data)
+            byte = static_cast<uint8_t>(random());
+
+        size_t headBytes = 0;
+        size_t tailBytes = 0;
+        HexDumpTruncation(size, maxBytes, headBytes, tailBytes);
+        const uint64_t omitted = size - headBytes - tailBytes;
+
+        std::string text = "[HexCheck] packet\n";
+        AppendTruncatedHexDump(text, data.data(), headBytes, data.data() + size - tailBytes, tailBytes, size);
+        text += "[HexCheck] next\n";
+
+        std::vector<uint8_t> expected(data.begin(), data.begin() + headBytes);
+        expected.insert(expected.end(), data.end() - tailBytes, data.end());
+
+        int mismatches = 0;
+        uint64_t badRows = 0;
+        for (size_t chunk : FEED_CHUNKS) {
+            auto check = [&](const HexDumpBlock& block) {
+                const bool ok = block.header == "[HexCheck] packet" && block.size == expected.size() && block.asciiMismatches == 0 &&
+                    std::equal(expected.begin(), expected.end(), block.data) &&
+                    block.omittedBytes == omitted && block.omittedOffset == (omitted > 0 ? headBytes : 0);
+                mismatches += ok ? 0 : 1;
+            };
+            HexDumpParser<decltype(check)> parser(check);
+            FeedInChunks(parser, text, chunk);
+            mismatches += parser.GetBlockCount() == 1 ? 0 : 1;
+            badRows += parser.GetBadRowCount();
+        }
+        mismatches += badRows == 0 ? 0 : 1;
+
+        std::printf("hex check (%zu bytes, max %zu -> %zu + %zu, %llu omitted): bad rows %llu -> %s\n",
+            size, maxBytes, headBytes, tailBytes, static_cast<unsigned long long>(omitted), static_cast<unsigned long long>(badRows),
+            mismatches == 0 ? "OK" : "FAILED");
+        passed &= mismatches == 0;
+    }
+
+    return passed ? 0 : 1;
+}
+
+#if defined(HEXDUMP_CHECK_MAIN)
+int main(void)
+{
+    // 빌드한 경로를 이 CPU가 실행하지 못하면 건너뛴다.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#if defined(HEXDUMP_AVX2)
+    if (!__builtin_cpu_supports("avx2")) {
+        std::printf("hex check: %s not supported by this CPU, skipped\n", HexDumpLevelName());
+        return 0;
+    }
+#elif defined(HEXDUMP_SSSE3)
+    if (!__builtin_cpu_supports("ssse3")) {
+        std::printf("hex check: %s not supported by this CPU, skipped\n", HexDumpLevelName());
+        return 0;
+    }
+#endif
+#endif
+    return RunHexCheck();
+}
+#endif
@@ -0,0 +1,417 @@
+﻿#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "HexDump.h"
+
+// 로그 파일에서 LogHex 블록(HexDump.h 형식의 덤프 줄들)을 찾아 원래 바이트로 되돌리는 스트리밍 파서.
+// 입력은 아무 크기로 잘라서 Feed에 넘기면 되고, 블록 하나가 끝날 때마다 callback(const HexDumpBlock&)이 호출된다.
+// 가운데를 잘라낸 덤프(AppendTruncatedHexDump)는 "... N bytes omitted ..." 줄이 알린 만큼 주소를 건너뛰어 한 블록으로 읽는다.
+// 줄 단위로 memchr로 끊고, 16바이트 줄의 헥스 칸 48자는 SIMD로 한 번에 검사 / 변환한다.
+// 버퍼는 처음 크기를 잡은 뒤에는 다시 할당하지 않는다. (블록이 지금까지보다 클 때만 payload가 늘어남)
+
+struct HexDumpBlock {
+    std::string_view header;        // 덤프 바로 앞 줄 (LogHex의 머리말). MAX_HEADER_LENGTH에서 잘린다.
+    const uint8_t* data = nullptr;  // 복원된 바이트
+    size_t size = 0;
+    size_t asciiMismatches = 0;     // ASCII 칸이 바이트와 맞지 않은 줄 수 (0이 아니라면 덤프가 손상됐을 수 있음)
+    uint64_t lineNumber = 0;        // 첫 덤프 줄의 줄 번호 (1부터)
+    size_t omittedOffset = 0;       // 잘린 덤프라면 data에서 빠진 부분이 있던 위치 (앞부분의 길이)
+    uint64_t omittedBytes = 0;      // 잘린 덤프에서 빠진 바이트 수. 원래 버퍼는 size + omittedBytes 바이트
+};
+
+namespace HexDumpParserDetail {
+#if defined(HEXDUMP_SSE2)
+    // 헥스 칸 48자를 16자씩 나눴을 때 ' '가 와야 하는 자리
+    alignas(16) inline constexpr uint8_t SPACE_POSITIONS[3][16] = {
+        { 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0 },
+        { 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0 },
+        { 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF, 0, 0, 0xFF },
+    };
+
+    // 16자 안의 헥스 문자를 니블 값으로 바꾼다. 형식에 맞지 않는 자리가 있으면 invalid에 표시된다.
+    inline __m128i DecodeNibbles(__m128i chars, __m128i spaces, __m128i& invalid)
+    {
+        const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+        const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)), _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+
+        // 대소문자를 같이 받는다.
+        const __m128i alpha = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(alpha, _mm_set1_epi8(-1)), _mm_cmplt_epi8(alpha, _mm_set1_epi8(6)));
+
+        const __m128i isHex = _mm_or_si128(isDigit, isAlpha);
+        const __m128i isSpace = _mm_cmpeq_epi8(chars, _mm_set1_epi8(' '));
+
+        invalid = _mm_or_si128(invalid, _mm_or_si128(
+            _mm_andnot_si128(isHex, _mm_andnot_si128(spaces, _mm_set1_epi8(-1))),
+            _mm_andnot_si128(isSpace, spaces)));
+
+        return _mm_or_si128(
+            _mm_and_si128(isDigit, digit),
+            _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+    }
+#endif
+
+#if defined(HEXDUMP_SSSE3)
+    // 니블 48개(3 x 16) 중 각 바이트의 상위 / 하위 니블 자리를 모으는 셔플 마스크
+    alignas(16) inline constexpr int8_t GATHER_HIGH[3][16] = {
+        { 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13 },
+    };
+    alignas(16) inline constexpr int8_t GATHER_LOW[3][16] = {
+        { 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14 },
+    };
+
+    inline __m128i Gather(const __m128i nibbles[3], const int8_t (&masks)[3][16])
+    {
+        __m128i result = _mm_shuffle_epi8(nibbles[0], _mm_load_si128(reinterpret_cast<const __m128i*>(masks[0])));
+        result = _mm_or_si128(result, _mm_shuffle_epi8(nibbles[1], _mm_load_si128(reinterpret_cast<const __m128i*>(masks[1]))));
+        result = _mm_or_si128(result, _mm_shuffle_epi8(nibbles[2], _mm_load_si128(reinterpret_cast<const __m128i*>(masks[2]))));
+        return result;
+    }
+#endif
+
+    inline int HexValue(char ch)
+    {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        return -1;
+    }
+
+    // "xx " 16개(48자)를 16바이트로 바꾼다. 형식이 하나라도 맞지 않으면 false
+    inline bool DecodeFullColumn(const char* column, uint8_t* out)
+    {
+#if defined(HEXDUMP_SSE2)
+        __m128i invalid = _mm_setzero_si128();
+        __m128i nibbles[3];
+        for (int i = 0; i < 3; ++i) {
+            const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i * 16));
+            const __m128i spaces = _mm_load_si128(reinterpret_cast<const __m128i*>(SPACE_POSITIONS[i]));
+            nibbles[i] = DecodeNibbles(chars, spaces, invalid);
+        }
+
+        if (_mm_movemask_epi8(invalid) != 0) {
+            return false;
+        }
+
+#if defined(HEXDUMP_SSSE3)
+        const __m128i high = Gather(nibbles, GATHER_HIGH);
+        const __m128i low = Gather(nibbles, GATHER_LOW);
+        const __m128i bytes = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(high, 4), _mm_set1_epi8(static_cast<char>(0xF0))), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+#else
+        alignas(16) uint8_t values[48];
+        _mm_store_si128(reinterpret_cast<__m128i*>(values), nibbles[0]);
+        _mm_store_si128(reinterpret_cast<__m128i*>(values + 16), nibbles[1]);
+        _mm_store_si128(reinterpret_cast<__m128i*>(values + 32), nibbles[2]);
+        for (size_t i = 0; i < HEX_DUMP_BYTES_PER_LINE; ++i)
+            out[i] = static_cast<uint8_t>((values[i * 3] << 4) | values[i * 3 + 1]);
+#endif
+        return true;
+#else
+        for (size_t i = 0; i < HEX_DUMP_BYTES_PER_LINE; ++i) {
+            const int high = HexValue(column[i * 3]);
+            const int low = HexValue(column[i * 3 + 1]);
+            if (high < 0 || low < 0 || column[i * 3 + 2] != ' ') {
+                return false;
+            }
+            out[i] = static_cast<uint8_t>((high << 4) | low);
+        }
+        return true;
+#endif
+    }
+
+    // 마지막 줄처럼 앞의 count 칸만 채워지고 나머지는 "   "인 헥스 칸. 형식이 맞지 않으면 -1
+    inline int DecodePartialColumn(const char* column, uint8_t* out)
+    {
+        size_t count = 0;
+        for (; count < HEX_DUMP_BYTES_PER_LINE; ++count) {
+            const int high = HexValue(column[count * 3]);
+            const int low = HexValue(column[count * 3 + 1]);
+            if (high < 0 || low < 0 || column[count * 3 + 2] != ' ') {
+                break;
+            }
+            out[count] = static_cast<uint8_t>((high << 4) | low);
+        }
+
+        for (size_t i = count * 3; i < HexDumpDetail::HEX_COLUMN_LENGTH; ++i) {
+            if (column[i] != ' ') {
+                return -1;
+            }
+        }
+        return static_cast<int>(count);
+    }
+
+    // 복원한 바이트로 다시 만든 ASCII 칸과 실제 ASCII 칸이 같은지
+    inline bool CheckAsciiColumn(const uint8_t* bytes, size_t count, const char* ascii)
+    {
+#if defined(HEXDUMP_SSE2)
+        if (count == HEX_DUMP_BYTES_PER_LINE) {
+            const __m128i expected = HexDumpDetail::PrintableMask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)));
+            const __m128i actual = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ascii));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(expected, actual)) == 0xFFFF;
+        }
+#endif
+        for (size_t i = 0; i < count; ++i) {
+            const char expected = (bytes[i] >= 0x20 && bytes[i] <= 0x7E) ? static_cast<char>(bytes[i]) : '.';
+            if (ascii[i] != expected) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 한 줄이 덤프 줄이라면 주소와 바이트를 채우고 바이트 수(0 ~ 16)를 반환한다. 덤프 줄이 아니면 -1
+    inline int ParseRow(const char* line, size_t length, uint64_t& address, uint8_t* out, bool& asciiMatches)
+    {
+        using namespace HexDumpDetail;
+
+        // 주소: 8 ~ 16자리 16진수 + ": "
+        size_t digits = 0;
+        address = 0;
+        while (digits < length && digits <= 16) {
+            const int value = HexValue(line[digits]);
+            if (value < 0) {
+                break;
+            }
+            address = (address << 4) | static_cast<uint64_t>(value);
+            ++digits;
+        }
+        if (digits < 8 || digits > 16) {
+            return -1;
+        }
+
+        const size_t rowLength = digits + 2 + HEX_COLUMN_LENGTH + SEPARATOR_LENGTH + HEX_DUMP_BYTES_PER_LINE;
+        if (length < rowLength || line[digits] != ':' || line[digits + 1] != ' ') {
+            return -1;
+        }
+
+        const char* column = line + digits + 2;
+        const char* separator = column + HEX_COLUMN_LENGTH;
+        if (std::memcmp(separator, " | ", SEPARATOR_LENGTH) != 0) {
+            return -1;
+        }
+
+        int count = HEX_DUMP_BYTES_PER_LINE;
+        if (!DecodeFullColumn(column, out)) {
+            count = DecodePartialColumn(column, out);
+            if (count < 0) {
+                return -1;
+            }
+        }
+
+        asciiMatches = CheckAsciiColumn(out, static_cast<size_t>(count), separator + SEPARATOR_LENGTH);
+        return count;
+    }
+
+    // "... N bytes omitted ..." 줄이라면 N을 채우고 true
+    inline bool ParseOmittedLine(const char* line, size_t length, uint64_t& omitted)
+    {
+        using namespace HexDumpDetail;
+
+        if (length <= OMITTED_PREFIX_LENGTH + OMITTED_SUFFIX_LENGTH || std::memcmp(line, OMITTED_PREFIX, OMITTED_PREFIX_LENGTH) != 0
+            || std::memcmp(line + length - OMITTED_SUFFIX_LENGTH, OMITTED_SUFFIX, OMITTED_SUFFIX_LENGTH) != 0) {
+            return false;
+        }
+
+        const char* digits = line + OMITTED_PREFIX_LENGTH;
+        const char* digitsEnd = line + length - OMITTED_SUFFIX_LENGTH;
+        const auto [end, error] = std::from_chars(digits, digitsEnd, omitted);
+        return error == std::errc() && end == digitsEnd && omitted > 0;
+    }
+}
+
+template <typename Callback>
+class HexDumpParser {
+public:
+    static constexpr size_t MAX_HEADER_LENGTH = 1024;
+    static constexpr size_t MAX_CARRY_LENGTH = 4096;    // 조각 사이에 걸친 줄을 모아두는 최대 길이. 넘는 부분은 버린다. (덤프 줄은 훨씬 짧음)
+
+    explicit HexDumpParser(Callback callback) : callback(std::move(callback))
+    {
+        header.reserve(MAX_HEADER_LENGTH);
+        carry.reserve(MAX_CARRY_LENGTH);
+        payload.reserve(64 * 1024);
+    }
+
+    // 입력의 다음 조각. 줄이 조각 사이에 걸쳐도 된다.
+    void Feed(const char* data, size_t size)
+    {
+        const char* end = data + size;
+        while (data < end) {
+            const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+            if (newline == nullptr) {
+                AppendCarry(data, end - data);
+                return;
+            }
+
+            if (!carry.empty()) {
+                AppendCarry(data, newline - data);
+                ProcessLine(carry.data(), carry.size());
+                carry.clear();
+            }
+            else {
+                ProcessLine(data, newline - data);
+            }
+            data = newline + 1;
+        }
+    }
+
+    // 입력이 끝났을 때 호출. 마지막 줄과 진행 중인 블록을 내보낸다.
+    void Finish(void)
+    {
+        if (!carry.empty()) {
+            ProcessLine(carry.data(), carry.size());
+            carry.clear();
+        }
+        EmitBlock();
+    }
+
+    uint64_t GetBlockCount(void) const { return blockCount; }
+    uint64_t GetLineCount(void) const { return lineNumber; }
+    uint64_t GetBadRowCount(void) const { return badRowCount; }    // 블록 안에서 주소가 이어지지 않는 덤프 줄 수
+
+private:
+    void AppendCarry(const char* data, size_t size)
+    {
+        const size_t room = MAX_CARRY_LENGTH - carry.size();
+        carry.insert(carry.end(), data, data + (size < room ? size : room));
+    }
+
+    void ProcessLine(const char* line, size_t length)
+    {
+        ++lineNumber;
+        if (length != 0 && line[length - 1] == '\r') {
+            --length;
+        }
+
+        uint64_t address = 0;
+        uint8_t bytes[HEX_DUMP_BYTES_PER_LINE];
+        bool asciiMatches = true;
+        const int count = HexDumpParserDetail::ParseRow(line, length, address, bytes, asciiMatches);
+
+        // 잘린 덤프의 가운데 줄. 앞부분이 16바이트 줄로 끝났거나(앞부분이 없으면 블록의 시작) 뒷부분은 그만큼 뒤의 주소부터 이어진다.
+        uint64_t omitted = 0;
+        if (count < 0 && HexDumpParserDetail::ParseOmittedLine(line, length, omitted) && omittedBytes == 0) {
+            if (!inBlock) {
+                inBlock = true;
+                blockLine = lineNumber;
+                nextAddress = 0;
+            }
+            omittedOffset = payload.size();
+            omittedBytes = omitted;
+            nextAddress += omitted;
+            return;
+        }
+
+        if (count < 0) {
+            // 덤프 줄이 아니라면 진행 중인 블록을 끝내고, 다음 블록의 머리말 후보로 남겨둔다.
+            EmitBlock();
+            header.assign(line, length < MAX_HEADER_LENGTH ? length : MAX_HEADER_LENGTH);
+            return;
+        }
+
+        if (address == 0) {
+            EmitBlock();
+            inBlock = true;
+            blockLine = lineNumber;
+        }
+        else if (!inBlock || address != nextAddress) {
+            ++badRowCount;
+            EmitBlock();
+            header.clear();
+            return;
+        }
+
+        payload.insert(payload.end(), bytes, bytes + count);
+        asciiMismatches += asciiMatches ? 0 : 1;
+        nextAddress = address + HEX_DUMP_BYTES_PER_LINE;
+
+        // 16바이트보다 짧은 줄은 블록의 마지막 줄
+        if (count < static_cast<int>(HEX_DUMP_BYTES_PER_LINE)) {
+            EmitBlock();
+        }
+    }
+
+    void EmitBlock(void)
+    {
+        if (!inBlock) {
+            return;
+        }
+
+        HexDumpBlock block;
+        block.header = header;
+        block.data = payload.data();
+        block.size = payload.size();
+        block.asciiMismatches = asciiMismatches;
+        block.lineNumber = blockLine;
+        block.omittedOffset = omittedOffset;
+        block.omittedBytes = omittedBytes;
+        callback(block);
+
+        ++blockCount;
+        inBlock = false;
+        payload.clear();
+        asciiMismatches = 0;
+        omittedOffset = 0;
+        omittedBytes = 0;
+        header.clear();
+    }
+
+    Callback callback;
+
+    std::string header;             // 마지막으로 본 덤프가 아닌 줄
+    std::vector<char> carry;        // 조각 끝에서 끊긴 줄
+    std::vector<uint8_t> payload;   // 진행 중인 블록의 바이트
+
+    bool inBlock = false;
+    uint64_t nextAddress = 0;
+    uint64_t blockLine = 0;
+    size_t asciiMismatches = 0;
+    size_t omittedOffset = 0;       // 진행 중인 블록에서 "... N bytes omitted ..." 줄을 만난 위치
+    uint64_t omittedBytes = 0;
+
+    uint64_t lineNumber = 0;
+    uint64_t blockCount = 0;
+    uint64_t badRowCount = 0;
+};
+
+// 로그 파일 전체를 CHUNK_SIZE 씩 읽어서 파싱한다. 파일을 열지 못하면 false
+template <typename Callback>
+inline bool ParseHexDumpFile(const std::filesystem::path& path, Callback callback)
+{
+    constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::unique_ptr<char[]> buffer(new char[CHUNK_SIZE]);
+    HexDumpParser<Callback> parser(std::move(callback));
+
+    while (file) {
+        file.read(buffer.get(), CHUNK_SIZE);
+        const std::streamsize got = file.gcount();
+        if (got <= 0) {
+            break;
+        }
+        parser.Feed(buffer.get(), static_cast<size_t>(got));
+    }
+
+    parser.Finish();
+    return true;
+}
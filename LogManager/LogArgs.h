@@ -0,0 +1,594 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "LogBufferPool.h"
+#include "LogFormat.h"
+#include "LogUtf8.h"
+
+// 지연 포맷(deferred formatting)을 위해 Log 인자를 타입 정보와 함께 그대로 복사해두는 버퍼.
+// 게임 스레드에서는 포맷 문자열 포인터와 인자 바이트를 복사만 하고,
+// 실제 문자열 조립(FormatLogArgs)은 writer / collector 스레드에서 한다.
+// 포맷 문자열은 포인터만 저장하므로 문자열 리터럴처럼 프로그램이 끝날 때까지 살아있어야 한다.
+// LogFormatString으로 받은 포맷은 컴파일 타임에 해석된 LogFormatSlot 배열도 함께 복사해두므로
+// 소비하는 쪽에서 포맷 문자열을 다시 파싱하지 않는다.
+
+namespace LogArgDetail {
+    template <typename CharT>
+    inline std::basic_string_view<CharT> ToStringView(const CharT* str)
+    {
+        if (str == nullptr) {
+            if constexpr (std::is_same_v<CharT, wchar_t>)
+                return L"(null)";
+            else
+                return "(null)";
+        }
+        return std::basic_string_view<CharT>(str);
+    }
+
+    template <typename CharT>
+    inline std::basic_string_view<CharT> ToStringView(const std::basic_string<CharT>& str) { return str; }
+
+    template <typename CharT>
+    inline std::basic_string_view<CharT> ToStringView(std::basic_string_view<CharT> str) { return str; }
+
+    // 포맷하는 동안만 쓰는 스레드별 문자열. 용량이 남아있으므로 한 번 늘어난 뒤에는 할당하지 않는다.
+    inline std::wstring& ReaderScratch(void)
+    {
+        static thread_local std::wstring scratch;
+        return scratch;
+    }
+
+    inline std::wstring& ConversionScratch(void)
+    {
+        static thread_local std::wstring scratch;
+        return scratch;
+    }
+
+    // 인자 하나가 버퍼에서 차지하는 바이트 수 (타입 태그 포함)
+    template <typename T>
+    inline size_t EncodedSize(const T& value)
+    {
+        constexpr LogArgType type = ArgTypeOf<T>();
+        if constexpr (type == LogArgType::ARG_INT32 || type == LogArgType::ARG_UINT32)
+            return 1 + 4;
+        else if constexpr (type == LogArgType::ARG_WSTRING)
+            return 1 + 4 + ToStringView<wchar_t>(value).size() * sizeof(wchar_t);
+        else if constexpr (type == LogArgType::ARG_STRING)
+            return 1 + 4 + ToStringView<char>(value).size();
+        else
+            return 1 + 8;
+    }
+
+    template <typename T>
+    inline uint8_t* Encode(uint8_t* out, const T& value)
+    {
+        using D = std::decay_t<T>;
+        constexpr LogArgType type = ArgTypeOf<T>();
+
+        *out++ = static_cast<uint8_t>(type);
+
+        if constexpr (type == LogArgType::ARG_INT32 || type == LogArgType::ARG_UINT32) {
+            uint32_t raw;
+            if constexpr (std::is_enum_v<D>)
+                raw = static_cast<uint32_t>(static_cast<std::underlying_type_t<D>>(value));
+            else
+                raw = static_cast<uint32_t>(value);
+            std::memcpy(out, &raw, 4);
+            return out + 4;
+        }
+        else if constexpr (type == LogArgType::ARG_INT64 || type == LogArgType::ARG_UINT64) {
+            uint64_t raw;
+            if constexpr (std::is_enum_v<D>)
+                raw = static_cast<uint64_t>(static_cast<std::underlying_type_t<D>>(value));
+            else
+                raw = static_cast<uint64_t>(value);
+            std::memcpy(out, &raw, 8);
+            return out + 8;
+        }
+        else if constexpr (type == LogArgType::ARG_DOUBLE) {
+            double raw = static_cast<double>(value);
+            std::memcpy(out, &raw, 8);
+            return out + 8;
+        }
+        else if constexpr (type == LogArgType::ARG_POINTER) {
+            uint64_t raw = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+            std::memcpy(out, &raw, 8);
+            return out + 8;
+        }
+        else {
+            using CharT = std::conditional_t<type == LogArgType::ARG_WSTRING, wchar_t, char>;
+            auto view = ToStringView<CharT>(value);
+            uint32_t length = static_cast<uint32_t>(view.size());
+            std::memcpy(out, &length, 4);
+            std::memcpy(out + 4, view.data(), view.size() * sizeof(CharT));
+            return out + 4 + view.size() * sizeof(CharT);
+        }
+    }
+}
+
+class LogArgBuffer {
+public:
+    // 이 크기를 넘는 인자(긴 문자열 등)는 LogBufferPool에서 받는다.
+    static constexpr size_t INLINE_CAPACITY = 192;
+
+    LogArgBuffer(void) = default;
+
+    LogArgBuffer(const LogArgBuffer& other) { CopyFrom(other); }
+
+    LogArgBuffer& operator=(const LogArgBuffer& other)
+    {
+        if (this != &other) {
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    LogArgBuffer(LogArgBuffer&& other) noexcept { MoveFrom(other); }
+
+    LogArgBuffer& operator=(LogArgBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    // 런타임에 받은 포맷. 포맷 문자열은 FormatLogArgs에서 해석한다.
+    template <typename... Args>
+    void Capture(const wchar_t* formatString, const Args&... args)
+    {
+        CaptureWithSlots(formatString, nullptr, 0, false, args...);
+    }
+
+    // 컴파일 타임에 검사 / 해석된 포맷. 해석 결과(slot 배열)를 인자 앞에 함께 복사한다.
+    template <typename... Args>
+    void Capture(const LogFormatString<Args...>& formatString, const Args&... args)
+    {
+        CaptureWithSlots(formatString.Get(), formatString.Slots(), formatString.SlotCount(), true, args...);
+    }
+
+    void Clear(void)
+    {
+        format = nullptr;
+        size = 0;
+        count = 0;
+        slotCount = 0;
+        hasSlots = false;
+    }
+
+    bool Empty(void) const { return format == nullptr; }
+    const wchar_t* Format(void) const { return format; }
+    uint32_t Count(void) const { return count; }
+
+    // 미리 해석된 slot 배열. HasSlots()가 false라면 포맷 문자열을 직접 해석해야 한다.
+    bool HasSlots(void) const { return hasSlots; }
+    uint32_t SlotCount(void) const { return slotCount; }
+    const LogFormatSlot* Slots(void) const { return reinterpret_cast<const LogFormatSlot*>(Storage()); }
+
+    // 인자 바이트 (slot 배열 뒤)
+    const uint8_t* Data(void) const { return Storage() + SlotBytes(); }
+    uint32_t Size(void) const { return size; }
+
+private:
+    template <typename... Args>
+    void CaptureWithSlots(const wchar_t* formatString, const LogFormatSlot* slots, size_t slotTotal, bool precomputed, const Args&... args)
+    {
+        format = formatString;
+        count = static_cast<uint32_t>(sizeof...(Args));
+        size = static_cast<uint32_t>((static_cast<size_t>(0) + ... + LogArgDetail::EncodedSize(args)));
+        slotCount = static_cast<uint32_t>(slotTotal);
+        hasSlots = precomputed;
+
+        uint8_t* out = Reserve(SlotBytes() + size);
+        if (slots != nullptr && slotCount != 0) {
+            std::memcpy(out, slots, SlotBytes());
+            out += SlotBytes();
+        }
+        ((out = LogArgDetail::Encode(out, args)), ...);
+    }
+
+    size_t SlotBytes(void) const { return slotCount * sizeof(LogFormatSlot); }
+    const uint8_t* Storage(void) const { return heap ? heap.get() : inlineData; }
+
+    uint8_t* Reserve(size_t bytes)
+    {
+        if (bytes <= INLINE_CAPACITY) {
+            heap.reset();
+            heapCapacity = 0;
+            return inlineData;
+        }
+
+        if (bytes > heapCapacity) {
+            heap.reset(static_cast<uint8_t*>(LogBufferPool::Allocate(bytes)));
+            heapCapacity = bytes;
+        }
+        return heap.get();
+    }
+
+    void CopyFrom(const LogArgBuffer& other)
+    {
+        format = other.format;
+        count = other.count;
+        size = other.size;
+        slotCount = other.slotCount;
+        hasSlots = other.hasSlots;
+        std::memcpy(Reserve(SlotBytes() + size), other.Storage(), SlotBytes() + size);
+    }
+
+    void MoveFrom(LogArgBuffer& other)
+    {
+        format = other.format;
+        count = other.count;
+        size = other.size;
+        slotCount = other.slotCount;
+        hasSlots = other.hasSlots;
+
+        if (other.heap) {
+            heap = std::move(other.heap);
+            heapCapacity = other.heapCapacity;
+            other.heapCapacity = 0;
+        }
+        else {
+            heap.reset();
+            heapCapacity = 0;
+            std::memcpy(inlineData, other.inlineData, SlotBytes() + size);
+        }
+
+        other.Clear();
+    }
+
+    const wchar_t* format = nullptr;
+    uint32_t size = 0;                  // 인자들이 차지하는 바이트 수
+    uint32_t count = 0;                 // 인자 수
+    uint32_t slotCount = 0;             // 저장된 LogFormatSlot 수
+    bool hasSlots = false;
+    std::unique_ptr<uint8_t[], LogPoolDeleter> heap;
+    size_t heapCapacity = 0;
+    alignas(8) uint8_t inlineData[INLINE_CAPACITY];
+};
+
+// 버퍼에서 인자를 하나씩 꺼낸다.
+struct LogArgValue {
+    LogArgType type = LogArgType::ARG_INT32;
+    uint64_t bits = 0;                  // 정수 / 포인터
+    double real = 0.0;
+    std::wstring_view wide;
+    std::string_view narrow;
+
+    bool IsInteger(void) const
+    {
+        return type == LogArgType::ARG_INT32 || type == LogArgType::ARG_UINT32
+            || type == LogArgType::ARG_INT64 || type == LogArgType::ARG_UINT64;
+    }
+
+    int64_t AsInt64(void) const
+    {
+        switch (type) {
+        case LogArgType::ARG_INT32: return static_cast<int32_t>(bits);
+        case LogArgType::ARG_UINT32: return static_cast<uint32_t>(bits);
+        case LogArgType::ARG_DOUBLE: return static_cast<int64_t>(real);
+        default: return static_cast<int64_t>(bits);
+        }
+    }
+
+    double AsDouble(void) const
+    {
+        switch (type) {
+        case LogArgType::ARG_DOUBLE: return real;
+        case LogArgType::ARG_UINT32:
+        case LogArgType::ARG_UINT64:
+        case LogArgType::ARG_POINTER: return static_cast<double>(bits);
+        default: return static_cast<double>(AsInt64());
+        }
+    }
+};
+
+class LogArgReader {
+public:
+    explicit LogArgReader(const LogArgBuffer& buffer)
+        : cursor(buffer.Data()), end(buffer.Data() + buffer.Size()) {}
+
+    // LogArgBuffer::Data()와 같은 형식의 인자 바이트 (바이너리 로그 파일에서 읽은 것 등)
+    LogArgReader(const uint8_t* data, size_t size)
+        : cursor(data), end(data + size) {}
+
+    // 인자가 더 없거나 남은 바이트가 모자라면 false
+    bool Next(LogArgValue& value)
+    {
+        if (cursor >= end) {
+            return false;
+        }
+
+        value = LogArgValue();
+        value.type = static_cast<LogArgType>(*cursor++);
+
+        const size_t remaining = static_cast<size_t>(end - cursor);
+        if (remaining < EncodedPayloadSize(value.type, cursor, remaining)) {
+            cursor = end;
+            return false;
+        }
+
+        switch (value.type) {
+        case LogArgType::ARG_INT32:
+        case LogArgType::ARG_UINT32: {
+            uint32_t raw;
+            std::memcpy(&raw, cursor, 4);
+            cursor += 4;
+            value.bits = raw;
+            break;
+        }
+        case LogArgType::ARG_DOUBLE:
+            std::memcpy(&value.real, cursor, 8);
+            cursor += 8;
+            break;
+        case LogArgType::ARG_WSTRING: {
+            uint32_t length;
+            std::memcpy(&length, cursor, 4);
+            // 버퍼 안에서 wchar_t 정렬이 보장되지 않으므로 view가 직접 가리키지 않고 복사해둔다. (다음 Next까지 유효)
+            wideCopy.assign(length, L'\0');
+            std::memcpy(wideCopy.data(), cursor + 4, length * sizeof(wchar_t));
+            value.wide = wideCopy;
+            cursor += 4 + length * sizeof(wchar_t);
+            break;
+        }
+        case LogArgType::ARG_STRING: {
+            uint32_t length;
+            std::memcpy(&length, cursor, 4);
+            value.narrow = std::string_view(reinterpret_cast<const char*>(cursor + 4), length);
+            cursor += 4 + length;
+            break;
+        }
+        default:
+            std::memcpy(&value.bits, cursor, 8);
+            cursor += 8;
+            break;
+        }
+        return true;
+    }
+
+private:
+    // 타입 바이트 뒤에 이어지는 값의 바이트 수. 길이를 읽을 수 없다면 remaining보다 큰 값
+    static size_t EncodedPayloadSize(LogArgType type, const uint8_t* payload, size_t remaining)
+    {
+        switch (type) {
+        case LogArgType::ARG_INT32:
+        case LogArgType::ARG_UINT32:
+            return 4;
+        case LogArgType::ARG_WSTRING:
+        case LogArgType::ARG_STRING: {
+            if (remaining < 4) {
+                return remaining + 1;
+            }
+            uint32_t length;
+            std::memcpy(&length, payload, 4);
+            return 4 + static_cast<size_t>(length) * (type == LogArgType::ARG_WSTRING ? sizeof(wchar_t) : 1);
+        }
+        default:
+            return 8;
+        }
+    }
+
+    const uint8_t* cursor;
+    const uint8_t* end;
+    std::wstring& wideCopy = LogArgDetail::ReaderScratch();
+};
+
+namespace LogArgDetail {
+    inline void AppendPadded(std::wstring& out, std::wstring_view text, int width, bool leftAlign)
+    {
+        size_t padding = (width > 0 && static_cast<size_t>(width) > text.size()) ? width - text.size() : 0;
+        if (!leftAlign)
+            out.append(padding, L' ');
+        out.append(text);
+        if (leftAlign)
+            out.append(padding, L' ');
+    }
+
+    // 리터럴 구간을 붙인다. "%%"는 '%' 하나로 바꾼다.
+    inline void AppendLiteral(std::wstring& out, const wchar_t* begin, const wchar_t* end)
+    {
+        while (begin < end) {
+            const wchar_t* percent = std::wmemchr(begin, L'%', end - begin);
+            if (percent == nullptr) {
+                out.append(begin, end);
+                return;
+            }
+            out.append(begin, percent + 1);
+            begin = (percent + 1 < end && percent[1] == L'%') ? percent + 2 : percent + 1;
+        }
+    }
+
+    // 숫자 하나를 swprintf로 포맷해서 붙인다.
+    template <typename T>
+    inline void AppendNumber(std::wstring& out, uint8_t flags, int width, int precision, const wchar_t* lengthModifier, wchar_t conversion, T value)
+    {
+        wchar_t spec[32];
+        wchar_t* p = spec;
+        *p++ = L'%';
+        if (flags & FORMAT_FLAG_LEFT) *p++ = L'-';
+        if (flags & FORMAT_FLAG_PLUS) *p++ = L'+';
+        if (flags & FORMAT_FLAG_SPACE) *p++ = L' ';
+        if (flags & FORMAT_FLAG_ALT) *p++ = L'#';
+        if (flags & FORMAT_FLAG_ZERO) *p++ = L'0';
+        *p++ = L'*';
+        *p++ = L'.';
+        *p++ = L'*';
+        while (*lengthModifier != L'\0')
+            *p++ = *lengthModifier++;
+        *p++ = conversion;
+        *p = L'\0';
+
+        size_t capacity = 64 + static_cast<size_t>(width > 0 ? width : 0) + static_cast<size_t>(precision > 0 ? precision : 0);
+        size_t oldSize = out.size();
+        out.resize(oldSize + capacity);
+
+        // width / precision이 없을 때는 '*'에 각각 0 / -1을 넘기면 지정하지 않은 것과 같다.
+        int written = std::swprintf(out.data() + oldSize, capacity, spec, width > 0 ? width : 0, precision, value);
+        out.resize(oldSize + (written > 0 ? static_cast<size_t>(written) : 0));
+    }
+
+    // 변환 지정자 하나와 그에 해당하는 인자를 출력한다.
+    inline void AppendConversion(std::wstring& out, const LogFormatSlot& slot, LogArgReader& reader)
+    {
+        LogArgValue value;
+
+        uint8_t flags = slot.flags;
+        int width = slot.width;
+        if (width == FORMAT_VALUE_STAR) {
+            width = reader.Next(value) ? static_cast<int>(value.AsInt64()) : 0;
+            if (width < 0) {
+                flags |= FORMAT_FLAG_LEFT;
+                width = -width;
+            }
+        }
+
+        int precision = slot.precision;
+        if (precision == FORMAT_VALUE_STAR) {
+            precision = reader.Next(value) ? static_cast<int>(value.AsInt64()) : 0;
+            if (precision < 0)
+                precision = -1;
+        }
+
+        if (!reader.Next(value)) {
+            return;
+        }
+
+        const bool leftAlign = (flags & FORMAT_FLAG_LEFT) != 0;
+        const wchar_t conversion = static_cast<wchar_t>(slot.conversion);
+
+        switch (conversion) {
+        case L'd':
+        case L'i':
+            AppendNumber(out, flags, width, precision, L"ll", conversion, static_cast<long long>(value.AsInt64()));
+            break;
+
+        case L'u':
+        case L'o':
+        case L'x':
+        case L'X': {
+            // 32비트 정수는 printf와 같이 32비트 범위로 출력 (음수를 %x로 찍는 경우 등)
+            unsigned long long bits = value.IsInteger() ? value.bits : static_cast<unsigned long long>(value.AsInt64());
+            if (value.type == LogArgType::ARG_INT32 || value.type == LogArgType::ARG_UINT32)
+                bits &= 0xFFFFFFFFull;
+            AppendNumber(out, flags, width, precision, L"ll", conversion, bits);
+            break;
+        }
+
+        case L'f':
+        case L'F':
+        case L'e':
+        case L'E':
+        case L'g':
+        case L'G':
+        case L'a':
+        case L'A':
+            AppendNumber(out, flags, width, precision, L"", conversion, value.AsDouble());
+            break;
+
+        case L'p':
+            AppendNumber(out, flags, width, precision, L"", conversion, reinterpret_cast<void*>(static_cast<uintptr_t>(value.bits)));
+            break;
+
+        case L'c':
+        case L'C': {
+            wchar_t ch = static_cast<wchar_t>(value.AsInt64());
+            AppendPadded(out, std::wstring_view(&ch, 1), width, leftAlign);
+            break;
+        }
+
+        case L's':
+        case L'S': {
+            // wchar_t 문자열은 복사하지 않고 그대로, 나머지는 스레드별 문자열에 만들어서 붙인다.
+            std::wstring_view text;
+            if (value.type == LogArgType::ARG_WSTRING) {
+                text = value.wide;
+            }
+            else {
+                std::wstring& scratch = ConversionScratch();
+                scratch.clear();
+                if (value.type == LogArgType::ARG_STRING) {
+                    // char 문자열은 UTF-8로 보고 wchar_t로 바꾼다. 출력에서 다시 UTF-8이 되므로 바이트가 그대로 남는다.
+                    AppendWide(scratch, value.narrow);
+                }
+                else {
+                    AppendNumber(scratch, 0, 0, -1, L"ll", L'd', static_cast<long long>(value.AsInt64()));
+                }
+                text = scratch;
+            }
+
+            if (precision >= 0 && static_cast<size_t>(precision) < text.size())
+                text = text.substr(0, precision);
+
+            AppendPadded(out, text, width, leftAlign);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+}
+
+// 해석된 slot 배열과 버퍼의 인자로 printf 규칙대로 문자열을 만든다.
+// 인자의 실제 타입을 알고 있으므로 길이 지정자(l, ll, I64 등)는 무시하고 저장된 타입에 맞춰 출력하며,
+// %s는 플랫폼과 상관없이 wchar_t / char 문자열을 모두 받는다. 길이 제한은 없다.
+// 마지막 slot 뒤의 나머지는 리터럴로 붙이므로, 해석이 중간에 실패한 포맷은 실패한 곳부터 그대로 출력된다.
+inline void FormatLogArgs(const wchar_t* format, const LogFormatSlot* slots, size_t slotCount, LogArgReader& reader, std::wstring& out)
+{
+    using namespace LogArgDetail;
+
+    const wchar_t* p = format;
+    for (size_t i = 0; i < slotCount; ++i) {
+        AppendLiteral(out, p, p + slots[i].literalLength);
+        p += slots[i].literalLength;
+
+        AppendConversion(out, slots[i], reader);
+        p += slots[i].specLength;
+    }
+
+    AppendLiteral(out, p, p + std::wcslen(p));
+}
+
+// 버퍼에 미리 해석된 slot이 있다면 그대로 쓰고, 없다면(런타임 포맷) 여기서 포맷 문자열을 해석한다.
+inline void FormatLogArgs(const wchar_t* format, const LogArgBuffer& buffer, std::wstring& out)
+{
+    LogArgReader reader(buffer);
+
+    if (buffer.HasSlots()) {
+        FormatLogArgs(format, buffer.Slots(), buffer.SlotCount(), reader, out);
+        return;
+    }
+
+    constexpr size_t MAX_RUNTIME_SLOTS = 64;
+    LogFormatSlot slots[MAX_RUNTIME_SLOTS];
+    LogFormatParseResult result = ParseLogFormat(format, slots, MAX_RUNTIME_SLOTS);
+    FormatLogArgs(format, slots, result.slotCount, reader, out);
+}
+
+// 포맷 문자열과 인자 바이트가 따로 있는 경우. (바이너리 로그 디코더) 포맷은 매번 해석한다.
+inline void FormatLogArgs(const wchar_t* format, const uint8_t* args, size_t argBytes, std::wstring& out)
+{
+    LogArgReader reader(args, argBytes);
+
+    constexpr size_t MAX_RUNTIME_SLOTS = 64;
+    LogFormatSlot slots[MAX_RUNTIME_SLOTS];
+    LogFormatParseResult result = ParseLogFormat(format, slots, MAX_RUNTIME_SLOTS);
+    FormatLogArgs(format, slots, result.slotCount, reader, out);
+}
+
+inline std::wstring FormatLogArgs(const LogArgBuffer& buffer)
+{
+    std::wstring out;
+    if (!buffer.Empty()) {
+        FormatLogArgs(buffer.Format(), buffer, out);
+    }
+    return out;
+}
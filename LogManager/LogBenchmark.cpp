@@ -0,0 +1,444 @@
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameLogManager.h"
+#include "HexDump.h"
+#include "SystemLogManager.h"
+
+// SystemLogManager / HexDump / GameLogManager의 주요 경로 측정.
+//
+//     LogBenchmark [--records N] [--threads N] [--json output.json] [--label text]
+//
+// Log는 모드(동기 / 비동기 / 스레드 로컬)와 출력(텍스트 / 매핑 텍스트 / 바이너리)마다 스레드 하나와 threads개로 나눠서 records번 호출한다.
+// LogHex, AppendHexDump, GameLogManager::SaveToDatabase도 같은 항목을 잰다.
+//
+// calls/s       : 호출한 스레드 기준. 비동기 / 스레드 로컬 모드에서 파일에 다 쓰기까지 걸린 시간은 toDiskSeconds로 따로 남긴다.
+// p50/p99/p999  : 호출 하나의 지연(ns). 시각을 재는 비용(now() 두 번)이 포함된다.
+// allocs/call   : 측정 구간 동안 모든 스레드(writer / collector 포함)의 전역 operator new 횟수와 바이트를 호출 수로 나눈 값
+// bytesWritten  : 측정 구간에 쓴 파일 크기 (AppendHexDump는 만든 문자 수)
+// --json을 주면 같은 결과를 JSON으로도 남긴다. label에 커밋 등을 넣어서 커밋 사이의 결과를 비교한다.
+
+namespace {
+    // 전역 operator new를 바꿔서 할당 횟수와 바이트를 센다. (측정 구간에서만 켬)
+    std::atomic<bool> countAllocations{ false };
+    std::atomic<uint64_t> allocationCount{ 0 };
+    std::atomic<uint64_t> allocationBytes{ 0 };
+}
+
+void* operator new(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+enum class BenchMode {
+    MODE_SYNC,
+    MODE_ASYNC,
+    MODE_THREAD_LOCAL
+};
+
+enum class BenchOutput {
+    OUTPUT_TEXT,
+    OUTPUT_MAPPED,
+    OUTPUT_BINARY
+};
+
+const char* ModeName(BenchMode mode)
+{
+    switch (mode) {
+    case BenchMode::MODE_ASYNC: return "async";
+    case BenchMode::MODE_THREAD_LOCAL: return "thread";
+    default: return "sync";
+    }
+}
+
+const char* OutputName(BenchOutput output)
+{
+    switch (output) {
+    case BenchOutput::OUTPUT_MAPPED: return "mapped";
+    case BenchOutput::OUTPUT_BINARY: return "binary";
+    default: return "text";
+    }
+}
+
+struct BenchResult {
+    std::string name;
+    std::string mode;
+    std::string output;
+    int threads = 1;
+    uint64_t calls = 0;
+    double seconds = 0;
+    double toDiskSeconds = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0;
+    double allocationsPerCall = 0;
+    double allocatedBytesPerCall = 0;
+    uint64_t bytesWritten = 0;
+};
+
+constexpr size_t BENCH_QUEUE_DEPTH = 64 * 1024;
+const wchar_t* const BENCH_TYPES[] = { L"Bench0", L"Bench1", L"Bench2", L"Bench3" };
+constexpr size_t BENCH_TYPE_COUNT = sizeof(BENCH_TYPES) / sizeof(BENCH_TYPES[0]);
+
+// 실제 패킷과 비슷한 크기
+constexpr size_t PACKET_BYTES = 256;
+constexpr size_t HEX_DUMP_BYTES = 4096;
+
+uint64_t DirectoryBytes(const std::filesystem::path& directory)
+{
+    uint64_t bytes = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+        if (entry.is_regular_file(error)) {
+            bytes += entry.file_size(error);
+        }
+    }
+    return bytes;
+}
+
+// 항목마다 따로 쓰는 폴더. (Bench/Log_sync_text_1t ...)
+std::filesystem::path CaseDirectory(std::string name)
+{
+    std::replace(name.begin(), name.end(), '/', '_');
+    return std::filesystem::path("Bench") / name;
+}
+
+// threads개의 스레드가 callsPerThread번씩 call(thread, i)를 부르고, 호출마다 지연을 잰다.
+// 할당 횟수는 측정을 시작할 때 0으로 돌린다. 끝난 뒤에도 세는 상태로 둔다. (파일에 다 쓰기까지 포함하도록 호출한 쪽에서 끔)
+template <typename Call>
+void RunThreads(int threads, uint64_t callsPerThread, Call&& call, BenchResult& result)
+{
+    std::vector<std::vector<uint32_t>> latencies(threads);
+    for (auto& samples : latencies)
+        samples.reserve(callsPerThread);
+
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::vector<uint32_t>& samples = latencies[t];
+            ready.fetch_add(1);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+
+            for (uint64_t i = 0; i < callsPerThread; ++i) {
+                const auto begin = std::chrono::steady_clock::now();
+                call(t, i);
+                const auto end = std::chrono::steady_clock::now();
+                samples.push_back(static_cast<uint32_t>(std::min<int64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count(), UINT32_MAX)));
+            }
+        });
+    }
+
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+
+    allocationCount = 0;
+    allocationBytes = 0;
+    countAllocations = true;
+    const auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& worker : workers)
+        worker.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint32_t> merged;
+    merged.reserve(callsPerThread * threads);
+    for (const auto& samples : latencies)
+        merged.insert(merged.end(), samples.begin(), samples.end());
+    std::sort(merged.begin(), merged.end());
+
+    auto percentile = [&](double q) {
+        return merged.empty() ? 0.0 : static_cast<double>(merged[std::min(merged.size() - 1, static_cast<size_t>(q * merged.size()))]);
+    };
+
+    result.threads = threads;
+    result.calls = callsPerThread * threads;
+    result.p50 = percentile(0.50);
+    result.p99 = percentile(0.99);
+    result.p999 = percentile(0.999);
+}
+
+void StopCountingAllocations(BenchResult& result)
+{
+    countAllocations = false;
+    result.allocationsPerCall = static_cast<double>(allocationCount.load()) / result.calls;
+    result.allocatedBytesPerCall = static_cast<double>(allocationBytes.load()) / result.calls;
+}
+
+// 모드와 출력을 바꾸고 새 폴더로 옮긴다.
+void Configure(SystemLogManager& manager, BenchMode mode, BenchOutput output, const std::wstring& directory)
+{
+    manager.ShutdownAsync();
+    manager.ShutdownThreadLocal();
+    manager.CloseFiles();
+
+    manager.InitializeDirectory(directory);
+    manager.InitializeFileFormat(output == BenchOutput::OUTPUT_BINARY ? LogFileFormat::FORMAT_BINARY : LogFileFormat::FORMAT_TEXT);
+    manager.InitializeFileWriter(output == BenchOutput::OUTPUT_MAPPED ? LogFileWriter::WRITER_MAPPED : LogFileWriter::WRITER_STREAM);
+
+    if (mode == BenchMode::MODE_ASYNC) {
+        manager.InitializeAsync(BENCH_QUEUE_DEPTH, QueueFullPolicy::POLICY_BLOCK);
+    }
+    else if (mode == BenchMode::MODE_THREAD_LOCAL) {
+        manager.InitializeThreadLocal(BENCH_QUEUE_DEPTH, QueueFullPolicy::POLICY_BLOCK);
+    }
+}
+
+// 큐 / 링 버퍼에 남은 로그까지 모두 파일에 쓰고 닫는다.
+void Drain(SystemLogManager& manager)
+{
+    manager.ShutdownAsync();
+    manager.ShutdownThreadLocal();
+    manager.CloseFiles();
+}
+
+// Log 또는 LogHex(hex가 true)를 records번 (threads개로 나눠서) 호출한다.
+BenchResult RunLog(BenchMode mode, BenchOutput output, int threads, uint64_t records, bool hex)
+{
+    SystemLogManager& manager = SystemLogManager::GetInstance();
+
+    BenchResult result;
+    result.mode = ModeName(mode);
+    result.output = OutputName(output);
+    result.name = std::string(hex ? "LogHex/" : "Log/") + result.mode + "/" + result.output + "/" + std::to_string(threads) + "t";
+
+    const std::filesystem::path directory = CaseDirectory(result.name);
+
+    char packet[PACKET_BYTES];
+    for (size_t i = 0; i < sizeof(packet); ++i)
+        packet[i] = static_cast<char>(i * 7);
+
+    auto call = [&](int thread, uint64_t i) {
+        const wchar_t* type = BENCH_TYPES[(i + thread) % BENCH_TYPE_COUNT];
+        if (hex) {
+            manager.LogHex(type, LogLevel::LEVEL_DEBUG, L"packet", packet, sizeof(packet));
+        }
+        else {
+            manager.Log(type, LogLevel::LEVEL_DEBUG, L"player %d moved to (%d, %d) in %s", thread, static_cast<int>(i),
+                static_cast<int>(i * 3), L"Field");
+        }
+    };
+
+    // 데우기 (버퍼 풀, 파일 열기). 측정에 들어가지 않도록 다른 폴더에 쓴다.
+    Configure(manager, mode, output, (std::filesystem::path("Bench") / "warmup").wstring());
+    RunThreads(threads, std::min<uint64_t>(records / threads / 10 + 1, 10000), call, result);
+    countAllocations = false;
+
+    Configure(manager, mode, output, directory.wstring());
+    const auto start = std::chrono::steady_clock::now();
+    RunThreads(threads, records / threads, call, result);
+    Drain(manager);
+    result.toDiskSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    StopCountingAllocations(result);
+
+    result.bytesWritten = DirectoryBytes(directory);
+    return result;
+}
+
+BenchResult RunHexDump(uint64_t records)
+{
+    BenchResult result;
+    result.name = "AppendHexDump/4KB";
+    result.mode = "none";
+    result.output = "memory";
+
+    std::vector<uint8_t> data(HEX_DUMP_BYTES);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 13);
+
+    const uint64_t calls = std::max<uint64_t>(records / 16, 1);
+    std::string text;
+    text.reserve(HexDumpLength(data.size()));
+    RunThreads(1, calls, [&](int, uint64_t) {
+        text.clear();
+        AppendHexDump(text, data.data(), data.size());
+    }, result);
+    result.toDiskSeconds = result.seconds;
+    StopCountingAllocations(result);
+
+    result.bytesWritten = static_cast<uint64_t>(text.size()) * result.calls;
+    return result;
+}
+
+BenchResult RunSaveToDatabase(int threads, uint64_t records)
+{
+    BenchResult result;
+    result.name = "SaveToDatabase/file/" + std::to_string(threads) + "t";
+    result.mode = "pipeline";
+    result.output = "file";
+
+    const std::filesystem::path directory = CaseDirectory(result.name);
+    std::filesystem::create_directories(directory);
+
+    GameLogPipelineConfig config;
+    config.journalFileName = (directory / "GameLogJournal.bin").wstring();
+    GameLogManager::Start(std::make_unique<GameLogFileSink>((directory / "GameLog.tsv").wstring()), config);
+
+    const auto start = std::chrono::steady_clock::now();
+    RunThreads(threads, records / threads, [](int thread, uint64_t i) {
+        GameLogManager::SaveToDatabase(GameLog("Server1", "BATTLE", "MONSTER_KILLED_GOLD", 100000 + i,
+            thread, 1000, static_cast<int32_t>(i), 2500, "MonsterType: Dragon"));
+    }, result);
+    GameLogManager::Stop();
+    result.toDiskSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    StopCountingAllocations(result);
+
+    result.bytesWritten = DirectoryBytes(directory);
+    return result;
+}
+
+void PrintResult(const BenchResult& result)
+{
+    std::printf("%-28s %10.0f calls/s  p50 %7.0f  p99 %8.0f  p999 %9.0f ns  %6.2f allocs/call (%7.1f B)  %10llu bytes  to disk %.3f s\n",
+        result.name.c_str(), result.calls / result.seconds, result.p50, result.p99, result.p999,
+        result.allocationsPerCall, result.allocatedBytesPerCall, static_cast<unsigned long long>(result.bytesWritten), result.toDiskSeconds);
+}
+
+// label에 따옴표나 \가 있으면 이스케이프한다.
+std::string JsonString(const std::string& text)
+{
+    std::string out = "\"";
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out.push_back('\\');
+            out.push_back(ch);
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            out += escaped;
+        }
+        else {
+            out.push_back(ch);
+        }
+    }
+    return out + "\"";
+}
+
+bool WriteJson(const char* path, const std::string& label, uint64_t records, int threads, const std::vector<BenchResult>& results)
+{
+    std::FILE* out = std::fopen(path, "wb");
+    if (out == nullptr) {
+        return false;
+    }
+
+    std::fprintf(out, "{\n  \"label\": %s,\n  \"records\": %llu,\n  \"threads\": %d,\n  \"results\": [\n",
+        JsonString(label).c_str(), static_cast<unsigned long long>(records), threads);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        std::fprintf(out,
+            "    { \"name\": %s, \"mode\": %s, \"output\": %s, \"threads\": %d, \"calls\": %llu, "
+            "\"seconds\": %.6f, \"callsPerSecond\": %.1f, \"toDiskSeconds\": %.6f, "
+            "\"latencyNs\": { \"p50\": %.0f, \"p99\": %.0f, \"p999\": %.0f }, "
+            "\"allocationsPerCall\": %.4f, \"allocatedBytesPerCall\": %.2f, \"bytesWritten\": %llu }%s\n",
+            JsonString(result.name).c_str(), JsonString(result.mode).c_str(), JsonString(result.output).c_str(), result.threads,
+            static_cast<unsigned long long>(result.calls), result.seconds, result.calls / result.seconds, result.toDiskSeconds,
+            result.p50, result.p99, result.p999, result.allocationsPerCall, result.allocatedBytesPerCall,
+            static_cast<unsigned long long>(result.bytesWritten), i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    std::fclose(out);
+    return true;
+}
+
+int Usage(void)
+{
+    std::fprintf(stderr, "usage: LogBenchmark [--records N] [--threads N] [--json output.json] [--label text]\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t records = 200000;
+    int threads = 4;
+    const char* jsonPath = nullptr;
+    std::string label;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc) {
+            records = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        }
+        else {
+            return Usage();
+        }
+    }
+    if (records == 0 || threads <= 0) {
+        return Usage();
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all("Bench", error);
+    std::filesystem::create_directory("Bench");
+
+    SystemLogManager& manager = SystemLogManager::GetInstance();
+    LogConsolePolicy consolePolicy;
+    consolePolicy.enabled = false;
+    manager.InitializeConsole(consolePolicy);
+    manager.InitializeLevel(LogLevel::LEVEL_DEBUG);
+    manager.InitializeFlushPolicy(64 * 1024, std::chrono::milliseconds(1000), LogLevel::LEVEL_ERROR);
+
+    std::vector<BenchResult> results;
+    auto record = [&](BenchResult result) {
+        PrintResult(result);
+        results.push_back(std::move(result));
+    };
+
+    std::printf("%llu records per case, %d threads\n", static_cast<unsigned long long>(records), threads);
+    for (BenchMode mode : { BenchMode::MODE_SYNC, BenchMode::MODE_ASYNC, BenchMode::MODE_THREAD_LOCAL }) {
+        for (BenchOutput output : { BenchOutput::OUTPUT_TEXT, BenchOutput::OUTPUT_MAPPED, BenchOutput::OUTPUT_BINARY }) {
+            record(RunLog(mode, output, 1, records, false));
+            if (threads > 1) {
+                record(RunLog(mode, output, threads, records, false));
+            }
+        }
+    }
+    for (BenchMode mode : { BenchMode::MODE_SYNC, BenchMode::MODE_ASYNC }) {
+        record(RunLog(mode, BenchOutput::OUTPUT_TEXT, 1, records / 4, true));
+    }
+    record(RunHexDump(records));
+    record(RunSaveToDatabase(1, records));
+    if (threads > 1) {
+        record(RunSaveToDatabase(threads, records));
+    }
+
+    std::filesystem::remove_all("Bench", error);
+
+    if (jsonPath != nullptr && !WriteJson(jsonPath, label, records, threads, results)) {
+        std::fprintf(stderr, "cannot write %s\n", jsonPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,492 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "LogFile.h"
+#include "LogHexBytes.h"
+#include "LogMetrics.h"
+#include "LogTime.h"
+
+// 바이너리 로그 파일 형식. (type 별 파일 logDirectory/YYYYMM_type.bin)
+//
+// 파일   := FileHeader Block*
+// FileHeader (16바이트) : "SLOGBIN1" / uint16 version / uint8 sizeof(wchar_t) / uint8 0 / uint32 0
+// Block  := uint8 blockType / uint32 payloadLength / payload           (정수는 모두 little endian)
+//
+// BLOCK_SESSION : 이 프로세스가 파일에 처음 쓸 때 하나. 디코더는 여기서 문자열 테이블을 비운다.
+//                 varint flags (SESSION_FLAG_*) / string typeName
+// BLOCK_STRINGS : 포맷 문자열 정의. 세션 안에서 id 하나는 한 번만 정의되며, 처음 쓰이는 RECORDS 블록보다 앞에 온다.
+//                 varint count / { varint id, string text } * count
+// BLOCK_RECORDS : 플러시 한 번에 쌓인 로그. 앞의 요약만 보고 블록 전체를 건너뛸 수 있다.
+//                 index 범위에는 인덱스가 없는 LogHex / 완성된 줄이 빠지므로, 그런 줄만 있는 블록은 minIndex > maxIndex이다.
+//                 varint recordCount / varint minIndex / varint maxIndex / varint minTimestamp / varint maxTimestamp /
+//                 varint baseTimestamp / uint8 levelMask / Record * recordCount
+// Record := uint8 header (하위 4비트 level, RECORD_FLAG_*) / varint index / varint zigzag(timestamp - 직전 timestamp) /
+//           RECORD_FLAG_FORMAT이면 varint formatId / varint argBytes / LogArgBuffer 인자 바이트
+//           RECORD_FLAG_HEX이면 utf8 description / varint totalBytes / varint headBytes / varint tailBytes / 바이트 * (headBytes + tailBytes)
+//             (LogHex. 헥스 문자열은 디코더가 만든다. headBytes + tailBytes < totalBytes라면 가운데를 잘라낸 것)
+//           아니면 text (RECORD_FLAG_LINE이면 완성된 줄, 아니면 메시지)
+//           text는 RECORD_FLAG_UTF8이면 utf8, 아니면 string (RECORD_FLAG_UTF8이 없던 때의 파일)
+// string := varint length / wchar_t * length
+// utf8   := varint length / UTF-8 바이트 * length
+//
+// timestamp는 LogClockNow() 값(ns), 첫 레코드의 직전 timestamp는 baseTimestamp(첫 레코드의 timestamp)이다.
+
+// type 별 로그 파일을 어떤 형식으로 남길지
+enum class LogFileFormat {
+    FORMAT_TEXT,                // YYYYMM_type.txt
+    FORMAT_BINARY,              // YYYYMM_type.bin (LogDecoder로 텍스트 복원)
+    FORMAT_TEXT_AND_BINARY
+};
+
+namespace LogBinary {
+    constexpr char FILE_MAGIC[8] = { 'S', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+    constexpr uint16_t FILE_VERSION = 2;           // 2 : RECORD_FLAG_HEX
+    constexpr uint16_t MIN_FILE_VERSION = 1;       // 디코더가 읽을 수 있는 가장 오래된 버전
+    constexpr size_t FILE_HEADER_SIZE = 16;
+    constexpr size_t BLOCK_HEADER_SIZE = 5;
+
+    enum BlockType : uint8_t {
+        BLOCK_SESSION = 1,
+        BLOCK_STRINGS = 2,
+        BLOCK_RECORDS = 3
+    };
+
+    enum SessionFlag : uint8_t {
+        SESSION_FLAG_MICROS = 0x01      // 머리말 시각에 마이크로초를 붙인다.
+    };
+
+    enum RecordFlag : uint8_t {
+        RECORD_LEVEL_MASK = 0x0F,
+        RECORD_FLAG_FORMAT = 0x10,      // 포맷 id + 인자
+        RECORD_FLAG_LINE = 0x20,        // text가 머리말까지 포함한 완성된 줄
+        RECORD_FLAG_UTF8 = 0x40,        // text가 UTF-8
+        RECORD_FLAG_HEX = 0x80          // 설명과 덤프할 바이트 (LogHex)
+    };
+
+    inline void AppendVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    // 실패(데이터가 끝나거나 10바이트를 넘음)하면 false
+    inline bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+            const uint8_t byte = *cursor++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint64_t ZigZag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    inline int64_t UnZigZag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+    inline void AppendString(std::string& out, std::wstring_view text)
+    {
+        AppendVarint(out, text.size());
+        out.append(reinterpret_cast<const char*>(text.data()), text.size() * sizeof(wchar_t));
+    }
+
+    inline void AppendUtf8String(std::string& out, std::string_view text)
+    {
+        AppendVarint(out, text.size());
+        out.append(text.data(), text.size());
+    }
+
+    inline bool ReadString(const uint8_t*& cursor, const uint8_t* end, std::wstring& text)
+    {
+        uint64_t length = 0;
+        if (!ReadVarint(cursor, end, length) || length > static_cast<uint64_t>(end - cursor) / sizeof(wchar_t)) {
+            return false;
+        }
+        text.resize(static_cast<size_t>(length));
+        std::memcpy(text.data(), cursor, static_cast<size_t>(length) * sizeof(wchar_t));
+        cursor += length * sizeof(wchar_t);
+        return true;
+    }
+
+    inline void AppendUInt32(std::string& out, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+
+    inline uint32_t ReadUInt32(const uint8_t* data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8)
+            | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    inline void AppendBlock(std::string& out, BlockType type, const std::string& payload)
+    {
+        out.push_back(static_cast<char>(type));
+        AppendUInt32(out, static_cast<uint32_t>(payload.size()));
+        out += payload;
+    }
+
+    inline std::string MakeFileHeader(void)
+    {
+        std::string header(FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.push_back(static_cast<char>(FILE_VERSION & 0xFF));
+        header.push_back(static_cast<char>(FILE_VERSION >> 8));
+        header.push_back(static_cast<char>(sizeof(wchar_t)));
+        header.append(5, '\0');
+        return header;
+    }
+}
+
+// 포맷 문자열 포인터 -> 바이너리 로그의 포맷 id. 포맷 문자열은 리터럴이므로 포인터가 곧 정체성이다.
+// 쓰는 쪽(writer 스레드 또는 동기 모드의 각 스레드)에서만 조회하므로 mutex로 충분하다.
+class LogFormatIdRegistry {
+public:
+    // 처음 보는 포맷이면 새 id (1부터)
+    uint32_t GetId(const wchar_t* format)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto [it, inserted] = ids.try_emplace(format, static_cast<uint32_t>(ids.size() + 1));
+        return it->second;
+    }
+
+private:
+    std::mutex lock;
+    std::unordered_map<const wchar_t*, uint32_t> ids;
+};
+
+// 바이너리 로그 한 건. 포인터들은 Write가 반환될 때까지만 유효하면 된다.
+struct LogBinaryEntry {
+    uint8_t level = 0;
+    int64_t index = 0;
+    LogTimestamp timestamp = 0;
+
+    uint32_t formatId = 0;                  // 0이 아니라면 format / args 사용
+    const wchar_t* format = nullptr;
+    const uint8_t* args = nullptr;
+    size_t argBytes = 0;
+
+    std::string_view text;                  // formatId가 0일 때의 메시지 또는 완성된 줄 (UTF-8)
+    bool completeLine = false;              // text가 완성된 줄인지
+    const LogHexBytes* hex = nullptr;       // nullptr이 아니라면 text는 설명, hex는 덤프할 바이트 (LogHex)
+};
+
+// 한 type의 바이너리 로그 파일. LogFile과 같이 열어둔 채로 버퍼에 모았다가 같은 LogFlushPolicy로 기록하며,
+// 플러시 한 번이 RECORDS 블록 하나가 된다. 파일(조각)이 바뀔 때마다 세션 블록과 포맷 정의를 새로 써서 조각 하나만으로도 복원된다.
+// 핸들 수는 LogFile과 같이 LogOpenFileCache가 센다.
+class LogBinaryFile : public LogCachedFile {
+public:
+    using Clock = LogCachedFile::Clock;
+
+    LogBinaryFile(void) = default;
+    ~LogBinaryFile(void) { Close(); }
+
+    LogBinaryFile(const LogBinaryFile&) = delete;
+    LogBinaryFile& operator=(const LogBinaryFile&) = delete;
+
+    // fileName / flushNow / policy / rotation은 LogFile::Write와 같다. (rotation의 maxBytes는 기록할 바이트 기준)
+    // typeName, micros는 세션 블록에 기록된다. (파일이 바뀔 때만 의미가 있음)
+    void Write(const std::wstring& fileName, std::wstring_view typeName, bool micros, const LogBinaryEntry& entry, bool flushNow, const LogFlushPolicy& policy,
+        const LogRotationPolicy& rotation)
+    {
+        LogTimedLock<std::mutex> guard(lock, lockWaits);
+
+        auto now = Clock::now();
+
+        if (!segments.IsCurrentPeriod(fileName)) {
+            FlushLocked(now);
+            CloseStream();
+            segments.BeginPeriod(fileName, rotation);
+            StartSession();
+        }
+        sessionTypeName.assign(typeName);
+        sessionMicros = micros;
+        // records는 flushBytes에 닿으면 쓰므로 flushBytes와 로그 하나를 크게 넘지 않는다. 미리 잡아두어 쓰는 동안 버퍼가 자라지 않도록 한다.
+        ReserveBuffers(policy.flushBytes * 2);
+
+        const size_t bufferedBytes = strings.size() + records.size();
+        if (entry.formatId != 0) {
+            DefineFormat(entry.formatId, entry.format);
+        }
+        AppendRecord(entry);
+        lastWrite = now;
+        Touch(now);
+
+        const bool full = segments.Add(strings.size() + records.size() - bufferedBytes, 1, rotation);
+
+        if (full || flushNow || records.size() >= policy.flushBytes || IsFlushDue(now, policy)) {
+            FlushLocked(now);
+        }
+
+        if (full) {
+            CloseStream();
+            segments.NextSegment(rotation);
+            StartSession();
+        }
+    }
+
+    bool Maintain(Clock::time_point now, const LogFlushPolicy& policy, std::chrono::milliseconds idleTimeout)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (recordCount != 0 && IsFlushDue(now, policy)) {
+            FlushLocked(now);
+        }
+
+        if (stream.is_open() && idleTimeout.count() > 0 && now - lastWrite >= idleTimeout) {
+            FlushLocked(now);
+            CloseStream();
+        }
+
+        return stream.is_open();
+    }
+
+    void Flush(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        FlushLocked(Clock::now());
+    }
+
+    void Close(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        FlushLocked(Clock::now());
+        CloseStream();
+    }
+
+    Clock::time_point GetLastWrite(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return lastWrite;
+    }
+
+    // LogFile::GetFileName과 같다.
+    std::wstring GetFileName(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return segments.FileName();
+    }
+
+    // LogFile::GetLockWaits와 같다.
+    LogWaitStats GetLockWaits(void) const { return lockWaits.GetStats(); }
+
+private:
+    bool IsFlushDue(Clock::time_point now, const LogFlushPolicy& policy) const
+    {
+        return policy.flushInterval.count() > 0 && now - lastFlush >= policy.flushInterval;
+    }
+
+    // LogFile::TryEvict와 같다.
+    bool TryEvict(void) override
+    {
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            return false;
+        }
+        if (stream.is_open()) {
+            FlushLocked(Clock::now());
+            stream.close();
+        }
+        return true;
+    }
+
+    void CloseStream(void)
+    {
+        if (stream.is_open()) {
+            stream.close();
+            NotifyClosed();
+        }
+    }
+
+    // 새 파일은 세션 블록부터 쓰고 포맷 정의도 처음부터 다시 남긴다.
+    void StartSession(void)
+    {
+        sessionStarted = false;
+        definedFormats.clear();
+    }
+
+    void DefineFormat(uint32_t formatId, const wchar_t* format)
+    {
+        if (formatId < definedFormats.size() && definedFormats[formatId]) {
+            return;
+        }
+        if (formatId >= definedFormats.size()) {
+            definedFormats.resize(formatId + 1, false);
+        }
+        definedFormats[formatId] = true;
+
+        LogBinary::AppendVarint(strings, formatId);
+        LogBinary::AppendString(strings, format);
+        stringCount++;
+    }
+
+    void AppendRecord(const LogBinaryEntry& entry)
+    {
+        using namespace LogBinary;
+
+        if (recordCount == 0) {
+            minIndex = INT64_MAX;
+            maxIndex = 0;
+            minTimestamp = maxTimestamp = baseTimestamp = previousTimestamp = entry.timestamp;
+            levelMask = 0;
+        }
+
+        uint8_t header = entry.level & RECORD_LEVEL_MASK;
+        if (entry.formatId != 0) header |= RECORD_FLAG_FORMAT;
+        else if (entry.hex != nullptr) header |= RECORD_FLAG_HEX | RECORD_FLAG_UTF8;
+        else if (entry.completeLine) header |= RECORD_FLAG_LINE | RECORD_FLAG_UTF8;
+        else header |= RECORD_FLAG_UTF8;
+
+        records.push_back(static_cast<char>(header));
+        AppendVarint(records, static_cast<uint64_t>(entry.index));
+        AppendVarint(records, ZigZag(static_cast<int64_t>(entry.timestamp - previousTimestamp)));
+
+        if (entry.formatId != 0) {
+            AppendVarint(records, entry.formatId);
+            AppendVarint(records, entry.argBytes);
+            records.append(reinterpret_cast<const char*>(entry.args), entry.argBytes);
+        }
+        else if (entry.hex != nullptr) {
+            AppendUtf8String(records, entry.text);
+            AppendVarint(records, entry.hex->TotalBytes());
+            AppendVarint(records, entry.hex->HeadBytes());
+            AppendVarint(records, entry.hex->TailBytes());
+            records.append(entry.hex->Head(), entry.hex->HeadBytes());
+            records.append(entry.hex->Tail(), entry.hex->TailBytes());
+        }
+        else {
+            AppendUtf8String(records, entry.text);
+        }
+
+        previousTimestamp = entry.timestamp;
+        if (!entry.completeLine && entry.hex == nullptr) {
+            minIndex = entry.index < minIndex ? entry.index : minIndex;
+            maxIndex = entry.index > maxIndex ? entry.index : maxIndex;
+        }
+        minTimestamp = entry.timestamp < minTimestamp ? entry.timestamp : minTimestamp;
+        maxTimestamp = entry.timestamp > maxTimestamp ? entry.timestamp : maxTimestamp;
+        levelMask |= static_cast<uint8_t>(1u << (entry.level & 7));
+        recordCount++;
+    }
+
+    void ReserveBuffers(size_t bytes)
+    {
+        if (records.capacity() >= bytes) {
+            return;
+        }
+        records.reserve(bytes);
+        payloadBuffer.reserve(bytes);
+        blockBuffer.reserve(bytes);
+    }
+
+    void FlushLocked(Clock::time_point now)
+    {
+        using namespace LogBinary;
+
+        lastFlush = now;
+
+        if (recordCount == 0) {
+            return;
+        }
+
+        if (!stream.is_open()) {
+            std::filesystem::path path(segments.FileName());
+            std::error_code error;
+            const bool empty = !std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) == 0;
+
+            NotifyOpening();
+            stream.open(path, std::ios::binary | std::ios::app);
+            if (!stream.is_open()) {
+                NotifyClosed();
+            }
+            if (stream.is_open() && empty) {
+                const std::string fileHeader = MakeFileHeader();
+                stream.write(fileHeader.data(), static_cast<std::streamsize>(fileHeader.size()));
+            }
+        }
+
+        std::string& out = blockBuffer;
+        std::string& payload = payloadBuffer;
+        out.clear();
+        payload.clear();
+
+        if (!sessionStarted) {
+            AppendVarint(payload, sessionMicros ? SESSION_FLAG_MICROS : 0);
+            AppendString(payload, sessionTypeName);
+            AppendBlock(out, BLOCK_SESSION, payload);
+            sessionStarted = true;
+        }
+
+        if (stringCount != 0) {
+            payload.clear();
+            AppendVarint(payload, stringCount);
+            payload += strings;
+            AppendBlock(out, BLOCK_STRINGS, payload);
+        }
+
+        payload.clear();
+        AppendVarint(payload, recordCount);
+        AppendVarint(payload, static_cast<uint64_t>(minIndex));
+        AppendVarint(payload, static_cast<uint64_t>(maxIndex));
+        AppendVarint(payload, minTimestamp);
+        AppendVarint(payload, maxTimestamp);
+        AppendVarint(payload, baseTimestamp);
+        payload.push_back(static_cast<char>(levelMask));
+        payload += records;
+
+        AppendBlock(out, BLOCK_RECORDS, payload);
+
+        if (stream.is_open()) {
+            stream.write(out.data(), static_cast<std::streamsize>(out.size()));
+            stream.flush();
+        }
+
+        strings.clear();
+        stringCount = 0;
+        records.clear();
+        recordCount = 0;
+    }
+
+    std::mutex lock;
+    LogWaitHistogram lockWaits;             // Write의 lock 대기
+    std::ofstream stream;
+    LogSegmentTracker segments;             // 지금 쓰고 있는 파일 (type + 기간 + 조각 번호)
+    std::wstring sessionTypeName;
+    bool sessionMicros = false;
+    bool sessionStarted = false;            // 이 프로세스가 지금 파일에 세션 블록을 썼는지
+    std::vector<bool> definedFormats;       // 이번 세션에서 정의한 포맷 id
+
+    std::string strings;                    // 다음 STRINGS 블록의 내용 (count 제외)
+    uint64_t stringCount = 0;
+    std::string records;                    // 다음 RECORDS 블록의 레코드들
+    uint64_t recordCount = 0;
+    int64_t minIndex = 0;
+    int64_t maxIndex = 0;
+    LogTimestamp minTimestamp = 0;
+    LogTimestamp maxTimestamp = 0;
+    LogTimestamp baseTimestamp = 0;
+    LogTimestamp previousTimestamp = 0;
+    uint8_t levelMask = 0;
+
+    std::string blockBuffer;                // FlushLocked에서 이번에 쓸 블록들. 용량을 유지해서 매번 할당하지 않는다.
+    std::string payloadBuffer;
+
+    Clock::time_point lastWrite{};
+    Clock::time_point lastFlush{};
+};
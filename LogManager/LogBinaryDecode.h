@@ -0,0 +1,257 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HexDump.h"
+#include "LogArgs.h"
+#include "LogBinary.h"
+#include "LogLine.h"
+#include "LogTime.h"
+#include "LogUtf8.h"
+
+// 바이너리 로그(LogBinary.h)를 텍스트 로그와 같은 줄로 되돌린다. (LogDecoder, 크래시 점검)
+
+struct DecodeFilter {
+    int minLevel = 0;
+    bool byIndex = false;
+    int64_t fromIndex = 0;
+    int64_t toIndex = 0;
+    bool byTime = false;
+    LogTimestamp fromTime = 0;
+    LogTimestamp toTime = 0;
+
+    // RECORDS 블록의 요약만으로 조건에 맞는 레코드가 없다고 알 수 있는지
+    bool SkipsBlock(int64_t minIndex, int64_t maxIndex, LogTimestamp minTime, LogTimestamp maxTime, uint8_t levelMask) const
+    {
+        if ((levelMask >> minLevel) == 0) return true;
+        if (byIndex && (minIndex > maxIndex || maxIndex < fromIndex || minIndex > toIndex)) return true;
+        if (byTime && (maxTime < fromTime || minTime > toTime)) return true;
+        return false;
+    }
+
+    bool Accepts(int level, int64_t index, bool hasIndex, LogTimestamp timestamp) const
+    {
+        if (level < minLevel) return false;
+        if (byIndex && (!hasIndex || index < fromIndex || index > toIndex)) return false;
+        if (byTime && (timestamp < fromTime || timestamp > toTime)) return false;
+        return true;
+    }
+};
+
+struct DecodeStats {
+    uint64_t blocks = 0;
+    uint64_t skippedBlocks = 0;
+    uint64_t records = 0;
+    uint64_t decodedRecords = 0;
+};
+
+// 파일 하나를 디코드한다. 형식이 깨진 곳을 만나면 거기까지 출력하고 false
+inline bool DecodeLogBinary(const std::vector<uint8_t>& file, const DecodeFilter& filter, std::FILE* out, DecodeStats& stats)
+{
+    using namespace LogBinary;
+
+    if (file.size() < FILE_HEADER_SIZE || std::memcmp(file.data(), FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        std::wcerr << L"바이너리 로그 파일이 아닙니다.\n";
+        return false;
+    }
+
+    const uint16_t version = static_cast<uint16_t>(file[8] | (file[9] << 8));
+    if (version < MIN_FILE_VERSION || version > FILE_VERSION || file[10] != sizeof(wchar_t)) {
+        std::wcerr << L"지원하지 않는 버전(" << version << L") 또는 wchar_t 크기(" << static_cast<int>(file[10]) << L")입니다.\n";
+        return false;
+    }
+
+    std::vector<std::wstring> formats;      // 포맷 id -> 포맷 문자열. 세션마다 새로 채운다.
+    std::wstring typeName;
+    std::string utf8TypeName;
+    bool micros = false;
+
+    LogTimestampCache timestampCache;
+    std::string line;
+    std::string utf8Text;       // RECORD_FLAG_UTF8인 메시지 또는 완성된 줄
+    std::wstring message;       // 포맷한 메시지 또는 RECORD_FLAG_UTF8이 없는 텍스트
+    std::wstring text;
+
+    const uint8_t* cursor = file.data() + FILE_HEADER_SIZE;
+    const uint8_t* fileEnd = file.data() + file.size();
+
+    while (cursor < fileEnd) {
+        if (static_cast<size_t>(fileEnd - cursor) < BLOCK_HEADER_SIZE) {
+            std::wcerr << L"잘린 블록 헤더\n";
+            return false;
+        }
+
+        const uint8_t blockType = cursor[0];
+        const uint32_t length = ReadUInt32(cursor + 1);
+        cursor += BLOCK_HEADER_SIZE;
+        if (length > static_cast<size_t>(fileEnd - cursor)) {
+            std::wcerr << L"잘린 블록 (마지막 플러시가 끝나지 않음)\n";
+            return false;
+        }
+
+        const uint8_t* p = cursor;
+        const uint8_t* end = cursor + length;
+        cursor = end;
+        stats.blocks++;
+
+        if (blockType == BLOCK_SESSION) {
+            uint64_t flags = 0;
+            if (!ReadVarint(p, end, flags) || !ReadString(p, end, typeName)) {
+                return false;
+            }
+            micros = (flags & SESSION_FLAG_MICROS) != 0;
+            utf8TypeName = ToUtf8(typeName);
+            formats.clear();
+            continue;
+        }
+
+        if (blockType == BLOCK_STRINGS) {
+            uint64_t count = 0;
+            if (!ReadVarint(p, end, count)) {
+                return false;
+            }
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t id = 0;
+                if (!ReadVarint(p, end, id) || id > 0xFFFFFFFF || !ReadString(p, end, text)) {
+                    return false;
+                }
+                if (id >= formats.size()) {
+                    formats.resize(static_cast<size_t>(id) + 1);
+                }
+                formats[static_cast<size_t>(id)] = text;
+            }
+            continue;
+        }
+
+        if (blockType != BLOCK_RECORDS) {
+            continue;       // 모르는 블록은 건너뛴다.
+        }
+
+        uint64_t count = 0, minIndex = 0, maxIndex = 0, minTime = 0, maxTime = 0, baseTime = 0;
+        if (!ReadVarint(p, end, count) || !ReadVarint(p, end, minIndex) || !ReadVarint(p, end, maxIndex)
+            || !ReadVarint(p, end, minTime) || !ReadVarint(p, end, maxTime) || !ReadVarint(p, end, baseTime) || p >= end) {
+            return false;
+        }
+        const uint8_t levelMask = *p++;
+
+        stats.records += count;
+        if (filter.SkipsBlock(static_cast<int64_t>(minIndex), static_cast<int64_t>(maxIndex), minTime, maxTime, levelMask)) {
+            stats.skippedBlocks++;
+            continue;
+        }
+
+        LogTimestamp timestamp = baseTime;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (p >= end) {
+                return false;
+            }
+            const uint8_t header = *p++;
+
+            uint64_t index = 0, delta = 0;
+            if (!ReadVarint(p, end, index) || !ReadVarint(p, end, delta)) {
+                return false;
+            }
+            timestamp += static_cast<LogTimestamp>(UnZigZag(delta));
+
+            const int level = header & RECORD_LEVEL_MASK;
+            const bool completeLine = (header & RECORD_FLAG_LINE) != 0;
+            const bool hexDump = (header & RECORD_FLAG_HEX) != 0;
+            const bool utf8 = (header & RECORD_FLAG_UTF8) != 0;
+            const bool accepted = filter.Accepts(level, static_cast<int64_t>(index), !completeLine && !hexDump, timestamp);
+
+            if (hexDump) {
+                uint64_t descriptionLength = 0, totalBytes = 0, headBytes = 0, tailBytes = 0;
+                if (!ReadVarint(p, end, descriptionLength) || descriptionLength > static_cast<uint64_t>(end - p)) {
+                    return false;
+                }
+                const uint8_t* description = p;
+                p += descriptionLength;
+                if (!ReadVarint(p, end, totalBytes) || !ReadVarint(p, end, headBytes) || !ReadVarint(p, end, tailBytes)
+                    || headBytes > static_cast<uint64_t>(end - p) || tailBytes > static_cast<uint64_t>(end - p) - headBytes
+                    || headBytes + tailBytes > totalBytes) {
+                    return false;
+                }
+                const uint8_t* bytes = p;
+                p += headBytes + tailBytes;
+                if (!accepted) {
+                    continue;
+                }
+
+                stats.decodedRecords++;
+                line.clear();
+                AppendLogHexHeader(line, utf8TypeName, timestamp, static_cast<LogLevel>(level), micros,
+                    std::string_view(reinterpret_cast<const char*>(description), static_cast<size_t>(descriptionLength)), timestampCache);
+                AppendTruncatedHexDump(line, bytes, static_cast<size_t>(headBytes), bytes + headBytes, static_cast<size_t>(tailBytes), totalBytes);
+                std::fwrite(line.data(), 1, line.size(), out);
+                continue;
+            }
+
+            if (header & RECORD_FLAG_FORMAT) {
+                uint64_t formatId = 0, argBytes = 0;
+                if (!ReadVarint(p, end, formatId) || !ReadVarint(p, end, argBytes) || argBytes > static_cast<uint64_t>(end - p)) {
+                    return false;
+                }
+                const uint8_t* args = p;
+                p += argBytes;
+
+                if (!accepted) {
+                    continue;
+                }
+                if (formatId >= formats.size()) {
+                    std::wcerr << L"정의되지 않은 포맷 id " << formatId << L'\n';
+                    return false;
+                }
+
+                message.clear();
+                FormatLogArgs(formats[static_cast<size_t>(formatId)].c_str(), args, static_cast<size_t>(argBytes), message);
+            }
+            else {
+                // 조건에 맞지 않는다면 복사하지 않고 길이만큼 건너뛴다.
+                const size_t unitSize = utf8 ? 1 : sizeof(wchar_t);
+                uint64_t textLength = 0;
+                if (!ReadVarint(p, end, textLength) || textLength > static_cast<uint64_t>(end - p) / unitSize) {
+                    return false;
+                }
+                const uint8_t* textBegin = p;
+                p += textLength * unitSize;
+                if (!accepted) {
+                    continue;
+                }
+
+                if (utf8) {
+                    utf8Text.assign(reinterpret_cast<const char*>(textBegin), static_cast<size_t>(textLength));
+                }
+                else {
+                    message.resize(static_cast<size_t>(textLength));
+                    std::memcpy(message.data(), textBegin, static_cast<size_t>(textLength) * sizeof(wchar_t));
+                }
+            }
+
+            stats.decodedRecords++;
+            line.clear();
+            if (completeLine && utf8) {
+                std::fwrite(utf8Text.data(), 1, utf8Text.size(), out);
+                continue;
+            }
+            if (completeLine) {
+                AppendUtf8(line, message);
+            }
+            else if (utf8) {
+                AppendLogLine(line, utf8TypeName, timestamp, static_cast<LogLevel>(level), micros,
+                    static_cast<int64_t>(index), std::string_view(utf8Text), timestampCache);
+            }
+            else {
+                AppendLogLine(line, utf8TypeName, timestamp, static_cast<LogLevel>(level), micros,
+                    static_cast<int64_t>(index), std::wstring_view(message), timestampCache);
+            }
+            std::fwrite(line.data(), 1, line.size(), out);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,440 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+
+// 로그 경로의 버퍼(LogArgBuffer의 큰 인자, LogHex 줄 등)를 재사용하는 메모리 풀.
+//
+// MAX_SLAB_SIZE 이하 : 크기별(64B ~ 64KB, 2의 거듭제곱) 고정 크기 slab. 모든 스레드가 공유하는 락프리 free list로 돌려쓴다.
+// 그 위 ~ MAX_ARENA_SIZE : 할당한 스레드의 arena에서 돌려쓴다. 큰 헥스 덤프처럼 드물고 큰 버퍼를 스레드마다 ARENA_RETAIN_BYTES까지만 보관한다.
+//                         다른 스레드(writer 등)가 해제하면 주인 arena의 remote 목록에 넣어두고, 주인이 다음 할당 때 가져간다.
+// 그보다 크면 힙에서 바로 할당한다.
+//
+// 풀에서 꺼낸 메모리는 힙으로 돌려주지 않으므로, 한 번 데워진 뒤(steady state)에는 힙 할당이 일어나지 않는다.
+// GetStats()의 heapAllocations가 더 늘지 않는지로 확인할 수 있다.
+
+struct LogBufferPoolStats {
+    uint64_t slabAllocations = 0;       // slab에서 나간 버퍼
+    uint64_t slabFrees = 0;
+    uint64_t arenaAllocations = 0;      // arena에서 나간 버퍼
+    uint64_t arenaFrees = 0;
+    uint64_t arenaRemoteFrees = 0;      // 그 중 다른 스레드가 해제한 것
+    uint64_t oversizeAllocations = 0;   // MAX_ARENA_SIZE를 넘어서 힙에서 바로 할당한 버퍼
+    uint64_t heapAllocations = 0;       // 풀이 힙에서 메모리를 가져온 횟수 (slab 청크 / arena 블록 / oversize 포함)
+    uint64_t heapBytes = 0;             // 풀이 지금 힙에서 가지고 있는 바이트
+};
+
+namespace LogPoolDetail {
+    class ThreadArena;
+
+    enum BlockKind : uint32_t {
+        BLOCK_SLAB,
+        BLOCK_ARENA,
+        BLOCK_OVERSIZE
+    };
+
+    // 사용자 메모리 바로 앞에 붙는 머리. 크기가 16의 배수라서 뒤따르는 사용자 메모리도 16바이트 정렬이다.
+    struct alignas(16) BlockHeader {
+        std::atomic<BlockHeader*> next{ nullptr };  // free list 연결. 사용자 메모리와 겹치지 않으므로 쓰는 중에 다른 스레드가 읽어도 된다.
+        ThreadArena* arena = nullptr;               // BLOCK_ARENA의 주인
+        uint32_t sizeClass = 0;
+        uint32_t kind = BLOCK_SLAB;
+    };
+
+    inline BlockHeader* HeaderOf(void* p) { return reinterpret_cast<BlockHeader*>(p) - 1; }
+    inline void* PayloadOf(BlockHeader* header) { return header + 1; }
+
+    // 태그를 붙인 Treiber stack. 포인터와 같은 64비트에 pop 횟수를 넣어서 ABA를 막는다.
+    // (x64 사용자 주소는 하위 48비트 안에 있으므로 상위 16비트를, 32비트 빌드는 상위 32비트를 태그로 쓴다)
+    class FreeList {
+    public:
+        void Push(BlockHeader* node)
+        {
+            uint64_t old = head.load(std::memory_order_relaxed);
+            do {
+                node->next.store(Unpack(old), std::memory_order_relaxed);
+            } while (!head.compare_exchange_weak(old, Pack(node, Tag(old)), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // 같은 slab 청크에서 잘라낸 [first, last] 목록을 한 번에 넣는다.
+        void PushList(BlockHeader* first, BlockHeader* last)
+        {
+            uint64_t old = head.load(std::memory_order_relaxed);
+            do {
+                last->next.store(Unpack(old), std::memory_order_relaxed);
+            } while (!head.compare_exchange_weak(old, Pack(first, Tag(old)), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        BlockHeader* Pop(void)
+        {
+            uint64_t old = head.load(std::memory_order_acquire);
+            for (;;) {
+                BlockHeader* node = Unpack(old);
+                if (node == nullptr) {
+                    return nullptr;
+                }
+
+                // node가 다른 스레드에 먼저 꺼내져 다시 들어왔다면 태그가 달라서 CAS가 실패한다.
+                BlockHeader* next = node->next.load(std::memory_order_relaxed);
+                if (head.compare_exchange_weak(old, Pack(next, Tag(old) + 1), std::memory_order_acquire, std::memory_order_acquire)) {
+                    return node;
+                }
+            }
+        }
+
+    private:
+        static constexpr int POINTER_BITS = sizeof(void*) == 8 ? 48 : 32;
+        static constexpr uint64_t POINTER_MASK = (1ull << POINTER_BITS) - 1;
+
+        static uint64_t Pack(BlockHeader* node, uint64_t tag)
+        {
+            return (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) & POINTER_MASK) | (tag << POINTER_BITS);
+        }
+        static BlockHeader* Unpack(uint64_t value) { return reinterpret_cast<BlockHeader*>(static_cast<uintptr_t>(value & POINTER_MASK)); }
+        static uint64_t Tag(uint64_t value) { return value >> POINTER_BITS; }
+
+        std::atomic<uint64_t> head{ 0 };
+    };
+
+    constexpr size_t MIN_SLAB_SIZE = 64;
+    constexpr size_t SLAB_CLASS_COUNT = 11;                                             // 64B ~ 64KB
+    constexpr size_t MAX_SLAB_SIZE = MIN_SLAB_SIZE << (SLAB_CLASS_COUNT - 1);
+    constexpr size_t SLAB_CHUNK_SIZE = 256 * 1024;                                      // slab을 한 번에 잘라낼 힙 청크 크기
+
+    constexpr size_t ARENA_CLASS_COUNT = 10;                                            // 128KB ~ 64MB
+    constexpr size_t MAX_ARENA_SIZE = MAX_SLAB_SIZE << ARENA_CLASS_COUNT;
+    constexpr size_t ARENA_RETAIN_BYTES = 64 * 1024 * 1024;                             // 스레드 하나가 보관하는 블록의 합. 넘으면 힙에 돌려준다. (크기별로 하나는 항상 보관)
+
+    struct Counters {
+        std::atomic<uint64_t> slabAllocations{ 0 };
+        std::atomic<uint64_t> slabFrees{ 0 };
+        std::atomic<uint64_t> arenaAllocations{ 0 };
+        std::atomic<uint64_t> arenaFrees{ 0 };
+        std::atomic<uint64_t> arenaRemoteFrees{ 0 };
+        std::atomic<uint64_t> oversizeAllocations{ 0 };
+        std::atomic<uint64_t> heapAllocations{ 0 };
+        std::atomic<int64_t> heapBytes{ 0 };
+    };
+
+    inline Counters& GetCounters(void)
+    {
+        static Counters counters;
+        return counters;
+    }
+
+    inline void* HeapAllocate(size_t bytes)
+    {
+        Counters& counters = GetCounters();
+        counters.heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        counters.heapBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        return ::operator new(bytes);
+    }
+
+    inline void HeapFree(void* p, size_t bytes)
+    {
+        GetCounters().heapBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        ::operator delete(p);
+    }
+
+    inline size_t ArenaBlockBytes(uint32_t sizeClass) { return sizeof(BlockHeader) + (MAX_SLAB_SIZE << (sizeClass + 1)); }
+
+    // 스레드 하나가 보관하는 큰 블록들. 주인 스레드만 local을 만지고, 다른 스레드는 remote에 넣기만 한다.
+    // 참조 수 = 주인 스레드(1) + 밖에 나가있는 블록 수. 주인이 끝나고 마지막 블록이 돌아오면 스스로를 지운다.
+    class ThreadArena {
+    public:
+        void* Allocate(uint32_t sizeClass)
+        {
+            BlockHeader* block = local[sizeClass];
+            if (block == nullptr) {
+                TakeRemote(sizeClass);
+                block = local[sizeClass];
+            }
+
+            if (block != nullptr) {
+                local[sizeClass] = block->next.load(std::memory_order_relaxed);
+                localCount[sizeClass]--;
+                localBytes -= ArenaBlockBytes(sizeClass);
+            }
+            else {
+                block = new (HeapAllocate(ArenaBlockBytes(sizeClass))) BlockHeader;
+                block->arena = this;
+                block->sizeClass = sizeClass;
+                block->kind = BLOCK_ARENA;
+            }
+
+            references.fetch_add(1, std::memory_order_relaxed);
+            GetCounters().arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+            return PayloadOf(block);
+        }
+
+        // owner가 true라면 이 arena의 주인 스레드에서 호출한 것
+        void Free(BlockHeader* block, bool owner)
+        {
+            GetCounters().arenaFrees.fetch_add(1, std::memory_order_relaxed);
+
+            if (owner) {
+                KeepLocal(block);
+            }
+            else {
+                GetCounters().arenaRemoteFrees.fetch_add(1, std::memory_order_relaxed);
+                BlockHeader* head = remote[block->sizeClass].load(std::memory_order_relaxed);
+                do {
+                    block->next.store(head, std::memory_order_relaxed);
+                } while (!remote[block->sizeClass].compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            Release();
+        }
+
+        // 주인 스레드가 끝날 때. 보관하던 블록을 힙에 돌려주고 주인 몫의 참조를 놓는다.
+        void Retire(void)
+        {
+            for (uint32_t sizeClass = 0; sizeClass < ARENA_CLASS_COUNT; ++sizeClass) {
+                FreeChain(local[sizeClass]);
+                local[sizeClass] = nullptr;
+                localCount[sizeClass] = 0;
+                FreeChain(remote[sizeClass].exchange(nullptr, std::memory_order_acquire));
+            }
+            Release();
+        }
+
+    private:
+        ~ThreadArena(void)
+        {
+            for (auto& list : remote) {
+                FreeChain(list.exchange(nullptr, std::memory_order_acquire));
+            }
+        }
+
+        void Release(void)
+        {
+            if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        void KeepLocal(BlockHeader* block)
+        {
+            const uint32_t sizeClass = block->sizeClass;
+            const size_t bytes = ArenaBlockBytes(sizeClass);
+            if (localCount[sizeClass] != 0 && localBytes + bytes > ARENA_RETAIN_BYTES) {
+                HeapFree(block, bytes);
+                return;
+            }
+            block->next.store(local[sizeClass], std::memory_order_relaxed);
+            local[sizeClass] = block;
+            localCount[sizeClass]++;
+            localBytes += bytes;
+        }
+
+        void TakeRemote(uint32_t sizeClass)
+        {
+            BlockHeader* block = remote[sizeClass].exchange(nullptr, std::memory_order_acquire);
+            while (block != nullptr) {
+                BlockHeader* next = block->next.load(std::memory_order_relaxed);
+                KeepLocal(block);
+                block = next;
+            }
+        }
+
+        static void FreeChain(BlockHeader* block)
+        {
+            while (block != nullptr) {
+                BlockHeader* next = block->next.load(std::memory_order_relaxed);
+                HeapFree(block, ArenaBlockBytes(block->sizeClass));
+                block = next;
+            }
+        }
+
+        BlockHeader* local[ARENA_CLASS_COUNT] = {};
+        size_t localCount[ARENA_CLASS_COUNT] = {};
+        size_t localBytes = 0;                                      // local에 보관중인 블록의 합
+        std::atomic<BlockHeader*> remote[ARENA_CLASS_COUNT] = {};
+        std::atomic<size_t> references{ 1 };
+    };
+
+    // 스레드가 끝날 때 arena를 놓아준다.
+    struct ThreadArenaHolder {
+        ThreadArena* arena = nullptr;
+        ~ThreadArenaHolder(void)
+        {
+            if (arena != nullptr) {
+                arena->Retire();
+            }
+        }
+    };
+
+    inline ThreadArenaHolder& CurrentArenaHolder(void)
+    {
+        static thread_local ThreadArenaHolder holder;
+        return holder;
+    }
+
+    // 크기별 slab free list. 프로그램이 끝날 때까지 힙에 돌려주지 않는다.
+    class SlabPool {
+    public:
+        static SlabPool& Instance(void)
+        {
+            // 다른 정적 객체(SystemLogManager 등)의 소멸자에서도 해제할 수 있도록 일부러 지우지 않는다.
+            static SlabPool* pool = new SlabPool;
+            return *pool;
+        }
+
+        void* Allocate(uint32_t sizeClass)
+        {
+            BlockHeader* block = freeLists[sizeClass].Pop();
+            if (block == nullptr) {
+                block = Refill(sizeClass);
+            }
+
+            GetCounters().slabAllocations.fetch_add(1, std::memory_order_relaxed);
+            return PayloadOf(block);
+        }
+
+        void Free(BlockHeader* block)
+        {
+            GetCounters().slabFrees.fetch_add(1, std::memory_order_relaxed);
+            freeLists[block->sizeClass].Push(block);
+        }
+
+    private:
+        // 청크 하나를 같은 크기의 slab들로 잘라서 하나는 돌려주고 나머지는 free list에 넣는다.
+        BlockHeader* Refill(uint32_t sizeClass)
+        {
+            const size_t stride = sizeof(BlockHeader) + (MIN_SLAB_SIZE << sizeClass);
+            const size_t count = stride < SLAB_CHUNK_SIZE ? SLAB_CHUNK_SIZE / stride : 1;
+            char* chunk = static_cast<char*>(HeapAllocate(stride * count));
+
+            BlockHeader* first = nullptr;
+            BlockHeader* previous = nullptr;
+            for (size_t i = 0; i < count; ++i) {
+                BlockHeader* block = new (chunk + i * stride) BlockHeader;
+                block->sizeClass = sizeClass;
+                block->kind = BLOCK_SLAB;
+                if (previous != nullptr) {
+                    previous->next.store(block, std::memory_order_relaxed);
+                }
+                else {
+                    first = block;
+                }
+                previous = block;
+            }
+
+            if (count > 1) {
+                freeLists[sizeClass].PushList(first->next.load(std::memory_order_relaxed), previous);
+            }
+            return first;
+        }
+
+        FreeList freeLists[SLAB_CLASS_COUNT];
+    };
+}
+
+class LogBufferPool {
+public:
+    static constexpr size_t MAX_SLAB_SIZE = LogPoolDetail::MAX_SLAB_SIZE;
+    static constexpr size_t MAX_ARENA_SIZE = LogPoolDetail::MAX_ARENA_SIZE;
+
+    // 16바이트 정렬된 bytes 이상의 메모리
+    static void* Allocate(size_t bytes)
+    {
+        using namespace LogPoolDetail;
+
+        if (bytes <= MAX_SLAB_SIZE) {
+            uint32_t sizeClass = 0;
+            while ((MIN_SLAB_SIZE << sizeClass) < bytes)
+                ++sizeClass;
+            return SlabPool::Instance().Allocate(sizeClass);
+        }
+
+        if (bytes <= MAX_ARENA_SIZE) {
+            uint32_t sizeClass = 0;
+            while ((MAX_SLAB_SIZE << (sizeClass + 1)) < bytes)
+                ++sizeClass;
+
+            ThreadArenaHolder& holder = CurrentArenaHolder();
+            if (holder.arena == nullptr) {
+                holder.arena = new ThreadArena;
+            }
+            return holder.arena->Allocate(sizeClass);
+        }
+
+        GetCounters().oversizeAllocations.fetch_add(1, std::memory_order_relaxed);
+        BlockHeader* block = new (HeapAllocate(sizeof(BlockHeader) + bytes)) BlockHeader;
+        block->kind = BLOCK_OVERSIZE;
+        block->arena = reinterpret_cast<ThreadArena*>(static_cast<uintptr_t>(bytes));     // oversize는 크기를 arena 자리에 둔다.
+        return PayloadOf(block);
+    }
+
+    static void Free(void* p)
+    {
+        using namespace LogPoolDetail;
+
+        if (p == nullptr) {
+            return;
+        }
+
+        BlockHeader* block = HeaderOf(p);
+        switch (block->kind) {
+        case BLOCK_SLAB:
+            SlabPool::Instance().Free(block);
+            break;
+
+        case BLOCK_ARENA:
+            block->arena->Free(block, block->arena == CurrentArenaHolder().arena);
+            break;
+
+        default:
+            HeapFree(block, sizeof(BlockHeader) + static_cast<size_t>(reinterpret_cast<uintptr_t>(block->arena)));
+            break;
+        }
+    }
+
+    static LogBufferPoolStats GetStats(void)
+    {
+        const LogPoolDetail::Counters& counters = LogPoolDetail::GetCounters();
+
+        LogBufferPoolStats stats;
+        stats.slabAllocations = counters.slabAllocations.load(std::memory_order_relaxed);
+        stats.slabFrees = counters.slabFrees.load(std::memory_order_relaxed);
+        stats.arenaAllocations = counters.arenaAllocations.load(std::memory_order_relaxed);
+        stats.arenaFrees = counters.arenaFrees.load(std::memory_order_relaxed);
+        stats.arenaRemoteFrees = counters.arenaRemoteFrees.load(std::memory_order_relaxed);
+        stats.oversizeAllocations = counters.oversizeAllocations.load(std::memory_order_relaxed);
+        stats.heapAllocations = counters.heapAllocations.load(std::memory_order_relaxed);
+        stats.heapBytes = static_cast<uint64_t>(counters.heapBytes.load(std::memory_order_relaxed));
+        return stats;
+    }
+};
+
+// unique_ptr로 LogBufferPool::Allocate의 결과를 들고 있을 때
+struct LogPoolDeleter {
+    void operator()(void* p) const noexcept { LogBufferPool::Free(p); }
+};
+
+// LogBufferPool을 쓰는 표준 allocator. 상태가 없으므로 모든 인스턴스가 같다.
+template <typename T>
+struct LogPoolAllocator {
+    using value_type = T;
+
+    LogPoolAllocator(void) noexcept = default;
+    template <typename U>
+    LogPoolAllocator(const LogPoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) { return static_cast<T*>(LogBufferPool::Allocate(count * sizeof(T))); }
+    void deallocate(T* p, size_t) noexcept { LogBufferPool::Free(p); }
+
+    template <typename U>
+    bool operator==(const LogPoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const LogPoolAllocator<U>&) const noexcept { return false; }
+};
+
+// 풀에서 메모리를 받는 문자열. 스레드 사이로 넘어가는 줄(LogHex 등)에 쓴다.
+using LogString = std::basic_string<wchar_t, std::char_traits<wchar_t>, LogPoolAllocator<wchar_t>>;
+
+// LogString의 UTF-8 버전. 스레드 사이로 넘어가는 로그 텍스트(LogRecord::text)에 쓴다.
+using LogUtf8String = std::basic_string<char, std::char_traits<char>, LogPoolAllocator<char>>;
@@ -0,0 +1,347 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "LogBufferPool.h"
+#include "LogLine.h"
+#include "LogPlatform.h"
+#include "LogQueue.h"
+#include "LogTime.h"
+#include "LogTypeRegistry.h"
+
+// 릴리스 빌드(NDEBUG)에서는 콘솔 출력이 기본으로 꺼져있다. (SYSLOG_CONSOLE로 켤 수 있음)
+#ifndef SYSLOG_CONSOLE_DEFAULT_ENABLED
+#ifdef NDEBUG
+#define SYSLOG_CONSOLE_DEFAULT_ENABLED false
+#else
+#define SYSLOG_CONSOLE_DEFAULT_ENABLED true
+#endif
+#endif
+
+// 콘솔 출력 기준 (SYSLOG_CONSOLE)
+struct LogConsolePolicy {
+    bool enabled = SYSLOG_CONSOLE_DEFAULT_ENABLED;
+    LogLevel level = LogLevel::LEVEL_DEBUG;     // 이 레벨 이상의 로그만 출력 (파일의 SYSLOG_LEVEL과 따로 정한다)
+    size_t bufferLines = 4096;                  // 콘솔 스레드가 밀렸을 때 담아둘 수 있는 줄 수. 넘치는 줄은 버린다.
+    uint32_t maxLinesPerSecond = 200;           // type 하나가 1초에 출력할 수 있는 줄 수. 넘는 줄은 버리고 수만 알린다. 0이면 제한 없음
+    bool coalesceRepeats = true;                // 한 type에서 같은 메시지가 이어지면 "last message repeated N times" 한 줄로 줄인다.
+};
+
+struct LogConsoleStats {
+    uint64_t writtenLines = 0;      // 콘솔에 출력한 줄
+    uint64_t droppedLines = 0;      // 버퍼가 가득 차서 버린 줄
+    uint64_t limitedLines = 0;      // maxLinesPerSecond를 넘어서 버린 줄
+    uint64_t repeatedLines = 0;     // 앞의 메시지와 같아서 개수만 센 줄
+};
+
+// 콘솔 출력 전용 sink. 로그를 남기는 스레드(또는 writer / collector 스레드)는 줄을 버퍼에 넣기만 하고 기다리지 않으며,
+// 콘솔 스레드가 모아서 stdout에 쓴다. 터미널이 느려도 버퍼가 넘칠 뿐 파일 기록은 느려지지 않는다.
+// 반복 확인과 1초당 줄 수 제한은 넣는 쪽에서 버퍼에 넣기 전에 하므로, 같은 메시지가 쏟아져도 버퍼와 한도를 차지하지 않는다.
+// 반복 수는 다른 메시지가 들어오거나 REPORT_INTERVAL이 지나면 "[type] last message repeated N times"로 알린다.
+class LogConsoleSink {
+public:
+    static constexpr size_t NO_MESSAGE = static_cast<size_t>(-1);
+
+    // typeRegistry : 알림 줄을 남길 때 type id로 sink를 찾을 곳
+    explicit LogConsoleSink(const LogTypeRegistry& typeRegistry)
+        : registry(typeRegistry), types(new TypeState[LogTypeRegistry::MAX_TYPES]), printedHashes(new uint64_t[LogTypeRegistry::MAX_TYPES]()) {}
+    ~LogConsoleSink(void) { Stop(); }
+
+    LogConsoleSink(const LogConsoleSink&) = delete;
+    LogConsoleSink& operator=(const LogConsoleSink&) = delete;
+
+    // 이전 기준으로 돌던 콘솔 스레드는 남은 줄을 출력한 뒤 멈춘다. 로그를 남기기 전, 초기화 시점에 호출한다.
+    void Start(const LogConsolePolicy& consolePolicy)
+    {
+        Stop();
+
+        policy = consolePolicy;
+        minLevel.store(policy.level, std::memory_order_relaxed);
+        if (!policy.enabled) {
+            return;
+        }
+
+#ifdef _WIN32
+        // 콘솔에는 UTF-8 바이트를 그대로 쓴다.
+        SetConsoleOutputCP(CP_UTF8);
+#endif
+
+        queue = std::make_unique<BoundedLogQueue<Entry>>(policy.bufferLines);
+        running = true;
+        thread = std::thread(&LogConsoleSink::ThreadProc, this);
+
+        enabled.store(true);
+    }
+
+    // 버퍼에 남은 줄을 출력하고 콘솔 스레드를 멈춘다.
+    void Stop(void)
+    {
+        if (!enabled.exchange(false)) {
+            return;
+        }
+
+        // 이미 버퍼에 넣는 중인 스레드가 끝날 때까지 대기
+        while (activeProducers.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            running = false;
+        }
+        wakeup.notify_one();
+        thread.join();
+
+        queue.reset();
+    }
+
+    bool IsEnabled(LogLevel level) const
+    {
+        return enabled.load(std::memory_order_relaxed) && level >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    // 완성된 줄 하나를 콘솔에 넘긴다. 꺼져있거나, 레벨이 낮거나, 한도를 넘었거나, 버퍼가 가득 찼다면 버린다.
+    // sink          : 줄의 type. 콘솔 스레드가 sink->utf8Name을 알림 줄에 쓴다.
+    // line          : '\n'까지 포함한 UTF-8 줄 (Submit이 반환되면 다시 써도 된다)
+    // messageOffset : line에서 메시지가 시작하는 위치. 반복을 비교하는 구간이며, NO_MESSAGE라면 비교하지 않는다. (LogHex)
+    void Submit(const LogTypeSink& sink, LogLevel level, LogTimestamp timestamp, std::string_view line, size_t messageOffset)
+    {
+        if (!IsEnabled(level)) {
+            return;
+        }
+
+        activeProducers.fetch_add(1);
+
+        // Stop과 경합한 경우 버린다.
+        if (!enabled.load()) {
+            activeProducers.fetch_sub(1);
+            return;
+        }
+
+        TypeState& state = types[sink.id];
+
+        // 바로 앞의 메시지와 같다면 수만 센다.
+        uint64_t hash = 0;
+        if (policy.coalesceRepeats && messageOffset != NO_MESSAGE && messageOffset <= line.size()) {
+            hash = std::hash<std::string_view>()(line.substr(messageOffset)) | 1;
+            if (state.lastHash.exchange(hash, std::memory_order_relaxed) == hash) {
+                state.repeated.fetch_add(1, std::memory_order_relaxed);
+                repeatedLines.fetch_add(1, std::memory_order_relaxed);
+                activeProducers.fetch_sub(1);
+                return;
+            }
+        }
+        else {
+            state.lastHash.store(0, std::memory_order_relaxed);
+        }
+
+        if (policy.maxLinesPerSecond == 0 || Admit(state, timestamp / 1000000000ull)) {
+            Entry entry;
+            entry.sink = &sink;
+            entry.hash = hash;
+            // 지금까지 센 반복은 앞의 메시지의 것이다. 이 줄보다 먼저 알린다.
+            entry.repeatsBefore = state.repeated.exchange(0, std::memory_order_relaxed);
+            entry.line.assign(line.data(), line.size());
+
+            if (!queue->TryPush(std::move(entry))) {
+                state.repeated.fetch_add(entry.repeatsBefore, std::memory_order_relaxed);
+                droppedLines.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            // 출력하지 않은 메시지의 반복은 세지 않는다. (이어지는 같은 메시지도 한도에 걸린다)
+            state.lastHash.store(0, std::memory_order_relaxed);
+        }
+
+        activeProducers.fetch_sub(1);
+    }
+
+    LogConsoleStats GetStats(void) const
+    {
+        LogConsoleStats stats;
+        stats.writtenLines = writtenLines.load(std::memory_order_relaxed);
+        stats.droppedLines = droppedLines.load(std::memory_order_relaxed);
+        stats.limitedLines = limitedLines.load(std::memory_order_relaxed);
+        stats.repeatedLines = repeatedLines.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Entry {
+        const LogTypeSink* sink = nullptr;
+        uint64_t hash = 0;                      // 메시지의 해시. 반복을 비교하지 않는 줄(LogHex)은 0
+        uint64_t repeatsBefore = 0;             // 이 줄 앞에 알릴 앞 메시지의 반복 수
+        LogUtf8String line;                     // LogBufferPool에서 할당
+    };
+
+    // 넣는 쪽에서 쓰는 type 별 상태
+    struct TypeState {
+        std::atomic<uint64_t> lastHash{ 0 };    // 마지막으로 들어온 메시지의 해시
+        std::atomic<uint64_t> repeated{ 0 };    // lastHash 메시지가 이어서 들어온 수 (아직 알리지 않은 것)
+
+        // 1초 창. 창이 바뀌는 순간에는 몇 줄 더 들어갈 수 있다.
+        std::atomic<uint64_t> second{ 0 };
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint64_t> limited{ 0 };     // 한도를 넘어 버린 수 (아직 알리지 않은 것)
+    };
+
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{ 10 };        // 콘솔 스레드가 버퍼를 확인하는 주기
+    static constexpr std::chrono::milliseconds REPORT_INTERVAL{ 1000 };    // 반복 수 / 버린 줄 수를 알리는 주기
+
+    bool Admit(TypeState& state, uint64_t second)
+    {
+        uint64_t current = state.second.load(std::memory_order_relaxed);
+        if (current != second && state.second.compare_exchange_strong(current, second, std::memory_order_relaxed)) {
+            state.count.store(0, std::memory_order_relaxed);
+        }
+
+        if (state.count.fetch_add(1, std::memory_order_relaxed) < policy.maxLinesPerSecond) {
+            return true;
+        }
+
+        state.limited.fetch_add(1, std::memory_order_relaxed);
+        limitedLines.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void ThreadProc(void)
+    {
+        auto lastReport = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> guard(lock);
+        while (running) {
+            guard.unlock();
+
+            Drain();
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= REPORT_INTERVAL) {
+                Report();
+                lastReport = now;
+            }
+            Write();
+
+            guard.lock();
+            wakeup.wait_for(guard, POLL_INTERVAL, [&] { return !running; });
+        }
+        guard.unlock();
+
+        // 종료 시에는 남은 줄과 알림을 모두 출력
+        Drain();
+        Report();
+        Write();
+    }
+
+    // 버퍼의 줄을 output에 모은다.
+    void Drain(void)
+    {
+        Entry entry;
+        while (queue->TryPop(entry)) {
+            AppendRepeated(*entry.sink, entry.repeatsBefore);
+            output.append(entry.line.data(), entry.line.size());
+            printedHashes[entry.sink->id] = entry.hash;
+            writtenLines.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 아직 알리지 않은 반복 수와 버린 줄 수(한도 / 버퍼)를 output에 붙인다.
+    void Report(void)
+    {
+        for (size_t id = 0; id < LogTypeRegistry::MAX_TYPES; ++id) {
+            TypeState& state = types[id];
+
+            // 반복되는 메시지가 아직 버퍼에 있다면(출력하기 전이라면) 다음 차례에 알린다.
+            uint64_t repeated = 0;
+            const uint64_t lastHash = state.lastHash.load(std::memory_order_relaxed);
+            if (lastHash == 0 || lastHash == printedHashes[id]) {
+                repeated = state.repeated.exchange(0, std::memory_order_relaxed);
+            }
+            const uint64_t limited = state.limited.exchange(0, std::memory_order_relaxed);
+            if (repeated == 0 && limited == 0) {
+                continue;
+            }
+
+            // 줄이 들어온 type만 값이 있으므로 sink는 이미 등록되어 있다.
+            const LogTypeSink* sink = registry.GetSink(static_cast<LogTypeId>(id));
+            if (sink == nullptr) {
+                continue;
+            }
+
+            AppendRepeated(*sink, repeated);
+            if (limited != 0) {
+                output += '[';
+                output += sink->utf8Name;
+                output += "] ";
+                AppendDigits(output, limited);
+                output += " lines dropped by the console rate limit\n";
+            }
+        }
+
+        const uint64_t dropped = droppedLines.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops) {
+            output += "[console] ";
+            AppendDigits(output, dropped - reportedDrops);
+            output += " lines dropped, console output fell behind\n";
+            reportedDrops = dropped;
+        }
+    }
+
+    // "[type] last message repeated N times"
+    void AppendRepeated(const LogTypeSink& sink, uint64_t count)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        output += '[';
+        output += sink.utf8Name;
+        output += "] last message repeated ";
+        AppendDigits(output, count);
+        output += " times\n";
+    }
+
+    void Write(void)
+    {
+        if (output.empty()) {
+            return;
+        }
+
+        std::fwrite(output.data(), 1, output.size(), stdout);
+        std::fflush(stdout);
+        output.clear();
+    }
+
+    LogConsolePolicy policy;
+    const LogTypeRegistry& registry;
+
+    std::unique_ptr<BoundedLogQueue<Entry>> queue;
+    std::unique_ptr<TypeState[]> types;
+    std::unique_ptr<uint64_t[]> printedHashes;  // 콘솔 스레드 전용. type 별로 마지막에 출력한 메시지의 해시
+    std::string output;                         // 콘솔 스레드 전용. 이번 차례에 출력할 내용
+    uint64_t reportedDrops = 0;                 // 콘솔 스레드 전용. 지금까지 알린 droppedLines
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<LogLevel> minLevel{ LogLevel::LEVEL_DEBUG };   // policy.level. 넣는 쪽이 activeProducers를 올리기 전에 읽는다.
+    std::atomic<int> activeProducers{ 0 };
+
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wakeup;
+    bool running = false;                       // lock으로 보호
+
+    std::atomic<uint64_t> writtenLines{ 0 };
+    std::atomic<uint64_t> droppedLines{ 0 };
+    std::atomic<uint64_t> limitedLines{ 0 };
+    std::atomic<uint64_t> repeatedLines{ 0 };
+};
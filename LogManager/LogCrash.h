@@ -0,0 +1,384 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "LogBinary.h"
+#include "LogPlatform.h"
+#include "LogTime.h"
+
+// 크래시 때 아직 파일에 쓰지 못한 로그를 남기는 비상 파일.
+// 파일은 미리(InitializeCrashHandler) 만들어 열어두고, 크래시 때는 시그널 핸들러 안에서도 안전한 write만 쓴다. (힙 할당 / lock 없음)
+// 형식은 바이너리 로그(LogBinary.h)와 같아서 LogDecoder로 텍스트를 복원한다.
+// type이 바뀔 때마다 SESSION 블록을 두고, 로그 하나를 레코드 하나짜리 RECORDS 블록으로 쓴다.
+// 지연 포맷된 로그는 바로 앞에 포맷 문자열을 id 1로 정의하는 STRINGS 블록을 둔다. (디코더는 같은 id를 다시 정의하면 덮어씀)
+class LogEmergencyFile {
+public:
+    LogEmergencyFile(void) = default;
+    ~LogEmergencyFile(void) { Close(); }
+
+    LogEmergencyFile(const LogEmergencyFile&) = delete;
+    LogEmergencyFile& operator=(const LogEmergencyFile&) = delete;
+
+    // 있으면 비운다.
+    bool Open(const std::wstring& fileName)
+    {
+        Close();
+
+#ifdef _WIN32
+        file = CreateFileW(fileName.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+#else
+        descriptor = open(std::filesystem::path(fileName).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (descriptor < 0) {
+            return false;
+        }
+#endif
+        path = fileName;
+        written = false;
+        return true;
+    }
+
+    // 크래시 없이 끝났다면 아무것도 쓰지 않은 빈 파일이므로 지운다.
+    void Close(void)
+    {
+        if (!IsOpen()) {
+            return;
+        }
+
+#ifdef _WIN32
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+#else
+        close(descriptor);
+        descriptor = -1;
+#endif
+        if (!written) {
+            std::error_code error;
+            std::filesystem::remove(std::filesystem::path(path), error);
+        }
+        path.clear();
+    }
+
+    bool IsOpen(void) const
+    {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return descriptor >= 0;
+#endif
+    }
+
+    // 아래는 크래시 핸들러 안에서 호출한다.
+
+    // 파일 머리말. 처음 한 번
+    void BeginFile(void)
+    {
+        uint8_t header[LogBinary::FILE_HEADER_SIZE] = {};
+        std::memcpy(header, LogBinary::FILE_MAGIC, sizeof(LogBinary::FILE_MAGIC));
+        header[8] = static_cast<uint8_t>(LogBinary::FILE_VERSION & 0xFF);
+        header[9] = static_cast<uint8_t>(LogBinary::FILE_VERSION >> 8);
+        header[10] = static_cast<uint8_t>(sizeof(wchar_t));
+        WriteRaw(header, sizeof(header));
+    }
+
+    // 이후의 레코드가 속한 type
+    void BeginSession(std::wstring_view typeName, bool micros)
+    {
+        uint8_t prefix[PREFIX_CAPACITY];
+        uint8_t* cursor = PutVarint(prefix, micros ? LogBinary::SESSION_FLAG_MICROS : 0);
+        cursor = PutVarint(cursor, typeName.size());
+        WriteBlock(LogBinary::BLOCK_SESSION, prefix, static_cast<size_t>(cursor - prefix), typeName.data(), typeName.size() * sizeof(wchar_t));
+    }
+
+    // 지연 포맷된 로그. args는 LogArgBuffer::Data()의 인자 바이트
+    void WriteFormatRecord(uint8_t level, int64_t index, LogTimestamp timestamp, const wchar_t* format, const uint8_t* args, size_t argBytes)
+    {
+        const size_t formatLength = std::char_traits<wchar_t>::length(format);
+
+        uint8_t prefix[PREFIX_CAPACITY];
+        uint8_t* cursor = PutVarint(prefix, 1);
+        cursor = PutVarint(cursor, EMERGENCY_FORMAT_ID);
+        cursor = PutVarint(cursor, formatLength);
+        WriteBlock(LogBinary::BLOCK_STRINGS, prefix, static_cast<size_t>(cursor - prefix), format, formatLength * sizeof(wchar_t));
+
+        cursor = PutRecordPrefix(prefix, static_cast<uint8_t>(level | LogBinary::RECORD_FLAG_FORMAT), index, true, timestamp);
+        cursor = PutVarint(cursor, EMERGENCY_FORMAT_ID);
+        cursor = PutVarint(cursor, argBytes);
+        WriteBlock(LogBinary::BLOCK_RECORDS, prefix, static_cast<size_t>(cursor - prefix), args, argBytes);
+    }
+
+    // 포맷된 메시지. completeLine이면 머리말까지 포함한 완성된 줄 (여러 줄이어도 된다)
+    void WriteTextRecord(uint8_t level, int64_t index, LogTimestamp timestamp, std::string_view text, bool completeLine)
+    {
+        const uint8_t flags = completeLine ? LogBinary::RECORD_FLAG_LINE | LogBinary::RECORD_FLAG_UTF8 : LogBinary::RECORD_FLAG_UTF8;
+
+        uint8_t prefix[PREFIX_CAPACITY];
+        uint8_t* cursor = PutRecordPrefix(prefix, static_cast<uint8_t>(level | flags), index, !completeLine, timestamp);
+        cursor = PutVarint(cursor, text.size());
+        WriteBlock(LogBinary::BLOCK_RECORDS, prefix, static_cast<size_t>(cursor - prefix), text.data(), text.size());
+    }
+
+    // LogHex와 같은 레코드. 바이트만 남기며 헥스 문자열은 디코더가 만든다.
+    // head / tail : 원래 버퍼(totalBytes)의 앞 / 뒤 (LogHexBytes). 잘라내지 않았다면 tailBytes는 0
+    void WriteHexRecord(uint8_t level, LogTimestamp timestamp, std::string_view description, const void* head, size_t headBytes,
+        const void* tail, size_t tailBytes, uint64_t totalBytes)
+    {
+        uint8_t prefix[PREFIX_CAPACITY];
+        uint8_t* cursor = PutRecordPrefix(prefix, static_cast<uint8_t>(level | LogBinary::RECORD_FLAG_HEX | LogBinary::RECORD_FLAG_UTF8), 0, false, timestamp);
+        cursor = PutVarint(cursor, description.size());
+        const size_t descriptionOffset = static_cast<size_t>(cursor - prefix);
+
+        uint8_t lengths[PREFIX_CAPACITY];
+        uint8_t* lengthsEnd = PutVarint(lengths, totalBytes);
+        lengthsEnd = PutVarint(lengthsEnd, headBytes);
+        lengthsEnd = PutVarint(lengthsEnd, tailBytes);
+        const size_t lengthBytes = static_cast<size_t>(lengthsEnd - lengths);
+
+        WriteBlockHeader(LogBinary::BLOCK_RECORDS, descriptionOffset + description.size() + lengthBytes + headBytes + tailBytes);
+        WriteRaw(prefix, descriptionOffset);
+        WriteRaw(description.data(), description.size());
+        WriteRaw(lengths, lengthBytes);
+        WriteRaw(head, headBytes);
+        WriteRaw(tail, tailBytes);
+    }
+
+    // data의 헥스 덤프. (LogHex와 같은 레코드)
+    void WriteHexDump(uint8_t level, LogTimestamp timestamp, std::string_view description, const uint8_t* data, size_t length)
+    {
+        WriteHexRecord(level, timestamp, description, data, length, nullptr, 0, length);
+    }
+
+    void Sync(void)
+    {
+#ifdef _WIN32
+        FlushFileBuffers(file);
+#else
+        fsync(descriptor);
+#endif
+    }
+
+private:
+    static constexpr size_t PREFIX_CAPACITY = 128;         // 블록에서 뒤에 붙는 데이터 앞까지 (varint 최대 10바이트 * 10개 미만)
+    static constexpr uint64_t EMERGENCY_FORMAT_ID = 1;
+
+    // LogBinary::AppendVarint와 같은 인코딩
+    static uint8_t* PutVarint(uint8_t* out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            *out++ = static_cast<uint8_t>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<uint8_t>(value);
+        return out;
+    }
+
+    // 레코드 하나짜리 RECORDS 블록의 요약과 레코드 머리. timestamp가 곧 baseTimestamp이므로 차이는 0이다.
+    static uint8_t* PutRecordPrefix(uint8_t* out, uint8_t header, int64_t index, bool hasIndex, LogTimestamp timestamp)
+    {
+        out = PutVarint(out, 1);
+        out = PutVarint(out, hasIndex ? static_cast<uint64_t>(index) : 1);     // 인덱스가 없으면 minIndex > maxIndex
+        out = PutVarint(out, hasIndex ? static_cast<uint64_t>(index) : 0);
+        out = PutVarint(out, timestamp);
+        out = PutVarint(out, timestamp);
+        out = PutVarint(out, timestamp);
+        *out++ = static_cast<uint8_t>(1u << (header & 7));
+        *out++ = header;
+        out = PutVarint(out, static_cast<uint64_t>(index));
+        return PutVarint(out, LogBinary::ZigZag(0));
+    }
+
+    // 블록 머리 + prefix + tail. 큰 데이터(tail)는 복사하지 않고 그 자리에서 바로 쓴다.
+    void WriteBlock(LogBinary::BlockType type, const uint8_t* prefix, size_t prefixBytes, const void* tail, size_t tailBytes)
+    {
+        WriteBlockHeader(type, prefixBytes + tailBytes);
+        WriteRaw(prefix, prefixBytes);
+        WriteRaw(tail, tailBytes);
+    }
+
+    void WriteBlockHeader(LogBinary::BlockType type, size_t payloadBytes)
+    {
+        const uint32_t payloadLength = static_cast<uint32_t>(payloadBytes);
+
+        uint8_t header[LogBinary::BLOCK_HEADER_SIZE];
+        header[0] = static_cast<uint8_t>(type);
+        for (int i = 0; i < 4; ++i)
+            header[1 + i] = static_cast<uint8_t>((payloadLength >> (i * 8)) & 0xFF);
+
+        WriteRaw(header, sizeof(header));
+    }
+
+    void WriteRaw(const void* data, size_t size)
+    {
+        const char* cursor = static_cast<const char*>(data);
+        written = true;
+
+        while (size > 0) {
+#ifdef _WIN32
+            DWORD done = 0;
+            const DWORD request = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+            if (!WriteFile(file, cursor, request, &done, nullptr) || done == 0) {
+                return;
+            }
+#else
+            const ssize_t done = write(descriptor, cursor, size);
+            if (done < 0 && errno == EINTR) {
+                continue;
+            }
+            if (done <= 0) {
+                return;
+            }
+#endif
+            cursor += done;
+            size -= static_cast<size_t>(done);
+        }
+    }
+
+    std::wstring path;
+    bool written = false;               // 크래시 때 무언가 썼는지. 아니라면 Close에서 지운다.
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int descriptor = -1;
+#endif
+};
+
+// 크래시 때 헥스 덤프로 남길 메모리 (SetCrashDumpRegion). 핸들러는 lock 없이 읽으므로 data를 마지막에 공개한다.
+class LogCrashRegion {
+public:
+    static constexpr size_t MAX_DESCRIPTION_BYTES = 256;
+
+    // description은 MAX_DESCRIPTION_BYTES에서 (UTF-8 문자 경계로) 잘린다. data가 nullptr이면 해제
+    void Set(std::string_view description, const void* data, size_t length)
+    {
+        region.store(nullptr);
+
+        size_t descriptionBytes = description.size() < MAX_DESCRIPTION_BYTES ? description.size() : MAX_DESCRIPTION_BYTES;
+        while (descriptionBytes < description.size() && descriptionBytes > 0
+            && (static_cast<uint8_t>(description[descriptionBytes]) & 0xC0) == 0x80) {
+            descriptionBytes--;
+        }
+        std::memcpy(descriptionText, description.data(), descriptionBytes);
+        descriptionLength = descriptionBytes;
+        regionLength = length;
+
+        region.store(static_cast<const uint8_t*>(data), std::memory_order_release);
+    }
+
+    // 크래시 핸들러 전용
+    const uint8_t* Data(void) const { return region.load(std::memory_order_acquire); }
+    size_t Length(void) const { return regionLength; }
+    std::string_view Description(void) const { return std::string_view(descriptionText, descriptionLength); }
+
+private:
+    std::atomic<const uint8_t*> region{ nullptr };
+    size_t regionLength = 0;
+    char descriptionText[MAX_DESCRIPTION_BYTES] = {};
+    size_t descriptionLength = 0;
+};
+
+// 치명적인 시그널(SIGSEGV / SIGABRT / SIGBUS / SIGILL / SIGFPE)을 받으면 onCrash를 한 번 부른 뒤 원래 동작(프로세스 종료)으로 넘긴다.
+// Windows는 처리되지 않은 SEH 예외(SetUnhandledExceptionFilter)와 CRT 시그널(abort 등)을 받는다.
+// onCrash는 시그널 핸들러 안에서 불리므로 async-signal-safe한 일만 해야 한다.
+// 동시에 다른 스레드에서도 크래시가 나면 먼저 들어온 쪽만 onCrash를 부른다.
+namespace LogCrash {
+
+    using CrashCallback = void (*)(int signal);
+
+    namespace Detail {
+        inline std::atomic<CrashCallback> callback{ nullptr };
+        inline std::atomic<bool> entered{ false };
+
+#ifdef _WIN32
+        constexpr int FATAL_SIGNALS[] = { SIGSEGV, SIGABRT, SIGILL, SIGFPE };
+        inline LPTOP_LEVEL_EXCEPTION_FILTER previousFilter = nullptr;
+#else
+        constexpr int FATAL_SIGNALS[] = { SIGSEGV, SIGABRT, SIGBUS, SIGILL, SIGFPE };
+#endif
+
+        inline void RunCallback(int signal)
+        {
+            if (entered.exchange(true)) {
+                return;
+            }
+            if (CrashCallback onCrash = callback.load()) {
+                onCrash(signal);
+            }
+        }
+
+        inline void HandleSignal(int signal)
+        {
+            RunCallback(signal);
+
+            // 기본 동작으로 되돌린 뒤 다시 보낸다. 핸들러가 끝나면 바로 전달되어 원래대로 (코어 덤프와 함께) 끝난다.
+#ifdef _WIN32
+            std::signal(signal, SIG_DFL);
+#else
+            struct sigaction action = {};
+            action.sa_handler = SIG_DFL;
+            sigaction(signal, &action, nullptr);
+#endif
+            std::raise(signal);
+        }
+
+#ifdef _WIN32
+        inline LONG WINAPI HandleException(EXCEPTION_POINTERS* exception)
+        {
+            RunCallback(SIGSEGV);
+            return previousFilter != nullptr ? previousFilter(exception) : EXCEPTION_CONTINUE_SEARCH;
+        }
+#endif
+    }
+
+    inline void Install(CrashCallback onCrash)
+    {
+        Detail::callback.store(onCrash);
+
+#ifdef _WIN32
+        Detail::previousFilter = SetUnhandledExceptionFilter(&Detail::HandleException);
+        for (int signal : Detail::FATAL_SIGNALS)
+            std::signal(signal, &Detail::HandleSignal);
+#else
+        struct sigaction action = {};
+        action.sa_handler = &Detail::HandleSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+        for (int signal : Detail::FATAL_SIGNALS)
+            sigaction(signal, &action, nullptr);
+#endif
+    }
+
+    // 원래 동작으로 되돌린다. (정상 종료 시)
+    inline void Uninstall(void)
+    {
+        Detail::callback.store(nullptr);
+
+#ifdef _WIN32
+        SetUnhandledExceptionFilter(Detail::previousFilter);
+        for (int signal : Detail::FATAL_SIGNALS)
+            std::signal(signal, SIG_DFL);
+#else
+        struct sigaction action = {};
+        action.sa_handler = SIG_DFL;
+        for (int signal : Detail::FATAL_SIGNALS)
+            sigaction(signal, &action, nullptr);
+#endif
+    }
+}
@@ -0,0 +1,122 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+
+#include "LogBinaryDecode.h"
+#include "LogLz4.h"
+#include "LogPlatform.h"
+#include "LogTime.h"
+
+// 바이너리 로그(YYYYMM_type.bin)를 텍스트 로그와 같은 형식으로 되돌리는 도구.
+//
+//     LogDecoder <input.bin | input.bin.lz4> [output.txt] [--level DEBUG|ERROR|SYSTEM] [--index FROM TO] [--time "YYYY-MM-DD HH:MM:SS" "YYYY-MM-DD HH:MM:SS"]
+//
+// --level : 이 레벨 이상만 (SYSLOG_LEVEL과 같은 기준)
+// --index : 인덱스가 FROM 이상 TO 이하인 로그만. 인덱스가 없는 LogHex는 빠진다.
+// --time  : 로컬 시각 기준으로 FROM 이상 TO 이하(TO의 초 끝까지)인 로그만
+// 조건이 있으면 RECORDS 블록의 요약으로 블록을 통째로 건너뛰고, 블록 안에서도 조건에 맞는 레코드만 인자를 포맷한다.
+// output을 주지 않으면 콘솔로 출력한다. 출력은 텍스트 로그와 같은 UTF-8이며, 압축된 파일(.lz4, LogArchiver)은 풀어서 읽는다.
+
+bool ParseLevel(const char* text, int& level)
+{
+    for (int i = 0; i <= static_cast<int>(LogLevel::LEVEL_SYSTEM); ++i) {
+        std::wstring_view name = LogLevelToString(static_cast<LogLevel>(i));
+        if (std::strlen(text) == name.size() && std::equal(name.begin(), name.end(), text)) {
+            level = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+int Usage(void)
+{
+    std::wcerr << L"usage: LogDecoder <input.bin> [output.txt] [--level DEBUG|ERROR|SYSTEM] [--index FROM TO] "
+        L"[--time \"YYYY-MM-DD HH:MM:SS\" \"YYYY-MM-DD HH:MM:SS\"]\n";
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    const char* inputPath = nullptr;
+    const char* outputPath = nullptr;
+    DecodeFilter filter;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            if (!ParseLevel(argv[++i], filter.minLevel)) return Usage();
+        }
+        else if (std::strcmp(argv[i], "--index") == 0 && i + 2 < argc) {
+            filter.byIndex = true;
+            filter.fromIndex = std::strtoll(argv[++i], nullptr, 10);
+            filter.toIndex = std::strtoll(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--time") == 0 && i + 2 < argc) {
+            std::time_t from = 0, to = 0;
+            if (!ParseLocalTime(argv[++i], from) || !ParseLocalTime(argv[++i], to)) return Usage();
+            filter.byTime = true;
+            filter.fromTime = static_cast<LogTimestamp>(from) * 1000000000ull;
+            filter.toTime = static_cast<LogTimestamp>(to) * 1000000000ull + 999999999ull;
+        }
+        else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            return Usage();
+        }
+        else if (inputPath == nullptr) {
+            inputPath = argv[i];
+        }
+        else if (outputPath == nullptr) {
+            outputPath = argv[i];
+        }
+        else {
+            return Usage();
+        }
+    }
+
+    if (inputPath == nullptr) {
+        return Usage();
+    }
+
+    std::ifstream input(inputPath, std::ios::binary);
+    if (!input) {
+        std::wcerr << L"파일을 열 수 없습니다.\n";
+        return 1;
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    const size_t pathLength = std::strlen(inputPath);
+    if (pathLength > 4 && std::strcmp(inputPath + pathLength - 4, ".lz4") == 0) {
+        std::string decompressed;
+        if (!LogLz4::DecompressFrame(file.data(), file.size(), decompressed)) {
+            std::wcerr << L"압축을 풀 수 없습니다.\n";
+            return 1;
+        }
+        file.assign(decompressed.begin(), decompressed.end());
+    }
+
+    // 텍스트 로그(LogFile)와 같이 UTF-8 바이트를 그대로 써야 같은 바이트가 나온다.
+    DecodeStats stats;
+    bool ok;
+    if (outputPath != nullptr) {
+        std::FILE* output = std::fopen(outputPath, "wb");
+        if (output == nullptr) {
+            std::wcerr << L"출력 파일을 열 수 없습니다.\n";
+            return 1;
+        }
+        ok = DecodeLogBinary(file, filter, output, stats);
+        std::fclose(output);
+    }
+    else {
+        LogPlatform::SetBinaryMode(stdout);
+        ok = DecodeLogBinary(file, filter, stdout, stats);
+    }
+
+    std::wcerr << L"blocks " << stats.blocks << L" (skipped " << stats.skippedBlocks << L"), records "
+        << stats.records << L" (decoded " << stats.decodedRecords << L")\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,350 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "LogMetrics.h"
+#include "LogRotation.h"
+
+// 로그 파일 버퍼를 실제 파일로 내보내는 기준
+struct LogFlushPolicy {
+    size_t flushBytes = 64 * 1024;                          // 버퍼에 이만큼(바이트) 쌓이면 기록. 0이면 매번 기록
+    std::chrono::milliseconds flushInterval{ 1000 };        // 마지막 기록 후 이 시간이 지나면 기록. 0이면 사용 안 함
+};
+
+class LogOpenFileCache;
+
+// 열린 핸들을 LogOpenFileCache에 알리는 파일 (LogFile, LogMappedFile, LogBinaryFile)
+class LogCachedFile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 열린 파일 수를 함께 셀 캐시. 파일을 쓰기 전, 한 번만 정한다. (nullptr이면 세지 않음)
+    void SetOpenFileCache(LogOpenFileCache* cache) { openFileCache = cache; }
+
+protected:
+    LogCachedFile(void) = default;
+    ~LogCachedFile(void) = default;
+
+    // 파일의 lock을 잡은 채, 핸들을 열기 직전 / 닫은 직후(열지 못한 경우 포함)에 부른다.
+    // 열기 전에 자리를 잡아두므로 여러 스레드가 동시에 열어도 한도를 넘는 핸들이 먼저 생기지 않는다.
+    void NotifyOpening(void);
+    void NotifyClosed(void);
+
+    // 캐시가 가장 오래 쓰이지 않은 파일을 고를 때 보는 시각
+    void Touch(Clock::time_point now) { lastUse.store(now.time_since_epoch().count(), std::memory_order_relaxed); }
+
+private:
+    friend class LogOpenFileCache;
+
+    // 캐시가 자신의 lock을 잡은 채 부른다. 파일의 lock을 바로 잡을 수 있으면 기록하지 않은 버퍼를 쓰고 핸들을 닫는다.
+    // (NotifyClosed는 부르지 않는다) 쓰는 중이라 lock을 잡지 못하면 false
+    virtual bool TryEvict(void) = 0;
+
+    LogOpenFileCache* openFileCache = nullptr;
+    std::atomic<Clock::rep> lastUse{ 0 };
+};
+
+// 여러 종류의 로그 파일이 함께 쓰는 열린 파일 수 한도.
+// 파일이 핸들을 열려고 할 때 한도를 넘으면 그 자리에서 가장 오래 쓰이지 않은 다른 파일부터 닫는다. (닫힌 파일은 다음 Write 때 다시 열린다)
+// 고른 파일이 마침 쓰는 중이면 그다음으로 오래된 파일을 닫고, 모두 쓰는 중이면 잠시 한도를 넘긴 채 Trim에 맡긴다.
+// lock 순서는 파일의 lock -> 캐시의 lock이며, 캐시는 다른 파일의 lock을 try_lock으로만 잡는다.
+class LogOpenFileCache {
+public:
+    explicit LogOpenFileCache(size_t maxOpen = 0) : maxOpenFiles(maxOpen) {}
+
+    LogOpenFileCache(const LogOpenFileCache&) = delete;
+    LogOpenFileCache& operator=(const LogOpenFileCache&) = delete;
+
+    // 0이면 제한 없음. 줄어든 한도는 다음 Opening / Trim 때 맞춘다.
+    void SetLimit(size_t maxOpen)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        maxOpenFiles = maxOpen;
+    }
+
+    size_t OpenCount(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return openFiles.size();
+    }
+
+    void Opening(LogCachedFile* file)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (std::find(openFiles.begin(), openFiles.end(), file) == openFiles.end()) {
+            openFiles.push_back(file);
+        }
+        EvictLocked(file);
+    }
+
+    void Closed(LogCachedFile* file)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = std::find(openFiles.begin(), openFiles.end(), file);
+        if (found != openFiles.end()) {
+            *found = openFiles.back();
+            openFiles.pop_back();
+        }
+    }
+
+    // 쓰는 중이라 닫지 못하고 남은 만큼 닫는다. 주기적으로 호출된다.
+    void Trim(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        EvictLocked(nullptr);
+    }
+
+private:
+    // keep(지금 여는 파일)을 뺀 나머지에서 오래 쓰이지 않은 순서로 닫는다.
+    void EvictLocked(const LogCachedFile* keep)
+    {
+        if (maxOpenFiles == 0 || openFiles.size() <= maxOpenFiles) {
+            return;
+        }
+
+        candidates.clear();
+        for (LogCachedFile* file : openFiles) {
+            if (file != keep) {
+                candidates.emplace_back(file->lastUse.load(std::memory_order_relaxed), file);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        for (const auto& [lastUse, file] : candidates) {
+            if (openFiles.size() <= maxOpenFiles) {
+                break;
+            }
+            if (file->TryEvict()) {
+                auto found = std::find(openFiles.begin(), openFiles.end(), file);
+                *found = openFiles.back();
+                openFiles.pop_back();
+            }
+        }
+    }
+
+    std::mutex lock;
+    size_t maxOpenFiles;
+    std::vector<LogCachedFile*> openFiles;                                  // 핸들이 열려있는 파일
+    std::vector<std::pair<LogCachedFile::Clock::rep, LogCachedFile*>> candidates;    // EvictLocked에서 재사용
+};
+
+inline void LogCachedFile::NotifyOpening(void)
+{
+    if (openFileCache != nullptr) {
+        openFileCache->Opening(this);
+    }
+}
+
+inline void LogCachedFile::NotifyClosed(void)
+{
+    if (openFileCache != nullptr) {
+        openFileCache->Closed(this);
+    }
+}
+
+// 한 type의 로그 파일. 파일을 매번 열고 닫지 않고 열어둔 채로 버퍼에 모았다가 정책에 따라 기록한다.
+// 받은 UTF-8 바이트를 변환 없이 그대로 파일에 쓴다.
+// 쓰는 파일 이름(GetLogFileName의 결과)이 바뀌면 이전 파일을 닫고 새 파일로 넘어가며,
+// 기간 안에서도 LogRotationPolicy의 한도에 닿으면 다음 조각으로 넘어간다. 다 쓴 파일은 archiver에 넘긴다. (LogSegmentTracker)
+// 핸들 수는 LogOpenFileCache가 다른 파일들과 함께 센다. (SetOpenFileCache)
+class LogFile : public LogCachedFile {
+public:
+    using Clock = LogCachedFile::Clock;
+
+    LogFile(void) = default;
+    ~LogFile(void) { Close(); }
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // fileName  : 이번 로그가 들어가야 할 파일
+    // text      : UTF-8로 완성된 줄 (length는 바이트 수)
+    // records   : text에 담긴 로그 수. 한 번에 쓰는 text는 나누지 않으므로 maxRecords를 그만큼 넘길 수 있다.
+    // flushNow  : 정책과 상관없이 바로 파일에 기록할지 여부 (ERROR 이상의 로그 등)
+    // rotation  : 파일을 나누는 기준 (이 type의 LogTypeSink::rotation)
+    void Write(const std::wstring& fileName, const char* text, size_t length, size_t records, bool flushNow, const LogFlushPolicy& policy,
+        const LogRotationPolicy& rotation)
+    {
+        LogTimedLock<std::mutex> guard(lock, lockWaits);
+
+        auto now = Clock::now();
+
+        if (!segments.IsCurrentPeriod(fileName)) {
+            FlushLocked(now);
+            CloseStream();
+            segments.BeginPeriod(fileName, rotation);
+        }
+
+        // 버퍼가 flushBytes보다 크게 자라지 않도록 먼저 비우고, flushBytes 이상인 조각(싱크의 한 차례 등)은 버퍼를 거치지 않고 바로 쓴다.
+        // 그래서 버퍼는 처음에 flushBytes만큼 잡아두면 더 자라지 않는다.
+        if (buffer.capacity() < policy.flushBytes) {
+            buffer.reserve(policy.flushBytes);
+        }
+        if (!buffer.empty() && buffer.size() + length > policy.flushBytes) {
+            FlushLocked(now);
+        }
+        if (length > 0 && length >= policy.flushBytes) {
+            WriteStream(text, length);
+            lastFlush = now;
+        }
+        else {
+            buffer.append(text, length);
+        }
+        lastWrite = now;
+        Touch(now);
+
+        const bool full = segments.Add(length, records, rotation);
+        if (full || flushNow || buffer.size() >= policy.flushBytes || IsFlushDue(now, policy)) {
+            FlushLocked(now);
+        }
+
+        if (full) {
+            CloseStream();
+            segments.NextSegment(rotation);
+        }
+    }
+
+    // 시간 기준 플러시와 유휴 파일 닫기. 주기적으로 호출된다.
+    // 반환값 : 호출 후에도 파일이 열려있는지 여부
+    bool Maintain(Clock::time_point now, const LogFlushPolicy& policy, std::chrono::milliseconds idleTimeout)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (!buffer.empty() && IsFlushDue(now, policy)) {
+            FlushLocked(now);
+        }
+
+        if (stream.is_open() && idleTimeout.count() > 0 && now - lastWrite >= idleTimeout) {
+            FlushLocked(now);
+            CloseStream();
+        }
+
+        return stream.is_open();
+    }
+
+    void Flush(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        FlushLocked(Clock::now());
+    }
+
+    void Close(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        FlushLocked(Clock::now());
+        CloseStream();
+    }
+
+    Clock::time_point GetLastWrite(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return lastWrite;
+    }
+
+    // 지금 쓰고 있는(닫혀있다면 다음 Write 때 다시 열) 파일. 아직 쓴 적이 없으면 빈 문자열
+    std::wstring GetFileName(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return segments.FileName();
+    }
+
+    // Write가 lock을 잡을 때 기다린 사이클 (LogMetrics.h)
+    LogWaitStats GetLockWaits(void) const { return lockWaits.GetStats(); }
+
+    // 크래시 핸들러 전용. 아직 파일에 기록하지 않은 버퍼를 돌려준다.
+    // 다른 스레드가 쓰는 중이라면 잠깐 lock을 기다리며, 잡은 lock은 풀지 않는다. (프로세스가 곧 끝나므로 이후의 Write는 멈춰있게 된다)
+    // 끝내 잡지 못하면(이 스레드가 쓰던 중에 크래시가 난 경우 등) 그대로 읽는다.
+    std::string_view PendingTextForCrash(void)
+    {
+        for (int attempt = 0; attempt < CRASH_LOCK_ATTEMPTS && !lock.try_lock(); ++attempt) {
+        }
+        return buffer;
+    }
+
+private:
+    static constexpr int CRASH_LOCK_ATTEMPTS = 1 << 20;
+
+    bool IsFlushDue(Clock::time_point now, const LogFlushPolicy& policy) const
+    {
+        return policy.flushInterval.count() > 0 && now - lastFlush >= policy.flushInterval;
+    }
+
+    void FlushLocked(Clock::time_point now)
+    {
+        lastFlush = now;
+
+        if (buffer.empty()) {
+            return;
+        }
+
+        WriteStream(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    bool TryEvict(void) override
+    {
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            return false;
+        }
+        if (stream.is_open()) {
+            FlushLocked(Clock::now());
+            stream.close();
+        }
+        return true;
+    }
+
+    void CloseStream(void)
+    {
+        if (stream.is_open()) {
+            stream.close();
+            NotifyClosed();
+        }
+    }
+
+    void WriteStream(const char* text, size_t length)
+    {
+        // 파일이 닫혀있다면(처음 쓰거나, 유휴 상태라 닫혔거나, 롤오버된 경우) 다시 연다. 열린 파일이 한도를 넘으면 다른 파일이 닫힌다.
+        if (!stream.is_open()) {
+            NotifyOpening();
+            stream.open(std::filesystem::path(segments.FileName()), std::ios::app | std::ios::binary);
+            if (!stream.is_open()) {
+                NotifyClosed();
+            }
+        }
+
+        if (stream.is_open()) {
+            stream.write(text, static_cast<std::streamsize>(length));
+            stream.flush();
+        }
+    }
+
+    std::mutex lock;
+    LogWaitHistogram lockWaits;     // Write의 lock 대기
+    std::ofstream stream;
+    LogSegmentTracker segments;     // 지금 쓰고 있는 파일 (type + 기간 + 조각 번호)
+    std::string buffer;             // 아직 파일에 기록되지 않은 로그 (UTF-8)
+    Clock::time_point lastWrite{};
+    Clock::time_point lastFlush{};
+};
+
+// 시간 기준 플러시와 유휴 파일 닫기. 열린 파일 수 한도는 파일을 열 때 LogOpenFileCache가 맞춘다.
+// File은 LogFile과 같은 Maintain을 가진 타입 (LogBinaryFile, LogMappedFile)
+template<typename File>
+void MaintainLogFiles(const std::vector<File*>& files, const LogFlushPolicy& policy, std::chrono::milliseconds idleTimeout)
+{
+    auto now = LogFile::Clock::now();
+    for (File* file : files) {
+        file->Maintain(now, policy, idleTimeout);
+    }
+}
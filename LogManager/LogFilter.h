@@ -0,0 +1,451 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LogLine.h"
+#include "LogPlatform.h"
+#include "LogTypeRegistry.h"
+#include "LogUtf8.h"
+
+// 레벨 집합. LogLevel 하나가 비트 하나
+using LogLevelMask = uint8_t;
+
+constexpr LogLevelMask LOG_LEVELS_NONE = 0;
+constexpr LogLevelMask LOG_LEVELS_ALL = 0x07;
+
+constexpr LogLevelMask LogLevelBit(LogLevel level)
+{
+    return static_cast<LogLevelMask>(1u << static_cast<unsigned>(level));
+}
+
+// level과 그 위의 레벨
+constexpr LogLevelMask LogLevelsFrom(LogLevel level)
+{
+    return static_cast<LogLevelMask>(LOG_LEVELS_ALL & ~(LogLevelBit(level) - 1));
+}
+
+// 필터 설정 한 줄. type의 레벨 집합을 정하거나(levels), 이 설정에서 빼서 아래 단계의 값을 따르게 한다. (inherit)
+struct LogFilterRule {
+    std::wstring type;
+    LogLevelMask levels = LOG_LEVELS_ALL;
+    bool inherit = false;
+};
+
+// 필터 설정 파일 / 제어 소켓으로 받은 설정
+struct LogFilterConfig {
+    bool reset = false;                     // 이전에 받은 규칙을 모두 지우고 적용 (제어 소켓에서만 의미가 있음)
+    bool hasDefault = false;                // "* = ..." 줄이 있었는지
+    bool defaultInherit = false;            // "* = INHERIT"
+    LogLevelMask defaultLevels = LOG_LEVELS_ALL;
+    std::vector<LogFilterRule> rules;
+};
+
+// "DEBUG" / "LEVEL_DEBUG" (대소문자 구분 없음)
+inline bool ParseLogLevelName(std::string_view name, LogLevel& level)
+{
+    std::string upper;
+    for (char c : name)
+        upper.push_back((c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c);
+    std::string_view text = upper;
+    if (text.substr(0, 6) == "LEVEL_") {
+        text.remove_prefix(6);
+    }
+
+    if (text == "DEBUG") { level = LogLevel::LEVEL_DEBUG; return true; }
+    if (text == "ERROR") { level = LogLevel::LEVEL_ERROR; return true; }
+    if (text == "SYSTEM") { level = LogLevel::LEVEL_SYSTEM; return true; }
+    return false;
+}
+
+inline std::string_view TrimLogFilterText(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r'))
+        text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+        text.remove_suffix(1);
+    return text;
+}
+
+// 필터 설정을 읽는다. 한 줄에 규칙 하나이며 '#' 뒤는 주석이다.
+//   * = ERROR              정하지 않은 type은 ERROR 이상
+//   Memory = DEBUG         Memory type은 DEBUG 이상
+//   Battle = [DEBUG, SYSTEM]   그 레벨만
+//   Chat = NONE            남기지 않음 (OFF도 같음)   ALL은 모두
+//   Memory = INHERIT       이 설정에서 규칙을 빼고 아래 단계(기본 레벨 / 설정 파일)를 따름
+//   reset                  이전에 받은 규칙을 모두 지움 (제어 소켓)
+// 잘못된 줄이 있으면 false와 함께 error에 줄 번호와 이유를 남기며, config는 쓰지 않는다.
+inline bool ParseLogFilterConfig(std::string_view text, LogFilterConfig& config, std::string& error)
+{
+    LogFilterConfig parsed;
+
+    size_t lineNumber = 0;
+    while (!text.empty()) {
+        const size_t lineEnd = text.find('\n');
+        std::string_view line = text.substr(0, lineEnd);
+        text.remove_prefix(lineEnd == std::string_view::npos ? text.size() : lineEnd + 1);
+        lineNumber++;
+
+        line = TrimLogFilterText(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        const auto fail = [&](const char* reason) {
+            error = "line " + std::to_string(lineNumber) + ": " + reason + " (" + std::string(line) + ")";
+            return false;
+        };
+
+        if (line == "reset" || line == "RESET") {
+            parsed.reset = true;
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        if (equals == std::string_view::npos) {
+            return fail("expected 'type = level'");
+        }
+
+        const std::string_view type = TrimLogFilterText(line.substr(0, equals));
+        std::string_view value = TrimLogFilterText(line.substr(equals + 1));
+        if (type.empty() || value.empty()) {
+            return fail("expected 'type = level'");
+        }
+
+        LogFilterRule rule;
+        if (value == "INHERIT" || value == "inherit") {
+            rule.inherit = true;
+        }
+        else if (value == "NONE" || value == "none" || value == "OFF" || value == "off") {
+            rule.levels = LOG_LEVELS_NONE;
+        }
+        else if (value == "ALL" || value == "all") {
+            rule.levels = LOG_LEVELS_ALL;
+        }
+        else if (value.front() == '[') {
+            if (value.back() != ']') {
+                return fail("missing ']'");
+            }
+            value = value.substr(1, value.size() - 2);
+
+            rule.levels = LOG_LEVELS_NONE;
+            while (!value.empty()) {
+                const size_t comma = value.find(',');
+                const std::string_view name = TrimLogFilterText(value.substr(0, comma));
+                value.remove_prefix(comma == std::string_view::npos ? value.size() : comma + 1);
+
+                LogLevel level;
+                if (!ParseLogLevelName(name, level)) {
+                    return fail("unknown level");
+                }
+                rule.levels |= LogLevelBit(level);
+            }
+        }
+        else {
+            LogLevel level;
+            if (!ParseLogLevelName(value, level)) {
+                return fail("unknown level");
+            }
+            rule.levels = LogLevelsFrom(level);
+        }
+
+        if (type == "*") {
+            parsed.hasDefault = true;
+            parsed.defaultInherit = rule.inherit;
+            parsed.defaultLevels = rule.levels;
+        }
+        else {
+            AppendWide(rule.type, type);
+            parsed.rules.push_back(std::move(rule));
+        }
+    }
+
+    config = std::move(parsed);
+    return true;
+}
+
+// "DEBUG ERROR" 처럼 집합에 든 레벨 이름. 비어있으면 "NONE"
+inline std::wstring LogLevelMaskToString(LogLevelMask levels)
+{
+    std::wstring text;
+    for (LogLevel level : { LogLevel::LEVEL_DEBUG, LogLevel::LEVEL_ERROR, LogLevel::LEVEL_SYSTEM }) {
+        if (levels & LogLevelBit(level)) {
+            if (!text.empty()) {
+                text += L' ';
+            }
+            text += LogLevelToString(level);
+        }
+    }
+    return text.empty() ? L"NONE" : text;
+}
+
+// 실행 중에 바꿀 수 있는 type / 레벨 별 필터.
+// 설정은 세 단계로 겹친다. 기본 레벨(SYSLOG_LEVEL) 위에 설정 파일의 규칙, 그 위에 실행 중에 받은 규칙(API / 제어 소켓)이 덮어쓴다.
+// 규칙이 바뀌면 mutex 안에서 type id 별 레벨 집합을 다시 계산해 atomic으로 공개한다. 로그를 남기는 쪽은 락 없이 읽기만 한다.
+//   MayPass : 어느 type에서든 켜진 레벨의 합집합. type을 찾기 전에 대부분의 로그를 load 하나로 걸러낸다.
+//   Passes  : type 하나의 레벨 집합. 규칙이 없는 type은 기본값을 따른다.
+// 규칙에 나온 type은 아직 로그를 남기지 않았더라도 이 때 등록해서 id를 받는다.
+class LogFilter {
+public:
+    explicit LogFilter(LogTypeRegistry& typeRegistry) : registry(typeRegistry), typeLevels(new std::atomic<uint8_t>[LogTypeRegistry::MAX_TYPES])
+    {
+        for (size_t id = 0; id < LogTypeRegistry::MAX_TYPES; ++id)
+            typeLevels[id].store(USE_DEFAULT, std::memory_order_relaxed);
+    }
+
+    LogFilter(const LogFilter&) = delete;
+    LogFilter& operator=(const LogFilter&) = delete;
+
+    bool MayPass(LogLevel level) const
+    {
+        return (enabledLevels.load(std::memory_order_relaxed) & LogLevelBit(level)) != 0;
+    }
+
+    bool Passes(LogTypeId typeId, LogLevel level) const
+    {
+        uint8_t levels = typeLevels[typeId].load(std::memory_order_relaxed);
+        if (levels & USE_DEFAULT) {
+            levels = defaultLevels.load(std::memory_order_relaxed);
+        }
+        return (levels & LogLevelBit(level)) != 0;
+    }
+
+    // 기본 레벨 (SYSLOG_LEVEL)
+    void SetBaseLevels(LogLevelMask levels)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        baseLevels = levels;
+        Publish();
+    }
+
+    // 설정 파일의 규칙을 통째로 바꾼다.
+    void SetFileConfig(const LogFilterConfig& config)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        fileLayer = Layer();
+        Merge(fileLayer, config);
+        Publish();
+    }
+
+    // 실행 중에 받은 규칙을 이전 규칙 위에 덧붙인다. (config.reset이면 이전 규칙을 지운 뒤)
+    void ApplyRuntimeConfig(const LogFilterConfig& config)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (config.reset) {
+            runtimeLayer = Layer();
+        }
+        Merge(runtimeLayer, config);
+        Publish();
+    }
+
+    // type 하나의 레벨 집합을 실행 중에 정한다. inherit이면 정한 값을 지워 설정 파일 / 기본 레벨을 따른다.
+    void SetRuntimeType(std::wstring_view type, LogLevelMask levels, bool inherit)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (inherit) {
+            runtimeLayer.types.erase(std::wstring(type));
+        }
+        else {
+            runtimeLayer.types[std::wstring(type)] = levels;
+        }
+        Publish();
+    }
+
+    // 지금 적용된 규칙. ("* = ERROR SYSTEM, Memory = DEBUG ERROR SYSTEM")
+    std::wstring Describe(void) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        std::wstring text = L"* = " + LogLevelMaskToString(defaultLevels.load(std::memory_order_relaxed));
+        for (const auto& [id, levels] : assignedTypes) {
+            const LogTypeSink* sink = registry.GetSink(id);
+            if (sink != nullptr) {
+                text += L", " + sink->name + L" = " + LogLevelMaskToString(levels);
+            }
+        }
+        return text;
+    }
+
+private:
+    static constexpr uint8_t USE_DEFAULT = 0x80;    // typeLevels에서 이 type에는 규칙이 없다는 표시
+
+    struct Layer {
+        bool hasDefault = false;
+        LogLevelMask defaultLevels = LOG_LEVELS_ALL;
+        std::map<std::wstring, LogLevelMask> types;
+    };
+
+    static void Merge(Layer& layer, const LogFilterConfig& config)
+    {
+        if (config.hasDefault) {
+            layer.hasDefault = !config.defaultInherit;
+            layer.defaultLevels = config.defaultLevels;
+        }
+        for (const LogFilterRule& rule : config.rules) {
+            if (rule.inherit) {
+                layer.types.erase(rule.type);
+            }
+            else {
+                layer.types[rule.type] = rule.levels;
+            }
+        }
+    }
+
+    // 세 단계를 합쳐서 공개한다. (lock 안에서)
+    // type 별 값을 먼저 쓰고 합집합을 나중에 쓰므로, 레벨을 넓힐 때 합집합만 보고 통과한 로그가 이전 값에 걸리는 일은 잠깐뿐이다.
+    void Publish(void)
+    {
+        LogLevelMask defaults = baseLevels;
+        if (fileLayer.hasDefault) {
+            defaults = fileLayer.defaultLevels;
+        }
+        if (runtimeLayer.hasDefault) {
+            defaults = runtimeLayer.defaultLevels;
+        }
+
+        std::map<std::wstring, LogLevelMask> merged = fileLayer.types;
+        for (const auto& [type, levels] : runtimeLayer.types)
+            merged[type] = levels;
+
+        std::map<LogTypeId, LogLevelMask> assigned;
+        LogLevelMask enabled = defaults;
+        for (const auto& [type, levels] : merged) {
+            const LogTypeId id = registry.Register(type);
+            if (id == INVALID_LOG_TYPE_ID) {
+                continue;
+            }
+            assigned[id] = levels;
+            enabled |= levels;
+        }
+
+        defaultLevels.store(defaults, std::memory_order_relaxed);
+        for (const auto& [id, levels] : assignedTypes) {
+            if (assigned.find(id) == assigned.end()) {
+                typeLevels[id].store(USE_DEFAULT, std::memory_order_relaxed);
+            }
+        }
+        for (const auto& [id, levels] : assigned)
+            typeLevels[id].store(levels, std::memory_order_relaxed);
+        enabledLevels.store(enabled, std::memory_order_release);
+
+        assignedTypes = std::move(assigned);
+    }
+
+    LogTypeRegistry& registry;
+
+    std::atomic<uint8_t> enabledLevels{ LOG_LEVELS_ALL };   // 어느 type에서든 켜진 레벨
+    std::atomic<uint8_t> defaultLevels{ LOG_LEVELS_ALL };   // 규칙이 없는 type의 레벨
+    std::unique_ptr<std::atomic<uint8_t>[]> typeLevels;     // type id -> 레벨 집합 또는 USE_DEFAULT
+
+    mutable std::mutex lock;                        // 아래 값들을 보호
+    LogLevelMask baseLevels = LOG_LEVELS_ALL;
+    Layer fileLayer;
+    Layer runtimeLayer;
+    std::map<LogTypeId, LogLevelMask> assignedTypes;    // 지금 typeLevels에 규칙이 들어있는 type
+};
+
+// 필터 설정 파일이 바뀌었는지 수정 시각과 크기로 확인한다. (maintenance 스레드에서 주기적으로)
+class LogFilterFileWatcher {
+public:
+    void Watch(const std::filesystem::path& fileName)
+    {
+        path = fileName;
+        lastWriteTime = std::filesystem::file_time_type::min();
+        lastSize = 0;
+        watching = true;
+    }
+
+    bool IsWatching(void) const { return watching; }
+    const std::filesystem::path& Path(void) const { return path; }
+
+    // 지난번과 달라졌다면 true와 함께 파일 내용을 text에 담는다. 처음 부르면 파일이 있는 한 true
+    bool Poll(std::string& text)
+    {
+        if (!watching) {
+            return false;
+        }
+
+        std::error_code error;
+        const auto writeTime = std::filesystem::last_write_time(path, error);
+        if (error) {
+            return false;
+        }
+        const uintmax_t size = std::filesystem::file_size(path, error);
+        if (error || (writeTime == lastWriteTime && size == lastSize)) {
+            return false;
+        }
+
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return false;
+        }
+        text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+        lastWriteTime = writeTime;
+        lastSize = size;
+        return true;
+    }
+
+private:
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastWriteTime = std::filesystem::file_time_type::min();
+    uintmax_t lastSize = 0;
+    bool watching = false;
+};
+
+// 필터 규칙을 받는 제어 소켓. 127.0.0.1의 UDP 포트에 묶이므로 같은 머신에서만 보낼 수 있다.
+// datagram 하나가 설정 파일과 같은 형식의 규칙 묶음이며, 이전에 받은 규칙 위에 덧붙는다. ("reset"으로 지움)
+//   예) printf 'Memory = DEBUG\n' | nc -u -w0 127.0.0.1 <port>
+class LogControlSocket {
+public:
+    static constexpr size_t MAX_DATAGRAM = 8192;
+
+    ~LogControlSocket(void) { Close(); }
+
+    bool Open(uint16_t port)
+    {
+        Close();
+        socket = LogPlatform::OpenLoopbackUdp(port);
+        return socket != LogPlatform::INVALID_SOCKET_HANDLE;
+    }
+
+    void Close(void)
+    {
+        if (socket != LogPlatform::INVALID_SOCKET_HANDLE) {
+            LogPlatform::CloseSocket(socket);
+            socket = LogPlatform::INVALID_SOCKET_HANDLE;
+        }
+    }
+
+    bool IsOpen(void) const { return socket != LogPlatform::INVALID_SOCKET_HANDLE; }
+
+    // 기다리지 않고 datagram 하나를 받는다. 없으면 false
+    bool Poll(std::string& text)
+    {
+        if (socket == LogPlatform::INVALID_SOCKET_HANDLE) {
+            return false;
+        }
+
+        char buffer[MAX_DATAGRAM];
+        const int received = LogPlatform::ReceiveDatagram(socket, buffer, sizeof(buffer));
+        if (received < 0) {
+            return false;
+        }
+        text.assign(buffer, static_cast<size_t>(received));
+        return true;
+    }
+
+private:
+    LogPlatform::SocketHandle socket = LogPlatform::INVALID_SOCKET_HANDLE;
+};
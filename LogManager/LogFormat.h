@@ -0,0 +1,328 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// printf 형식의 로그 포맷 문자열을 컴파일 타임에 해석하고, 넘겨진 인자 타입과 맞는지 검사한다.
+// 해석 결과(리터럴 구간 길이, 변환 지정자 정보)는 LogFormatSlot 배열로 남아서
+// 소비하는 쪽(FormatLogArgs)이 포맷 문자열을 다시 훑지 않고 바로 조립할 수 있다.
+
+// 인자가 버퍼에 저장되는 형태
+enum class LogArgType : uint8_t {
+    ARG_INT32,
+    ARG_UINT32,
+    ARG_INT64,
+    ARG_UINT64,
+    ARG_DOUBLE,
+    ARG_POINTER,
+    ARG_WSTRING,    // [uint32 길이][wchar_t * 길이]
+    ARG_STRING      // [uint32 길이][char * 길이]
+};
+
+namespace LogArgDetail {
+    template <typename T>
+    constexpr bool IsWideString = std::is_same_v<T, const wchar_t*> || std::is_same_v<T, wchar_t*>
+        || std::is_same_v<T, std::wstring> || std::is_same_v<T, std::wstring_view>;
+
+    template <typename T>
+    constexpr bool IsNarrowString = std::is_same_v<T, const char*> || std::is_same_v<T, char*>
+        || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+    template <typename T>
+    constexpr bool AlwaysFalse = false;
+
+    // 인자 타입 T가 버퍼에 어떤 형태로 저장되는지
+    template <typename T>
+    constexpr LogArgType ArgTypeOf(void)
+    {
+        using D = std::decay_t<T>;
+
+        if constexpr (std::is_enum_v<D>) {
+            return ArgTypeOf<std::underlying_type_t<D>>();
+        }
+        else if constexpr (std::is_same_v<D, bool>) {
+            return LogArgType::ARG_INT32;
+        }
+        else if constexpr (std::is_integral_v<D>) {
+            if constexpr (sizeof(D) <= 4)
+                return std::is_signed_v<D> ? LogArgType::ARG_INT32 : LogArgType::ARG_UINT32;
+            else
+                return std::is_signed_v<D> ? LogArgType::ARG_INT64 : LogArgType::ARG_UINT64;
+        }
+        else if constexpr (std::is_floating_point_v<D>) {
+            return LogArgType::ARG_DOUBLE;
+        }
+        else if constexpr (IsWideString<D>) {
+            return LogArgType::ARG_WSTRING;
+        }
+        else if constexpr (IsNarrowString<D>) {
+            return LogArgType::ARG_STRING;
+        }
+        else if constexpr (std::is_pointer_v<D> || std::is_null_pointer_v<D>) {
+            return LogArgType::ARG_POINTER;
+        }
+        else {
+            static_assert(AlwaysFalse<D>, "Log argument type is not supported");
+            return LogArgType::ARG_INT32;
+        }
+    }
+}
+
+// 변환 지정자의 플래그
+enum LogFormatFlag : uint8_t {
+    FORMAT_FLAG_LEFT = 0x01,    // '-'
+    FORMAT_FLAG_PLUS = 0x02,    // '+'
+    FORMAT_FLAG_SPACE = 0x04,   // ' '
+    FORMAT_FLAG_ALT = 0x08,     // '#'
+    FORMAT_FLAG_ZERO = 0x10     // '0'
+};
+
+constexpr int16_t FORMAT_VALUE_NONE = -1;     // width / precision 지정 없음
+constexpr int16_t FORMAT_VALUE_STAR = -2;     // '*' : 인자에서 받음
+
+// 인자를 소비하는 변환 지정자 하나. ("%%"는 리터럴 구간에 그대로 남는다)
+struct LogFormatSlot {
+    uint16_t literalLength = 0;     // 이 지정자 앞의 리터럴 구간 길이 (직전 지정자 끝부터)
+    uint16_t specLength = 0;        // '%'부터 변환 문자까지의 길이
+    int16_t width = FORMAT_VALUE_NONE;
+    int16_t precision = FORMAT_VALUE_NONE;
+    uint8_t flags = 0;
+    char conversion = 0;            // 'd', 's', 'x', ...
+};
+
+enum class LogFormatError {
+    FORMAT_OK,
+    FORMAT_TOO_MANY_CONVERSIONS,    // 인자 수보다 변환 지정자가 많음
+    FORMAT_UNTERMINATED,            // '%'로 끝남
+    FORMAT_UNSUPPORTED_CONVERSION,  // %n 또는 알 수 없는 변환 문자
+    FORMAT_TOO_LONG                 // 리터럴 구간이나 width / precision이 표현 범위를 넘음
+};
+
+struct LogFormatParseResult {
+    size_t slotCount = 0;
+    LogFormatError error = LogFormatError::FORMAT_OK;
+};
+
+// format을 해석해서 slots에 최대 maxSlots개의 변환 지정자를 채운다. 컴파일 타임과 런타임 모두에서 쓸 수 있다.
+constexpr LogFormatParseResult ParseLogFormat(const wchar_t* format, LogFormatSlot* slots, size_t maxSlots)
+{
+    LogFormatParseResult result;
+
+    const wchar_t* p = format;
+    const wchar_t* segmentBegin = format;
+
+    while (*p != L'\0') {
+        if (*p != L'%') {
+            ++p;
+            continue;
+        }
+
+        if (p[1] == L'%') {
+            p += 2;
+            continue;
+        }
+
+        const wchar_t* specBegin = p++;
+
+        LogFormatSlot slot;
+        for (;;) {
+            if (*p == L'-') slot.flags |= FORMAT_FLAG_LEFT;
+            else if (*p == L'+') slot.flags |= FORMAT_FLAG_PLUS;
+            else if (*p == L' ') slot.flags |= FORMAT_FLAG_SPACE;
+            else if (*p == L'#') slot.flags |= FORMAT_FLAG_ALT;
+            else if (*p == L'0') slot.flags |= FORMAT_FLAG_ZERO;
+            else break;
+            ++p;
+        }
+
+        if (*p == L'*') {
+            slot.width = FORMAT_VALUE_STAR;
+            ++p;
+        }
+        else if (*p >= L'0' && *p <= L'9') {
+            int width = 0;
+            while (*p >= L'0' && *p <= L'9') {
+                width = width * 10 + (*p++ - L'0');
+                if (width > 4096) {
+                    result.error = LogFormatError::FORMAT_TOO_LONG;
+                    return result;
+                }
+            }
+            slot.width = static_cast<int16_t>(width);
+        }
+
+        if (*p == L'.') {
+            ++p;
+            if (*p == L'*') {
+                slot.precision = FORMAT_VALUE_STAR;
+                ++p;
+            }
+            else {
+                int precision = 0;
+                while (*p >= L'0' && *p <= L'9') {
+                    precision = precision * 10 + (*p++ - L'0');
+                    if (precision > 4096) {
+                        result.error = LogFormatError::FORMAT_TOO_LONG;
+                        return result;
+                    }
+                }
+                slot.precision = static_cast<int16_t>(precision);
+            }
+        }
+
+        // 길이 지정자는 실제 인자 타입을 알고 있으므로 건너뛴다. (h, hh, l, ll, L, z, j, t, w, I, I32, I64)
+        for (;;) {
+            if (*p == L'h' || *p == L'l' || *p == L'L' || *p == L'z' || *p == L'j' || *p == L't' || *p == L'w') {
+                ++p;
+            }
+            else if (*p == L'I') {
+                ++p;
+                if ((p[0] == L'3' && p[1] == L'2') || (p[0] == L'6' && p[1] == L'4'))
+                    p += 2;
+            }
+            else {
+                break;
+            }
+        }
+
+        switch (*p) {
+        case L'\0':
+            result.error = LogFormatError::FORMAT_UNTERMINATED;
+            return result;
+
+        case L'd': case L'i': case L'u': case L'o': case L'x': case L'X':
+        case L'f': case L'F': case L'e': case L'E': case L'g': case L'G': case L'a': case L'A':
+        case L'c': case L'C': case L's': case L'S': case L'p':
+            slot.conversion = static_cast<char>(*p);
+            break;
+
+        default:
+            result.error = LogFormatError::FORMAT_UNSUPPORTED_CONVERSION;
+            return result;
+        }
+        ++p;
+
+        if (specBegin - segmentBegin > 0xFFFF) {
+            result.error = LogFormatError::FORMAT_TOO_LONG;
+            return result;
+        }
+
+        if (result.slotCount >= maxSlots) {
+            result.error = LogFormatError::FORMAT_TOO_MANY_CONVERSIONS;
+            return result;
+        }
+
+        slot.literalLength = static_cast<uint16_t>(specBegin - segmentBegin);
+        slot.specLength = static_cast<uint16_t>(p - specBegin);
+        slots[result.slotCount++] = slot;
+
+        segmentBegin = p;
+    }
+
+    return result;
+}
+
+// 변환 지정자 하나가 소비하는 인자 수 ('*' width / precision 포함)
+constexpr size_t LogFormatSlotArgCount(const LogFormatSlot& slot)
+{
+    return 1 + (slot.width == FORMAT_VALUE_STAR ? 1 : 0) + (slot.precision == FORMAT_VALUE_STAR ? 1 : 0);
+}
+
+namespace LogFormatDetail {
+    // 아래 함수들은 constexpr가 아니므로 consteval 안에서 호출되면 컴파일 에러가 된다.
+    // 에러 메시지에 함수 이름이 찍히므로 무엇이 잘못됐는지 알 수 있다.
+    inline void LogFormatSyntaxError(void) {}
+    inline void LogFormatArgumentCountMismatch(void) {}
+    inline void LogFormatArgumentTypeMismatch(void) {}
+
+    constexpr bool IsIntegerArg(LogArgType type)
+    {
+        return type == LogArgType::ARG_INT32 || type == LogArgType::ARG_UINT32
+            || type == LogArgType::ARG_INT64 || type == LogArgType::ARG_UINT64;
+    }
+
+    constexpr bool IsConversionCompatible(char conversion, LogArgType type)
+    {
+        switch (conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c': case 'C':
+            return IsIntegerArg(type);
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return type == LogArgType::ARG_DOUBLE;
+        case 's': case 'S':
+            return type == LogArgType::ARG_WSTRING || type == LogArgType::ARG_STRING;
+        case 'p':
+            return type == LogArgType::ARG_POINTER;
+        default:
+            return false;
+        }
+    }
+}
+
+// LOG / SystemLogManager::Log의 포맷 문자열 파라미터.
+// 문자열 리터럴로만 만들 수 있으며, 만들어지는 시점(컴파일 타임)에 변환 지정자와 인자의 수 / 타입을 검사하고
+// 각 지정자의 위치와 옵션을 미리 계산해둔다.
+template <typename... Args>
+class BasicLogFormatString {
+public:
+    static constexpr size_t MAX_SLOTS = sizeof...(Args);
+
+    template <size_t N>
+    consteval BasicLogFormatString(const wchar_t (&str)[N]) : format(str)
+    {
+        LogFormatSlot parsed[MAX_SLOTS + 1] = {};
+        LogFormatParseResult result = ParseLogFormat(str, parsed, MAX_SLOTS);
+
+        if (result.error == LogFormatError::FORMAT_TOO_MANY_CONVERSIONS) {
+            LogFormatDetail::LogFormatArgumentCountMismatch();
+        }
+        else if (result.error != LogFormatError::FORMAT_OK) {
+            LogFormatDetail::LogFormatSyntaxError();
+        }
+
+        constexpr LogArgType types[MAX_SLOTS + 1] = { LogArgDetail::ArgTypeOf<Args>()... };
+
+        size_t argIndex = 0;
+        for (size_t i = 0; i < result.slotCount; ++i) {
+            const LogFormatSlot& slot = parsed[i];
+
+            if (argIndex + LogFormatSlotArgCount(slot) > MAX_SLOTS) {
+                LogFormatDetail::LogFormatArgumentCountMismatch();
+            }
+
+            if (slot.width == FORMAT_VALUE_STAR && !LogFormatDetail::IsIntegerArg(types[argIndex++])) {
+                LogFormatDetail::LogFormatArgumentTypeMismatch();
+            }
+            if (slot.precision == FORMAT_VALUE_STAR && !LogFormatDetail::IsIntegerArg(types[argIndex++])) {
+                LogFormatDetail::LogFormatArgumentTypeMismatch();
+            }
+            if (!LogFormatDetail::IsConversionCompatible(slot.conversion, types[argIndex++])) {
+                LogFormatDetail::LogFormatArgumentTypeMismatch();
+            }
+
+            slots[i] = slot;
+        }
+
+        if (argIndex != MAX_SLOTS) {
+            LogFormatDetail::LogFormatArgumentCountMismatch();
+        }
+
+        slotCount = result.slotCount;
+    }
+
+    const wchar_t* Get(void) const { return format; }
+    const LogFormatSlot* Slots(void) const { return slots.data(); }
+    size_t SlotCount(void) const { return slotCount; }
+
+private:
+    const wchar_t* format;
+    std::array<LogFormatSlot, MAX_SLOTS> slots{};
+    size_t slotCount = 0;
+};
+
+// 인자 타입 추론에 포맷 문자열이 끼어들지 않도록 type_identity로 감싼다.
+template <typename... Args>
+using LogFormatString = BasicLogFormatString<std::type_identity_t<Args>...>;
@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "HexDump.h"
+#include "LogBufferPool.h"
+
+// LogHexPinned의 버퍼를 다 썼을 때 부르는 함수. context / data는 LogHexPinned에 넘긴 값이다.
+// 파일에 쓴 뒤(또는 걸러지거나 큐가 가득 차서 버려진 뒤) 그 로그를 마지막으로 가진 스레드에서 한 번 불린다.
+using LogHexRelease = void (*)(void* context, const char* data);
+
+// LogHex가 덤프할 바이트. 줄(헥스 문자열)은 기록하는 쪽(writer / collector 스레드)에서 만든다.
+//   복사 : 버퍼의 앞 / 뒤(HexDumpTruncation으로 정한 만큼)만 풀에서 받은 메모리에 복사한다.
+//   참조 : 호출한 쪽이 고정해둔 버퍼를 복사하지 않고 가리키며, 없어질 때 release를 부른다.
+// 옮길 수만 있다. (큐 / 링 버퍼를 지나 한 곳에서만 해제되도록)
+class LogHexBytes {
+public:
+    LogHexBytes(void) = default;
+    ~LogHexBytes(void) { Release(); }
+
+    LogHexBytes(const LogHexBytes&) = delete;
+    LogHexBytes& operator=(const LogHexBytes&) = delete;
+
+    LogHexBytes(LogHexBytes&& other) noexcept { MoveFrom(other); }
+
+    LogHexBytes& operator=(LogHexBytes&& other) noexcept
+    {
+        if (this != &other) {
+            Release();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    // data의 처음 headBytes와 마지막 tailBytes만 복사한다.
+    void Copy(const char* data, size_t length, size_t headBytes, size_t tailBytes)
+    {
+        Release();
+        copied.assign(data, headBytes);
+        copied.append(data + length - tailBytes, tailBytes);
+        head = copied.data();
+        tail = copied.data() + headBytes;
+        this->headBytes = headBytes;
+        this->tailBytes = tailBytes;
+        totalBytes = length;
+    }
+
+    // data를 복사하지 않고 가리킨다. 없어질 때 release(context, data)를 부른다. (release가 nullptr이면 부르지 않음)
+    void Reference(const char* data, size_t length, size_t headBytes, size_t tailBytes, LogHexRelease release, void* context)
+    {
+        Release();
+        head = data;
+        tail = data + length - tailBytes;
+        this->headBytes = headBytes;
+        this->tailBytes = tailBytes;
+        totalBytes = length;
+        pinned = data;
+        releaseFunction = release;
+        releaseContext = context;
+    }
+
+    const char* Head(void) const { return head; }
+    size_t HeadBytes(void) const { return headBytes; }
+    const char* Tail(void) const { return tail; }
+    size_t TailBytes(void) const { return tailBytes; }
+    uint64_t TotalBytes(void) const { return totalBytes; }
+
+    // 남기는 바이트 수 (앞 + 뒤)
+    size_t KeptBytes(void) const { return headBytes + tailBytes; }
+
+    template <typename String>
+    void AppendDump(String& out) const
+    {
+        AppendTruncatedHexDump(out, head, headBytes, tail, tailBytes, totalBytes);
+    }
+
+private:
+    void Release(void)
+    {
+        if (releaseFunction != nullptr) {
+            releaseFunction(releaseContext, pinned);
+        }
+        copied.clear();
+        head = tail = pinned = nullptr;
+        headBytes = tailBytes = 0;
+        totalBytes = 0;
+        releaseFunction = nullptr;
+        releaseContext = nullptr;
+    }
+
+    void MoveFrom(LogHexBytes& other)
+    {
+        const bool ownsCopy = other.pinned == nullptr && other.head != nullptr;
+        copied = std::move(other.copied);
+        head = ownsCopy ? copied.data() : other.head;
+        tail = ownsCopy ? copied.data() + other.headBytes : other.tail;
+        headBytes = other.headBytes;
+        tailBytes = other.tailBytes;
+        totalBytes = other.totalBytes;
+        pinned = other.pinned;
+        releaseFunction = other.releaseFunction;
+        releaseContext = other.releaseContext;
+
+        other.copied.clear();
+        other.head = other.tail = other.pinned = nullptr;
+        other.headBytes = other.tailBytes = 0;
+        other.totalBytes = 0;
+        other.releaseFunction = nullptr;
+        other.releaseContext = nullptr;
+    }
+
+    LogUtf8String copied;               // 복사한 앞 + 뒤 (LogBufferPool에서 할당)
+    const char* head = nullptr;
+    const char* tail = nullptr;
+    size_t headBytes = 0;
+    size_t tailBytes = 0;
+    uint64_t totalBytes = 0;            // 원래 버퍼의 길이
+
+    const char* pinned = nullptr;       // 참조하는 버퍼 (release에 넘길 값)
+    LogHexRelease releaseFunction = nullptr;
+    void* releaseContext = nullptr;
+};
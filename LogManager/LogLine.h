@@ -0,0 +1,120 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "LogTime.h"
+#include "LogUtf8.h"
+
+// 텍스트 로그 한 줄의 형식. SystemLogManager와 바이너리 로그 디코더(LogDecoder.cpp)가 같은 결과를 내도록 여기서만 만든다.
+//
+//     [type] [YYYY-MM-DD HH:MM:SS / LEVEL / 000000001] message
+//     [type] [YYYY-MM-DD HH:MM:SS / LEVEL ] description        (LogHex. 뒤에 HexDump.h 형식의 덤프가 이어짐)
+
+enum class LogLevel {
+    LEVEL_DEBUG,
+    LEVEL_ERROR,
+    LEVEL_SYSTEM
+};
+
+inline std::wstring_view LogLevelToString(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::LEVEL_DEBUG: return L"DEBUG";
+    case LogLevel::LEVEL_ERROR: return L"ERROR";
+    case LogLevel::LEVEL_SYSTEM: return L"SYSTEM";
+    default: return L"UNKNOWN";
+    }
+}
+
+// 아래 함수들의 String은 줄을 담을 문자열이다.
+// char 문자열(std::string, LogUtf8String 등)이라면 UTF-8 줄을 만들며, wchar_t로 받은 type / 메시지는 UTF-8로 바꿔서 붙인다. (LogUtf8.h)
+// wchar_t 문자열(std::wstring, LogString 등)이라면 type / 메시지도 wchar_t여야 한다.
+
+// ASCII만 들어있는 text를 그대로 붙인다. (머리말의 구분자 / 시각 / 레벨)
+template <typename String, typename CharT>
+inline void AppendLogAscii(String& line, const CharT* text, size_t length)
+{
+    const size_t oldSize = line.size();
+    line.resize(oldSize + length);
+    auto* dest = &line[oldSize];
+    for (size_t i = 0; i < length; ++i)
+        dest[i] = static_cast<typename String::value_type>(text[i]);
+}
+
+template <typename String, typename CharT>
+inline void AppendLogAscii(String& line, std::basic_string_view<CharT> text)
+{
+    AppendLogAscii(line, text.data(), text.size());
+}
+
+template <typename String, size_t N>
+inline void AppendLogAscii(String& line, const char (&text)[N])
+{
+    AppendLogAscii(line, text, N - 1);
+}
+
+// type / 메시지를 붙인다.
+template <typename String>
+inline void AppendLogText(String& line, std::wstring_view text)
+{
+    if constexpr (sizeof(typename String::value_type) == 1) {
+        AppendUtf8(line, text);
+    }
+    else {
+        line.append(text.data(), text.size());
+    }
+}
+
+template <typename String>
+inline void AppendLogText(String& line, std::string_view text)
+{
+    static_assert(sizeof(typename String::value_type) == 1, "UTF-8 텍스트는 char 줄에만 붙일 수 있다.");
+    line.append(text.data(), text.size());
+}
+
+// "[type] [YYYY-MM-DD HH:MM:SS / LEVEL" 까지 붙인다. micros라면 시각 뒤에 ".uuuuuu"를 붙인다.
+template <typename String, typename Type>
+inline void AppendLogLinePrefix(String& line, const Type& type, LogTimestamp timestamp, LogLevel level, bool micros, LogTimestampCache& timestampCache)
+{
+    std::wstring_view levelText = LogLevelToString(level);
+    line.reserve(line.size() + levelText.size() + LogTimestampCache::MICRO_TEXT_LENGTH + 32);
+
+    AppendLogAscii(line, "[");
+    AppendLogText(line, type);
+    AppendLogAscii(line, "] [");
+    if (micros) {
+        AppendLogAscii(line, timestampCache.FormatMicros(timestamp), LogTimestampCache::MICRO_TEXT_LENGTH);
+    }
+    else {
+        AppendLogAscii(line, timestampCache.Format(LogTimestampSeconds(timestamp)), LogTimestampCache::TEXT_LENGTH);
+    }
+    AppendLogAscii(line, " / ");
+    AppendLogAscii(line, levelText);
+}
+
+// 인덱스가 있는 일반 로그 한 줄 ('\n' 포함)
+template <typename String, typename Type, typename Message>
+inline void AppendLogLine(String& line, const Type& type, LogTimestamp timestamp, LogLevel level, bool micros,
+    int64_t index, const Message& message, LogTimestampCache& timestampCache)
+{
+    AppendLogLinePrefix(line, type, timestamp, level, micros, timestampCache);
+    AppendLogAscii(line, " / ");
+    AppendDigits(line, static_cast<uint64_t>(index), 9);
+    AppendLogAscii(line, "] ");
+    AppendLogText(line, message);
+    AppendLogAscii(line, "\n");
+}
+
+// LogHex의 첫 줄 ('\n' 포함)
+template <typename String, typename Type, typename Description>
+inline void AppendLogHexHeader(String& line, const Type& type, LogTimestamp timestamp, LogLevel level, bool micros,
+    const Description& description, LogTimestampCache& timestampCache)
+{
+    AppendLogLinePrefix(line, type, timestamp, level, micros, timestampCache);
+    AppendLogAscii(line, " ] ");
+    AppendLogText(line, description);
+    AppendLogAscii(line, "\n");
+}
@@ -0,0 +1,329 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// 다 쓴 로그 파일을 압축하는 LZ4 (LogArchiver). 표준 LZ4 프레임 형식으로 쓰므로 `lz4 -d`로도 풀린다.
+// 압축은 해시 테이블로 앞쪽 64KB 안에서 4바이트가 같은 자리를 찾는 빠른 방식이며, 블록은 서로 독립적이다.
+namespace LogLz4 {
+    constexpr uint32_t FRAME_MAGIC = 0x184D2204;
+    constexpr size_t BLOCK_SIZE = 4 * 1024 * 1024;      // 프레임 블록 최대 크기 (BD = 7)
+    constexpr uint32_t UNCOMPRESSED_FLAG = 0x80000000u;
+
+    constexpr size_t MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;                 // 블록 끝 5바이트는 항상 리터럴
+    constexpr size_t MATCH_FIND_LIMIT = 12;             // 블록 끝 12바이트 안에서는 매치를 시작하지 않음
+    constexpr size_t MAX_DISTANCE = 65535;
+    constexpr int HASH_LOG = 16;
+
+    inline uint32_t Read32(const uint8_t* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline void Write32(std::string& out, uint32_t value)
+    {
+        const char bytes[4] = { static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16), static_cast<char>(value >> 24) };
+        out.append(bytes, 4);
+    }
+
+    inline uint32_t Rotl(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+    // 프레임 머리의 체크섬에 쓰는 xxHash32
+    inline uint32_t Xxh32(const uint8_t* data, size_t size, uint32_t seed)
+    {
+        constexpr uint32_t P1 = 2654435761u, P2 = 2246822519u, P3 = 3266489917u, P4 = 668265263u, P5 = 374761393u;
+
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+        uint32_t hash;
+
+        if (size >= 16) {
+            uint32_t v[4] = { seed + P1 + P2, seed + P2, seed, seed - P1 };
+            for (; p + 16 <= end; p += 16) {
+                for (int i = 0; i < 4; ++i) {
+                    v[i] = Rotl(v[i] + Read32(p + i * 4) * P2, 13) * P1;
+                }
+            }
+            hash = Rotl(v[0], 1) + Rotl(v[1], 7) + Rotl(v[2], 12) + Rotl(v[3], 18);
+        }
+        else {
+            hash = seed + P5;
+        }
+
+        hash += static_cast<uint32_t>(size);
+        for (; p + 4 <= end; p += 4) {
+            hash = Rotl(hash + Read32(p) * P3, 17) * P4;
+        }
+        for (; p < end; ++p) {
+            hash = Rotl(hash + *p * P5, 11) * P1;
+        }
+
+        hash ^= hash >> 15;
+        hash *= P2;
+        hash ^= hash >> 13;
+        hash *= P3;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    inline size_t CompressBound(size_t size) { return size + size / 255 + 16; }
+
+    inline void AppendLength(uint8_t*& out, size_t length)
+    {
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+        *out++ = static_cast<uint8_t>(length);
+    }
+
+    // source를 LZ4 블록 하나로 압축해서 dest(CompressBound 이상)에 쓰고 길이를 반환한다.
+    // table은 (1 << HASH_LOG)개짜리 작업 공간 (호출마다 다시 채운다)
+    inline size_t CompressBlock(const uint8_t* source, size_t size, uint8_t* dest, uint32_t* table)
+    {
+        uint8_t* out = dest;
+        const uint8_t* anchor = source;
+
+        auto emitSequence = [&](const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+            uint8_t* token = out++;
+            *token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+            if (literalLength >= 15) AppendLength(out, literalLength - 15);
+            std::memcpy(out, literals, literalLength);
+            out += literalLength;
+
+            if (matchLength == 0) {
+                return;
+            }
+
+            *out++ = static_cast<uint8_t>(offset);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+            matchLength -= MIN_MATCH;
+            *token |= static_cast<uint8_t>(matchLength >= 15 ? 15 : matchLength);
+            if (matchLength >= 15) AppendLength(out, matchLength - 15);
+        };
+
+        if (size > MATCH_FIND_LIMIT) {
+            const uint8_t* matchLimit = source + size - LAST_LITERALS;
+            const uint8_t* inputLimit = source + size - MATCH_FIND_LIMIT;
+            auto hash = [](const uint8_t* p) { return (Read32(p) * 2654435761u) >> (32 - HASH_LOG); };
+
+            std::memset(table, 0, sizeof(uint32_t) << HASH_LOG);
+
+            const uint8_t* ip = source + 1;
+            while (ip < inputLimit) {
+                const uint32_t slot = hash(ip);
+                const uint8_t* match = source + table[slot];
+                table[slot] = static_cast<uint32_t>(ip - source);
+
+                if (match >= ip || static_cast<size_t>(ip - match) > MAX_DISTANCE || Read32(match) != Read32(ip)) {
+                    // 매치가 오래 없으면 건너뛰는 폭을 늘린다. (압축이 안 되는 구간을 빨리 지나가기 위함)
+                    ip += 1 + (static_cast<size_t>(ip - anchor) >> 6);
+                    continue;
+                }
+
+                while (ip > anchor && match > source && ip[-1] == match[-1]) {
+                    --ip;
+                    --match;
+                }
+
+                const uint8_t* matchEnd = ip + MIN_MATCH;
+                const uint8_t* reference = match + MIN_MATCH;
+                while (matchEnd < matchLimit && *matchEnd == *reference) {
+                    ++matchEnd;
+                    ++reference;
+                }
+
+                emitSequence(anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - match), static_cast<size_t>(matchEnd - ip));
+
+                ip = matchEnd;
+                anchor = ip;
+                if (ip < inputLimit) {
+                    table[hash(ip - 2)] = static_cast<uint32_t>(ip - 2 - source);
+                }
+            }
+        }
+
+        emitSequence(anchor, static_cast<size_t>(source + size - anchor), 0, 0);
+        return static_cast<size_t>(out - dest);
+    }
+
+    // LZ4 블록 하나를 풀어서 out 뒤에 붙인다. 매치는 out에 이미 있는 내용까지 가리킬 수 있다. (의존 블록 지원)
+    inline bool DecompressBlock(const uint8_t* source, size_t size, std::string& out)
+    {
+        const uint8_t* ip = source;
+        const uint8_t* end = source + size;
+
+        auto readLength = [&](size_t length) -> size_t {
+            if (length != 15) return length;
+            uint8_t byte;
+            do {
+                if (ip >= end) return SIZE_MAX;
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        };
+
+        while (ip < end) {
+            const uint8_t token = *ip++;
+
+            const size_t literalLength = readLength(token >> 4);
+            if (literalLength == SIZE_MAX || literalLength > static_cast<size_t>(end - ip)) {
+                return false;
+            }
+            out.append(reinterpret_cast<const char*>(ip), literalLength);
+            ip += literalLength;
+
+            if (ip == end) {
+                return true;
+            }
+            if (end - ip < 2) {
+                return false;
+            }
+
+            const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+
+            size_t matchLength = readLength(token & 15);
+            if (matchLength == SIZE_MAX || offset == 0 || offset > out.size()) {
+                return false;
+            }
+            matchLength += MIN_MATCH;
+
+            // 겹치는 매치(offset < 길이)가 있으므로 한 바이트씩 복사한다.
+            const size_t start = out.size();
+            out.resize(start + matchLength);
+            char* dest = &out[start];
+            const char* from = dest - offset;
+            for (size_t i = 0; i < matchLength; ++i) {
+                dest[i] = from[i];
+            }
+        }
+        return true;
+    }
+
+    // source 파일을 LZ4 프레임으로 압축해서 dest에 쓴다. 실패하면 dest를 지우고 false
+    inline bool CompressFile(const std::filesystem::path& source, const std::filesystem::path& dest)
+    {
+        std::ifstream input(source, std::ios::binary);
+        std::ofstream output(dest, std::ios::binary | std::ios::trunc);
+        if (!input || !output) {
+            return false;
+        }
+
+        std::string frame;
+        Write32(frame, FRAME_MAGIC);
+        const uint8_t descriptor[2] = { 0x60, 0x70 };   // 버전 1, 블록 독립 / 블록 최대 4MB
+        frame.append(reinterpret_cast<const char*>(descriptor), 2);
+        frame.push_back(static_cast<char>((Xxh32(descriptor, 2, 0) >> 8) & 0xFF));
+        output.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+
+        std::vector<uint8_t> block(BLOCK_SIZE);
+        std::vector<uint8_t> compressed(CompressBound(BLOCK_SIZE));
+        std::vector<uint32_t> table(size_t(1) << HASH_LOG);
+
+        for (;;) {
+            input.read(reinterpret_cast<char*>(block.data()), static_cast<std::streamsize>(block.size()));
+            const size_t size = static_cast<size_t>(input.gcount());
+            if (size == 0) {
+                break;
+            }
+
+            const size_t compressedSize = CompressBlock(block.data(), size, compressed.data(), table.data());
+
+            // 줄어들지 않는 블록은 그대로 남긴다.
+            frame.clear();
+            if (compressedSize < size) {
+                Write32(frame, static_cast<uint32_t>(compressedSize));
+                output.write(frame.data(), 4);
+                output.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressedSize));
+            }
+            else {
+                Write32(frame, static_cast<uint32_t>(size) | UNCOMPRESSED_FLAG);
+                output.write(frame.data(), 4);
+                output.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(size));
+            }
+        }
+
+        frame.clear();
+        Write32(frame, 0);
+        output.write(frame.data(), 4);
+        output.close();
+
+        if (input.bad() || !output) {
+            std::error_code error;
+            std::filesystem::remove(dest, error);
+            return false;
+        }
+        return true;
+    }
+
+    // LZ4 프레임(들)을 풀어서 out 뒤에 붙인다. 체크섬은 확인하지 않고 건너뛴다.
+    inline bool DecompressFrame(const uint8_t* data, size_t size, std::string& out)
+    {
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+
+        while (p < end) {
+            if (end - p < 7 || Read32(p) != FRAME_MAGIC) {
+                return false;
+            }
+            p += 4;
+
+            const uint8_t flags = *p;
+            if ((flags >> 6) != 1) {
+                return false;
+            }
+            const bool blockChecksum = (flags & 0x10) != 0;
+            const bool contentSize = (flags & 0x08) != 0;
+            const bool contentChecksum = (flags & 0x04) != 0;
+            const bool dictionaryId = (flags & 0x01) != 0;
+
+            const size_t descriptorSize = 3 + (contentSize ? 8 : 0) + (dictionaryId ? 4 : 0);
+            if (static_cast<size_t>(end - p) < descriptorSize) {
+                return false;
+            }
+            p += descriptorSize;
+
+            for (;;) {
+                if (end - p < 4) {
+                    return false;
+                }
+                const uint32_t blockSize = Read32(p);
+                p += 4;
+                if (blockSize == 0) {
+                    break;
+                }
+
+                const size_t length = blockSize & ~UNCOMPRESSED_FLAG;
+                if (static_cast<size_t>(end - p) < length + (blockChecksum ? 4 : 0)) {
+                    return false;
+                }
+
+                if (blockSize & UNCOMPRESSED_FLAG) {
+                    out.append(reinterpret_cast<const char*>(p), length);
+                }
+                else if (!DecompressBlock(p, length, out)) {
+                    return false;
+                }
+                p += length + (blockChecksum ? 4 : 0);
+            }
+
+            if (contentChecksum) {
+                if (end - p < 4) {
+                    return false;
+                }
+                p += 4;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,741 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "LogFile.h"
+#include "LogRotation.h"
+#include "MappedFile.h"
+
+// 텍스트 로그 파일을 쓰는 방식 (SYSLOG_FILE_WRITER)
+enum class LogFileWriter {
+    WRITER_STREAM,      // LogFile : 버퍼에 모았다가 ofstream으로 기록
+    WRITER_MAPPED,      // LogMappedFile : 미리 늘려둔 파일을 매핑해두고 잠금 없이 바로 복사
+};
+
+// LogMappedFile이 쓰는 파일의 형식.
+// 첫 줄(HEADER_SIZE 바이트)은 "#SLOGMAP " + 기록이 끝난 로그 길이(16진수 16자리)이고, 그 뒤로 UTF-8 로그가 이어진다.
+// 파일은 CHUNK_BYTES 단위로 미리 늘려두므로 기록 중에는 로그 뒤가 0으로 채워져 있고, 닫을 때 실제 길이로 잘라낸다.
+namespace LogMappedFormat {
+    constexpr char HEADER_TAG[] = "#SLOGMAP ";
+    constexpr size_t HEADER_TAG_LENGTH = sizeof(HEADER_TAG) - 1;
+    constexpr size_t HEADER_DIGITS = 16;
+    constexpr size_t HEADER_SIZE = 32;
+
+    constexpr uint64_t CHUNK_BYTES = 16ull * 1024 * 1024;   // 파일을 늘리고 매핑하는 단위
+    constexpr size_t MAX_CHUNKS = 4096;                     // 파일 하나에 64GB까지. 넘치는 로그는 버린다.
+
+    static_assert(CHUNK_BYTES % WritableMappedFile::MAP_ALIGNMENT == 0, "chunk must be a valid mapping offset");
+    static_assert(HEADER_TAG_LENGTH + HEADER_DIGITS < HEADER_SIZE, "header must fit in one line");
+
+    inline void WriteHeader(uint8_t* header, uint64_t committed)
+    {
+        static constexpr char digits[] = "0123456789abcdef";
+
+        std::memcpy(header, HEADER_TAG, HEADER_TAG_LENGTH);
+        for (size_t i = 0; i < HEADER_DIGITS; ++i) {
+            header[HEADER_TAG_LENGTH + i] = static_cast<uint8_t>(digits[(committed >> ((HEADER_DIGITS - 1 - i) * 4)) & 0xF]);
+        }
+        std::memset(header + HEADER_TAG_LENGTH + HEADER_DIGITS, ' ', HEADER_SIZE - HEADER_TAG_LENGTH - HEADER_DIGITS - 1);
+        header[HEADER_SIZE - 1] = '\n';
+    }
+
+    inline bool ReadHeader(const uint8_t* header, uint64_t& committed)
+    {
+        if (std::memcmp(header, HEADER_TAG, HEADER_TAG_LENGTH) != 0 || header[HEADER_SIZE - 1] != '\n') {
+            return false;
+        }
+
+        committed = 0;
+        for (size_t i = 0; i < HEADER_DIGITS; ++i) {
+            const uint8_t digit = header[HEADER_TAG_LENGTH + i];
+            if (digit >= '0' && digit <= '9') committed = (committed << 4) | static_cast<uint64_t>(digit - '0');
+            else if (digit >= 'a' && digit <= 'f') committed = (committed << 4) | static_cast<uint64_t>(digit - 'a' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    constexpr size_t SCAN_BLOCK_BYTES = 64 * 1024;      // 꼬리를 찾거나 머리를 붙일 때 한 번에 읽는 양
+
+    enum class FileState {
+        FILE_EMPTY,         // 없거나 빈 파일
+        FILE_MAPPED,        // 머리가 있거나, 머리를 쓰기 전에 끝나서 앞이 0뿐인 파일 (미리 늘려둔 조각)
+        FILE_LEGACY,        // 머리 없이 내용이 있는 파일 (WRITER_STREAM으로 쓰던 파일 등)
+        FILE_UNREADABLE,
+    };
+
+    // 파일 크기와 머리의 길이를 읽는다. 앞이 0뿐이면 committed는 0
+    inline FileState ReadFileState(const std::filesystem::path& path, uint64_t& size, uint64_t& committed)
+    {
+        std::error_code error;
+        size = std::filesystem::file_size(path, error);
+        committed = 0;
+        if (error || size == 0) {
+            return FileState::FILE_EMPTY;
+        }
+
+        uint8_t header[HEADER_SIZE] = {};
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(size, HEADER_SIZE));
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read(reinterpret_cast<char*>(header), static_cast<std::streamsize>(length))) {
+            return FileState::FILE_UNREADABLE;
+        }
+
+        if (length == HEADER_SIZE && ReadHeader(header, committed)) {
+            return FileState::FILE_MAPPED;
+        }
+        return std::all_of(header, header + length, [](uint8_t byte) { return byte == 0; }) ? FileState::FILE_MAPPED : FileState::FILE_LEGACY;
+    }
+
+    // 머리의 길이 뒤로 남은 꼬리(비정상 종료로 남은 미리 늘려둔 0과 쓰다 만 줄)를 잘라내고 머리를 실제 길이로 고친다.
+    // 파일 끝에서부터 0이 아닌 마지막 바이트를 찾고, 그 앞의 마지막 줄바꿈까지를 로그로 살린다.
+    // 그 사이에 복사를 끝내지 못한 자리(0)가 있으면 그 줄은 빼고 뒤의 줄을 앞으로 당긴다.
+    inline bool RepairTail(const std::filesystem::path& path, uint64_t size, uint64_t committed)
+    {
+        std::error_code error;
+        if (size < HEADER_SIZE) {
+            // 머리도 다 쓰지 못한 파일. 처음부터 다시 쓴다.
+            std::filesystem::resize_file(path, 0, error);
+            return !error;
+        }
+        if (size == HEADER_SIZE + committed) {
+            return true;
+        }
+
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        const uint64_t start = HEADER_SIZE + std::min(committed, size - HEADER_SIZE);
+        uint64_t end = start;
+        std::vector<char> block(SCAN_BLOCK_BYTES);
+        bool foundData = false;
+        for (uint64_t position = size; position > start && end == start; ) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(block.size(), position - start));
+            position -= count;
+            file.seekg(static_cast<std::streamoff>(position));
+            if (!file.read(block.data(), static_cast<std::streamsize>(count))) {
+                return false;
+            }
+
+            for (size_t i = count; i-- > 0; ) {
+                if (!foundData && block[i] == 0) {
+                    continue;
+                }
+                foundData = true;
+                if (block[i] == '\n') {
+                    end = position + i + 1;
+                    break;
+                }
+            }
+        }
+
+        // 0을 만나면 쓰던 줄은 버린다. 다음 자리는 다음 로그의 시작이므로 0이 끝나는 곳부터 새 줄로 본다.
+        uint64_t writePosition = start;
+        std::string line;
+        std::string output;
+        for (uint64_t position = start; position < end; ) {
+            const size_t count = static_cast<size_t>(std::min<uint64_t>(block.size(), end - position));
+            file.seekg(static_cast<std::streamoff>(position));
+            if (!file.read(block.data(), static_cast<std::streamsize>(count))) {
+                return false;
+            }
+            position += count;
+
+            output.clear();
+            for (size_t i = 0; i < count; ++i) {
+                if (block[i] == 0) {
+                    line.clear();
+                    continue;
+                }
+                line.push_back(block[i]);
+                if (block[i] == '\n') {
+                    output += line;
+                    line.clear();
+                }
+            }
+
+            // 읽은 자리보다 앞에만 쓰므로 같은 파일 안에서 당겨 써도 된다.
+            file.seekp(static_cast<std::streamoff>(writePosition));
+            file.write(output.data(), static_cast<std::streamsize>(output.size()));
+            writePosition += output.size();
+        }
+        end = writePosition;
+
+        uint8_t header[HEADER_SIZE];
+        WriteHeader(header, end - HEADER_SIZE);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+        file.close();
+        if (file.fail()) {
+            return false;
+        }
+
+        std::filesystem::resize_file(path, end, error);
+        return !error;
+    }
+
+    // 머리 없는 파일의 앞에 머리를 붙인다. 파일이 클 수 있으므로 조금씩 옮겨 쓴 임시 파일로 바꿔치운다.
+    inline bool PrependHeader(const std::filesystem::path& path, uint64_t size)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        std::filesystem::path tempPath = path;
+        tempPath += L".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+
+            uint8_t header[HEADER_SIZE];
+            WriteHeader(header, size);
+            out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+            std::vector<char> block(SCAN_BLOCK_BYTES);
+            uint64_t copied = 0;
+            while (in.read(block.data(), static_cast<std::streamsize>(block.size())) || in.gcount() > 0) {
+                out.write(block.data(), in.gcount());
+                copied += static_cast<uint64_t>(in.gcount());
+            }
+
+            // 크기를 잰 뒤에 바뀌었다면 실제로 옮긴 길이로 고친다.
+            if (copied != size) {
+                WriteHeader(header, copied);
+                out.seekp(0);
+                out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+            }
+            if (!out) {
+                return false;
+            }
+        }
+        in.close();
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, path, error);
+        return !error;
+    }
+
+    // 열기 전에 파일을 이어 쓸 수 있는 모양으로 만든다. 머리가 없으면 붙이고, 비정상 종료로 남은 꼬리는 잘라낸다.
+    // 성공하면 파일은 비어있거나 "머리 + 머리에 적힌 길이"만큼이다.
+    inline bool PrepareFile(const std::filesystem::path& path)
+    {
+        uint64_t size = 0;
+        uint64_t committed = 0;
+        switch (ReadFileState(path, size, committed)) {
+        case FileState::FILE_EMPTY:
+            return true;
+        case FileState::FILE_MAPPED:
+            return RepairTail(path, size, committed);
+        case FileState::FILE_LEGACY:
+            return PrependHeader(path, size);
+        default:
+            return false;
+        }
+    }
+}
+
+// 한 type의 로그 파일을 메모리 매핑으로 쓴다. LogFile과 같은 Write / Maintain / Flush / Close / GetLastWrite를 가진다.
+// 쓰는 스레드는 쓰기 위치를 fetch_add로 잡고 매핑된 영역에 UTF-8로 바로 복사한다. (로그마다 잠금 / 시스템 콜 없음)
+// 파일 늘리기 / 매핑은 CHUNK_BYTES마다 한 번, 파일 전환 / 닫기는 그 파일을 쓰던 스레드가 모두 빠져나간 뒤에 한다.
+// LogRotationPolicy의 한도는 그 한도를 넘긴 자리를 잡은 스레드 하나가 다음 조각을 열어 바꿔 끼운다. (그동안 다른 스레드는 이전 조각에 계속 쓴다)
+//
+// 비정상 종료 대비 : 머리의 길이는 그 앞의 로그가 모두 복사된 것이 확인됐을 때만 올린다. (Maintain / Flush / flushNow)
+// 다시 열 때는 파일 끝의 0을 건너뛴 마지막 줄바꿈까지 살리고 나머지는 잘라낸다. (LogMappedFormat::PrepareFile)
+// 기간의 첫 조각을 열 때는 그 앞 조각들 중 닫지 못하고 끝난 것도 같이 잘라내고 압축 대기열로 넘긴다.
+// 핸들 수는 LogFile과 같이 LogOpenFileCache가 센다. 쓰는 쪽은 시각을 남기지 않으므로 오래된 정도는 Maintain이 본 시각이다.
+class LogMappedFile : public LogCachedFile {
+public:
+    using Clock = LogCachedFile::Clock;
+
+    LogMappedFile(void) = default;
+    ~LogMappedFile(void) { Close(); }
+
+    LogMappedFile(const LogMappedFile&) = delete;
+    LogMappedFile& operator=(const LogMappedFile&) = delete;
+
+    // fileName  : 이번 로그가 들어가야 할 파일
+    // text      : UTF-8로 완성된 줄 / records : text에 담긴 로그 수 (LogFile::Write와 같음)
+    // flushNow  : 머리의 기록 길이를 바로 갱신할지 여부 (ERROR 이상의 로그 등). 다른 스레드가 갱신 중이면 그쪽에 맡긴다.
+    // policy    : 버퍼가 없으므로 쓰지 않는다. (LogFile과 호출 모양을 맞추기 위함)
+    // rotation  : 파일을 나누는 기준. maxBytes는 UTF-8 바이트 기준
+    void Write(const std::wstring& fileName, const char* text, size_t length, size_t records, bool flushNow, const LogFlushPolicy& policy,
+        const LogRotationPolicy& rotation)
+    {
+        (void)policy;
+
+        if (length == 0) {
+            return;
+        }
+
+        for (;;) {
+            const uint64_t epoch = Enter();
+            Mapping* mapping = current.load(std::memory_order_acquire);
+            if (mapping != nullptr && mapping->IsFor(fileName)) {
+                const bool full = mapping->Append(text, length, records, rotation);
+                const uint64_t generation = mapping->generation;
+                Leave(epoch);
+
+                // Leave 뒤로는 mapping이 이미 닫혀 지워졌을 수 있으므로 세대 번호로 비교한다.
+                if (full) {
+                    Rotate(generation, rotation);
+                }
+                break;
+            }
+            Leave(epoch);
+
+            // 열 수 없는 파일이면 LogFile처럼 이번 로그는 버린다.
+            if (!SwitchTo(fileName, rotation)) {
+                return;
+            }
+        }
+
+        if (flushNow) {
+            std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+            if (guard.owns_lock()) {
+                CommitLocked();
+            }
+        }
+    }
+
+    // 기록 길이 갱신과 유휴 파일 닫기. 주기적으로 호출된다.
+    // 반환값 : 호출 후에도 파일이 열려있는지 여부
+    bool Maintain(Clock::time_point now, const LogFlushPolicy& policy, std::chrono::milliseconds idleTimeout)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        Mapping* mapping = current.load(std::memory_order_relaxed);
+        if (mapping == nullptr) {
+            return false;
+        }
+
+        // 쓰는 쪽에서 시각을 남기지 않도록, 지난번 이후 쓰기 위치가 움직였으면 그 사이에 쓰인 것으로 본다.
+        const uint64_t reserved = mapping->reserved.load(std::memory_order_relaxed);
+        if (reserved != mapping->seenReserved) {
+            mapping->seenReserved = reserved;
+            lastWrite = now;
+            Touch(now);
+        }
+
+        if (policy.flushInterval.count() == 0 || now - lastCommit >= policy.flushInterval) {
+            CommitLocked();
+            lastCommit = now;
+        }
+
+        if (idleTimeout.count() > 0 && now - lastWrite >= idleTimeout) {
+            CloseLocked();
+            return false;
+        }
+
+        return true;
+    }
+
+    void Flush(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        CommitLocked();
+    }
+
+    // 쓰던 스레드가 모두 빠져나가길 기다렸다가 파일을 실제 길이로 잘라내고 닫는다.
+    void Close(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        CloseLocked();
+    }
+
+    Clock::time_point GetLastWrite(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return lastWrite;
+    }
+
+    // LogFile::GetFileName과 같다.
+    std::wstring GetFileName(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return segmentName;
+    }
+
+private:
+    // 열려있는 파일(조각) 하나. 파일 전환 / 닫기 때 통째로 바뀐다.
+    struct Mapping {
+        Mapping(const std::wstring& base, const std::wstring& retiredBase, uint32_t sequence, uint64_t generation)
+            : baseName(base), retiredBaseName(retiredBase), fileName(LogSegmentName(base, sequence)), generation(generation),
+            chunks(new std::atomic<uint8_t*>[LogMappedFormat::MAX_CHUNKS])
+        {
+            for (size_t i = 0; i < LogMappedFormat::MAX_CHUNKS; ++i) {
+                chunks[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // fileName(GetLogFileName의 결과)의 로그를 이 조각에 쓸지. 바로 전 기간으로 늦게 도착한 로그도 받는다. (LogSegmentTracker와 같음)
+        bool IsFor(const std::wstring& name) const
+        {
+            return name == baseName || (!retiredBaseName.empty() && name == retiredBaseName);
+        }
+
+        static constexpr uint64_t Capacity(void)
+        {
+            return LogMappedFormat::MAX_CHUNKS * LogMappedFormat::CHUNK_BYTES - LogMappedFormat::HEADER_SIZE;
+        }
+
+        // 파일을 열고 머리를 확인한다. 비정상 종료로 남은 꼬리는 PrepareFile이 먼저 잘라낸다. 실패하면 false
+        bool Open(void)
+        {
+            using namespace LogMappedFormat;
+
+            if (!PrepareFile(std::filesystem::path(fileName)) || !file.Open(fileName)) {
+                return false;
+            }
+
+            const uint64_t existingSize = file.Size();
+            fileSize = existingSize;
+
+            uint8_t* header = Chunk(0);
+            if (header == nullptr) {
+                return false;
+            }
+
+            // 비어있던 파일이면 머리부터 쓴다.
+            uint64_t committed = 0;
+            if (existingSize < HEADER_SIZE || !ReadHeader(header, committed)) {
+                committed = 0;
+            }
+            const uint64_t end = std::min({ committed, existingSize > HEADER_SIZE ? existingSize - HEADER_SIZE : 0, Capacity() });
+
+            reserved.store(end, std::memory_order_relaxed);
+            completed.store(end, std::memory_order_relaxed);
+            seenReserved = end;
+            committedLength = end;
+            WriteHeader(header, end);
+            return true;
+        }
+
+        // 쓰던 스레드가 모두 빠져나간 뒤에 호출된다.
+        void Close(void)
+        {
+            using namespace LogMappedFormat;
+
+            const uint64_t length = std::min(reserved.load(std::memory_order_acquire), Capacity());
+            if (uint8_t* header = chunks[0].load(std::memory_order_relaxed)) {
+                WriteHeader(header, length);
+            }
+
+            for (size_t i = 0; i < MAX_CHUNKS; ++i) {
+                if (uint8_t* view = chunks[i].load(std::memory_order_relaxed)) {
+                    WritableMappedFile::Unmap(view, CHUNK_BYTES);
+                    chunks[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            if (file.IsOpen()) {
+                file.Resize(HEADER_SIZE + length);
+                file.Close();
+            }
+        }
+
+        // 반환값 : 이 로그로 rotation의 한도를 처음 넘겼는지 (한 조각에서 한 스레드만 true를 받는다)
+        bool Append(const char* data, size_t size, size_t count, const LogRotationPolicy& rotation)
+        {
+            using namespace LogMappedFormat;
+
+            const uint64_t offset = reserved.fetch_add(size, std::memory_order_relaxed);
+            bool full = rotation.maxBytes != 0 && offset < rotation.maxBytes && offset + size >= rotation.maxBytes;
+            if (rotation.maxRecords != 0) {
+                const uint64_t written = records.fetch_add(count, std::memory_order_relaxed);
+                full |= written < rotation.maxRecords && written + count >= rotation.maxRecords;
+            }
+
+            uint64_t position = HEADER_SIZE + offset;
+            const uint64_t end = position + size;
+
+            if (offset + size <= Capacity()) {
+                while (position < end) {
+                    const size_t within = static_cast<size_t>(position % CHUNK_BYTES);
+                    const size_t count = static_cast<size_t>(std::min<uint64_t>(end - position, CHUNK_BYTES - within));
+
+                    // 매핑하지 못한 구간(디스크 부족 등)은 0으로 남는다.
+                    if (uint8_t* view = Chunk(static_cast<size_t>(position / CHUNK_BYTES))) {
+                        std::memcpy(view + within, data, count);
+                    }
+                    data += count;
+                    position += count;
+                }
+
+                // 다음 청크를 미리 늘려 매핑해둔다. 그 청크에 처음 쓰는 스레드가 기다리지 않게 하기 위함
+                const size_t next = static_cast<size_t>((end - 1) / CHUNK_BYTES) + 1;
+                if (next < MAX_CHUNKS && chunks[next].load(std::memory_order_relaxed) == nullptr) {
+                    Chunk(next);
+                }
+            }
+
+            completed.fetch_add(size, std::memory_order_release);
+            return full;
+        }
+
+        // 복사를 끝낸 양이 자리를 잡은 양과 같으면 그 앞은 빈틈이 없으므로 머리의 길이를 올린다.
+        // completed를 먼저 읽어야 그 사이에 잡히고 끝난 자리 때문에 앞의 빈틈을 놓치지 않는다.
+        void Commit(void)
+        {
+            const uint64_t done = completed.load(std::memory_order_acquire);
+            if (done != reserved.load(std::memory_order_acquire) || done == committedLength) {
+                return;
+            }
+
+            committedLength = std::min(done, Capacity());
+            LogMappedFormat::WriteHeader(chunks[0].load(std::memory_order_relaxed), committedLength);
+        }
+
+        // index번째 청크의 매핑. 처음 쓰이는 청크면 파일을 늘리고 매핑한다.
+        uint8_t* Chunk(size_t index)
+        {
+            uint8_t* view = chunks[index].load(std::memory_order_acquire);
+            if (view != nullptr) {
+                return view;
+            }
+
+            std::lock_guard<std::mutex> guard(growLock);
+
+            view = chunks[index].load(std::memory_order_relaxed);
+            if (view != nullptr) {
+                return view;
+            }
+
+            const uint64_t chunkEnd = (static_cast<uint64_t>(index) + 1) * LogMappedFormat::CHUNK_BYTES;
+            if (fileSize < chunkEnd) {
+                if (!file.Resize(chunkEnd)) {
+                    return nullptr;
+                }
+                fileSize = chunkEnd;
+            }
+
+            view = file.Map(static_cast<uint64_t>(index) * LogMappedFormat::CHUNK_BYTES, static_cast<size_t>(LogMappedFormat::CHUNK_BYTES));
+            if (view != nullptr) {
+                chunks[index].store(view, std::memory_order_release);
+            }
+            return view;
+        }
+
+        const std::wstring baseName;            // GetLogFileName의 결과
+        const std::wstring retiredBaseName;     // 바로 전 기간의 baseName
+        const std::wstring fileName;            // 이 조각의 파일 이름
+        const uint64_t generation;              // 연 순서. Rotate가 지금 조각인지 확인할 때 쓴다.
+        WritableMappedFile file;
+        std::unique_ptr<std::atomic<uint8_t*>[]> chunks;
+
+        alignas(64) std::atomic<uint64_t> reserved{ 0 };    // 자리를 잡은 로그 바이트 수 (머리 제외)
+        alignas(64) std::atomic<uint64_t> completed{ 0 };   // 그 중 복사를 끝낸 바이트 수
+        std::atomic<uint64_t> records{ 0 };                 // 이번에 연 뒤로 남긴 로그 수 (maxRecords가 있을 때만 센다)
+
+        alignas(64) std::mutex growLock;
+        uint64_t fileSize = 0;          // growLock : 지금까지 늘려둔 파일 크기
+
+        uint64_t committedLength = 0;   // LogMappedFile::lock : 머리에 적힌 길이
+        uint64_t seenReserved = 0;      // LogMappedFile::lock : 지난 Maintain 때의 reserved
+    };
+
+    // 쓰는 스레드는 current를 읽기 전에 지금 세대의 카운터를 올리고, 다 쓴 뒤에 내린다.
+    // 파일을 바꾸는 쪽은 current를 바꾼 뒤 세대를 넘기고 이전 세대의 카운터가 0이 될 때까지 기다린다.
+    uint64_t Enter(void)
+    {
+        for (;;) {
+            const uint64_t epoch = epochCounter.load(std::memory_order_seq_cst);
+            activeWriters[epoch & 1].count.fetch_add(1, std::memory_order_seq_cst);
+            if (epochCounter.load(std::memory_order_seq_cst) == epoch) {
+                return epoch;
+            }
+            activeWriters[epoch & 1].count.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void Leave(uint64_t epoch)
+    {
+        activeWriters[epoch & 1].count.fetch_sub(1, std::memory_order_release);
+    }
+
+    // lock을 잡은 상태에서 호출. 이 호출 전에 current를 읽었을 수 있는 스레드가 모두 빠져나갈 때까지 기다린다.
+    void WaitForWritersLocked(void)
+    {
+        const uint64_t epoch = epochCounter.fetch_add(1, std::memory_order_seq_cst);
+        while (activeWriters[epoch & 1].count.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    // 다른 기간의 파일로 넘어가거나, 닫혀있던 파일을 다시 연다. 파일을 열지 못하면 false
+    bool SwitchTo(const std::wstring& fileName, const LogRotationPolicy& rotation)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        Mapping* mapping = current.load(std::memory_order_relaxed);
+        if (mapping != nullptr && mapping->IsFor(fileName)) {
+            return true;
+        }
+
+        CloseLocked();
+
+        // 유휴 상태라 닫혀있었다면 같은 조각을 다시 연다. 바로 전 기간으로 늦게 도착한 로그도 지금 기간 파일로 보낸다.
+        const bool samePeriod = fileName == baseName || (!retiredBaseName.empty() && fileName == retiredBaseName);
+        if (!samePeriod) {
+            if (!baseName.empty()) {
+                Retire(segmentName, rotation);
+                retiredBaseName = baseName;
+            }
+            baseName = fileName;
+            sequence = FindLogSegment(fileName);
+            RepairStaleSegmentsLocked(rotation);
+        }
+
+        NotifyOpening();
+        std::unique_ptr<Mapping> opened = OpenSegmentLocked(rotation);
+        if (opened == nullptr) {
+            NotifyClosed();
+            return false;
+        }
+
+        lastWrite = Clock::now();
+        Touch(lastWrite);
+        current.store(opened.release(), std::memory_order_release);
+        return true;
+    }
+
+    // 한도를 넘긴 조각(generation)을 다음 조각으로 바꾼다. 새 조각을 먼저 열어 바꿔 끼운 뒤 이전 조각을 쓰던 스레드가 빠져나가면 닫는다.
+    void Rotate(uint64_t generation, const LogRotationPolicy& rotation)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        Mapping* mapping = current.load(std::memory_order_relaxed);
+        if (mapping == nullptr || mapping->generation != generation) {
+            return;
+        }
+
+        sequence++;
+        std::unique_ptr<Mapping> opened = OpenSegmentLocked(rotation);
+        if (opened == nullptr) {
+            // 다음 조각을 열지 못했다면 지금 조각에 계속 쓴다.
+            sequence--;
+            segmentName = mapping->fileName;
+            return;
+        }
+
+        std::unique_ptr<Mapping> previous(current.exchange(opened.release(), std::memory_order_acq_rel));
+        WaitForWritersLocked();
+        previous->Close();
+        Retire(previous->fileName, rotation);
+    }
+
+    // baseName의 sequence번째 조각을 연다. 이전 실행에서 이미 한도까지 쓴 조각이면 다음 조각으로 넘어간다.
+    std::unique_ptr<Mapping> OpenSegmentLocked(const LogRotationPolicy& rotation)
+    {
+        for (;;) {
+            std::unique_ptr<Mapping> opened = std::make_unique<Mapping>(baseName, retiredBaseName, sequence, ++generationCounter);
+            if (!opened->Open()) {
+                opened->Close();
+                return nullptr;
+            }
+
+            segmentName = opened->fileName;
+            if (!rotation.IsFull(opened->reserved.load(std::memory_order_relaxed), 0)) {
+                return opened;
+            }
+
+            opened->Close();
+            Retire(opened->fileName, rotation);
+            sequence++;
+        }
+    }
+
+    // 기간의 첫 조각을 열 때 부른다. 지난 실행이 조각을 닫지 못하고 끝났다면(Rotate 도중 등) sequence 앞의 조각에
+    // 미리 늘려둔 0이 남아있으므로 잘라내고 압축 대기열로 넘긴다. 깨끗하게 닫힌 조각은 머리만 읽고 넘어간다.
+    void RepairStaleSegmentsLocked(const LogRotationPolicy& rotation)
+    {
+        using namespace LogMappedFormat;
+
+        for (uint32_t i = 0; i < sequence; ++i) {
+            const std::filesystem::path path(LogSegmentName(baseName, i));
+            uint64_t size = 0;
+            uint64_t committed = 0;
+            if (ReadFileState(path, size, committed) != FileState::FILE_MAPPED || size == HEADER_SIZE + committed) {
+                continue;
+            }
+            if (RepairTail(path, size, committed)) {
+                Retire(path.wstring(), rotation);
+            }
+        }
+    }
+
+    static void Retire(const std::wstring& fileName, const LogRotationPolicy& rotation)
+    {
+        if (rotation.archiver != nullptr && !fileName.empty()) {
+            rotation.archiver->Submit(fileName);
+        }
+    }
+
+    void CommitLocked(void)
+    {
+        if (Mapping* mapping = current.load(std::memory_order_relaxed)) {
+            mapping->Commit();
+        }
+    }
+
+    void CloseLocked(void)
+    {
+        if (CloseMappingLocked()) {
+            NotifyClosed();
+        }
+    }
+
+    bool CloseMappingLocked(void)
+    {
+        std::unique_ptr<Mapping> mapping(current.exchange(nullptr, std::memory_order_acq_rel));
+        if (mapping == nullptr) {
+            return false;
+        }
+
+        WaitForWritersLocked();
+        mapping->Close();
+        return true;
+    }
+
+    // LogFile::TryEvict와 같다.
+    bool TryEvict(void) override
+    {
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (!guard.owns_lock()) {
+            return false;
+        }
+        CloseMappingLocked();
+        return true;
+    }
+
+    struct alignas(64) WriterCount {
+        std::atomic<uint64_t> count{ 0 };
+    };
+
+    std::atomic<Mapping*> current{ nullptr };
+    alignas(64) std::atomic<uint64_t> epochCounter{ 0 };
+    WriterCount activeWriters[2];
+
+    std::mutex lock;                // 파일 전환 / 닫기 / 머리 갱신
+    std::wstring baseName;          // lock : 지금 기간의 파일 이름 (GetLogFileName의 결과)
+    std::wstring retiredBaseName;   // lock : 바로 전 기간의 파일 이름
+    std::wstring segmentName;       // lock : 지금(또는 마지막으로 연) 조각의 파일 이름
+    uint32_t sequence = 0;          // lock : 지금 조각 번호
+    uint64_t generationCounter = 0; // lock : 마지막으로 연 조각의 세대 번호
+    Clock::time_point lastWrite{};
+    Clock::time_point lastCommit{};
+};
@@ -0,0 +1,422 @@
+﻿#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "LogLine.h"
+#include "LogPlatform.h"
+#include "LogSite.h"
+
+// 로거 자신의 계측. (SystemLogManager::GetLoggerStats / SYSLOG_STATS_LOG)
+// SYSLOG_METRICS를 0으로 정의하고 빌드하면 계측 코드는 모두 빠진다. (스냅샷은 0만 담는다)
+#ifndef SYSLOG_METRICS
+#define SYSLOG_METRICS 1
+#endif
+
+constexpr bool LOG_METRICS_ENABLED = SYSLOG_METRICS != 0;
+
+constexpr size_t LOG_LEVEL_COUNT = static_cast<size_t>(LogLevel::LEVEL_SYSTEM) + 1;
+
+// 로그 한 건이 거치는 구간. 구간마다 사이클(LogPlatform::ReadCycles)을 잰다.
+enum class LogStage : uint8_t {
+    STAGE_CAPTURE,      // 호출한 스레드에서 메시지를 만드는 구간 (인자 복사 / LogV의 포맷 / LogHex의 헥스 덤프)
+    STAGE_ENQUEUE,      // 비동기 큐 / 스레드 로컬 링 버퍼에 넣기 (가득 차서 기다린 시간 포함)
+    STAGE_FORMAT,       // 지연 포맷 (인자로 메시지 만들기)
+    STAGE_RENDER,       // 머리말을 붙여 한 줄 완성
+    STAGE_TEXT_WRITE,   // 텍스트 파일에 쓰기 (lock 대기와 플러시 포함. 비동기 / 스레드 로컬 모드는 type 별로 모은 한 번의 쓰기)
+    STAGE_BINARY_WRITE, // 바이너리 파일에 쓰기 (lock 대기와 플러시 포함)
+    STAGE_CONSOLE,      // 콘솔 버퍼에 넣기
+    STAGE_SINKS,        // 추가 출력 대상에 나눠주기 (싱크들이 쓰는 형식 만들기 포함. 쓰기는 싱크의 스레드에서)
+    STAGE_COUNT
+};
+
+inline const wchar_t* LogStageName(LogStage stage)
+{
+    switch (stage) {
+    case LogStage::STAGE_CAPTURE: return L"capture";
+    case LogStage::STAGE_ENQUEUE: return L"enqueue";
+    case LogStage::STAGE_FORMAT: return L"format";
+    case LogStage::STAGE_RENDER: return L"render";
+    case LogStage::STAGE_TEXT_WRITE: return L"text";
+    case LogStage::STAGE_BINARY_WRITE: return L"binary";
+    case LogStage::STAGE_CONSOLE: return L"console";
+    case LogStage::STAGE_SINKS: return L"sinks";
+    default: return L"unknown";
+    }
+}
+
+constexpr size_t LOG_STAGE_COUNT = static_cast<size_t>(LogStage::STAGE_COUNT);
+
+// 구간 하나의 누적 값
+struct LogStageStats {
+    uint64_t samples = 0;       // 잰 횟수 (LOG_METRICS_SAMPLE_INTERVAL 건에 한 번)
+    uint64_t cycles = 0;        // 잰 사이클의 합
+    uint64_t maxCycles = 0;
+
+    uint64_t AverageCycles(void) const { return samples == 0 ? 0 : cycles / samples; }
+};
+
+// lock 대기 히스토그램. bucket 0은 기다리지 않고 잡은 횟수, bucket n(1 이상)은 2^(n-1) ~ 2^n - 1 사이클 기다린 횟수
+constexpr size_t LOG_WAIT_BUCKETS = 40;
+
+struct LogWaitStats {
+    std::array<uint64_t, LOG_WAIT_BUCKETS> buckets{};
+
+    uint64_t Acquisitions(void) const
+    {
+        uint64_t total = 0;
+        for (uint64_t count : buckets)
+            total += count;
+        return total;
+    }
+
+    uint64_t Waits(void) const { return Acquisitions() - buckets[0]; }
+
+    // 기다린 경우 중 q(0 ~ 1) 위치의 대기 사이클. bucket의 윗값으로 답한다. (기다린 적이 없으면 0)
+    uint64_t WaitPercentile(double q) const
+    {
+        const uint64_t waits = Waits();
+        if (waits == 0) {
+            return 0;
+        }
+
+        const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(waits - 1));
+        uint64_t seen = 0;
+        for (size_t bucket = 1; bucket < LOG_WAIT_BUCKETS; ++bucket) {
+            seen += buckets[bucket];
+            if (seen > rank) {
+                return (uint64_t{ 1 } << bucket) - 1;
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    LogWaitStats& operator+=(const LogWaitStats& other)
+    {
+        for (size_t i = 0; i < LOG_WAIT_BUCKETS; ++i)
+            buckets[i] += other.buckets[i];
+        return *this;
+    }
+};
+
+class LogWaitHistogram {
+public:
+    // lock을 잡은 뒤에 부른다. (AddUncontended와 같음)
+    void Add(uint64_t cycles)
+    {
+        size_t bucket = 1;
+        while (bucket + 1 < LOG_WAIT_BUCKETS && (cycles >> bucket) != 0) {
+            bucket++;
+        }
+        buckets[bucket].store(buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // lock을 잡은 뒤에 부른다. 쓰는 쪽이 lock을 가진 스레드 하나뿐이므로 원자적으로 더하지 않는다.
+    void AddUncontended(void) { buckets[0].store(buckets[0].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    LogWaitStats GetStats(void) const
+    {
+        LogWaitStats stats;
+        for (size_t i = 0; i < LOG_WAIT_BUCKETS; ++i)
+            stats.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, LOG_WAIT_BUCKETS> buckets{};
+};
+
+// std::lock_guard 대신 사용한다. 바로 잡히지 않으면 기다린 사이클을 histogram에 남긴다.
+template <typename Mutex>
+class LogTimedLock {
+public:
+    LogTimedLock(Mutex& mutex, LogWaitHistogram& histogram) : mutex(mutex)
+    {
+        if constexpr (LOG_METRICS_ENABLED) {
+            if (mutex.try_lock()) {
+                histogram.AddUncontended();
+                return;
+            }
+
+            const uint64_t start = LogPlatform::ReadCycles();
+            mutex.lock();
+            histogram.Add(LogPlatform::ReadCycles() - start);
+        }
+        else {
+            (void)histogram;
+            mutex.lock();
+        }
+    }
+
+    ~LogTimedLock(void) { mutex.unlock(); }
+
+    LogTimedLock(const LogTimedLock&) = delete;
+    LogTimedLock& operator=(const LogTimedLock&) = delete;
+
+private:
+    Mutex& mutex;
+};
+
+// type 하나의 레벨 별 기록 수와 바이트
+// 바이트는 텍스트 줄의 길이다. 텍스트를 쓰지 않으면(FORMAT_BINARY) 메시지 / 인자의 길이
+struct LogTypeCounters {
+    std::array<uint64_t, LOG_LEVEL_COUNT> records{};
+    std::array<uint64_t, LOG_LEVEL_COUNT> bytes{};
+};
+
+// type / 레벨 별 기록 수와 바이트. 모든 로그가 지나가므로 공유 카운터에 원자적으로 더하지 않고,
+// 스레드마다 자신의 칸(Shard)에만 relaxed load / store로 쓴다. (쓰는 스레드가 하나뿐이라 잃는 값이 없다)
+// 칸은 type CHUNK_TYPES개 단위로 처음 쓸 때 만든다. 끝난 스레드의 칸은 다음 GetCounters 때 retired 합계로 옮긴다.
+class LogTypeCounterTable {
+public:
+    explicit LogTypeCounterTable(size_t maxTypes) : chunkCount((maxTypes + CHUNK_TYPES - 1) / CHUNK_TYPES) {}
+
+    LogTypeCounterTable(const LogTypeCounterTable&) = delete;
+    LogTypeCounterTable& operator=(const LogTypeCounterTable&) = delete;
+
+    void Add(size_t typeId, LogLevel level, size_t bytes)
+    {
+        if constexpr (LOG_METRICS_ENABLED) {
+            static thread_local ShardHandle handle;
+            if (!handle.shard) {
+                handle.shard = Attach();
+            }
+
+            Chunk* chunk = handle.shard->chunks[typeId / CHUNK_TYPES].load(std::memory_order_relaxed);
+            if (chunk == nullptr) {
+                chunk = AddChunk(*handle.shard, typeId / CHUNK_TYPES);
+            }
+
+            Slot& slot = chunk->slots[typeId % CHUNK_TYPES][static_cast<size_t>(level)];
+            slot.records.store(slot.records.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            slot.bytes.store(slot.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        }
+    }
+
+    // type id 순서의 누적 값. counters는 typeCount 크기로 바뀐다.
+    void GetCounters(size_t typeCount, std::vector<LogTypeCounters>& counters)
+    {
+        counters.assign(typeCount, LogTypeCounters());
+
+        std::lock_guard<std::mutex> guard(shardsLock);
+        for (auto it = shards.begin(); it != shards.end();) {
+            Shard& shard = **it;
+            const bool retired = shard.retired.load(std::memory_order_acquire);
+            AddShard(shard, retired ? retiredTotals : counters);
+
+            if (retired) {
+                it = shards.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        for (size_t id = 0; id < typeCount && id < retiredTotals.size(); ++id) {
+            for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+                counters[id].records[level] += retiredTotals[id].records[level];
+                counters[id].bytes[level] += retiredTotals[id].bytes[level];
+            }
+        }
+    }
+
+private:
+    static constexpr size_t CHUNK_TYPES = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> records{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+    };
+
+    struct Chunk {
+        std::array<std::array<Slot, LOG_LEVEL_COUNT>, CHUNK_TYPES> slots;
+    };
+
+    struct Shard {
+        explicit Shard(size_t chunkCount) : chunks(chunkCount) {}
+
+        std::vector<std::atomic<Chunk*>> chunks;        // 주인 스레드만 채운다. (shardsLock 안에서)
+        std::vector<std::unique_ptr<Chunk>> owned;      // shardsLock으로 보호
+        std::atomic<bool> retired{ false };
+    };
+
+    // 각 스레드가 thread_local로 들고 있는 핸들. 스레드가 끝나면 칸을 retired로 표시한다.
+    // (thread_local은 스레드마다 하나이므로 LogTypeCounterTable도 프로세스에 하나만 둔다. SystemLogManager)
+    struct ShardHandle {
+        std::shared_ptr<Shard> shard;
+
+        ~ShardHandle(void)
+        {
+            if (shard) {
+                shard->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    std::shared_ptr<Shard> Attach(void)
+    {
+        auto shard = std::make_shared<Shard>(chunkCount);
+        std::lock_guard<std::mutex> guard(shardsLock);
+        shards.push_back(shard);
+        return shard;
+    }
+
+    Chunk* AddChunk(Shard& shard, size_t index)
+    {
+        std::lock_guard<std::mutex> guard(shardsLock);
+        shard.owned.push_back(std::make_unique<Chunk>());
+        Chunk* chunk = shard.owned.back().get();
+        shard.chunks[index].store(chunk, std::memory_order_release);
+        return chunk;
+    }
+
+    // shardsLock을 잡은 상태에서 호출
+    void AddShard(const Shard& shard, std::vector<LogTypeCounters>& totals)
+    {
+        for (size_t index = 0; index < shard.chunks.size(); ++index) {
+            const Chunk* chunk = shard.chunks[index].load(std::memory_order_acquire);
+            if (chunk == nullptr) {
+                continue;
+            }
+
+            for (size_t offset = 0; offset < CHUNK_TYPES; ++offset) {
+                const size_t id = index * CHUNK_TYPES + offset;
+                for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+                    const Slot& slot = chunk->slots[offset][level];
+                    const uint64_t records = slot.records.load(std::memory_order_relaxed);
+                    if (records == 0) {
+                        continue;
+                    }
+                    if (id >= totals.size()) {
+                        totals.resize(id + 1);
+                    }
+                    totals[id].records[level] += records;
+                    totals[id].bytes[level] += slot.bytes.load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    const size_t chunkCount;
+    std::mutex shardsLock;
+    std::vector<std::shared_ptr<Shard>> shards;     // shardsLock으로 보호. 스레드마다 하나
+    std::vector<LogTypeCounters> retiredTotals;     // shardsLock으로 보호. 끝난 스레드의 합
+};
+
+// 구간 별 사이클. 모든 로그를 재면 rdtsc 두 번과 공유 카운터 갱신이 매번 붙으므로,
+// 스레드마다 LOG_METRICS_SAMPLE_INTERVAL 건에 한 번만 잰다. 나머지 건의 비용은 thread_local 카운터 증가 하나다.
+constexpr uint32_t LOG_METRICS_SAMPLE_INTERVAL = 64;
+
+class LogStageMetrics {
+public:
+    // 이 스레드에서 이번 로그의 구간들을 잴 차례인지. 로그 한 건을 처리하기 시작할 때 한 번 부른다.
+    static bool SampleNext(void)
+    {
+        if constexpr (LOG_METRICS_ENABLED) {
+            static thread_local uint32_t counter = 0;
+            return ++counter % LOG_METRICS_SAMPLE_INTERVAL == 0;
+        }
+        else {
+            return false;
+        }
+    }
+
+    void Add(LogStage stage, uint64_t cycles)
+    {
+        Slot& slot = slots[static_cast<size_t>(stage)];
+        slot.samples.fetch_add(1, std::memory_order_relaxed);
+        slot.cycles.fetch_add(cycles, std::memory_order_relaxed);
+
+        uint64_t seen = slot.maxCycles.load(std::memory_order_relaxed);
+        while (cycles > seen && !slot.maxCycles.compare_exchange_weak(seen, cycles, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::array<LogStageStats, LOG_STAGE_COUNT> GetStats(void) const
+    {
+        std::array<LogStageStats, LOG_STAGE_COUNT> stats;
+        for (size_t i = 0; i < LOG_STAGE_COUNT; ++i) {
+            stats[i].samples = slots[i].samples.load(std::memory_order_relaxed);
+            stats[i].cycles = slots[i].cycles.load(std::memory_order_relaxed);
+            stats[i].maxCycles = slots[i].maxCycles.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // 구간마다 캐시 라인을 따로 쓴다. (writer 스레드와 생산자가 서로 다른 구간을 갱신함)
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<uint64_t> samples{ 0 };
+        std::atomic<uint64_t> cycles{ 0 };
+        std::atomic<uint64_t> maxCycles{ 0 };
+    };
+
+    std::array<Slot, LOG_STAGE_COUNT> slots;
+};
+
+// 구간 하나를 잰다. sampled가 false면(또는 SYSLOG_METRICS가 0이면) 아무것도 하지 않는다.
+class LogStageTimer {
+public:
+    LogStageTimer(LogStageMetrics& metrics, LogStage stage, bool sampled) : metrics(metrics), stage(stage), sampled(LOG_METRICS_ENABLED && sampled)
+    {
+        if (this->sampled) {
+            start = LogPlatform::ReadCycles();
+        }
+    }
+
+    ~LogStageTimer(void)
+    {
+        if (sampled) {
+            metrics.Add(stage, LogPlatform::ReadCycles() - start);
+        }
+    }
+
+    LogStageTimer(const LogStageTimer&) = delete;
+    LogStageTimer& operator=(const LogStageTimer&) = delete;
+
+private:
+    LogStageMetrics& metrics;
+    LogStage stage;
+    bool sampled;
+    uint64_t start = 0;
+};
+
+// type 하나의 누적 값
+struct LogTypeStats {
+    std::wstring name;
+    LogTypeCounters counters;
+    LogWaitStats lockWaits;     // 텍스트(WRITER_STREAM) / 바이너리 파일의 lock 대기. WRITER_MAPPED는 lock 없이 쓴다.
+};
+
+// 추가 출력 대상(LogSink) 하나의 누적 값
+struct LogSinkStats {
+    std::wstring name;
+    uint64_t written = 0;       // 쓴 로그
+    uint64_t dropped = 0;       // 쌓인 로그가 한도를 넘어서 버린 로그
+    uint64_t failed = 0;        // 쓰지 못한 로그 (보내기 실패 등)
+    size_t pending = 0;         // 아직 쓰지 않은 로그
+};
+
+// SystemLogManager::GetLoggerStats의 결과. 값은 모두 시작부터의 누적이며, 초당 값은 두 스냅샷의 차이를 time의 차이로 나눠서 구한다.
+struct LoggerStatsSnapshot {
+    std::chrono::steady_clock::time_point time{};
+    std::array<LogStageStats, LOG_STAGE_COUNT> stages{};
+    std::vector<LogTypeStats> types;        // 등록된 type 전부 (id 순)
+    uint64_t queueDepth = 0;                // 비동기 큐 / 스레드 로컬 모드의 아직 기록하지 않은 로그 수 (writer / collector가 마지막으로 본 값)
+    uint64_t peakQueueDepth = 0;
+    int64_t droppedRecords = 0;             // 큐 / 링 버퍼가 가득 차서 버린 로그 (POLICY_DROP)
+    int64_t overwrittenRecords = 0;         // 큐가 가득 차서 덮어쓴 로그 (POLICY_OVERWRITE_OLDEST)
+    uint64_t truncatedMessages = 0;         // LogV(va_list)에서 최대 길이를 넘어 잘린 메시지
+    uint64_t consoleDroppedLines = 0;       // 콘솔 버퍼가 가득 차거나 1초당 한도를 넘어서 버린 줄
+    std::vector<LogSiteStats> sites;        // 기준(샘플링 / 1초당 한도 / 반복 줄이기)이 켜진 적이 있는 LOG 호출 위치
+    std::vector<LogSinkStats> sinks;        // 등록된 추가 출력 대상 (SYSLOG_ADD_SINK)
+};
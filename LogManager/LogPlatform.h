@@ -0,0 +1,251 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <cwchar>
+
+#ifdef _WIN32
+#include <winsock2.h>   // <Windows.h>보다 먼저 (<Windows.h>가 끌어오는 winsock.h와 겹치지 않도록)
+#include <ws2tcpip.h>
+#include <Windows.h>
+#include <strsafe.h>
+#include <io.h>
+#include <fcntl.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 운영체제마다 다른 API를 감싸는 얇은 층. 나머지 코드는 <Windows.h> / winsock2.h / strsafe.h / io.h를 직접 포함하지 않고 여기만 거친다.
+// (인덱스 카운터 등 원자적 연산은 std::atomic, 파일 / 매핑은 각 클래스 안의 _WIN32 분기가 맡는다)
+namespace LogPlatform {
+
+    // seconds의 로컬 시각. (localtime_s / localtime_r)
+    inline bool LocalTime(std::time_t seconds, std::tm& out)
+    {
+#ifdef _WIN32
+        return localtime_s(&out, &seconds) == 0;
+#else
+        return localtime_r(&seconds, &out) != nullptr;
+#endif
+    }
+
+    // seconds의 UTC 시각. (gmtime_s / gmtime_r)
+    inline bool UtcTime(std::time_t seconds, std::tm& out)
+    {
+#ifdef _WIN32
+        return gmtime_s(&out, &seconds) == 0;
+#else
+        return gmtime_r(&seconds, &out) != nullptr;
+#endif
+    }
+
+#ifndef _WIN32
+    // Windows의 wide printf 규칙(%s / %c는 wchar_t, %hs / %S는 char)을 C 표준(%ls / %lc는 wchar_t)으로 옮긴다.
+    // out이 모자라면 false
+    inline bool TranslateWideFormat(const wchar_t* format, wchar_t* out, size_t capacity)
+    {
+        size_t length = 0;
+        auto put = [&](wchar_t ch) {
+            if (length + 1 >= capacity) {
+                return false;
+            }
+            out[length++] = ch;
+            return true;
+        };
+
+        for (const wchar_t* p = format; *p != L'\0'; ++p) {
+            if (!put(*p)) {
+                return false;
+            }
+            if (*p != L'%') {
+                continue;
+            }
+
+            // 플래그 / 폭 / 정밀도는 그대로
+            ++p;
+            while (*p != L'\0' && std::wcschr(L"-+ #0123456789.*", *p) != nullptr) {
+                if (!put(*p++)) {
+                    return false;
+                }
+            }
+
+            bool ok = true;
+            if (*p == L's' || *p == L'c') {
+                ok = put(L'l') && put(*p);
+            }
+            else if (*p == L'S' || *p == L'C') {
+                ok = put(static_cast<wchar_t>(*p - L'A' + L'a'));
+            }
+            else if (*p == L'h' && (p[1] == L's' || p[1] == L'c')) {
+                ok = put(*++p);
+            }
+            else if (*p != L'\0') {
+                ok = put(*p);
+            }
+            else {
+                break;
+            }
+
+            if (!ok) {
+                return false;
+            }
+        }
+
+        out[length] = L'\0';
+        return true;
+    }
+#endif
+
+    // printf 형식(Windows 규칙)으로 buffer에 쓴다. 넘치면 잘린 채로 끝나고 false (StringCchVPrintf)
+    inline bool FormatV(wchar_t* buffer, size_t count, const wchar_t* format, va_list args)
+    {
+#ifdef _WIN32
+        return SUCCEEDED(StringCchVPrintfW(buffer, count, format, args));
+#else
+        wchar_t translated[1024];
+        if (TranslateWideFormat(format, translated, sizeof(translated) / sizeof(wchar_t))) {
+            format = translated;
+        }
+
+        if (std::vswprintf(buffer, count, format, args) < 0) {
+            buffer[count - 1] = L'\0';
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    // CPU 사이클 카운터 (x86은 rdtsc). 구간 길이를 비교하는 용도이며, 다른 CPU에서는 steady_clock의 틱으로 대신한다.
+    inline uint64_t ReadCycles(void)
+    {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+#ifdef _WIN32
+    using SocketHandle = SOCKET;
+    constexpr SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+#else
+    using SocketHandle = int;
+    constexpr SocketHandle INVALID_SOCKET_HANDLE = -1;
+#endif
+
+    // 127.0.0.1:port에 묶인 non-blocking UDP 소켓. 같은 머신에서만 보낼 수 있다. 실패하면 INVALID_SOCKET_HANDLE
+    inline SocketHandle OpenLoopbackUdp(uint16_t port)
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            return INVALID_SOCKET_HANDLE;
+        }
+#endif
+
+        SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == INVALID_SOCKET_HANDLE) {
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return INVALID_SOCKET_HANDLE;
+        }
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        const bool ready = bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0
+            && ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+        if (!ready) {
+            closesocket(handle);
+            WSACleanup();
+            return INVALID_SOCKET_HANDLE;
+        }
+#else
+        const int flags = fcntl(handle, F_GETFL, 0);
+        const bool ready = bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0
+            && flags != -1 && fcntl(handle, F_SETFL, flags | O_NONBLOCK | O_CLOEXEC) == 0;
+        if (!ready) {
+            close(handle);
+            return INVALID_SOCKET_HANDLE;
+        }
+#endif
+        return handle;
+    }
+
+    // 보내기만 하는 UDP 소켓 (SendLoopbackDatagram). 실패하면 INVALID_SOCKET_HANDLE
+    inline SocketHandle OpenUdpSender(void)
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            return INVALID_SOCKET_HANDLE;
+        }
+#endif
+
+        SocketHandle handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+        if (handle == INVALID_SOCKET_HANDLE) {
+            WSACleanup();
+        }
+#endif
+        return handle;
+    }
+
+    // 127.0.0.1:port로 datagram 하나를 보낸다. 받는 쪽이 없어도 실패하지 않을 수 있다. (UDP)
+    inline bool SendLoopbackDatagram(SocketHandle handle, uint16_t port, const char* data, size_t length)
+    {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sendto(handle, data, static_cast<int>(length), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == static_cast<int>(length);
+    }
+
+    // 기다리지 않고 datagram 하나를 받는다. 받은 바이트 수, 없거나 실패하면 -1 (capacity보다 긴 datagram은 잘린다)
+    inline int ReceiveDatagram(SocketHandle handle, char* buffer, size_t capacity)
+    {
+        return static_cast<int>(recv(handle, buffer, static_cast<int>(capacity), 0));
+    }
+
+    inline void CloseSocket(SocketHandle handle)
+    {
+#ifdef _WIN32
+        closesocket(handle);
+        WSACleanup();
+#else
+        close(handle);
+#endif
+    }
+
+    // 줄바꿈이 \r\n으로 바뀌지 않도록 바이너리 모드로 바꾼다. (stdout으로 UTF-8 바이트를 그대로 내보낼 때)
+    inline void SetBinaryMode(std::FILE* file)
+    {
+#ifdef _WIN32
+        _setmode(_fileno(file), _O_BINARY);
+#else
+        (void)file;
+#endif
+    }
+}
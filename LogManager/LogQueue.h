@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 큐가 가득 찼을 때 생산자(로그를 남기는 스레드)가 취할 행동
+enum class QueueFullPolicy {
+    POLICY_BLOCK,               // 자리가 날 때까지 대기
+    POLICY_DROP,                // 새로 들어온 로그를 버림
+    POLICY_OVERWRITE_OLDEST     // 가장 오래된 로그를 버리고 새 로그를 넣음
+};
+
+// 크기가 고정된 링 버퍼 기반의 락프리 큐.
+// 각 칸(Cell)이 자신의 sequence를 가지고 있어서 생산자끼리는 enqueuePos에 대한 CAS로만 경쟁하고,
+// 소비자와는 칸 단위로만 동기화된다. (Dmitry Vyukov의 bounded MPMC queue)
+// 로그 시스템에서는 여러 게임 스레드가 넣고 writer 스레드 하나가 빼는 MPSC로 사용하지만,
+// POLICY_OVERWRITE_OLDEST 처리를 위해 생산자도 TryPop을 호출할 수 있도록 MPMC로 구현한다.
+template <typename T>
+class BoundedLogQueue {
+public:
+    explicit BoundedLogQueue(size_t requestedCapacity)
+    {
+        // 인덱스 계산을 & 연산으로 하기 위해 2의 거듭제곱으로 올림
+        size_t capacity = 2;
+        while (capacity < requestedCapacity)
+            capacity <<= 1;
+
+        mask = capacity - 1;
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    BoundedLogQueue(const BoundedLogQueue&) = delete;
+    BoundedLogQueue& operator=(const BoundedLogQueue&) = delete;
+
+    // 큐가 가득 차 있다면 false를 반환하고 item은 건드리지 않는다.
+    bool TryPush(T&& item)
+    {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 큐가 비어 있다면 false를 반환한다.
+    bool TryPop(T& out)
+    {
+        Cell* cell;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        out = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 크래시 핸들러 전용. 꺼내지 않고 남아있는 항목을 넣은 순서대로 visit에 넘긴다.
+    // 소비자가 멈춰있어야 정확하며, 생산자가 넣는 중이라 아직 공개되지 않은 칸은 건너뛴다.
+    template <typename Visitor>
+    void PeekUnsafe(Visitor&& visit) const
+    {
+        const size_t head = dequeuePos.load(std::memory_order_acquire);
+        const size_t tail = enqueuePos.load(std::memory_order_acquire);
+        for (size_t pos = head; pos != tail && pos - head <= mask; ++pos) {
+            const Cell& cell = cells[pos & mask];
+            if (cell.sequence.load(std::memory_order_acquire) == pos + 1) {
+                visit(cell.data);
+            }
+        }
+    }
+
+    size_t Capacity(void) const { return mask + 1; }
+
+    // 다른 스레드가 동시에 접근 중이라면 정확하지 않은 값. 모니터링 용도로만 사용한다.
+    size_t ApproxSize(void) const
+    {
+        size_t tail = enqueuePos.load(std::memory_order_relaxed);
+        size_t head = dequeuePos.load(std::memory_order_relaxed);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool Empty(void) const { return ApproxSize() == 0; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+
+    // 생산자와 소비자가 같은 캐시 라인을 두고 경쟁하지 않도록 분리
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+};
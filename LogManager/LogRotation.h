@@ -0,0 +1,454 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "LogLz4.h"
+
+class LogArchiver;
+
+// 로그 파일을 나누는 기간 (GetLogFileName)
+enum class LogRotationPeriod {
+    ROTATE_MONTH,       // YYYYMM_type.txt
+    ROTATE_DAY,         // YYYYMMDD_type.txt
+    ROTATE_HOUR,        // YYYYMMDD_HH_type.txt
+};
+
+// 한 type의 로그 파일을 나누는 기준 (SYSLOG_ROTATION / SYSLOG_TYPE_ROTATION)
+// 기간이 바뀌면 새 파일로 넘어가고, 기간 안에서도 크기 / 기록 수 한도를 넘으면 YYYYMM_type.1.txt, .2.txt ... 로 넘어간다.
+// 한도를 넘긴 로그까지 그 파일에 들어가므로 파일은 한도보다 로그 한 건만큼 클 수 있다.
+struct LogRotationPolicy {
+    LogRotationPeriod period = LogRotationPeriod::ROTATE_MONTH;
+    uint64_t maxBytes = 0;              // 파일 하나의 한도(바이트). 0이면 사용 안 함
+    uint64_t maxRecords = 0;            // 파일 하나에 남길 로그 수 한도. 0이면 사용 안 함
+    LogArchiver* archiver = nullptr;    // 다 쓴 파일을 넘길 곳. SystemLogManager가 채운다. (nullptr이면 그대로 둔다)
+
+    bool IsFull(uint64_t bytes, uint64_t records) const
+    {
+        return (maxBytes != 0 && bytes >= maxBytes) || (maxRecords != 0 && records >= maxRecords);
+    }
+};
+
+// 다 쓴 로그 파일의 압축과 보관 기준 (SYSLOG_ARCHIVE)
+struct LogArchivePolicy {
+    size_t compressThreads = 1;                         // 다 쓴 파일을 LZ4(.lz4)로 압축할 스레드 수. 0이면 압축하지 않음
+    std::chrono::hours maxAge{ 0 };                     // 마지막 수정 후 이 시간이 지난 로그 파일은 지운다. 0이면 사용 안 함
+    uint64_t maxTotalBytes = 0;                         // 폴더의 로그 파일 크기 합이 이를 넘으면 오래된 것부터 지운다. 0이면 사용 안 함
+    std::chrono::seconds retentionInterval{ 60 };       // 보관 기준을 확인하는 주기
+};
+
+struct LogArchiveStats {
+    uint64_t compressedFiles = 0;
+    uint64_t compressedInputBytes = 0;
+    uint64_t compressedOutputBytes = 0;
+    uint64_t compressFailures = 0;
+    uint64_t deletedFiles = 0;
+    uint64_t deletedBytes = 0;
+};
+
+// baseName(GetLogFileName의 결과)의 sequence번째 조각. 0이면 baseName 그대로, 그 외에는 확장자 앞에 번호를 붙인다. (202610_Battle.3.txt)
+inline std::wstring LogSegmentName(const std::wstring& baseName, uint32_t sequence)
+{
+    if (sequence == 0) {
+        return baseName;
+    }
+
+    const size_t dot = baseName.find_last_of(L'.');
+    const size_t slash = baseName.find_last_of(L"/\\");
+    const size_t split = (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash)) ? baseName.size() : dot;
+    return baseName.substr(0, split) + L"." + std::to_wstring(sequence) + baseName.substr(split);
+}
+
+// baseName의 조각 중 이어서 쓸 번호. 가장 마지막 조각이 이미 압축되었다면(.lz4만 남음) 그 다음 번호
+// 기간이 바뀌어 처음 쓰는 경우에만 부르므로 폴더를 훑는다.
+inline uint32_t FindLogSegment(const std::wstring& baseName)
+{
+    const std::filesystem::path base(baseName);
+    const std::filesystem::path directory = base.has_parent_path() ? base.parent_path() : std::filesystem::path(L".");
+    const std::wstring stem = base.stem().wstring() + L".";
+    const std::wstring extension = base.extension().wstring();
+    const std::wstring fileName = base.filename().wstring();
+
+    int64_t last = -1;
+    bool lastIsPlain = false;
+
+    auto consider = [&](int64_t sequence, bool plain) {
+        if (sequence > last) {
+            last = sequence;
+            lastIsPlain = plain;
+        }
+        else if (sequence == last) {
+            lastIsPlain |= plain;
+        }
+    };
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        const std::wstring name = it->path().filename().wstring();
+
+        if (name == fileName || name == fileName + L".lz4") {
+            consider(0, name == fileName);
+            continue;
+        }
+        if (name.compare(0, stem.size(), stem) != 0) {
+            continue;
+        }
+
+        size_t position = stem.size();
+        int64_t sequence = 0;
+        while (position < name.size() && name[position] >= L'0' && name[position] <= L'9' && sequence < 0x7FFFFFFF) {
+            sequence = sequence * 10 + (name[position++] - L'0');
+        }
+        if (position == stem.size()) {
+            continue;
+        }
+
+        const std::wstring rest = name.substr(position);
+        if (rest == extension || rest == extension + L".lz4") {
+            consider(sequence, rest == extension);
+        }
+    }
+
+    if (last < 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>(lastIsPlain ? last : last + 1);
+}
+
+// 다 쓴 로그 파일을 백그라운드 스레드에서 LZ4로 압축하고(fileName.lz4, 원본은 지움) 보관 기준에 따라 오래된 로그 파일을 지운다.
+// Submit은 큐에 넣기만 하므로 로그를 남기는 스레드를 붙잡지 않는다. 시작하지 않았다면 Submit은 아무 일도 하지 않는다.
+// 보관 기준은 폴더에서 로그 파일 이름 형식(숫자로 시작, '_' 포함, .txt / .bin / .lz4)인 것만 보며, 지금 쓰고 있는 파일은 지우지 않는다.
+class LogArchiver {
+public:
+    // 지금 쓰고 있는(다시 열릴 수 있는) 파일 이름을 채워주는 함수
+    using ActiveFilesFunction = std::function<void(std::vector<std::wstring>&)>;
+
+    LogArchiver(void) = default;
+    ~LogArchiver(void) { Stop(); }
+
+    LogArchiver(const LogArchiver&) = delete;
+    LogArchiver& operator=(const LogArchiver&) = delete;
+
+    void Start(const std::wstring& logDirectory, const LogArchivePolicy& archivePolicy, ActiveFilesFunction activeFilesFunction)
+    {
+        Stop();
+
+        directory = logDirectory;
+        policy = archivePolicy;
+        activeFiles = std::move(activeFilesFunction);
+        stopping = false;
+        nextRetention = std::chrono::steady_clock::now();
+        running.store(true, std::memory_order_release);
+
+        const size_t threadCount = std::max<size_t>(1, policy.compressThreads);
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&LogArchiver::WorkerProc, this);
+        }
+    }
+
+    // 큐에 남은 파일을 모두 압축한 뒤 스레드를 종료한다.
+    void Stop(void)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (workers.empty()) {
+                return;
+            }
+            stopping = true;
+            running.store(false, std::memory_order_release);
+        }
+        wakeup.notify_all();
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // 다 쓴 파일을 압축 대기열에 넣는다.
+    void Submit(const std::wstring& fileName)
+    {
+        if (!running.load(std::memory_order_acquire) || policy.compressThreads == 0) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stopping) {
+                return;
+            }
+            pending.push_back(fileName);
+        }
+        wakeup.notify_one();
+    }
+
+    LogArchiveStats GetStats(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+private:
+    void WorkerProc(void)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            if (!pending.empty()) {
+                std::wstring fileName = std::move(pending.front());
+                pending.erase(pending.begin());
+
+                guard.unlock();
+                Compress(fileName);
+                guard.lock();
+
+                // 압축으로 크기가 바뀌었으니 대기열이 비면 보관 기준을 다시 확인한다.
+                if (pending.empty()) {
+                    nextRetention = std::chrono::steady_clock::now();
+                }
+                continue;
+            }
+
+            if (stopping) {
+                break;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= nextRetention && !retentionRunning) {
+                nextRetention = now + policy.retentionInterval;
+                retentionRunning = true;
+
+                guard.unlock();
+                EnforceRetention();
+                guard.lock();
+
+                retentionRunning = false;
+                continue;
+            }
+
+            wakeup.wait_until(guard, nextRetention);
+        }
+    }
+
+    void Compress(const std::wstring& fileName)
+    {
+        const std::filesystem::path source(fileName);
+        std::filesystem::path dest = source;
+        dest += L".lz4";
+        std::filesystem::path temp = dest;
+        temp += L".tmp";
+
+        std::error_code error;
+        const uintmax_t inputBytes = std::filesystem::file_size(source, error);
+        if (error) {
+            return;
+        }
+
+        bool ok = LogLz4::CompressFile(source, temp);
+        if (ok) {
+            std::filesystem::rename(temp, dest, error);
+            ok = !error;
+        }
+
+        uintmax_t outputBytes = 0;
+        if (ok) {
+            outputBytes = std::filesystem::file_size(dest, error);
+            std::filesystem::remove(source, error);
+        }
+        else {
+            std::filesystem::remove(temp, error);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (ok) {
+            stats.compressedFiles++;
+            stats.compressedInputBytes += inputBytes;
+            stats.compressedOutputBytes += outputBytes;
+        }
+        else {
+            stats.compressFailures++;
+        }
+    }
+
+    static bool IsLogFileName(const std::wstring& name)
+    {
+        if (name.empty() || name[0] < L'0' || name[0] > L'9' || name.find(L'_') == std::wstring::npos) {
+            return false;
+        }
+
+        auto endsWith = [&](const wchar_t* suffix) {
+            const size_t length = std::char_traits<wchar_t>::length(suffix);
+            return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+        };
+        return endsWith(L".txt") || endsWith(L".bin") || endsWith(L".lz4");
+    }
+
+    void EnforceRetention(void)
+    {
+        if (policy.maxAge.count() == 0 && policy.maxTotalBytes == 0) {
+            return;
+        }
+
+        std::vector<std::wstring> active;
+        if (activeFiles) {
+            activeFiles(active);
+        }
+        for (std::wstring& name : active) {
+            name = std::filesystem::path(name).filename().wstring();
+        }
+
+        struct Candidate {
+            std::filesystem::file_time_type lastWrite;
+            uintmax_t size;
+            std::filesystem::path path;
+        };
+        std::vector<Candidate> candidates;
+        uint64_t totalBytes = 0;
+
+        std::error_code error;
+        for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+            std::error_code entryError;
+            if (!it->is_regular_file(entryError)) {
+                continue;
+            }
+
+            const std::wstring name = it->path().filename().wstring();
+            if (!IsLogFileName(name)) {
+                continue;
+            }
+
+            const uintmax_t size = it->file_size(entryError);
+            const auto lastWrite = it->last_write_time(entryError);
+            if (entryError) {
+                continue;
+            }
+
+            totalBytes += size;
+            if (std::find(active.begin(), active.end(), name) == active.end()) {
+                candidates.push_back(Candidate{ lastWrite, size, it->path() });
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) { return lhs.lastWrite < rhs.lastWrite; });
+
+        const auto now = std::filesystem::file_time_type::clock::now();
+        uint64_t deletedFiles = 0;
+        uint64_t deletedBytes = 0;
+        for (const Candidate& candidate : candidates) {
+            const bool expired = policy.maxAge.count() > 0 && now - candidate.lastWrite >= policy.maxAge;
+            const bool overCap = policy.maxTotalBytes != 0 && totalBytes > policy.maxTotalBytes;
+            if (!expired && !overCap) {
+                break;
+            }
+
+            std::error_code removeError;
+            if (std::filesystem::remove(candidate.path, removeError)) {
+                totalBytes -= candidate.size;
+                deletedFiles++;
+                deletedBytes += candidate.size;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        stats.deletedFiles += deletedFiles;
+        stats.deletedBytes += deletedBytes;
+    }
+
+    std::wstring directory;
+    LogArchivePolicy policy;
+    ActiveFilesFunction activeFiles;
+
+    std::atomic<bool> running{ false };
+    std::mutex lock;
+    std::condition_variable wakeup;
+    std::vector<std::thread> workers;
+    std::vector<std::wstring> pending;                  // lock : 압축할 파일
+    bool stopping = false;                              // lock
+    bool retentionRunning = false;                      // lock
+    std::chrono::steady_clock::time_point nextRetention{};  // lock
+    LogArchiveStats stats;                              // lock
+};
+
+// LogFile / LogBinaryFile이 지금 쓰고 있는 조각. 파일 객체의 lock 안에서만 쓴다.
+class LogSegmentTracker {
+public:
+    // fileName(GetLogFileName의 결과)이 지금 기간의 파일인지.
+    // 기간이 바뀐 직전에 이전 기간 시각으로 늦게 도착한 로그도 지금 조각에 넣는다. (다 쓰고 압축 중인 파일을 다시 열지 않기 위함)
+    bool IsCurrentPeriod(const std::wstring& fileName) const
+    {
+        return fileName == baseName || (!retiredBaseName.empty() && fileName == retiredBaseName);
+    }
+
+    // 새 기간으로 넘어간다. 이전 기간의 마지막 조각은 다 쓴 것으로 보고 archiver에 넘긴다. (호출 전에 닫아두어야 한다)
+    void BeginPeriod(const std::wstring& fileName, const LogRotationPolicy& rotation)
+    {
+        if (!baseName.empty()) {
+            Retire(rotation);
+            retiredBaseName = baseName;
+        }
+
+        baseName = fileName;
+        OpenSegment(FindLogSegment(fileName));
+
+        // 이전 실행에서 이미 한도까지 쓴 조각이라면 다음 조각부터
+        if (rotation.IsFull(bytes, 0)) {
+            NextSegment(rotation);
+        }
+    }
+
+    // 기록한 로그를 더한다. 한도에 닿았다면 true (호출한 쪽이 기록 후 파일을 닫고 NextSegment를 부른다)
+    bool Add(uint64_t size, uint64_t count, const LogRotationPolicy& rotation)
+    {
+        bytes += size;
+        records += count;
+        return rotation.IsFull(bytes, records);
+    }
+
+    // 지금 조각을 archiver에 넘기고 다음 조각으로 넘어간다. (호출 전에 닫아두어야 한다)
+    void NextSegment(const LogRotationPolicy& rotation)
+    {
+        Retire(rotation);
+        OpenSegment(sequence + 1);
+    }
+
+    // 지금 조각의 파일 이름. 기록을 시작하기 전이면 빈 문자열
+    const std::wstring& FileName(void) const { return segmentName; }
+
+private:
+    void OpenSegment(uint32_t newSequence)
+    {
+        sequence = newSequence;
+        segmentName = LogSegmentName(baseName, sequence);
+        records = 0;
+
+        std::error_code error;
+        bytes = std::filesystem::file_size(std::filesystem::path(segmentName), error);
+        if (error) {
+            bytes = 0;
+        }
+    }
+
+    void Retire(const LogRotationPolicy& rotation) const
+    {
+        if (rotation.archiver != nullptr && !segmentName.empty()) {
+            rotation.archiver->Submit(segmentName);
+        }
+    }
+
+    std::wstring baseName;          // 지금 기간의 파일 이름 (GetLogFileName의 결과)
+    std::wstring retiredBaseName;   // 바로 전 기간의 파일 이름
+    std::wstring segmentName;       // 지금 조각의 파일 이름
+    uint32_t sequence = 0;
+    uint64_t bytes = 0;
+    uint64_t records = 0;
+};
@@ -0,0 +1,643 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LogBufferPool.h"
+#include "LogFilter.h"
+#include "LogLine.h"
+#include "LogMetrics.h"
+#include "LogTime.h"
+#include "LogTypeRegistry.h"
+
+// type 별 파일 / 콘솔 외에 로그를 더 내보낼 곳. (SystemLogManager::AddSink / SYSLOG_ADD_SINK)
+// 로그 한 건은 그 로그를 받는 싱크들이 쓰는 형식마다 한 번씩만 만들어지고(LogSinkRecord),
+// 싱크마다 복사하지 않고 참조 수(shared_ptr)로 나눠 가진다. 싱크를 더해도 포맷 비용은 늘지 않는다.
+
+// 싱크가 받는 텍스트 형식
+enum class LogSinkFormat : uint8_t {
+    FORMAT_LINE,        // 파일과 같은 줄 "[type] [시각 / LEVEL / 인덱스] 메시지\n" (LogHex는 헥스 덤프까지)
+    FORMAT_MESSAGE,     // 메시지만. 줄바꿈 없음 (LogHex는 "설명\n헥스 덤프")
+    FORMAT_COUNT
+};
+
+constexpr size_t LOG_SINK_FORMAT_COUNT = static_cast<size_t>(LogSinkFormat::FORMAT_COUNT);
+
+// LogSinkFormat 집합. 형식 하나가 비트 하나
+using LogSinkFormatMask = uint8_t;
+
+constexpr LogSinkFormatMask LogSinkFormatBit(LogSinkFormat format)
+{
+    return static_cast<LogSinkFormatMask>(1u << static_cast<unsigned>(format));
+}
+
+// 싱크가 로그를 쓰는 스레드
+enum class LogSinkThreading : uint8_t {
+    THREAD_INLINE,      // 로그를 나눠주는 스레드(writer / collector. 동기 모드는 호출한 스레드)에서 바로 쓴다. 메모리 링처럼 가벼운 싱크용
+    THREAD_DEDICATED,   // 싱크 전용 스레드 하나
+    THREAD_POOL,        // 다른 싱크와 나눠 쓰는 스레드 풀 (SYSLOG_SINK_POOL). 놀고 있는 스레드가 다른 스레드의 차례를 가져간다.
+};
+
+// 싱크가 받을 로그. type 규칙은 이름 그대로이거나, 끝이 '*'라면 앞부분이 같은 type ("Battle*")
+struct LogSinkFilter {
+    LogLevelMask levels = LOG_LEVELS_ALL;
+    std::vector<std::wstring> types;        // 비어있으면 모든 type
+};
+
+// 여러 싱크가 나눠 갖는 로그 한 건. 만든 뒤에는 바뀌지 않으므로 lock 없이 여러 스레드에서 읽는다.
+struct LogSinkRecord {
+    LogTypeId typeId = INVALID_LOG_TYPE_ID;
+    LogLevel level = LogLevel::LEVEL_DEBUG;
+    LogTimestamp timestamp = 0;
+    int64_t index = 0;                      // 0이면 인덱스 없음 (LogHex)
+    bool hexDump = false;                   // LogHex (FORMAT_MESSAGE의 첫 줄이 설명)
+    std::wstring_view typeName;             // LogTypeSink의 이름 (프로그램이 끝날 때까지 유효)
+    std::string_view utf8TypeName;
+
+    LogUtf8String text[LOG_SINK_FORMAT_COUNT];  // 이 로그를 받는 싱크들이 쓰는 형식만 채워진다.
+
+    std::string_view Text(LogSinkFormat format) const { return text[static_cast<size_t>(format)]; }
+};
+
+using LogSinkRecordPtr = std::shared_ptr<const LogSinkRecord>;
+
+class LogSinkPool;
+
+// 출력 대상 하나. Write / EndBatch는 한 싱크에 대해 동시에 불리지 않으며(THREAD_INLINE이면 싱크의 lock 안에서),
+// 싱크는 LogSinkRegistry에 등록된 뒤 자신의 차례가 오면 그동안 쌓인 로그를 한꺼번에 받는다. 싱크 안에서는 로그를 남기지 않는다.
+// 쓰는 쪽이 따라가지 못해 queueLimit만큼 쌓이면 새 로그는 버린다. (writer 스레드가 느린 싱크 때문에 멈추지 않도록)
+class LogSink {
+public:
+    static constexpr size_t DEFAULT_QUEUE_LIMIT = 64 * 1024;
+    static constexpr size_t INITIAL_QUEUE_CAPACITY = 4096;      // 등록할 때 쌓일 로그 목록을 이만큼 잡아둔다. (밀릴 때마다 목록이 자라지 않도록)
+
+    LogSink(std::wstring name, LogSinkFormat format, const LogSinkFilter& filter = LogSinkFilter())
+        : name(std::move(name)), format(format)
+    {
+        SetFilter(filter);
+    }
+
+    virtual ~LogSink(void) = default;
+
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    const std::wstring& Name(void) const { return name; }
+    LogSinkFormat Format(void) const { return format; }
+
+    // 실행 중에 바꿔도 된다. 이미 쌓여있는 로그에는 적용되지 않는다.
+    void SetFilter(const LogSinkFilter& newFilter)
+    {
+        std::lock_guard<std::mutex> guard(filterLock);
+        filter = newFilter;
+        levels.store(newFilter.levels, std::memory_order_relaxed);
+        allTypes.store(newFilter.types.empty(), std::memory_order_relaxed);
+        for (auto& decision : typeDecisions)
+            decision.store(TYPE_UNKNOWN, std::memory_order_relaxed);
+    }
+
+    LogSinkFilter GetFilter(void) const
+    {
+        std::lock_guard<std::mutex> guard(filterLock);
+        return filter;
+    }
+
+    // 쌓아둘 최대 로그 수. 등록하기 전, 초기화 시점에 호출한다.
+    void SetQueueLimit(size_t limit) { queueLimit = limit; }
+
+    bool Accepts(const LogTypeSink& type, LogLevel level)
+    {
+        if ((levels.load(std::memory_order_relaxed) & LogLevelBit(level)) == 0) {
+            return false;
+        }
+        if (allTypes.load(std::memory_order_relaxed) || type.id >= LogTypeRegistry::MAX_TYPES) {
+            return allTypes.load(std::memory_order_relaxed);
+        }
+
+        // type 규칙은 처음 본 type에서 한 번만 비교한다.
+        const uint8_t decision = typeDecisions[type.id].load(std::memory_order_relaxed);
+        if (decision != TYPE_UNKNOWN) {
+            return decision == TYPE_ACCEPTED;
+        }
+
+        std::lock_guard<std::mutex> guard(filterLock);
+        const bool accepted = MatchesType(type.name);
+        typeDecisions[type.id].store(accepted ? TYPE_ACCEPTED : TYPE_REJECTED, std::memory_order_relaxed);
+        return accepted;
+    }
+
+    LogSinkStats GetStats(void) const
+    {
+        LogSinkStats stats;
+        stats.name = name;
+        stats.written = written.load(std::memory_order_relaxed);
+        stats.dropped = dropped.load(std::memory_order_relaxed);
+        stats.failed = failed.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            stats.pending = pending.size();
+        }
+        return stats;
+    }
+
+protected:
+    // 로그 한 건을 쓴다. 다른 싱크와 나눠 가진 로그이므로 보관하려면 record를 복사해서 들고 있으면 된다. (참조 수만 늘어남)
+    virtual void Write(const LogSinkRecordPtr& record) = 0;
+
+    // 한 차례에 받은 로그를 다 Write한 뒤. 모아둔 출력을 내보낸다.
+    virtual void EndBatch(void) {}
+
+    // maintenance 스레드에서 주기적으로 (시간 기준 플러시 등). Write와 동시에 불릴 수 있다.
+    virtual void Maintain(void) {}
+
+    // 등록이 풀리거나 로거가 끝날 때 남은 로그를 다 쓴 뒤 한 번
+    virtual void Close(void) {}
+
+    // 쓰지 못한 로그 (보내기 실패 등). 통계에만 남는다.
+    void CountFailure(uint64_t count = 1) { failed.fetch_add(count, std::memory_order_relaxed); }
+
+private:
+    friend class LogSinkPool;
+    friend class LogSinkRegistry;
+
+    enum : uint8_t { TYPE_UNKNOWN, TYPE_ACCEPTED, TYPE_REJECTED };
+
+    bool MatchesType(std::wstring_view typeName) const
+    {
+        for (const std::wstring& rule : filter.types) {
+            if (!rule.empty() && rule.back() == L'*') {
+                if (typeName.substr(0, rule.size() - 1) == std::wstring_view(rule).substr(0, rule.size() - 1)) {
+                    return true;
+                }
+            }
+            else if (typeName == rule) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 등록할 때 LogSinkRegistry가 부른다. THREAD_DEDICATED라면 자신만의 스레드 하나짜리 풀을 만든다.
+    void Attach(LogSinkThreading newThreading, LogSinkPool* sharedPool);
+
+    // 등록을 풀 때. 쌓인 로그를 다 쓴 뒤 Close한다.
+    void Detach(void);
+
+    // 로그를 나눠주는 스레드에서
+    void Post(const LogSinkRecordPtr& record)
+    {
+        if (threading == LogSinkThreading::THREAD_INLINE) {
+            std::lock_guard<std::mutex> guard(inlineLock);
+            if (!closed) {
+                Write(record);
+                EndBatch();
+                written.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            if (closed || pending.size() >= queueLimit) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            pending.push_back(record);
+            if (!scheduled) {
+                scheduled = true;
+                schedule = true;
+            }
+        }
+
+        if (schedule) {
+            Schedule();
+        }
+    }
+
+    void Schedule(void);
+
+    // 풀의 스레드에서. 그동안 쌓인 로그를 모두 쓰고, 그 사이에 또 쌓였다면 다시 차례를 잡는다.
+    void RunBatch(void)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            batch.swap(pending);
+        }
+
+        for (const LogSinkRecordPtr& record : batch) {
+            Write(record);
+        }
+        EndBatch();
+        written.fetch_add(batch.size(), std::memory_order_relaxed);
+        batch.clear();
+
+        bool again = false;
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            again = !pending.empty();
+            scheduled = again;
+        }
+
+        if (again) {
+            Schedule();
+        }
+        else {
+            idle.notify_all();
+        }
+    }
+
+    const std::wstring name;
+    const LogSinkFormat format;
+
+    mutable std::mutex filterLock;
+    LogSinkFilter filter;                                   // filterLock으로 보호
+    std::atomic<LogLevelMask> levels{ LOG_LEVELS_ALL };
+    std::atomic<bool> allTypes{ true };
+    std::atomic<uint8_t> typeDecisions[LogTypeRegistry::MAX_TYPES] = {};    // type id 별로 규칙을 비교한 결과
+
+    LogSinkThreading threading = LogSinkThreading::THREAD_POOL;
+    LogSinkPool* pool = nullptr;                            // 차례를 넘길 풀 (공유 풀 또는 ownPool)
+    std::unique_ptr<LogSinkPool> ownPool;                   // THREAD_DEDICATED
+    size_t queueLimit = DEFAULT_QUEUE_LIMIT;
+
+    mutable std::mutex queueLock;
+    std::condition_variable idle;                           // 차례가 끝나고 쌓인 로그가 없을 때 (Detach)
+    std::vector<LogSinkRecordPtr> pending;                  // queueLock으로 보호
+    bool scheduled = false;                                 // queueLock으로 보호. 풀에 차례가 잡혀있거나 쓰는 중
+    bool closed = false;                                    // queueLock(THREAD_INLINE은 inlineLock)으로 보호
+    std::vector<LogSinkRecordPtr> batch;                    // 차례를 잡은 스레드 전용
+
+    std::mutex inlineLock;                                  // THREAD_INLINE의 Write를 직렬화
+
+    std::atomic<uint64_t> written{ 0 };
+    std::atomic<uint64_t> dropped{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+};
+
+// 싱크들의 차례를 돌리는 스레드 풀. 스레드마다 자신의 대기열을 가지며, 자기 것이 비면 다른 스레드의 대기열 뒤에서 가져온다.
+// 한 싱크는 한 번에 한 스레드에서만 돌기 때문에(LogSink::scheduled) 싱크 안의 순서는 지켜진다.
+class LogSinkPool {
+public:
+    LogSinkPool(void) = default;
+    ~LogSinkPool(void) { Stop(); }
+
+    LogSinkPool(const LogSinkPool&) = delete;
+    LogSinkPool& operator=(const LogSinkPool&) = delete;
+
+    void Start(size_t threadCount)
+    {
+        Stop();
+
+        threadCount = threadCount == 0 ? 1 : threadCount;
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            running = true;
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers[i]->thread = std::thread(&LogSinkPool::WorkerProc, this, i);
+        }
+    }
+
+    // 잡혀있는 차례를 모두 돌린 뒤 멈춘다.
+    void Stop(void)
+    {
+        {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            if (!running) {
+                return;
+            }
+            running = false;
+        }
+        wakeup.notify_all();
+
+        for (auto& worker : workers) {
+            worker->thread.join();
+        }
+        workers.clear();
+    }
+
+    bool IsRunning(void)
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        return running;
+    }
+
+    size_t ThreadCount(void) const { return workers.size(); }
+
+    // 다른 스레드의 대기열에서 가져온 차례 수
+    uint64_t GetSteals(void) const { return steals.load(std::memory_order_relaxed); }
+
+    // 풀의 스레드가 부르면(다시 차례를 잡는 싱크) 자신의 대기열에, 아니면 돌아가며 넣는다.
+    void Schedule(LogSink* sink)
+    {
+        size_t target = 0;
+        if (currentPool == this) {
+            target = currentWorker;
+        }
+        else {
+            target = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        }
+
+        // 먼저 세어둔다. (가져간 스레드가 빼는 것보다 늦지 않도록)
+        queued.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> guard(workers[target]->lock);
+            workers[target]->tasks.push_back(sink);
+        }
+
+        if (sleepers.load() > 0) {
+            std::lock_guard<std::mutex> guard(sleepLock);
+            wakeup.notify_one();
+        }
+    }
+
+private:
+    static constexpr std::chrono::milliseconds IDLE_WAIT{ 100 };
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<LogSink*, LogPoolAllocator<LogSink*>> tasks;     // 블록을 풀에서 받는다. (차례마다 넣고 빼면서 블록이 바뀜)
+        std::thread thread;
+    };
+
+    bool TryTake(size_t self, LogSink*& sink)
+    {
+        {
+            Worker& own = *workers[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                sink = own.tasks.front();
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < workers.size(); ++offset) {
+            Worker& victim = *workers[(self + offset) % workers.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                sink = victim.tasks.back();
+                victim.tasks.pop_back();
+                steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkerProc(size_t self)
+    {
+        currentPool = this;
+        currentWorker = self;
+
+        for (;;) {
+            LogSink* sink = nullptr;
+            if (TryTake(self, sink)) {
+                queued.fetch_sub(1);
+                sink->RunBatch();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepLock);
+            if (queued.load() != 0) {
+                continue;
+            }
+            if (!running) {
+                break;
+            }
+
+            sleepers.fetch_add(1);
+            wakeup.wait_for(lock, IDLE_WAIT, [&] { return !running || queued.load() != 0; });
+            sleepers.fetch_sub(1);
+        }
+
+        currentPool = nullptr;
+    }
+
+    static inline thread_local LogSinkPool* currentPool = nullptr;
+    static inline thread_local size_t currentWorker = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> nextWorker{ 0 };
+    std::atomic<size_t> queued{ 0 };        // 모든 대기열에 잡혀있는 차례 수
+    std::atomic<int> sleepers{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+
+    std::mutex sleepLock;
+    std::condition_variable wakeup;
+    bool running = false;                   // sleepLock으로 보호
+};
+
+inline void LogSink::Attach(LogSinkThreading newThreading, LogSinkPool* sharedPool)
+{
+    threading = newThreading;
+    if (threading == LogSinkThreading::THREAD_DEDICATED) {
+        ownPool = std::make_unique<LogSinkPool>();
+        ownPool->Start(1);
+        pool = ownPool.get();
+    }
+    else {
+        pool = sharedPool;
+    }
+
+    if (threading != LogSinkThreading::THREAD_INLINE) {
+        std::lock_guard<std::mutex> guard(queueLock);
+        pending.reserve(std::min(queueLimit, INITIAL_QUEUE_CAPACITY));
+        batch.reserve(std::min(queueLimit, INITIAL_QUEUE_CAPACITY));
+    }
+}
+
+inline void LogSink::Detach(void)
+{
+    if (threading == LogSinkThreading::THREAD_INLINE) {
+        std::lock_guard<std::mutex> guard(inlineLock);
+        closed = true;
+    }
+    else {
+        std::unique_lock<std::mutex> guard(queueLock);
+        closed = true;
+        idle.wait(guard, [this] { return !scheduled; });
+    }
+
+    if (ownPool) {
+        ownPool->Stop();
+    }
+    Close();
+}
+
+inline void LogSink::Schedule(void)
+{
+    pool->Schedule(this);
+}
+
+// 등록된 싱크 목록. 로그를 나눠주는 쪽(Publish)은 여러 스레드에서 동시에 불려도 되고, 등록 / 해제는 드물다고 본다.
+class LogSinkRegistry {
+public:
+    static constexpr size_t DEFAULT_POOL_THREADS = 2;
+
+    LogSinkRegistry(void) = default;
+    ~LogSinkRegistry(void) { Shutdown(); }
+
+    LogSinkRegistry(const LogSinkRegistry&) = delete;
+    LogSinkRegistry& operator=(const LogSinkRegistry&) = delete;
+
+    // THREAD_POOL 싱크들이 나눠 쓸 스레드 수. 이미 돌고 있다면 지금 차례를 마친 뒤 새 수로 다시 시작한다.
+    void SetPoolThreads(size_t threads)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        poolThreads = threads == 0 ? 1 : threads;
+        if (sharedPool.IsRunning()) {
+            sharedPool.Start(poolThreads);
+        }
+    }
+
+    // 같은 이름의 싱크가 이미 있으면 false
+    bool Add(std::shared_ptr<LogSink> sink, LogSinkThreading threading)
+    {
+        if (!sink) {
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> guard(lock);
+        for (const auto& registered : sinks) {
+            if (registered->Name() == sink->Name()) {
+                return false;
+            }
+        }
+
+        if (threading == LogSinkThreading::THREAD_POOL && !sharedPool.IsRunning()) {
+            sharedPool.Start(poolThreads);
+        }
+        sink->Attach(threading, &sharedPool);
+        sinks.push_back(std::move(sink));
+        count.store(sinks.size(), std::memory_order_release);
+        return true;
+    }
+
+    // 쌓여있던 로그를 다 쓰고 닫은 뒤 뺀다. 없으면 false
+    bool Remove(std::wstring_view name)
+    {
+        std::shared_ptr<LogSink> removed;
+        {
+            std::unique_lock<std::shared_mutex> guard(lock);
+            for (auto it = sinks.begin(); it != sinks.end(); ++it) {
+                if ((*it)->Name() == name) {
+                    removed = std::move(*it);
+                    sinks.erase(it);
+                    break;
+                }
+            }
+            count.store(sinks.size(), std::memory_order_release);
+        }
+
+        if (!removed) {
+            return false;
+        }
+        removed->Detach();
+        return true;
+    }
+
+    std::shared_ptr<LogSink> Find(std::wstring_view name) const
+    {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        for (const auto& sink : sinks) {
+            if (sink->Name() == name) {
+                return sink;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Empty(void) const { return count.load(std::memory_order_relaxed) == 0; }
+
+    // 로그 한 건을 받을 싱크들에 나눠준다. render(record, formats)는 formats에 든 형식만 record.text에 채우며,
+    // 받을 싱크가 없으면 불리지 않는다.
+    template <typename Render>
+    void Publish(const LogTypeSink& type, LogLevel level, Render&& render)
+    {
+        static thread_local std::vector<LogSink*> targets;
+
+        std::shared_lock<std::shared_mutex> guard(lock);
+        targets.clear();
+        LogSinkFormatMask formats = 0;
+        for (const auto& sink : sinks) {
+            if (sink->Accepts(type, level)) {
+                targets.push_back(sink.get());
+                formats |= LogSinkFormatBit(sink->Format());
+            }
+        }
+        if (targets.empty()) {
+            return;
+        }
+
+        // 기록과 shared_ptr의 control block도 텍스트와 같이 풀에서 받는다. (데워진 뒤에는 힙 할당이 없도록)
+        auto record = std::allocate_shared<LogSinkRecord>(LogPoolAllocator<LogSinkRecord>());
+        record->typeId = type.id;
+        record->level = level;
+        record->typeName = type.name;
+        record->utf8TypeName = type.utf8Name;
+        render(*record, formats);
+
+        const LogSinkRecordPtr shared = std::move(record);
+        for (LogSink* sink : targets) {
+            sink->Post(shared);
+        }
+    }
+
+    // maintenance 스레드에서
+    void Maintain(void)
+    {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        for (const auto& sink : sinks) {
+            sink->Maintain();
+        }
+    }
+
+    void GetStats(std::vector<LogSinkStats>& stats) const
+    {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        for (const auto& sink : sinks) {
+            stats.push_back(sink->GetStats());
+        }
+    }
+
+    // 모든 싱크의 남은 로그를 쓰고 닫는다. 더 이상 Publish가 불리지 않을 때(로거가 끝날 때) 호출한다.
+    void Shutdown(void)
+    {
+        std::vector<std::shared_ptr<LogSink>> removed;
+        {
+            std::unique_lock<std::shared_mutex> guard(lock);
+            removed.swap(sinks);
+            count.store(0, std::memory_order_release);
+        }
+
+        for (const auto& sink : removed) {
+            sink->Detach();
+        }
+        sharedPool.Stop();
+    }
+
+private:
+    mutable std::shared_mutex lock;
+    std::vector<std::shared_ptr<LogSink>> sinks;    // lock으로 보호
+    std::atomic<size_t> count{ 0 };
+    LogSinkPool sharedPool;
+    size_t poolThreads = DEFAULT_POOL_THREADS;      // lock으로 보호
+};
@@ -0,0 +1,477 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LogBinary.h"
+#include "LogFile.h"
+#include "LogLine.h"
+#include "LogMappedFile.h"
+#include "LogPlatform.h"
+#include "LogRotation.h"
+#include "LogSink.h"
+#include "LogTime.h"
+
+// SystemLogManager::AddSink로 등록하는 출력 대상들 (LogSink.h)
+//   LogFileSink / LogRotatingFileSink / LogMappedFileSink : 모든(걸러진) type을 한 텍스트 파일에
+//   LogBinaryFileSink : type 별 바이너리 파일 (LogDecoder로 복원)
+//   LogStdoutSink     : 표준 출력 / 표준 에러
+//   LogSyslogSink     : 127.0.0.1의 syslog(UDP, RFC 5424)로
+//   LogMemorySink     : 마지막 N건을 메모리에 (테스트 / 진단 화면용)
+
+// 파일 싱크의 선택
+struct LogSinkFileOptions {
+    bool rotate = false;                            // 기간마다 파일 이름 앞에 기간을 붙이고(Logs/all.txt -> Logs/202610_all.txt), rotation의 한도마다 조각을 나눈다.
+    LogRotationPolicy rotation;                     // rotate일 때만 사용. archiver는 쓰지 않는다.
+    LogFlushPolicy flush;
+    LogLevel flushLevel = LogLevel::LEVEL_ERROR;    // 이 레벨 이상의 로그가 든 차례는 바로 파일에 기록
+};
+
+// 파일 싱크가 이번 로그를 쓸 파일 이름. rotate라면 파일 이름 앞에 기간을 붙인다. 싱크의 스레드 전용
+class LogSinkFileName {
+public:
+    LogSinkFileName(std::wstring fileName, bool rotate, LogRotationPeriod period)
+        : fileName(std::move(fileName)), rotate(rotate), period(period)
+    {
+        const size_t slash = this->fileName.find_last_of(L"/\\");
+        directory = slash == std::wstring::npos ? std::wstring() : this->fileName.substr(0, slash + 1);
+        leaf = slash == std::wstring::npos ? this->fileName : this->fileName.substr(slash + 1);
+    }
+
+    const std::wstring& For(LogTimestamp timestamp)
+    {
+        if (!rotate) {
+            return fileName;
+        }
+
+        timestampCache.Format(LogTimestampSeconds(timestamp));
+        int64_t periodKey = timestampCache.MonthKey();
+        const wchar_t* periodText = timestampCache.Month();
+        if (period == LogRotationPeriod::ROTATE_DAY) {
+            periodKey = timestampCache.DayKey();
+            periodText = timestampCache.Day();
+        }
+        else if (period == LogRotationPeriod::ROTATE_HOUR) {
+            periodKey = timestampCache.HourKey();
+            periodText = timestampCache.Hour();
+        }
+
+        if (periodKey != cachedPeriodKey) {
+            cachedPeriodKey = periodKey;
+            periodFileName = directory + periodText + L"_" + leaf;
+        }
+        return periodFileName;
+    }
+
+private:
+    const std::wstring fileName;
+    const bool rotate;
+    const LogRotationPeriod period;
+    std::wstring directory;
+    std::wstring leaf;
+
+    LogTimestampCache timestampCache;
+    int64_t cachedPeriodKey = -1;
+    std::wstring periodFileName;
+};
+
+// 받은 로그를 한 텍스트 파일에 쓴다. 한 차례의 로그는 모아서 파일에 한 번 넘긴다. (SystemLogManager의 비동기 모드와 같음)
+// File은 LogFile(버퍼에 모았다가 기록) 또는 LogMappedFile(매핑된 파일에 바로 복사)
+template <typename File>
+class LogTextFileSink : public LogSink {
+public:
+    LogTextFileSink(std::wstring name, std::wstring fileName, const LogSinkFilter& filter = LogSinkFilter(),
+        const LogSinkFileOptions& options = LogSinkFileOptions())
+        : LogSink(std::move(name), LogSinkFormat::FORMAT_LINE, filter), options(options),
+        fileName(std::move(fileName), options.rotate, options.rotation.period)
+    {
+        if (!options.rotate) {
+            this->options.rotation = LogRotationPolicy();
+        }
+        this->options.rotation.archiver = nullptr;
+        pending.reserve(MAX_PENDING_BYTES);
+    }
+
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        const std::string_view text = record->Text(LogSinkFormat::FORMAT_LINE);
+        const std::wstring& target = fileName.For(record->timestamp);
+        if (!pending.empty() && (target != pendingFile || pending.size() + text.size() > MAX_PENDING_BYTES)) {
+            WritePending();
+        }
+        if (pending.empty()) {
+            pendingFile = target;
+        }
+
+        pending += text;
+        pendingRecords++;
+        flushNow |= record->level >= options.flushLevel;
+    }
+
+    void EndBatch(void) override
+    {
+        WritePending();
+    }
+
+    void Maintain(void) override
+    {
+        file.Maintain(File::Clock::now(), options.flush, std::chrono::milliseconds(0));
+    }
+
+    void Close(void) override
+    {
+        file.Close();
+    }
+
+private:
+    // 한 차례에 모으는 최대 크기. 쌓인 로그가 많아도 버퍼가 이 이상 커지지 않도록 중간에 쓴다.
+    static constexpr size_t MAX_PENDING_BYTES = 256 * 1024;
+
+    void WritePending(void)
+    {
+        if (pending.empty()) {
+            return;
+        }
+
+        file.Write(pendingFile, pending.data(), pending.size(), pendingRecords, flushNow, options.flush, options.rotation);
+        pending.clear();
+        pendingRecords = 0;
+        flushNow = false;
+    }
+
+    LogSinkFileOptions options;
+    LogSinkFileName fileName;
+    File file;
+
+    std::string pending;            // 이번 차례에 모은 줄
+    std::wstring pendingFile;
+    size_t pendingRecords = 0;
+    bool flushNow = false;
+};
+
+using LogFileSink = LogTextFileSink<LogFile>;
+using LogMappedFileSink = LogTextFileSink<LogMappedFile>;
+
+// 기간 / 크기 / 기록 수로 나누는 LogFileSink
+class LogRotatingFileSink : public LogFileSink {
+public:
+    LogRotatingFileSink(std::wstring name, std::wstring fileName, const LogRotationPolicy& rotation, const LogSinkFilter& filter = LogSinkFilter())
+        : LogFileSink(std::move(name), std::move(fileName), filter, RotatingOptions(rotation)) {}
+
+private:
+    static LogSinkFileOptions RotatingOptions(const LogRotationPolicy& rotation)
+    {
+        LogSinkFileOptions options;
+        options.rotate = true;
+        options.rotation = rotation;
+        return options;
+    }
+};
+
+// type 별 바이너리 파일. directory/type.bin (rotate라면 directory/YYYYMM_type.bin). 형식은 SYSLOG_FILE_FORMAT의 바이너리와 같아서 LogDecoder로 읽는다.
+// 메시지는 포맷된 UTF-8로 남는다. (포맷 id와 인자가 아님) 다른 싱크나 type 별 파일과 같은 폴더를 쓰지 않는다.
+class LogBinaryFileSink : public LogSink {
+public:
+    LogBinaryFileSink(std::wstring name, std::wstring directory, const LogSinkFilter& filter = LogSinkFilter(),
+        const LogSinkFileOptions& options = LogSinkFileOptions(), bool micros = false)
+        : LogSink(std::move(name), LogSinkFormat::FORMAT_MESSAGE, filter), directory(std::move(directory)), options(options), micros(micros)
+    {
+        if (!options.rotate) {
+            this->options.rotation = LogRotationPolicy();
+        }
+        this->options.rotation.archiver = nullptr;
+    }
+
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        TypeFile& type = GetTypeFile(*record);
+
+        LogBinaryEntry entry;
+        entry.level = static_cast<uint8_t>(record->level);
+        entry.index = record->index;
+        entry.timestamp = record->timestamp;
+
+        std::string_view message = record->Text(LogSinkFormat::FORMAT_MESSAGE);
+        if (record->hexDump) {
+            // 설명 줄에 머리말을 붙여서 완성된 줄로 남긴다.
+            const size_t newline = message.find('\n');
+            line.clear();
+            AppendLogHexHeader(line, record->utf8TypeName, record->timestamp, record->level, micros, message.substr(0, newline), timestampCache);
+            if (newline != std::string_view::npos) {
+                line += message.substr(newline + 1);
+                line += '\n';
+            }
+            entry.text = line;
+            entry.completeLine = true;
+        }
+        else {
+            entry.text = message;
+        }
+
+        type.file->Write(type.fileName.For(record->timestamp), record->typeName, micros, entry, record->level >= options.flushLevel,
+            options.flush, options.rotation);
+    }
+
+    void Maintain(void) override
+    {
+        std::lock_guard<std::mutex> guard(filesLock);
+        for (const auto& type : files) {
+            if (type) {
+                type->file->Maintain(LogBinaryFile::Clock::now(), options.flush, std::chrono::milliseconds(0));
+            }
+        }
+    }
+
+    void Close(void) override
+    {
+        std::lock_guard<std::mutex> guard(filesLock);
+        for (const auto& type : files) {
+            if (type) {
+                type->file->Close();
+            }
+        }
+    }
+
+private:
+    struct TypeFile {
+        TypeFile(std::wstring fileName, const LogSinkFileOptions& options)
+            : fileName(std::move(fileName), options.rotate, options.rotation.period), file(std::make_unique<LogBinaryFile>()) {}
+
+        LogSinkFileName fileName;
+        std::unique_ptr<LogBinaryFile> file;
+    };
+
+    // 목록을 바꾸는 것은 Write(싱크의 스레드)뿐이므로 읽을 때는 lock을 잡지 않는다.
+    TypeFile& GetTypeFile(const LogSinkRecord& record)
+    {
+        if (record.typeId >= files.size() || !files[record.typeId]) {
+            std::lock_guard<std::mutex> guard(filesLock);
+            if (record.typeId >= files.size()) {
+                files.resize(record.typeId + 1);
+            }
+            files[record.typeId] = std::make_unique<TypeFile>(directory + L"/" + std::wstring(record.typeName) + L".bin", options);
+        }
+        return *files[record.typeId];
+    }
+
+    const std::wstring directory;
+    LogSinkFileOptions options;
+    const bool micros;
+
+    std::mutex filesLock;                               // files의 크기 / 항목을 바꿀 때 (Maintain / Close와)
+    std::vector<std::unique_ptr<TypeFile>> files;       // type id 별
+    std::string line;
+    LogTimestampCache timestampCache;
+};
+
+// 표준 출력(또는 표준 에러)에 파일과 같은 줄을 출력한다. SYSLOG_CONSOLE과 달리 반복 줄이기 / 1초당 한도가 없고,
+// 따라가지 못하면 LogSink의 queueLimit에서 버린다.
+class LogStdoutSink : public LogSink {
+public:
+    explicit LogStdoutSink(std::wstring name, const LogSinkFilter& filter = LogSinkFilter(), bool useStderr = false)
+        : LogSink(std::move(name), LogSinkFormat::FORMAT_LINE, filter), stream(useStderr ? stderr : stdout)
+    {
+        LogPlatform::SetBinaryMode(stream);
+        output.reserve(MAX_OUTPUT_BYTES);
+    }
+
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        const std::string_view text = record->Text(LogSinkFormat::FORMAT_LINE);
+        if (!output.empty() && output.size() + text.size() > MAX_OUTPUT_BYTES) {
+            EndBatch();
+        }
+        output += text;
+    }
+
+    void EndBatch(void) override
+    {
+        if (output.empty()) {
+            return;
+        }
+
+        std::fwrite(output.data(), 1, output.size(), stream);
+        std::fflush(stream);
+        output.clear();
+    }
+
+private:
+    static constexpr size_t MAX_OUTPUT_BYTES = 64 * 1024;    // 한 번에 출력하는 최대 크기 (LogTextFileSink::MAX_PENDING_BYTES와 같은 이유)
+
+    std::FILE* const stream;
+    std::string output;
+};
+
+// 같은 머신의 syslog 데몬(127.0.0.1:port, UDP)으로 로그 한 건을 datagram 하나로 보낸다. (RFC 5424)
+//   <PRI>1 2026-10-17T05:27:39.123456Z - appName - type - 메시지
+// PRI는 facility * 8 + 심각도 (DEBUG = 7 debug, ERROR = 3 err, SYSTEM = 5 notice). 기본 facility는 16 (local0)
+// MAX_DATAGRAM을 넘는 메시지는 잘린다. 받는 쪽이 없어도 UDP이므로 알 수 없다.
+class LogSyslogSink : public LogSink {
+public:
+    static constexpr uint16_t DEFAULT_PORT = 514;
+    static constexpr size_t MAX_DATAGRAM = 60 * 1024;
+
+    LogSyslogSink(std::wstring name, uint16_t port = DEFAULT_PORT, std::string appName = "LogManager",
+        const LogSinkFilter& filter = LogSinkFilter(), uint8_t facility = 16)
+        : LogSink(std::move(name), LogSinkFormat::FORMAT_MESSAGE, filter), port(port), appName(std::move(appName)), facility(facility),
+        socket(LogPlatform::OpenUdpSender()) {}
+
+    ~LogSyslogSink(void) override { CloseSocket(); }
+
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        if (socket == LogPlatform::INVALID_SOCKET_HANDLE) {
+            CountFailure();
+            return;
+        }
+
+        datagram.clear();
+        datagram += '<';
+        AppendDigits(datagram, static_cast<uint64_t>(facility) * 8 + Severity(record->level));
+        datagram += ">1 ";
+        AppendUtcTimestamp(record->timestamp);
+        datagram += " - ";
+        datagram += appName;
+        datagram += " - ";
+        datagram += record->utf8TypeName.empty() ? std::string_view("-") : record->utf8TypeName;
+        datagram += " - ";
+
+        const std::string_view message = record->Text(LogSinkFormat::FORMAT_MESSAGE);
+        const size_t room = MAX_DATAGRAM > datagram.size() ? MAX_DATAGRAM - datagram.size() : 0;
+        datagram += message.substr(0, room);
+
+        if (!LogPlatform::SendLoopbackDatagram(socket, port, datagram.data(), datagram.size())) {
+            CountFailure();
+        }
+    }
+
+    void Close(void) override
+    {
+        CloseSocket();
+    }
+
+private:
+    static uint32_t Severity(LogLevel level)
+    {
+        switch (level) {
+        case LogLevel::LEVEL_DEBUG: return 7;
+        case LogLevel::LEVEL_ERROR: return 3;
+        case LogLevel::LEVEL_SYSTEM: return 5;
+        default: return 6;
+        }
+    }
+
+    // "YYYY-MM-DDTHH:MM:SS.uuuuuuZ". 초가 같다면 µs만 다시 쓴다.
+    void AppendUtcTimestamp(LogTimestamp timestamp)
+    {
+        const std::time_t seconds = LogTimestampSeconds(timestamp);
+        if (seconds != cachedSeconds) {
+            cachedSeconds = seconds;
+            std::tm utc = {};
+            LogPlatform::UtcTime(seconds, utc);
+            WriteFixedDigits(timeText, static_cast<uint64_t>(utc.tm_year + 1900), 4);
+            timeText[4] = '-';
+            WriteFixedDigits(timeText + 5, static_cast<uint64_t>(utc.tm_mon + 1), 2);
+            timeText[7] = '-';
+            WriteFixedDigits(timeText + 8, static_cast<uint64_t>(utc.tm_mday), 2);
+            timeText[10] = 'T';
+            WriteFixedDigits(timeText + 11, static_cast<uint64_t>(utc.tm_hour), 2);
+            timeText[13] = ':';
+            WriteFixedDigits(timeText + 14, static_cast<uint64_t>(utc.tm_min), 2);
+            timeText[16] = ':';
+            WriteFixedDigits(timeText + 17, static_cast<uint64_t>(utc.tm_sec), 2);
+            timeText[19] = '.';
+            timeText[26] = 'Z';
+        }
+        WriteFixedDigits(timeText + 20, LogTimestampMicros(timestamp), 6);
+        datagram.append(timeText, sizeof(timeText));
+    }
+
+    void CloseSocket(void)
+    {
+        if (socket != LogPlatform::INVALID_SOCKET_HANDLE) {
+            LogPlatform::CloseSocket(socket);
+            socket = LogPlatform::INVALID_SOCKET_HANDLE;
+        }
+    }
+
+    const uint16_t port;
+    const std::string appName;
+    const uint8_t facility;
+    LogPlatform::SocketHandle socket;
+
+    std::string datagram;
+    std::time_t cachedSeconds = -1;
+    char timeText[27] = {};
+};
+
+// 마지막 capacity건의 로그를 메모리에 들고 있는다. 로그는 복사하지 않고 다른 싱크와 나눠 가진 것을 그대로 보관한다.
+// 테스트에서 남은 로그를 확인하거나 진단 화면에 최근 로그를 보여줄 때 쓴다. THREAD_INLINE으로 등록하면 Log가 반환된 뒤(동기 모드) 바로 보인다.
+class LogMemorySink : public LogSink {
+public:
+    LogMemorySink(std::wstring name, size_t capacity, const LogSinkFilter& filter = LogSinkFilter(), LogSinkFormat format = LogSinkFormat::FORMAT_LINE)
+        : LogSink(std::move(name), format, filter), capacity(capacity == 0 ? 1 : capacity) {}
+
+    // 들고 있는 로그의 텍스트 (오래된 것부터)
+    std::vector<std::string> Lines(void) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::string> lines;
+        lines.reserve(records.size());
+        for (const LogSinkRecordPtr& record : records) {
+            lines.emplace_back(record->Text(Format()));
+        }
+        return lines;
+    }
+
+    // 들고 있는 로그 (오래된 것부터)
+    std::vector<LogSinkRecordPtr> Records(void) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return std::vector<LogSinkRecordPtr>(records.begin(), records.end());
+    }
+
+    // 지금까지 받은 로그 수 (밀려난 것 포함)
+    uint64_t Received(void) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return received;
+    }
+
+    void Clear(void)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        records.clear();
+    }
+
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (records.size() == capacity) {
+            records.pop_front();
+        }
+        records.push_back(record);
+        received++;
+    }
+
+private:
+    const size_t capacity;
+
+    mutable std::mutex lock;
+    std::deque<LogSinkRecordPtr> records;
+    uint64_t received = 0;
+};
@@ -0,0 +1,349 @@
+﻿#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "LogTime.h"
+#include "LogUtf8.h"
+
+// LOG 호출 위치 하나에 대한 기준. 기본값은 모두 꺼져있다.
+struct LogSitePolicy {
+    uint32_t sampleEvery = 1;                       // 스레드마다 N번에 한 번만 남긴다. 1이면 모두
+    uint32_t maxPerSecond = 0;                      // 호출 위치 전체에서 1초에 남길 수 있는 수. 0이면 제한 없음
+    std::chrono::milliseconds dedupWindow{ 0 };     // 이 시간 안에 같은 메시지가 이어지면 수만 세고 "last message repeated N times" 한 줄로 줄인다. 0이면 끔
+
+    static LogSitePolicy Sample(uint32_t every) { LogSitePolicy policy; policy.sampleEvery = every; return policy; }
+    static LogSitePolicy RateLimit(uint32_t perSecond) { LogSitePolicy policy; policy.maxPerSecond = perSecond; return policy; }
+    static LogSitePolicy Dedup(std::chrono::milliseconds window) { LogSitePolicy policy; policy.dedupWindow = window; return policy; }
+};
+
+struct LogSiteStats {
+    std::wstring label;             // "main.cpp:52"
+    LogSitePolicy policy;
+    uint64_t passed = 0;            // 샘플링과 1초당 한도를 통과한 로그 (기준이 켜진 동안)
+    uint64_t sampledOut = 0;        // sampleEvery로 거른 로그
+    uint64_t rateLimited = 0;       // maxPerSecond를 넘어 버린 로그
+    uint64_t deduplicated = 0;      // 앞의 메시지와 같아서 수만 센 로그
+};
+
+class LogSiteRegistry;
+
+// LOG 매크로가 호출 위치마다 static으로 하나씩 만드는 기술자. 호출 위치의 기준과 그 상태를 가진다.
+// 기준이 모두 꺼져있다면(대부분) Admit은 atomic load 하나로 끝난다.
+//   샘플링 : 스레드마다 따로 센다. (매크로가 만든 thread_local 카운터) 공유하는 값에 쓰지 않는다.
+//   1초당 한도 : 호출 위치 전체의 1초 창. 창이 바뀌는 순간에는 몇 개 더 들어갈 수 있다. (LogConsoleSink와 같음)
+//   반복 줄이기 : 메시지(포맷 문자열과 인자)의 해시를 바로 앞의 것과 비교한다. 메시지를 만든 뒤에 SystemLogManager가 확인한다.
+// 한 번 만들어진 기술자는 프로그램이 끝날 때까지 LogSiteRegistry의 목록에 남는다.
+// 정적 객체가 소멸된 뒤에도 maintenance 스레드가 목록을 훑을 수 있도록 소멸자가 하는 일이 없어야 한다. (trivially destructible)
+class LogSite {
+public:
+    static constexpr uint8_t FLAG_SAMPLE = 0x01;
+    static constexpr uint8_t FLAG_RATE = 0x02;
+    static constexpr uint8_t FLAG_DEDUP = 0x04;
+
+    inline LogSite(const char* file, int line, const LogSitePolicy& policy);
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    // 이 호출을 남길지. threadCalls : 호출 위치와 스레드마다 하나인 카운터
+    bool Admit(uint32_t& threadCalls)
+    {
+        const uint8_t active = flags.load(std::memory_order_relaxed);
+        return active == 0 || AdmitLimited(active, threadCalls);
+    }
+
+    bool Dedups(void) const { return (flags.load(std::memory_order_relaxed) & FLAG_DEDUP) != 0; }
+
+    // 반복 줄이기. 바로 앞의 메시지와 같고 창 안이라면 수만 세고 false.
+    // true라면 repeatsBefore에 앞의 메시지의 아직 알리지 않은 반복 수를 담는다. (이 메시지보다 먼저 알린다)
+    bool AdmitMessage(uint64_t hash, uint32_t typeId, int level, uint64_t& repeatsBefore)
+    {
+        const LogTimestamp now = LogClockNow();
+        const uint64_t window = static_cast<uint64_t>(dedupWindowNanos.load(std::memory_order_relaxed));
+
+        if (lastHash.exchange(hash, std::memory_order_relaxed) == hash && now - windowStart.load(std::memory_order_relaxed) < window) {
+            repeated.fetch_add(1, std::memory_order_relaxed);
+            deduplicated.fetch_add(1, std::memory_order_relaxed);
+            lastRepeat.store(now, std::memory_order_relaxed);
+            return false;
+        }
+
+        windowStart.store(now, std::memory_order_relaxed);
+        repeatTypeId.store(typeId, std::memory_order_relaxed);
+        repeatLevel.store(level, std::memory_order_relaxed);
+        repeatsBefore = repeated.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 마지막 반복에서 창만큼 지났다면 아직 알리지 않은 반복 수를 가져간다. (maintenance 스레드)
+    // 같은 메시지가 더 오지 않아도 반복 수가 남도록 한다.
+    uint64_t TakeExpiredRepeats(LogTimestamp now, uint32_t& typeId, int& level)
+    {
+        const uint64_t window = static_cast<uint64_t>(dedupWindowNanos.load(std::memory_order_relaxed));
+        if (repeated.load(std::memory_order_relaxed) == 0 || now - lastRepeat.load(std::memory_order_relaxed) < window) {
+            return 0;
+        }
+
+        typeId = repeatTypeId.load(std::memory_order_relaxed);
+        level = repeatLevel.load(std::memory_order_relaxed);
+        const uint64_t repeats = repeated.exchange(0, std::memory_order_relaxed);
+        // 다음에 오는 같은 메시지는 다시 남긴다.
+        lastHash.store(0, std::memory_order_relaxed);
+        return repeats;
+    }
+
+    // 실행 중에 기준을 바꾼다. (LogSiteRegistry::SetPolicy)
+    void SetPolicy(const LogSitePolicy& policy)
+    {
+        sampleEvery.store(policy.sampleEvery == 0 ? 1 : policy.sampleEvery, std::memory_order_relaxed);
+        maxPerSecond.store(policy.maxPerSecond, std::memory_order_relaxed);
+        dedupWindowNanos.store(std::chrono::duration_cast<std::chrono::nanoseconds>(policy.dedupWindow).count(), std::memory_order_relaxed);
+
+        uint8_t active = 0;
+        if (policy.sampleEvery > 1) active |= FLAG_SAMPLE;
+        if (policy.maxPerSecond > 0) active |= FLAG_RATE;
+        if (policy.dedupWindow.count() > 0) active |= FLAG_DEDUP;
+        flags.store(active, std::memory_order_relaxed);
+    }
+
+    LogSitePolicy GetPolicy(void) const
+    {
+        LogSitePolicy policy;
+        policy.sampleEvery = sampleEvery.load(std::memory_order_relaxed);
+        policy.maxPerSecond = maxPerSecond.load(std::memory_order_relaxed);
+        policy.dedupWindow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(dedupWindowNanos.load(std::memory_order_relaxed)));
+        return policy;
+    }
+
+    LogSiteStats GetStats(void) const
+    {
+        LogSiteStats stats;
+        AppendWide(stats.label, std::string_view(FileName()));
+        stats.label += L':';
+        stats.label += std::to_wstring(line);
+        stats.policy = GetPolicy();
+        stats.passed = passed.load(std::memory_order_relaxed);
+        stats.sampledOut = sampledOut.load(std::memory_order_relaxed);
+        stats.rateLimited = rateLimited.load(std::memory_order_relaxed);
+        stats.deduplicated = deduplicated.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    const char* File(void) const { return file; }
+    int Line(void) const { return line; }
+    // 경로를 뺀 파일 이름
+    const char* FileName(void) const { return file + fileNameOffset; }
+
+    // 지금 스레드에서 남기는 중인 로그의 호출 위치. 반복 줄이기가 켜진 호출 위치만 LogSiteScope가 정한다.
+    static LogSite* Current(void) { return current; }
+
+private:
+    friend class LogSiteRegistry;
+    friend class LogSiteScope;
+
+    bool AdmitLimited(uint8_t active, uint32_t& threadCalls)
+    {
+        if (active & FLAG_SAMPLE) {
+            const uint32_t every = sampleEvery.load(std::memory_order_relaxed);
+            if (++threadCalls < every) {
+                return false;
+            }
+            // 이번에 남기는 로그 앞에서 거른 수를 한 번에 더한다.
+            sampledOut.fetch_add(threadCalls - 1, std::memory_order_relaxed);
+            threadCalls = 0;
+        }
+
+        if (active & FLAG_RATE) {
+            const uint64_t second = LogClockNow() / 1000000000ull;
+            if (windowSecond.load(std::memory_order_relaxed) != second) {
+                windowSecond.store(second, std::memory_order_relaxed);
+                windowCount.store(0, std::memory_order_relaxed);
+            }
+            if (windowCount.fetch_add(1, std::memory_order_relaxed) >= maxPerSecond.load(std::memory_order_relaxed)) {
+                rateLimited.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        passed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const char* const file;
+    const int line;
+    uint32_t fileNameOffset = 0;        // file에서 경로를 뺀 이름이 시작하는 위치
+    LogSite* next = nullptr;            // LogSiteRegistry의 목록
+
+    std::atomic<uint8_t> flags{ 0 };    // 켜진 기준 (FLAG_*)
+    std::atomic<uint32_t> sampleEvery{ 1 };
+    std::atomic<uint32_t> maxPerSecond{ 0 };
+    std::atomic<int64_t> dedupWindowNanos{ 0 };
+
+    std::atomic<uint64_t> windowSecond{ 0 };    // 1초당 한도의 창
+    std::atomic<uint32_t> windowCount{ 0 };
+
+    std::atomic<uint64_t> lastHash{ 0 };        // 마지막으로 남긴(또는 센) 메시지의 해시
+    std::atomic<uint64_t> repeated{ 0 };        // lastHash 메시지가 이어서 들어온 수 (아직 알리지 않은 것)
+    std::atomic<LogTimestamp> windowStart{ 0 }; // lastHash 메시지를 마지막으로 남긴 시각
+    std::atomic<LogTimestamp> lastRepeat{ 0 };  // 마지막으로 반복을 센 시각
+    std::atomic<uint32_t> repeatTypeId{ 0 };    // 반복 수를 알릴 type / 레벨
+    std::atomic<int> repeatLevel{ 0 };
+
+    std::atomic<uint64_t> passed{ 0 };
+    std::atomic<uint64_t> sampledOut{ 0 };
+    std::atomic<uint64_t> rateLimited{ 0 };
+    std::atomic<uint64_t> deduplicated{ 0 };
+
+    static inline thread_local LogSite* current = nullptr;
+};
+
+// 반복 줄이기가 켜진 호출 위치에서 로그를 남기는 동안 LogSite::Current()를 정해둔다.
+class LogSiteScope {
+public:
+    explicit LogSiteScope(LogSite& site)
+    {
+        if (site.Dedups()) {
+            LogSite::current = &site;
+            active = true;
+        }
+    }
+
+    ~LogSiteScope(void)
+    {
+        if (active) {
+            LogSite::current = nullptr;
+        }
+    }
+
+    LogSiteScope(const LogSiteScope&) = delete;
+    LogSiteScope& operator=(const LogSiteScope&) = delete;
+
+    // 반복 수를 알리는 줄처럼 호출 위치와 상관없이 남기는 로그 앞에서 부른다.
+    static void Clear(void) { LogSite::current = nullptr; }
+
+private:
+    bool active = false;
+};
+
+// 처음 실행된 호출 위치의 목록과 "file:line" 별 기준.
+// 목록은 앞에 붙이기만 하므로 락 없이 훑을 수 있다. 기준은 아직 실행되지 않은 호출 위치에도 적용되도록 남겨둔다.
+class LogSiteRegistry {
+public:
+    static LogSiteRegistry& GetInstance(void)
+    {
+        // 정적 LogSite와 SystemLogManager의 소멸 순서와 상관없이 쓸 수 있도록 일부러 지우지 않는다.
+        static LogSiteRegistry* instance = new LogSiteRegistry;
+        return *instance;
+    }
+
+    void Add(LogSite& site)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (const Rule& rule : rules) {
+            if (Matches(site, rule.pattern)) {
+                site.SetPolicy(rule.policy);
+            }
+        }
+
+        site.next = head.load(std::memory_order_relaxed);
+        head.store(&site, std::memory_order_release);
+    }
+
+    // pattern : "main.cpp:52"(그 줄) 또는 "main.cpp"(파일 전체). 파일은 경로의 끝부분과 비교한다.
+    // 이미 실행된 호출 위치에 바로 적용하며, 앞으로 처음 실행되는 호출 위치에도 적용한다. 적용한 호출 위치 수를 반환한다.
+    size_t SetPolicy(std::string_view pattern, const LogSitePolicy& policy)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        bool replaced = false;
+        for (Rule& rule : rules) {
+            if (rule.pattern == pattern) {
+                rule.policy = policy;
+                replaced = true;
+            }
+        }
+        if (!replaced) {
+            rules.push_back({ std::string(pattern), policy });
+        }
+
+        size_t applied = 0;
+        for (LogSite* site = head.load(std::memory_order_acquire); site != nullptr; site = site->next) {
+            if (Matches(*site, pattern)) {
+                site->SetPolicy(policy);
+                applied++;
+            }
+        }
+        return applied;
+    }
+
+    template <typename Function>
+    void ForEach(Function&& function) const
+    {
+        for (LogSite* site = head.load(std::memory_order_acquire); site != nullptr; site = site->next)
+            function(*site);
+    }
+
+private:
+    struct Rule {
+        std::string pattern;
+        LogSitePolicy policy;
+    };
+
+    LogSiteRegistry(void) = default;
+
+    static std::string_view FileName(std::string_view path)
+    {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string_view::npos ? path : path.substr(slash + 1);
+    }
+
+    static bool Matches(const LogSite& site, std::string_view pattern)
+    {
+        std::string_view file = pattern;
+        int line = 0;
+        const size_t colon = pattern.rfind(':');
+        if (colon != std::string_view::npos && colon + 1 < pattern.size()) {
+            file = pattern.substr(0, colon);
+            for (char c : pattern.substr(colon + 1)) {
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                line = line * 10 + (c - '0');
+            }
+        }
+
+        const std::string_view path = site.File();
+        if (path.size() < file.size() || path.substr(path.size() - file.size()) != file) {
+            return false;
+        }
+        // "a.cpp"가 "data.cpp"에 맞지 않도록 경로 구분자 경계에서만
+        if (path.size() > file.size() && path[path.size() - file.size() - 1] != '/' && path[path.size() - file.size() - 1] != '\\') {
+            return false;
+        }
+        return line == 0 || line == site.Line();
+    }
+
+    friend class LogSite;
+
+    std::atomic<LogSite*> head{ nullptr };
+    std::mutex lock;                    // 등록과 rules를 보호
+    std::vector<Rule> rules;
+};
+
+inline LogSite::LogSite(const char* file, int line, const LogSitePolicy& policy) : file(file), line(line)
+{
+    const std::string_view path(file);
+    fileNameOffset = static_cast<uint32_t>(path.size() - LogSiteRegistry::FileName(path).size());
+
+    SetPolicy(policy);
+    LogSiteRegistry::GetInstance().Add(*this);
+}
+
+static_assert(std::is_trivially_destructible_v<LogSite>, "LogSite는 소멸된 뒤에도 목록에서 읽을 수 있어야 한다");
@@ -0,0 +1,226 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <cwchar>
+#include <string>
+
+#include "LogPlatform.h"
+
+// 로그 머리말에 들어가는 시간 / 숫자를 stringstream 없이 버퍼에 바로 쓰기 위한 도구들.
+
+namespace LogTimeDetail {
+    // 0 ~ 99의 두 자리 문자
+    inline constexpr char DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    inline int CountDigits(uint64_t value)
+    {
+        int digits = 1;
+        while (value >= 10) {
+            value /= 10;
+            ++digits;
+        }
+        return digits;
+    }
+}
+
+// value를 정확히 width 자리로 out에 쓴다. 모자라는 앞자리는 0으로 채우고, 넘치는 앞자리는 버린다.
+template <typename CharT>
+inline void WriteFixedDigits(CharT* out, uint64_t value, int width)
+{
+    CharT* p = out + width;
+    while (p - out >= 2) {
+        const size_t pair = static_cast<size_t>(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = static_cast<CharT>(LogTimeDetail::DIGIT_PAIRS[pair]);
+        p[1] = static_cast<CharT>(LogTimeDetail::DIGIT_PAIRS[pair + 1]);
+    }
+    if (p > out) {
+        *--p = static_cast<CharT>('0' + value % 10);
+    }
+}
+
+// value를 최소 minWidth 자리(앞은 0으로 채움)로 붙인다. std::setw(minWidth) << std::setfill(L'0')과 같은 결과
+template <typename String>
+inline void AppendDigits(String& out, uint64_t value, int minWidth = 1)
+{
+    typename String::value_type buffer[24];
+    int width = LogTimeDetail::CountDigits(value);
+    if (width < minWidth) {
+        width = minWidth < 24 ? minWidth : 24;
+    }
+
+    WriteFixedDigits(buffer, value, width);
+    out.append(buffer, width);
+}
+
+// 로그 시각. 1970-01-01 UTC부터의 ns
+using LogTimestamp = uint64_t;
+
+// steady_clock을 처음 호출된 시점의 system_clock에 맞춰둔 시계.
+// 벽시계 시간을 주면서도 절대 뒤로 가지 않으므로 스레드 사이의 순서 비교에 그대로 쓸 수 있다.
+// 기준을 잡은 뒤에 바뀐 시스템 시간(NTP 보정 등)은 따라가지 않는다.
+inline LogTimestamp LogClockNow(void)
+{
+    struct Anchor {
+        std::chrono::system_clock::time_point wall = std::chrono::system_clock::now();
+        std::chrono::steady_clock::time_point steady = std::chrono::steady_clock::now();
+        LogTimestamp wallNanos = static_cast<LogTimestamp>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(wall.time_since_epoch()).count());
+    };
+    static const Anchor anchor;
+
+    return anchor.wallNanos + static_cast<LogTimestamp>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - anchor.steady).count());
+}
+
+inline std::time_t LogTimestampSeconds(LogTimestamp timestamp)
+{
+    return static_cast<std::time_t>(timestamp / 1000000000ull);
+}
+
+inline uint32_t LogTimestampMicros(LogTimestamp timestamp)
+{
+    return static_cast<uint32_t>((timestamp / 1000ull) % 1000000ull);
+}
+
+// "YYYY-MM-DD HH:MM:SS" (로컬 시각) -> 초. 도구(LogDecoder 등)의 시각 조건을 읽을 때 사용
+inline bool ParseLocalTime(const char* text, std::time_t& seconds)
+{
+    std::tm localTime = {};
+    char tail = 0;
+    if (std::sscanf(text, "%4d-%2d-%2d %2d:%2d:%2d%c", &localTime.tm_year, &localTime.tm_mon, &localTime.tm_mday,
+        &localTime.tm_hour, &localTime.tm_min, &localTime.tm_sec, &tail) != 6) {
+        return false;
+    }
+
+    localTime.tm_year -= 1900;
+    localTime.tm_mon -= 1;
+    localTime.tm_isdst = -1;
+    seconds = std::mktime(&localTime);
+    return seconds != -1;
+}
+
+// "YYYY-MM-DD HH:MM:SS" 문자열을 초 단위로 캐시한다. 스레드 사이에 공유하지 않는다. (thread_local 또는 스레드 하나가 소유)
+// 같은 분 안이라면 초 두 자리만 다시 쓰고, 분이 바뀌었을 때만 로컬 시각을 구해서 바뀐 칸만 다시 쓴다.
+class LogTimestampCache {
+public:
+    static constexpr size_t TEXT_LENGTH = 19;           // "YYYY-MM-DD HH:MM:SS"
+    static constexpr size_t MICRO_TEXT_LENGTH = 26;     // "YYYY-MM-DD HH:MM:SS.uuuuuu"
+
+    LogTimestampCache(void)
+    {
+        std::wstring pattern = L"0000-00-00 00:00:00.000000";
+        pattern.copy(text, MICRO_TEXT_LENGTH);
+        text[MICRO_TEXT_LENGTH] = L'\0';
+        monthText[6] = L'\0';
+        dayText[8] = L'\0';
+        hourText[11] = L'\0';
+    }
+
+    // seconds에 해당하는 로컬 시간 문자열 (TEXT_LENGTH 자)
+    const wchar_t* Format(std::time_t seconds)
+    {
+        if (seconds == lastSeconds) {
+            return text;
+        }
+
+        if (seconds >= minuteStart && seconds < minuteStart + 60) {
+            WriteFixedDigits(text + 17, static_cast<uint64_t>(seconds - minuteStart), 2);
+        }
+        else {
+            Refresh(seconds);
+        }
+
+        lastSeconds = seconds;
+        return text;
+    }
+
+    // 초 아래 µs 여섯 자리까지 붙인 문자열 (MICRO_TEXT_LENGTH 자)
+    const wchar_t* FormatMicros(LogTimestamp timestamp)
+    {
+        Format(LogTimestampSeconds(timestamp));
+        WriteFixedDigits(text + 20, LogTimestampMicros(timestamp), 6);
+        return text;
+    }
+
+    // 마지막으로 Format한 시각의 "YYYYMM"
+    const wchar_t* Month(void) const { return monthText; }
+
+    // 마지막으로 Format한 시각의 연 * 100 + 월. 월이 바뀌었는지 비교할 때 사용
+    int MonthKey(void) const { return year * 100 + month; }
+
+    // 마지막으로 Format한 시각의 "YYYYMMDD" / "YYYYMMDD_HH"
+    const wchar_t* Day(void) const { return dayText; }
+    const wchar_t* Hour(void) const { return hourText; }
+
+    // 일 / 시가 바뀌었는지 비교할 때 사용 (YYYYMMDD / YYYYMMDDHH)
+    int DayKey(void) const { return MonthKey() * 100 + day; }
+    int64_t HourKey(void) const { return static_cast<int64_t>(DayKey()) * 100 + hour; }
+
+private:
+    void Refresh(std::time_t seconds)
+    {
+        std::tm localTime = {};
+        LogPlatform::LocalTime(seconds, localTime);
+
+        const int newYear = localTime.tm_year + 1900;
+        const int newMonth = localTime.tm_mon + 1;
+
+        if (newYear != year || newMonth != month) {
+            year = newYear;
+            month = newMonth;
+            WriteFixedDigits(text, static_cast<uint64_t>(year), 4);
+            WriteFixedDigits(text + 5, static_cast<uint64_t>(month), 2);
+            WriteFixedDigits(monthText, static_cast<uint64_t>(year), 4);
+            WriteFixedDigits(monthText + 4, static_cast<uint64_t>(month), 2);
+            std::wmemcpy(dayText, monthText, 6);
+            std::wmemcpy(hourText, monthText, 6);
+            day = -1;
+        }
+        if (localTime.tm_mday != day) {
+            day = localTime.tm_mday;
+            WriteFixedDigits(text + 8, static_cast<uint64_t>(day), 2);
+            WriteFixedDigits(dayText + 6, static_cast<uint64_t>(day), 2);
+            WriteFixedDigits(hourText + 6, static_cast<uint64_t>(day), 2);
+        }
+        if (localTime.tm_hour != hour) {
+            hour = localTime.tm_hour;
+            WriteFixedDigits(text + 11, static_cast<uint64_t>(hour), 2);
+            WriteFixedDigits(hourText + 9, static_cast<uint64_t>(hour), 2);
+        }
+        if (localTime.tm_min != minute) {
+            minute = localTime.tm_min;
+            WriteFixedDigits(text + 14, static_cast<uint64_t>(minute), 2);
+        }
+        WriteFixedDigits(text + 17, static_cast<uint64_t>(localTime.tm_sec), 2);
+
+        // 윤초(tm_sec == 60)는 다음 호출에서 다시 계산하도록 분 캐시를 비워둔다.
+        minuteStart = localTime.tm_sec < 60 ? seconds - localTime.tm_sec : -120;
+    }
+
+    std::time_t lastSeconds = -1;
+    std::time_t minuteStart = -120;     // 캐시된 분의 00초에 해당하는 time_t
+    int year = -1;
+    int month = -1;
+    int day = -1;
+    int hour = -1;
+    int minute = -1;
+    wchar_t text[MICRO_TEXT_LENGTH + 1];
+    wchar_t monthText[7] = L"000000";
+    wchar_t dayText[9] = L"00000000";
+    wchar_t hourText[12] = L"00000000_00";
+};
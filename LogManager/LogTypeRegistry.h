@@ -0,0 +1,182 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "LogBinary.h"
+#include "LogFile.h"
+#include "LogMappedFile.h"
+#include "LogRotation.h"
+#include "LogUtf8.h"
+
+// 로그 type(파일명)을 가리키는 작은 정수. 한 번 발급된 id는 프로그램이 끝날 때까지 바뀌지 않는다.
+using LogTypeId = uint32_t;
+constexpr LogTypeId INVALID_LOG_TYPE_ID = 0xFFFFFFFF;
+
+// type 하나에 대한 출력 대상. 열어둔 로그 파일(텍스트 / 바이너리)을 가지고 있으며, 파일은 자체 mutex로 보호된다.
+// Registry가 살아있는 동안 주소가 바뀌지 않으므로 자주 로그를 남기는 쪽은 포인터나 id를 들고 있어도 된다.
+struct LogTypeSink {
+    // openFiles : 세 파일의 핸들을 함께 셀 캐시 (Registry가 가진 것)
+    LogTypeSink(LogTypeId id, std::wstring_view name, const LogRotationPolicy& rotation, LogOpenFileCache* openFiles)
+        : id(id), name(name), utf8Name(ToUtf8(name)), rotation(rotation)
+    {
+        file.SetOpenFileCache(openFiles);
+        mappedFile.SetOpenFileCache(openFiles);
+        binaryFile.SetOpenFileCache(openFiles);
+    }
+
+    const LogTypeId id;
+    const std::wstring name;
+    const std::string utf8Name;     // 로그 줄의 머리말에 쓰는 name
+    LogRotationPolicy rotation;     // 이 type의 파일을 나누는 기준. 로그를 남기기 전, 초기화 시점에만 바꾼다.
+
+    LogFile file;               // 이 type의 텍스트 로그 파일
+    LogMappedFile mappedFile;   // 이 type의 텍스트 로그 파일 (LogFileWriter가 WRITER_MAPPED일 때 file 대신 사용)
+    LogBinaryFile binaryFile;   // 이 type의 바이너리 로그 파일 (LogFileFormat이 바이너리를 포함할 때만 사용)
+};
+
+// type 문자열을 id로 바꿔주는 저장소.
+// 조회는 고정 크기 open addressing 해시 테이블을 atomic load로만 읽기 때문에 락이 없다.
+// 등록은 mutex 안에서 완성된 항목을 만든 뒤 release store로 공개하므로, 처음 등록과 동시에 조회가 일어나도 안전하다.
+// 한 번 등록된 항목은 지워지지 않는다. (테이블 크기를 넘는 type은 등록되지 않음)
+class LogTypeRegistry {
+public:
+    static constexpr size_t MAX_TYPES = 1024;
+    static constexpr size_t DEFAULT_MAX_OPEN_FILES = 64;    // SystemLogManager::InitializeFileCache로 바꾼다.
+
+    LogTypeRegistry(void)
+    {
+        for (auto& slot : slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+        for (auto& sink : sinks)
+            sink.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~LogTypeRegistry(void)
+    {
+        for (auto& slot : slots)
+            delete slot.load(std::memory_order_relaxed);
+        for (auto& sink : sinks)
+            delete sink.load(std::memory_order_relaxed);
+    }
+
+    LogTypeRegistry(const LogTypeRegistry&) = delete;
+    LogTypeRegistry& operator=(const LogTypeRegistry&) = delete;
+
+    // 등록되지 않은 type이면 INVALID_LOG_TYPE_ID
+    LogTypeId Find(std::wstring_view name) const
+    {
+        const uint64_t hash = Hash(name);
+        for (size_t probe = 0; probe < SLOT_COUNT; ++probe) {
+            const Entry* entry = slots[(hash + probe) & (SLOT_COUNT - 1)].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                return INVALID_LOG_TYPE_ID;
+            }
+            if (entry->hash == hash && entry->name == name) {
+                return entry->id;
+            }
+        }
+        return INVALID_LOG_TYPE_ID;
+    }
+
+    // 이미 있다면 기존 id, 없다면 새로 등록한 id. 테이블이 가득 찼다면 INVALID_LOG_TYPE_ID
+    LogTypeId Register(std::wstring_view name)
+    {
+        LogTypeId id = Find(name);
+        if (id != INVALID_LOG_TYPE_ID) {
+            return id;
+        }
+
+        std::lock_guard<std::mutex> guard(registerLock);
+
+        // lock을 잡기 전에 다른 스레드가 등록했을 수 있으므로 다시 찾는다.
+        const uint64_t hash = Hash(name);
+        size_t index = 0;
+        for (size_t probe = 0; probe < SLOT_COUNT; ++probe) {
+            index = (hash + probe) & (SLOT_COUNT - 1);
+            const Entry* entry = slots[index].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                break;
+            }
+            if (entry->hash == hash && entry->name == name) {
+                return entry->id;
+            }
+        }
+
+        if (typeCount >= MAX_TYPES) {
+            return INVALID_LOG_TYPE_ID;
+        }
+
+        id = static_cast<LogTypeId>(typeCount);
+
+        // sink를 먼저 공개해야 Find로 id를 얻은 스레드가 바로 GetSink를 호출해도 nullptr을 보지 않는다.
+        sinks[id].store(new LogTypeSink(id, name, defaultRotation, &openFileCache), std::memory_order_release);
+        slots[index].store(new Entry{ hash, std::wstring(name), id }, std::memory_order_release);
+
+        typeCount++;
+        publishedCount.store(typeCount, std::memory_order_release);
+        return id;
+    }
+
+    // 이미 등록된 type과 앞으로 등록될 type의 파일 나누는 기준. 로그를 남기기 전, 초기화 시점에 호출한다.
+    void SetDefaultRotation(const LogRotationPolicy& rotation)
+    {
+        std::lock_guard<std::mutex> guard(registerLock);
+
+        defaultRotation = rotation;
+        for (size_t id = 0; id < typeCount; ++id) {
+            sinks[id].load(std::memory_order_relaxed)->rotation = rotation;
+        }
+    }
+
+    // 등록되지 않은 id라면 nullptr
+    LogTypeSink* GetSink(LogTypeId id) const
+    {
+        if (id >= MAX_TYPES) {
+            return nullptr;
+        }
+        return sinks[id].load(std::memory_order_acquire);
+    }
+
+    // 지금까지 등록된 type 수. 0 ~ (Count() - 1)의 id가 모두 유효하다.
+    size_t Count(void) const { return publishedCount.load(std::memory_order_acquire); }
+
+    // 모든 type의 파일(텍스트 / 매핑 / 바이너리)이 함께 쓰는 열린 파일 수 한도
+    LogOpenFileCache& GetOpenFileCache(void) { return openFileCache; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::wstring name;
+        LogTypeId id;
+    };
+
+    // 적재율을 0.5 이하로 유지
+    static constexpr size_t SLOT_COUNT = MAX_TYPES * 2;
+
+    // FNV-1a
+    static uint64_t Hash(std::wstring_view name)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (wchar_t ch : name) {
+            hash ^= static_cast<uint64_t>(ch);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::atomic<Entry*> slots[SLOT_COUNT];
+    std::atomic<LogTypeSink*> sinks[MAX_TYPES];
+
+    std::mutex registerLock;
+    size_t typeCount = 0;                       // registerLock으로 보호
+    LogRotationPolicy defaultRotation;          // registerLock으로 보호. 새로 등록되는 type의 기준
+    std::atomic<size_t> publishedCount{ 0 };
+
+    // sink들보다 늦게 사라져야 하므로(소멸자에서 sink의 파일을 닫음) 멤버로 둔다.
+    LogOpenFileCache openFileCache{ DEFAULT_MAX_OPEN_FILES };
+};
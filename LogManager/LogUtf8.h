@@ -0,0 +1,323 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LOGUTF8_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(LOGUTF8_SSE2) && defined(__AVX2__)
+#define LOGUTF8_AVX2 1
+#include <immintrin.h>
+#endif
+
+// 로그 텍스트의 UTF-8 변환.
+//
+// AppendUtf8      : wchar_t(Windows는 UTF-16, 그 외는 UTF-32) / char16_t 문자열을 UTF-8로 바꿔 붙인다.
+//                   짝이 맞지 않는 surrogate와 0x10FFFF를 넘는 값은 U+FFFD로 바꾼다.
+// AppendValidUtf8 : UTF-8로 받은 문자열을 검사하면서 붙인다. 잘못된 바이트열은 U+FFFD로 바꾼다.
+// AppendWide      : UTF-8을 wchar_t 문자열로 되돌린다. (UTF-8로 받은 type 이름을 LogTypeRegistry에서 찾을 때)
+//
+// 로그는 대부분 ASCII이므로 16(AVX2는 32)글자 단위로 ASCII인지 SSE2 / AVX2로 한 번에 확인하고, 그대로 좁혀서(또는 복사해서) 쓴다.
+// ASCII가 아닌 글자가 섞인 구간만 한 글자씩 변환하며, x86이 아니라면 스칼라 코드로 같은 결과를 낸다.
+
+namespace LogUtf8Detail {
+    constexpr char REPLACEMENT[] = "\xEF\xBF\xBD";     // U+FFFD
+    constexpr size_t REPLACEMENT_LENGTH = 3;
+
+    // 한 번에 확인하는 ASCII 구간의 글자 수. ASCII가 아닌 글자를 만나면 이만큼은 한 글자씩 변환한다.
+    constexpr size_t BLOCK_UNITS = 16;
+
+    // source 앞에서부터 ASCII만 있는 블록을 좁혀서 dest에 쓴다. 반환값 : 쓴 글자 수 (블록 단위)
+    template <typename Unit>
+    inline size_t NarrowAscii(const Unit* source, size_t count, uint8_t* dest)
+    {
+        static_assert(sizeof(Unit) == 2 || sizeof(Unit) == 4, "UTF-16 또는 UTF-32");
+
+        size_t i = 0;
+#if defined(LOGUTF8_AVX2)
+        if constexpr (sizeof(Unit) == 2) {
+            const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+            for (; i + 32 <= count; i += 32) {
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16));
+                if (!_mm256_testz_si256(_mm256_or_si256(low, high), mask)) {
+                    return i;
+                }
+                // packus는 128비트 lane 안에서 섞이므로 64비트 단위로 순서를 되돌린다.
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+            }
+        }
+        else {
+            const __m256i mask = _mm256_set1_epi32(static_cast<int>(0xFFFFFF80));
+            for (; i + 16 <= count; i += 16) {
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 8));
+                if (!_mm256_testz_si256(_mm256_or_si256(low, high), mask)) {
+                    return i;
+                }
+                const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+                const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), packed);
+            }
+        }
+#elif defined(LOGUTF8_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        if constexpr (sizeof(Unit) == 2) {
+            const __m128i mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+            for (; i + 16 <= count; i += 16) {
+                const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(low, high), mask), zero)) != 0xFFFF) {
+                    return i;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(low, high));
+            }
+        }
+        else {
+            const __m128i mask = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+            for (; i + 16 <= count; i += 16) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4));
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 12));
+                const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, mask), zero)) != 0xFFFF) {
+                    return i;
+                }
+                const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), packed);
+            }
+        }
+#endif
+        for (; i + BLOCK_UNITS <= count; i += BLOCK_UNITS) {
+            uint32_t bits = 0;
+            for (size_t j = 0; j < BLOCK_UNITS; ++j)
+                bits |= static_cast<uint32_t>(source[i + j]);
+            if (bits >= 0x80) {
+                return i;
+            }
+            for (size_t j = 0; j < BLOCK_UNITS; ++j)
+                dest[i + j] = static_cast<uint8_t>(source[i + j]);
+        }
+        return i;
+    }
+
+    // source 앞에서부터 ASCII만 있는 블록의 길이 (블록 단위)
+    inline size_t AsciiPrefix(const uint8_t* source, size_t count)
+    {
+        size_t i = 0;
+#if defined(LOGUTF8_AVX2)
+        for (; i + 32 <= count; i += 32) {
+            if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))) != 0) {
+                return i;
+            }
+        }
+#elif defined(LOGUTF8_SSE2)
+        for (; i + 16 <= count; i += 16) {
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))) != 0) {
+                return i;
+            }
+        }
+#endif
+        for (; i + BLOCK_UNITS <= count; i += BLOCK_UNITS) {
+            uint8_t bits = 0;
+            for (size_t j = 0; j < BLOCK_UNITS; ++j)
+                bits |= source[i + j];
+            if (bits >= 0x80) {
+                return i;
+            }
+        }
+        return i;
+    }
+
+    // 코드 포인트 하나를 dest에 쓰고 다음 위치를 돌려준다.
+    inline uint8_t* EncodeCodePoint(uint32_t codePoint, uint8_t* dest)
+    {
+        if (codePoint < 0x80) {
+            *dest++ = static_cast<uint8_t>(codePoint);
+        }
+        else if (codePoint < 0x800) {
+            *dest++ = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+            *dest++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000) {
+            *dest++ = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+            *dest++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+            *dest++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            *dest++ = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+            *dest++ = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+            *dest++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+            *dest++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        return dest;
+    }
+
+    // source에서 시작하는 올바른 UTF-8 바이트열 하나의 길이. 잘못되었거나 잘렸다면 0
+    // (overlong / surrogate / 0x10FFFF 초과는 잘못된 것으로 본다. Unicode 표 3-7)
+    inline size_t SequenceLength(const uint8_t* source, size_t remaining)
+    {
+        const uint8_t lead = source[0];
+        if (lead < 0x80) {
+            return 1;
+        }
+
+        size_t length;
+        uint8_t low = 0x80, high = 0xBF;    // 두 번째 바이트의 범위
+        if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+        else if (lead == 0xE0) { length = 3; low = 0xA0; }
+        else if (lead >= 0xE1 && lead <= 0xEF) { length = 3; if (lead == 0xED) high = 0x9F; }
+        else if (lead == 0xF0) { length = 4; low = 0x90; }
+        else if (lead >= 0xF1 && lead <= 0xF3) length = 4;
+        else if (lead == 0xF4) { length = 4; high = 0x8F; }
+        else return 0;
+
+        if (remaining < length || source[1] < low || source[1] > high) {
+            return 0;
+        }
+        for (size_t i = 2; i < length; ++i) {
+            if ((source[i] & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        return length;
+    }
+
+    template <typename String, typename Unit>
+    inline void AppendUtf8Units(String& out, const Unit* source, size_t count)
+    {
+        const size_t start = out.size();
+        out.resize(start + count * (sizeof(Unit) == 2 ? 3 : 4));
+
+        uint8_t* dest = reinterpret_cast<uint8_t*>(&out[0]) + start;
+        const Unit* end = source + count;
+
+        while (source < end) {
+            const size_t ascii = NarrowAscii(source, static_cast<size_t>(end - source), dest);
+            source += ascii;
+            dest += ascii;
+
+            // ASCII가 아닌 글자가 있는 블록(또는 블록보다 짧은 끝부분)은 한 글자씩 변환한다.
+            const Unit* blockEnd = (static_cast<size_t>(end - source) < BLOCK_UNITS) ? end : source + BLOCK_UNITS;
+            while (source < blockEnd) {
+                uint32_t codePoint = static_cast<uint32_t>(*source++);
+
+                if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                    if (sizeof(Unit) == 2 && codePoint <= 0xDBFF && source < end &&
+                        static_cast<uint32_t>(*source) >= 0xDC00 && static_cast<uint32_t>(*source) <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<uint32_t>(*source++) - 0xDC00);
+                    }
+                    else {
+                        codePoint = 0xFFFD;
+                    }
+                }
+                else if (codePoint > 0x10FFFF) {
+                    codePoint = 0xFFFD;
+                }
+
+                dest = EncodeCodePoint(codePoint, dest);
+            }
+        }
+
+        out.resize(static_cast<size_t>(dest - reinterpret_cast<uint8_t*>(&out[0])));
+    }
+}
+
+// text를 UTF-8로 바꿔 out 뒤에 붙인다. String은 char 문자열 (std::string, LogUtf8String 등)
+template <typename String>
+inline void AppendUtf8(String& out, std::wstring_view text)
+{
+    LogUtf8Detail::AppendUtf8Units(out, text.data(), text.size());
+}
+
+template <typename String>
+inline void AppendUtf8(String& out, std::u16string_view text)
+{
+    LogUtf8Detail::AppendUtf8Units(out, text.data(), text.size());
+}
+
+inline std::string ToUtf8(std::wstring_view text)
+{
+    std::string out;
+    AppendUtf8(out, text);
+    return out;
+}
+
+// text 앞에서부터 올바른 UTF-8인 구간의 길이
+inline size_t Utf8ValidLength(std::string_view text)
+{
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(text.data());
+    size_t i = 0;
+    while (i < text.size()) {
+        i += LogUtf8Detail::AsciiPrefix(source + i, text.size() - i);
+
+        const size_t blockEnd = (text.size() - i < LogUtf8Detail::BLOCK_UNITS) ? text.size() : i + LogUtf8Detail::BLOCK_UNITS;
+        while (i < blockEnd) {
+            const size_t length = LogUtf8Detail::SequenceLength(source + i, text.size() - i);
+            if (length == 0) {
+                return i;
+            }
+            i += length;
+        }
+    }
+    return text.size();
+}
+
+// UTF-8로 받은 text를 out 뒤에 붙인다. 잘못된 바이트는 하나씩 U+FFFD로 바꾼다.
+template <typename String>
+inline void AppendValidUtf8(String& out, std::string_view text)
+{
+    for (;;) {
+        const size_t valid = Utf8ValidLength(text);
+        out.append(text.data(), valid);
+        if (valid == text.size()) {
+            return;
+        }
+
+        out.append(LogUtf8Detail::REPLACEMENT, LogUtf8Detail::REPLACEMENT_LENGTH);
+        text.remove_prefix(valid + 1);
+    }
+}
+
+// UTF-8 text를 wchar_t 문자열로 바꿔 out 뒤에 붙인다. 잘못된 바이트는 하나씩 U+FFFD로 바꾼다.
+inline void AppendWide(std::wstring& out, std::string_view text)
+{
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(text.data());
+    const uint8_t* end = source + text.size();
+    out.reserve(out.size() + text.size());
+
+    while (source < end) {
+        const size_t length = LogUtf8Detail::SequenceLength(source, static_cast<size_t>(end - source));
+        uint32_t codePoint = 0xFFFD;
+        switch (length) {
+        case 1: codePoint = source[0]; break;
+        case 2: codePoint = ((source[0] & 0x1Fu) << 6) | (source[1] & 0x3Fu); break;
+        case 3: codePoint = ((source[0] & 0x0Fu) << 12) | ((source[1] & 0x3Fu) << 6) | (source[2] & 0x3Fu); break;
+        case 4: codePoint = ((source[0] & 0x07u) << 18) | ((source[1] & 0x3Fu) << 12) | ((source[2] & 0x3Fu) << 6) | (source[3] & 0x3Fu); break;
+        default: break;
+        }
+        source += length != 0 ? length : 1;
+
+        if (sizeof(wchar_t) == 2 && codePoint >= 0x10000) {
+            out.push_back(static_cast<wchar_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+        }
+        else {
+            out.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+}
+
+// char8_t 문자열은 같은 바이트를 char로 본다.
+inline std::string_view AsUtf8Chars(std::u8string_view text)
+{
+    return std::string_view(reinterpret_cast<const char*>(text.data()), text.size());
+}
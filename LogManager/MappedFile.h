@@ -0,0 +1,234 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "LogPlatform.h"
+
+// 파일 전체를 읽기 전용으로 메모리에 매핑한다. 열려있는 동안 Data()는 파일 내용을 그대로 가리킨다.
+// 다른 프로세스가 파일을 지우거나 이름을 바꿀 수 있도록 공유 모드를 열어둔다. (매핑은 닫을 때까지 유효)
+class MappedFile {
+public:
+    MappedFile(void) = default;
+    ~MappedFile(void) { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 빈 파일이나 열 수 없는 파일이면 false
+    bool Open(const std::wstring& fileName)
+    {
+        Close();
+
+#ifdef _WIN32
+        file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            Close();
+            return false;
+        }
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (data == nullptr) {
+            Close();
+            return false;
+        }
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        descriptor = open(std::filesystem::path(fileName).c_str(), O_RDONLY);
+        if (descriptor < 0) {
+            return false;
+        }
+
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            Close();
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+        if (view == MAP_FAILED) {
+            Close();
+            return false;
+        }
+        data = static_cast<const uint8_t*>(view);
+        size = static_cast<size_t>(status.st_size);
+#endif
+        return true;
+    }
+
+    void Close(void)
+    {
+#ifdef _WIN32
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data != nullptr) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+        if (descriptor >= 0) {
+            close(descriptor);
+            descriptor = -1;
+        }
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen(void) const { return data != nullptr; }
+    const uint8_t* Data(void) const { return data; }
+    size_t Size(void) const { return size; }
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int descriptor = -1;
+#endif
+};
+
+// 쓰기용으로 연 파일. 파일 크기를 직접 관리하고, 필요한 구간만 따로 매핑한다. (LogMappedFile)
+// 매핑한 구간은 Unmap 전까지 유효하며, 다른 구간을 매핑하거나 파일을 늘려도 옮겨지지 않는다.
+class WritableMappedFile {
+public:
+    // Map의 offset은 이 값의 배수여야 한다.
+    static constexpr uint64_t MAP_ALIGNMENT = 64 * 1024;
+
+    WritableMappedFile(void) = default;
+    ~WritableMappedFile(void) { Close(); }
+
+    WritableMappedFile(const WritableMappedFile&) = delete;
+    WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+
+    // 없으면 만든다.
+    bool Open(const std::wstring& fileName)
+    {
+        Close();
+
+#ifdef _WIN32
+        file = CreateFileW(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return file != INVALID_HANDLE_VALUE;
+#else
+        descriptor = open(std::filesystem::path(fileName).c_str(), O_RDWR | O_CREAT, 0644);
+        return descriptor >= 0;
+#endif
+    }
+
+    void Close(void)
+    {
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (descriptor >= 0) {
+            close(descriptor);
+            descriptor = -1;
+        }
+#endif
+    }
+
+    uint64_t Size(void) const
+    {
+#ifdef _WIN32
+        LARGE_INTEGER fileSize;
+        return GetFileSizeEx(file, &fileSize) ? static_cast<uint64_t>(fileSize.QuadPart) : 0;
+#else
+        struct stat status;
+        return fstat(descriptor, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+#endif
+    }
+
+    // 줄일 때는 그 뒤를 가리키는 매핑이 없어야 한다.
+    bool Resize(uint64_t bytes)
+    {
+#ifdef _WIN32
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(bytes);
+        return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+#else
+        return ftruncate(descriptor, static_cast<off_t>(bytes)) == 0;
+#endif
+    }
+
+    // [offset, offset + bytes)를 읽기 / 쓰기로 매핑한다. 파일은 미리 그 크기 이상이어야 한다. 실패하면 nullptr
+    uint8_t* Map(uint64_t offset, size_t bytes)
+    {
+#ifdef _WIN32
+        const uint64_t end = offset + bytes;
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(end >> 32), static_cast<DWORD>(end), nullptr);
+        if (mapping == nullptr) {
+            return nullptr;
+        }
+
+        // 뷰가 매핑 객체를 붙잡고 있으므로 핸들은 바로 닫는다.
+        void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset), bytes);
+        CloseHandle(mapping);
+        return static_cast<uint8_t*>(view);
+#else
+        void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, static_cast<off_t>(offset));
+        return view != MAP_FAILED ? static_cast<uint8_t*>(view) : nullptr;
+#endif
+    }
+
+    static void Unmap(uint8_t* view, size_t bytes)
+    {
+#ifdef _WIN32
+        (void)bytes;
+        UnmapViewOfFile(view);
+#else
+        munmap(view, bytes);
+#endif
+    }
+
+    bool IsOpen(void) const
+    {
+#ifdef _WIN32
+        return file != INVALID_HANDLE_VALUE;
+#else
+        return descriptor >= 0;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int descriptor = -1;
+#endif
+};
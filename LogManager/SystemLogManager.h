@@ -0,0 +1,2042 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "HexDump.h"
+#include "LogArgs.h"
+#include "LogBinary.h"
+#include "LogBufferPool.h"
+#include "LogConsole.h"
+#include "LogCrash.h"
+#include "LogFile.h"
+#include "LogFilter.h"
+#include "LogHexBytes.h"
+#include "LogLine.h"
+#include "LogMetrics.h"
+#include "LogPlatform.h"
+#include "LogQueue.h"
+#include "LogSinks.h"
+#include "LogSite.h"
+#include "LogTime.h"
+#include "LogTypeRegistry.h"
+#include "LogUtf8.h"
+#include "ThreadLogBuffer.h"
+
+class SystemLogManager {
+public:
+    static SystemLogManager& GetInstance() {
+        static SystemLogManager instance;
+        return instance;
+    }
+    ~SystemLogManager(void) {
+
+        // 큐에 쌓여있는 로그를 모두 파일에 기록한 뒤 writer 스레드를 종료
+        ShutdownAsync();
+        ShutdownThreadLocal();
+
+        // 추가 출력 대상에 쌓인 로그를 모두 쓰고 닫는다.
+        sinks.Shutdown();
+
+        // 콘솔 버퍼에 남은 줄을 출력한다.
+        console.Stop();
+
+        // 버퍼에 남아있는 로그를 기록하고 열어둔 파일을 모두 닫는다.
+        StopMaintenance();
+        CloseFiles();
+
+        // 압축 대기열에 남은 파일을 마저 압축한다.
+        archiver.Stop();
+
+        // 크래시 없이 끝났으므로 비상 파일(비어있음)은 지운다.
+        LogCrash::Uninstall();
+        emergencyFile.Close();
+    }
+
+    void Initialize(const std::wstring& directory, LogLevel level) {
+        InitializeDirectory(directory);
+        InitializeLevel(level);
+    }
+
+    void InitializeDirectory(const std::wstring& directory)
+    {
+        logDirectory = directory;
+        fileNameGeneration.fetch_add(1);
+
+        // 인자로 받은 파일 경로가 있는지 확인
+        if (!std::filesystem::exists(logDirectory)) {
+            // 없다면 해당 경로를 생성
+            std::filesystem::create_directory(logDirectory);
+        }
+
+        StartMaintenance();
+    }
+
+    // 모든 type의 기본 레벨. 필터 설정 파일이나 실행 중에 받은 규칙이 있다면 그 규칙이 이 값을 덮어쓴다. (LogFilter)
+    void InitializeLevel(LogLevel level)
+    {
+        filter.SetBaseLevels(LogLevelsFrom(level));
+    }
+
+    // 필터 설정 파일(형식은 ParseLogFilterConfig)을 읽어 적용하고, 그 뒤로 바뀔 때마다 다시 읽는다. (maintenance 스레드가 1초마다 확인)
+    // 읽지 못했거나 잘못된 줄이 있다면 false. 다시 읽다가 잘못된 줄을 만나면 이전 규칙을 그대로 두고 "LogFilter" type에 남긴다.
+    // 파일이 아직 없다면 생길 때 읽는다. 로그 폴더를 정한 뒤, 초기화 시점에 호출한다.
+    bool InitializeFilterFile(const std::wstring& fileName)
+    {
+        bool loaded = false;
+        {
+            std::lock_guard<std::mutex> guard(filterSourceLock);
+            filterTypeId = typeRegistry.Register(std::wstring(FILTER_TYPE_NAME));
+            filterFile.Watch(fileName);
+            loaded = PollFilterFile();
+            lastFilterFilePoll = std::chrono::steady_clock::now();
+        }
+
+        StartMaintenance();
+        return loaded;
+    }
+
+    // 127.0.0.1:port의 UDP 소켓으로 필터 규칙을 받는다. datagram 하나가 설정 파일과 같은 형식의 규칙 묶음이며,
+    // 이전에 받은 규칙 위에 덧붙는다. ("reset" 줄로 지움) 포트를 열지 못하면 false. 로그 폴더를 정한 뒤, 초기화 시점에 호출한다.
+    bool InitializeControlSocket(uint16_t port)
+    {
+        bool opened = false;
+        {
+            std::lock_guard<std::mutex> guard(filterSourceLock);
+            filterTypeId = typeRegistry.Register(std::wstring(FILTER_TYPE_NAME));
+            opened = controlSocket.Open(port);
+        }
+
+        StartMaintenance();
+        return opened;
+    }
+
+    // type 하나의 레벨을 실행 중에 바꾼다. (level 이상) 설정 파일의 규칙보다 앞선다.
+    void SetTypeLevel(std::wstring_view type, LogLevel level)
+    {
+        filter.SetRuntimeType(type, LogLevelsFrom(level), false);
+    }
+
+    // type 하나가 남길 레벨을 집합으로 정한다. (LogLevelBit(LEVEL_DEBUG) | LogLevelBit(LEVEL_SYSTEM) 처럼)
+    void SetTypeLevels(std::wstring_view type, LogLevelMask levels)
+    {
+        filter.SetRuntimeType(type, levels, false);
+    }
+
+    // SetTypeLevel(s)로 정한 값을 지워 설정 파일 / 기본 레벨을 따르게 한다.
+    void ClearTypeLevel(std::wstring_view type)
+    {
+        filter.SetRuntimeType(type, LOG_LEVELS_NONE, true);
+    }
+
+    // 제어 소켓으로 받은 것과 같이 규칙 묶음을 적용한다. (게임 서버의 운영 명령 등에서) 잘못된 줄이 있으면 아무것도 바꾸지 않고 false
+    bool ApplyFilterConfig(std::string_view text, std::string& error)
+    {
+        LogFilterConfig config;
+        if (!ParseLogFilterConfig(text, config, error)) {
+            return false;
+        }
+        filter.ApplyRuntimeConfig(config);
+        return true;
+    }
+
+    // 지금 적용된 필터 규칙. ("* = ERROR SYSTEM, Memory = DEBUG ERROR SYSTEM")
+    std::wstring GetFilterDescription(void) const { return filter.Describe(); }
+
+    // LOG 호출 위치의 기준(샘플링 / 1초당 한도 / 반복 줄이기)을 실행 중에 바꾼다. LOG_SAMPLED 등으로 정한 값을 덮어쓴다.
+    // site : "Battle.cpp:120"(그 줄) 또는 "Battle.cpp"(파일 전체). 아직 실행되지 않은 호출 위치에도 처음 실행될 때 적용된다.
+    // 지금 적용한 호출 위치 수를 반환한다.
+    size_t SetSitePolicy(std::string_view site, const LogSitePolicy& policy)
+    {
+        return LogSiteRegistry::GetInstance().SetPolicy(site, policy);
+    }
+
+    // 머리말의 시각을 초 아래 마이크로초까지 남길지 설정. (YYYY-MM-DD HH:MM:SS.uuuuuu) 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeTimestamp(bool micros)
+    {
+        microTimestamp = micros;
+    }
+
+    // type 별 로그 파일 형식 설정. 바이너리는 YYYYMM_type.bin에 포맷 문자열 id와 인자만 남기며, LogDecoder로 같은 텍스트를 복원한다.
+    // 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeFileFormat(LogFileFormat format)
+    {
+        fileFormat = format;
+    }
+
+    // 텍스트 로그 파일을 쓰는 방식 설정. WRITER_MAPPED는 파일을 미리 크게 늘려 매핑해두고 잠금 없이 바로 복사한다.
+    // 파일 첫 줄에 기록이 끝난 길이를 남기며, 파일을 닫을 때 실제 길이로 잘라낸다. (LogMappedFile)
+    // 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeFileWriter(LogFileWriter writer)
+    {
+        fileWriter = writer;
+    }
+
+    // 모든 type의 파일을 나누는 기준 설정. 기간(월 / 일 / 시)이 바뀌거나 크기 / 기록 수 한도에 닿으면 다음 파일로 넘어간다.
+    // 로그를 남기기 전, 초기화 시점에 호출한다. (type 별 기준을 따로 줄 때는 그보다 먼저)
+    void InitializeRotation(LogRotationPolicy rotation)
+    {
+        rotation.archiver = &archiver;
+        typeRegistry.SetDefaultRotation(rotation);
+        fileNameGeneration.fetch_add(1);
+    }
+
+    // type 하나의 파일을 나누는 기준 설정. 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeRotation(const std::wstring& type, LogRotationPolicy rotation)
+    {
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(type));
+        if (sink == nullptr) {
+            return;
+        }
+
+        rotation.archiver = &archiver;
+        sink->rotation = rotation;
+        fileNameGeneration.fetch_add(1);
+    }
+
+    // 다 쓴 파일(기간이 지났거나 한도에 닿은 파일)을 백그라운드 스레드에서 LZ4로 압축하고,
+    // 로그 폴더의 오래된 로그 파일을 보관 기준에 따라 지운다. 로그 폴더를 정한 뒤, 초기화 시점에 호출한다.
+    void InitializeArchive(const LogArchivePolicy& policy)
+    {
+        archiver.Start(logDirectory, policy, [this](std::vector<std::wstring>& files) { CollectActiveFiles(files); });
+    }
+
+    // 콘솔 출력 기준 설정. 콘솔은 파일과 따로 자신의 스레드에서 출력하며, 따라가지 못하면 줄을 버린다. (LogConsoleSink)
+    // 릴리스 빌드에서는 기본으로 꺼져있다. 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeConsole(const LogConsolePolicy& policy)
+    {
+        console.Start(policy);
+    }
+
+    // type 별 파일 / 콘솔 외의 출력 대상(LogSinks.h의 파일, 바이너리, 표준 출력, syslog, 메모리 링 등)을 더한다.
+    // 싱크마다 자신의 필터(레벨 / type)와 형식을 가지며, 로그 한 건은 싱크들이 쓰는 형식마다 한 번만 만들어 참조 수로 나눠준다.
+    // 쓰기는 threading에 따라 싱크 전용 스레드, 싱크들이 나눠 쓰는 풀(SYSLOG_SINK_POOL), 또는 로그를 나눠주는 스레드에서 한다.
+    // 같은 이름의 싱크가 이미 있으면 false. 실행 중에 더하거나 빼도 된다.
+    bool AddSink(std::shared_ptr<LogSink> sink, LogSinkThreading threading = LogSinkThreading::THREAD_POOL)
+    {
+        return sinks.Add(std::move(sink), threading);
+    }
+
+    // 쌓여있던 로그를 다 쓰고 닫은 뒤 뺀다.
+    bool RemoveSink(std::wstring_view name)
+    {
+        return sinks.Remove(name);
+    }
+
+    std::shared_ptr<LogSink> FindSink(std::wstring_view name) const
+    {
+        return sinks.Find(name);
+    }
+
+    // THREAD_POOL 싱크들이 나눠 쓸 스레드 수 (기본 2). 싱크를 더하기 전, 초기화 시점에 호출한다.
+    void InitializeSinkPool(size_t threads)
+    {
+        sinks.SetPoolThreads(threads);
+    }
+
+    // LogHex / LogHexPinned가 남길 최대 바이트. 넘는 버퍼는 앞 / 뒤 절반씩만 남기고 가운데는 "... N bytes omitted ..." 한 줄이 된다.
+    // 큰 버퍼 하나가 큐와 풀을 차지하지 않도록 기본은 64KB. 0이면 제한 없음. 로그를 남기기 전, 초기화 시점에 호출한다.
+    void InitializeHexDump(size_t maxBytes)
+    {
+        hexMaxBytes = maxBytes;
+    }
+
+    // interval마다 GetLoggerStats의 값(초당 기록 수 / 바이트, type 별 lock 대기, 구간 별 평균 사이클, 큐 깊이, 버린 수)을
+    // "LoggerStats" type에 SYSTEM 레벨로 남긴다. 0이면 남기지 않는다. 로그 폴더를 정한 뒤, 초기화 시점에 호출한다.
+    void InitializeStatsLog(std::chrono::milliseconds interval)
+    {
+        statsTypeId = typeRegistry.Register(std::wstring(STATS_TYPE_NAME));
+        statsLogInterval = interval;
+        StartMaintenance();
+    }
+
+    // 크래시(SIGSEGV / SIGABRT / SIGBUS 등. Windows는 처리되지 않은 예외와 abort) 때 파일 버퍼, 비동기 큐, 스레드 로컬 링 버퍼에
+    // 남아있던 로그를 fileName에 남긴다. 파일은 지금 만들어 열어두며, 형식은 바이너리 로그와 같아서 LogDecoder로 읽는다. (LogEmergencyFile)
+    // 크래시 없이 끝나면 빈 파일은 지운다. 로그를 남기기 전, 초기화 시점에 호출한다.
+    bool InitializeCrashHandler(const std::wstring& fileName)
+    {
+        if (!emergencyFile.Open(fileName)) {
+            return false;
+        }
+
+        // 시계의 기준은 핸들러 밖에서 잡아둔다.
+        LogClockNow();
+        LogCrash::Install(&SystemLogManager::OnCrash);
+        return true;
+    }
+
+    // 크래시 때 마지막으로 헥스 덤프(LogHex와 같은 줄)로 남길 메모리. 크래시 때 그대로 읽으므로 그때까지 유효해야 한다.
+    // 다시 부르면 바뀌며, data가 nullptr이면 남기지 않는다.
+    void SetCrashDumpRegion(std::string_view description, const void* data, size_t length)
+    {
+        crashRegion.Set(description, data, length);
+    }
+
+    // 비동기 모드 시작. 이후 Log/LogHex는 완성된 로그를 큐에 넣기만 하고,
+    // 콘솔/파일 출력은 writer 스레드가 모아서 한꺼번에 처리한다.
+    // queueDepth : 큐에 담아둘 수 있는 최대 로그 수 (2의 거듭제곱으로 올림)
+    // policy     : 큐가 가득 찼을 때 대기 / 버림 / 가장 오래된 로그 덮어쓰기 중 선택
+    void InitializeAsync(size_t queueDepth, QueueFullPolicy policy)
+    {
+        ShutdownAsync();
+        ShutdownThreadLocal();
+
+        fullPolicy = policy;
+        logQueue = std::make_unique<BoundedLogQueue<LogRecord>>(queueDepth);
+        writerRunning = true;
+        writerThread = std::thread(&SystemLogManager::WriterThreadProc, this);
+
+        asyncEnabled.store(true);
+    }
+
+    // 비동기 모드 종료. 큐에 남아있는 로그는 모두 기록된 뒤에 반환된다.
+    void ShutdownAsync(void)
+    {
+        if (!asyncEnabled.exchange(false)) {
+            return;
+        }
+
+        // 이미 비동기 경로로 들어와서 큐에 넣는 중인 스레드가 끝날 때까지 대기
+        while (activeProducers.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writerRunning = false;
+        }
+        writerWakeup.notify_one();
+        writerThread.join();
+
+        logQueue.reset();
+    }
+
+    // 스레드 로컬 모드 시작. 각 스레드가 자신만의 링 버퍼에 로그를 넣고, collector 스레드가 모든 버퍼를 모아
+    // 시간 순서로 정렬한 뒤 기록한다. 공유 인덱스 카운터와 type 별 lock을 건드리지 않으므로 코어가 많을 때 유리하다.
+    // 9자리 인덱스는 collector가 정렬된 순서대로 붙이므로, 파일에서 인덱스 순서가 곧 스레드 사이의 로그 순서다.
+    // ringCapacity : 스레드 하나의 링 버퍼에 담아둘 수 있는 최대 로그 수
+    // policy       : 링 버퍼가 가득 찼을 때 대기 / 버림 (POLICY_OVERWRITE_OLDEST는 POLICY_DROP과 같이 동작)
+    void InitializeThreadLocal(size_t ringCapacity, QueueFullPolicy policy)
+    {
+        ShutdownAsync();
+        ShutdownThreadLocal();
+
+        threadRingCapacity = ringCapacity;
+        threadRingPolicy = policy;
+        collectorCutoff = 0;
+        collectorRunning = true;
+        collectorThread = std::thread(&SystemLogManager::CollectorThreadProc, this);
+
+        threadLocalEnabled.store(true);
+    }
+
+    // 스레드 로컬 모드 종료. 모든 스레드의 링 버퍼에 남아있는 로그가 기록된 뒤에 반환된다.
+    void ShutdownThreadLocal(void)
+    {
+        if (!threadLocalEnabled.exchange(false)) {
+            return;
+        }
+
+        // 이미 링 버퍼에 넣는 중인 스레드가 끝날 때까지 대기
+        {
+            std::lock_guard<std::mutex> guard(threadBuffersLock);
+            for (auto& buffer : threadBuffers) {
+                while (buffer->writing.load()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(collectorMutex);
+            collectorRunning = false;
+        }
+        collectorWakeup.notify_one();
+        collectorThread.join();
+
+        // 지금까지의 버퍼는 버리고, 다시 시작하면 각 스레드가 새 버퍼를 받도록 한다.
+        std::lock_guard<std::mutex> guard(threadBuffersLock);
+        threadBuffers.clear();
+        threadBufferGeneration.fetch_add(1);
+    }
+
+    // 파일 버퍼를 언제 실제 파일에 기록할지 설정. 로그를 남기기 전, 초기화 시점에 호출한다.
+    // flushBytes    : 버퍼에 쌓인 양이 이 이상이면 기록 (0이면 매번 기록)
+    // flushInterval : 마지막 기록 후 이 시간이 지나면 기록
+    // flushLevel    : 이 레벨 이상의 로그는 바로 기록
+    void InitializeFlushPolicy(size_t flushBytes, std::chrono::milliseconds flushInterval, LogLevel level)
+    {
+        flushPolicy.flushBytes = flushBytes;
+        flushPolicy.flushInterval = flushInterval;
+        flushLevel = level;
+    }
+
+    // 열어둘 파일 핸들 수 제한. 로그를 남기기 전, 초기화 시점에 호출한다.
+    // maxOpen     : 동시에 열어둘 최대 파일 수. 텍스트 / 매핑 / 바이너리 파일을 모두 합쳐 센다.
+    //               파일을 열 때 넘으면 가장 오래 쓰이지 않은 파일부터 닫는다. (0이면 제한 없음)
+    // idleTimeout : 이 시간 동안 쓰이지 않은 파일은 닫는다.
+    void InitializeFileCache(size_t maxOpen, std::chrono::milliseconds idleTimeout)
+    {
+        typeRegistry.GetOpenFileCache().SetLimit(maxOpen);
+        fileIdleTimeout = idleTimeout;
+    }
+
+    // 버퍼에 쌓여있는 로그를 바로 파일에 기록한다. (비동기 모드의 큐에 남아있는 로그는 포함하지 않음)
+    void Flush(void)
+    {
+        for (size_t id = 0; id < typeRegistry.Count(); ++id) {
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->file.Flush();
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->mappedFile.Flush();
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->binaryFile.Flush();
+        }
+    }
+
+    // 버퍼에 쌓여있는 로그를 기록하고 열어둔 파일을 모두 닫는다. (WRITER_MAPPED 파일은 실제 길이로 잘린다)
+    // 다음 로그가 들어오면 다시 연다.
+    void CloseFiles(void)
+    {
+        for (size_t id = 0; id < typeRegistry.Count(); ++id) {
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->file.Close();
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->mappedFile.Close();
+            typeRegistry.GetSink(static_cast<LogTypeId>(id))->binaryFile.Close();
+        }
+    }
+
+    // type 문자열을 id로 등록한다. 같은 문자열은 항상 같은 id를 돌려준다.
+    // 자주 로그를 남기는 쪽은 id를 받아두고 id를 받는 Log/LogHex를 사용하면 매번 type 문자열을 찾는 비용이 없다.
+    // 등록 가능한 type 수(LogTypeRegistry::MAX_TYPES)를 넘으면 INVALID_LOG_TYPE_ID
+    LogTypeId RegisterType(const std::wstring& type)
+    {
+        return typeRegistry.Register(type);
+    }
+
+    // UTF-8로 받은 type 문자열을 id로 등록한다. 같은 이름의 wchar_t type과 같은 id다.
+    LogTypeId RegisterType(std::string_view type)
+    {
+        return typeRegistry.Register(WideTypeName(type));
+    }
+
+    // 큐(또는 스레드 로컬 링 버퍼)가 가득 차서 버려진(POLICY_DROP) 로그 수
+    int64_t GetDroppedCount(void) const { return droppedCount.load(); }
+
+    // 큐가 가득 차서 덮어써진(POLICY_OVERWRITE_OLDEST) 로그 수
+    int64_t GetOverwrittenCount(void) const { return overwrittenCount.load(); }
+
+    // 로그 버퍼 풀의 할당 횟수. 데워진 뒤에도 heapAllocations가 계속 늘어난다면 풀이 감당하지 못하는 크기가 있다는 뜻
+    LogBufferPoolStats GetBufferPoolStats(void) const { return LogBufferPool::GetStats(); }
+
+    // 압축한 파일 수 / 크기와 보관 기준으로 지운 파일 수 / 크기
+    LogArchiveStats GetArchiveStats(void) { return archiver.GetStats(); }
+
+    // 콘솔에 출력한 줄 수와 버린(버퍼가 가득 참 / 1초당 한도) 줄 수, 반복이라 줄인 줄 수
+    LogConsoleStats GetConsoleStats(void) const { return console.GetStats(); }
+
+    // 로거 자신의 계측 값. 구간 별 사이클(샘플), type 별 레벨 별 기록 수 / 바이트와 lock 대기 히스토그램, 큐 깊이, 버린 로그 수 (LogMetrics.h)
+    // SYSLOG_METRICS가 0이면 버린 로그 수 외에는 0이다.
+    LoggerStatsSnapshot GetLoggerStats(void)
+    {
+        LoggerStatsSnapshot snapshot;
+        snapshot.time = std::chrono::steady_clock::now();
+        snapshot.stages = stageMetrics.GetStats();
+
+        const size_t typeCount = typeRegistry.Count();
+        std::vector<LogTypeCounters> counters;
+        typeCounters.GetCounters(typeCount, counters);
+
+        snapshot.types.resize(typeCount);
+        for (size_t id = 0; id < typeCount; ++id) {
+            const LogTypeSink* sink = typeRegistry.GetSink(static_cast<LogTypeId>(id));
+            LogTypeStats& type = snapshot.types[id];
+            type.name = sink->name;
+            type.counters = counters[id];
+            type.lockWaits = sink->file.GetLockWaits();
+            type.lockWaits += sink->binaryFile.GetLockWaits();
+        }
+
+        snapshot.queueDepth = queueDepth.load(std::memory_order_relaxed);
+        snapshot.peakQueueDepth = peakQueueDepth.load(std::memory_order_relaxed);
+        snapshot.droppedRecords = droppedCount.load();
+        snapshot.overwrittenRecords = overwrittenCount.load();
+        snapshot.truncatedMessages = truncatedMessages.load(std::memory_order_relaxed);
+
+        const LogConsoleStats consoleStats = console.GetStats();
+        snapshot.consoleDroppedLines = consoleStats.droppedLines + consoleStats.limitedLines;
+
+        LogSiteRegistry::GetInstance().ForEach([&snapshot](const LogSite& site) {
+            LogSiteStats stats = site.GetStats();
+            if (stats.passed + stats.sampledOut + stats.rateLimited + stats.deduplicated > 0) {
+                snapshot.sites.push_back(std::move(stats));
+            }
+        });
+
+        sinks.GetStats(snapshot.sinks);
+        return snapshot;
+    }
+
+
+
+    // 어느 type에서든 level 로그가 남을 수 있는지. LOG 매크로는 인자를 평가하기 전에 이것부터 확인한다.
+    // (type 별 규칙은 type을 찾은 뒤에 확인)
+    bool IsLevelEnabled(LogLevel level) const { return filter.MayPass(level); }
+
+    // format은 문자열 리터럴만 받으며, 변환 지정자와 인자의 수 / 타입이 맞지 않으면 컴파일 에러가 난다.
+    // 인자는 타입 정보와 함께 복사만 해두고, 비동기 / 스레드 로컬 모드에서는 실제 문자열 조립을
+    // writer(collector) 스레드에서 한다. 포맷 해석은 컴파일 타임에 끝나 있다. 메시지 길이 제한은 없다.
+    template <typename... Args>
+    void Log(std::wstring_view type, LogLevel level, LogFormatString<Args...> format, const Args&... args)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(type));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        const bool sampled = LogStageMetrics::SampleNext();
+        LogRecord record;
+        {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_CAPTURE, sampled);
+            record.args.Capture(format, args...);
+        }
+        Submit(*sink, level, record, sampled);
+    }
+
+    template <typename... Args>
+    void Log(LogTypeId typeId, LogLevel level, LogFormatString<Args...> format, const Args&... args)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        const bool sampled = LogStageMetrics::SampleNext();
+        LogRecord record;
+        {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_CAPTURE, sampled);
+            record.args.Capture(format, args...);
+        }
+        Submit(*sink, level, record, sampled);
+    }
+
+    // 실행 중에 만든 포맷 문자열이나 va_list를 넘겨야 할 때 사용한다.
+    // 호출한 스레드에서 바로 포맷하며, 메시지가 길면 스레드별 버퍼를 두 배씩 늘려 다시 포맷한다.
+    // MAX_FORMAT_CHARS를 넘는 메시지는 잘리며 GetLoggerStats의 truncatedMessages로 센다.
+    void LogV(std::wstring_view type, LogLevel level, const wchar_t* format, va_list args)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(type));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogV(*sink, level, format, args);
+    }
+
+    void LogV(LogTypeId typeId, LogLevel level, const wchar_t* format, va_list args)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogV(*sink, level, format, args);
+    }
+
+    // UTF-8 메시지를 변환 없이 그대로 남긴다. 포맷은 하지 않으므로 호출한 쪽에서 완성한 메시지를 넘긴다.
+    // 잘못된 UTF-8 바이트는 U+FFFD로 바뀌며, wchar_t로 남긴 로그와 같은 파일에 같은 인덱스 순서로 기록된다.
+    void Log(std::string_view type, LogLevel level, std::string_view message)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(WideTypeName(type)));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogUtf8(*sink, level, message);
+    }
+
+    void Log(LogTypeId typeId, LogLevel level, std::string_view message)
+    {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogUtf8(*sink, level, message);
+    }
+
+    void Log(std::u8string_view type, LogLevel level, std::u8string_view message)
+    {
+        Log(AsUtf8Chars(type), level, AsUtf8Chars(message));
+    }
+
+    void Log(LogTypeId typeId, LogLevel level, std::u8string_view message)
+    {
+        Log(typeId, level, AsUtf8Chars(message));
+    }
+
+    void LogHex(std::wstring_view type, LogLevel level, std::wstring_view description, const char* data, size_t length) {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(type));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length);
+    }
+
+    void LogHex(LogTypeId typeId, LogLevel level, std::wstring_view description, const char* data, size_t length) {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length);
+    }
+
+    // description이 UTF-8인 LogHex
+    void LogHex(std::string_view type, LogLevel level, std::string_view description, const char* data, size_t length) {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(WideTypeName(type)));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length);
+    }
+
+    void LogHex(LogTypeId typeId, LogLevel level, std::string_view description, const char* data, size_t length) {
+        if (!filter.MayPass(level)) {
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length);
+    }
+
+    // 호출한 쪽이 고정해둔 버퍼(보내는 중인 패킷 등)를 복사하지 않고 남긴다. 헥스 문자열은 writer 스레드에서 만든다.
+    // 버퍼는 release(context, data)가 불릴 때까지 바꾸거나 해제하면 안 된다. release는 반드시 한 번 불리며,
+    // 파일에 쓴 뒤(동기 모드라면 반환하기 전) 또는 걸러지거나 버려진 즉시 그 로그를 마지막으로 가진 스레드에서 불린다.
+    void LogHexPinned(std::wstring_view type, LogLevel level, std::wstring_view description, const char* data, size_t length,
+        LogHexRelease release, void* context) {
+        if (!filter.MayPass(level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(type));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length, true, release, context);
+    }
+
+    void LogHexPinned(LogTypeId typeId, LogLevel level, std::wstring_view description, const char* data, size_t length,
+        LogHexRelease release, void* context) {
+        if (!filter.MayPass(level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length, true, release, context);
+    }
+
+    // description이 UTF-8인 LogHexPinned
+    void LogHexPinned(std::string_view type, LogLevel level, std::string_view description, const char* data, size_t length,
+        LogHexRelease release, void* context) {
+        if (!filter.MayPass(level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeRegistry.Register(WideTypeName(type)));
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length, true, release, context);
+    }
+
+    void LogHexPinned(LogTypeId typeId, LogLevel level, std::string_view description, const char* data, size_t length,
+        LogHexRelease release, void* context) {
+        if (!filter.MayPass(level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogTypeSink* sink = typeRegistry.GetSink(typeId);
+        if (sink == nullptr || !filter.Passes(sink->id, level)) {
+            ReleasePinned(data, release, context);
+            return;
+        }
+
+        LogHex(*sink, level, description, data, length, true, release, context);
+    }
+
+private:
+    // 로그 한 건. 모드에 따라 큐 / 스레드 로컬 링 버퍼를 거쳐 writer(collector) 스레드에서 한 줄로 완성된다.
+    struct LogRecord {
+        LogTypeId typeId = INVALID_LOG_TYPE_ID;
+        LogLevel level = LogLevel::LEVEL_DEBUG;
+        LogTimestamp timestamp = 0;     // LogClockNow(). 머리말의 시각이자 스레드 로컬 모드에서 스레드 사이의 순서를 정하는 기준
+        int64_t index = 0;              // 스레드 로컬 모드에서는 collector가 붙인다.
+        uint64_t sequence = 0;          // 스레드 로컬 모드 전용. 스레드가 받은 번호 블록에서 꺼낸 값. timestamp가 같을 때의 순서
+        bool hexDump = false;           // LogHex. text는 설명, hex는 덤프할 바이트이며 인덱스는 없다.
+        LogUtf8String text;             // 포맷된 메시지 또는 LogHex의 설명. UTF-8 (LogBufferPool에서 할당)
+        LogArgBuffer args;              // 지연 포맷할 포맷 문자열과 인자. 비어있지 않다면 text 대신 사용
+        LogHexBytes hex;                // LogHex의 바이트 (복사본 또는 호출한 쪽이 고정해둔 버퍼). 헥스 문자열은 RenderLine에서 만든다.
+    };
+
+    void LogV(LogTypeSink& sink, LogLevel level, const wchar_t* format, va_list args)
+    {
+        const bool sampled = LogStageMetrics::SampleNext();
+        LogRecord record;
+        {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_CAPTURE, sampled);
+
+            // 한 번 늘어난 버퍼는 스레드가 끝날 때까지 그대로 쓴다.
+            static thread_local std::wstring logMessage(FORMAT_BUFFER_CHARS, L'\0');
+
+            for (;;) {
+                va_list attempt;
+                va_copy(attempt, args);
+                const bool formatted = LogPlatform::FormatV(logMessage.data(), logMessage.size(), format, attempt);
+                va_end(attempt);
+
+                if (formatted) {
+                    break;
+                }
+                if (logMessage.size() >= MAX_FORMAT_CHARS) {
+                    // 잘린 메시지는 그대로 남긴다.
+                    truncatedMessages.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                logMessage.resize(logMessage.size() * 2);
+            }
+
+            AppendUtf8(record.text, std::wstring_view(logMessage.data()));
+        }
+        Submit(sink, level, record, sampled);
+    }
+
+    void LogUtf8(LogTypeSink& sink, LogLevel level, std::string_view message)
+    {
+        const bool sampled = LogStageMetrics::SampleNext();
+        LogRecord record;
+        {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_CAPTURE, sampled);
+            AppendValidUtf8(record.text, message);
+        }
+        Submit(sink, level, record, sampled);
+    }
+
+    // UTF-8로 받은 type 이름을 LogTypeRegistry가 찾는 wchar_t 이름으로 바꾼다. 다음 호출 전까지 유효하다.
+    static const std::wstring& WideTypeName(std::string_view type)
+    {
+        static thread_local std::wstring name;
+        name.clear();
+        AppendWide(name, type);
+        return name;
+    }
+
+    // 비동기 / 스레드 로컬 모드라면 출력은 다른 스레드에서 일어난다.
+    bool IsDeferredMode(void) const
+    {
+        return asyncEnabled.load(std::memory_order_relaxed) || threadLocalEnabled.load(std::memory_order_relaxed);
+    }
+
+    // 앞의 메시지와 같다면 수만 세고 false. 다르다면 앞의 메시지의 반복 수를 먼저 남긴다.
+    bool AdmitSiteMessage(LogSite& site, LogTypeSink& sink, LogLevel level, const LogRecord& record)
+    {
+        // 아래에서 남기는 반복 수는 호출 위치와 상관없는 로그다.
+        LogSiteScope::Clear();
+
+        uint64_t repeats = 0;
+        if (!site.AdmitMessage(MessageHash(sink.id, level, record), sink.id, static_cast<int>(level), repeats)) {
+            return false;
+        }
+        if (repeats > 0) {
+            Log(sink.id, level, L"last message repeated %llu times (%hs:%d)", repeats, site.FileName(), site.Line());
+        }
+        return true;
+    }
+
+    // 포맷 문자열과 인자 바이트(또는 완성된 메시지)의 해시. 같은 메시지인지 비교할 때 쓴다.
+    static uint64_t MessageHash(LogTypeId typeId, LogLevel level, const LogRecord& record)
+    {
+        const std::string_view bytes = record.args.Empty()
+            ? std::string_view(record.text.data(), record.text.size())
+            : std::string_view(reinterpret_cast<const char*>(record.args.Data()), record.args.Size());
+
+        uint64_t hash = std::hash<std::string_view>()(bytes);
+        if (record.hexDump) {
+            // LogHex는 설명이 같아도 덤프한 바이트가 다르면 다른 메시지다.
+            hash ^= std::hash<std::string_view>()(std::string_view(record.hex.Head(), record.hex.HeadBytes())) * 0x165667B19E3779F9ull;
+            hash ^= std::hash<std::string_view>()(std::string_view(record.hex.Tail(), record.hex.TailBytes())) + record.hex.TotalBytes();
+        }
+        hash ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(record.args.Format())) * 0x9E3779B97F4A7C15ull;
+        hash ^= ((static_cast<uint64_t>(typeId) << 8) | static_cast<uint64_t>(level)) * 0xC2B2AE3D27D4EB4Full;
+        return hash | 1;
+    }
+
+    // 로그 한 건을 현재 모드에 맞게 넘긴다. record에는 args(지연 포맷) 또는 text(포맷된 메시지 / 완성된 줄)가 채워져 있어야 한다.
+    // 큐나 링 버퍼에 들어간 경우 record의 내용은 옮겨진다.
+    // sampled : 이 로그의 구간 사이클을 잴지 (LogStageMetrics::SampleNext)
+    void Submit(LogTypeSink& sink, LogLevel level, LogRecord& record, bool sampled)
+    {
+        // 반복 줄이기가 켜진 LOG 호출 위치 (LOG_DEDUP)
+        if (LogSite* site = LogSite::Current()) {
+            if (!AdmitSiteMessage(*site, sink, level, record)) {
+                return;
+            }
+        }
+
+        // 재지 않는 로그(대부분)에는 구간마다의 확인도 남지 않도록 따로 만든다.
+        if (sampled) {
+            SubmitRecord<true>(sink, level, record);
+        }
+        else {
+            SubmitRecord<false>(sink, level, record);
+        }
+    }
+
+    template <bool Sampled>
+    void SubmitRecord(LogTypeSink& sink, LogLevel level, LogRecord& record)
+    {
+        record.typeId = sink.id;
+        record.level = level;
+
+        // 스레드 로컬 모드라면 시간과 인덱스는 collector가 붙인다.
+        if (TryPushThreadLocal(record, Sampled)) {
+            return;
+        }
+
+        record.timestamp = LogClockNow();
+        if (!record.hexDump) {
+            record.index = logIndex.fetch_add(1) + 1;
+        }
+
+        // 비동기 모드라면 큐에 넣고 바로 반환
+        if (TryEnqueue(record, Sampled)) {
+            return;
+        }
+
+        const bool flushNow = level >= flushLevel;
+
+        // 바이너리는 인자가 남아있을 때(포맷 전에) 기록한다.
+        if (WritesBinary()) {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_BINARY_WRITE, Sampled);
+            WriteBinary(sink, record, flushNow);
+        }
+
+        // 텍스트 파일도 콘솔도 추가 출력 대상도 없다면 메시지를 만들 필요가 없다.
+        const bool rendersLine = WritesText() || console.IsEnabled(level);
+        if (!rendersLine && sinks.Empty()) {
+            typeCounters.Add(sink.id, level, PayloadBytes(record));
+            return;
+        }
+
+        std::string_view message = MessageText(record, Sampled);
+        std::string_view text = rendersLine ? RenderLine(record, message, Sampled) : std::string_view();
+        if (!sinks.Empty()) {
+            PublishToSinks(sink, record, message, text, Sampled);
+        }
+        if (!rendersLine) {
+            typeCounters.Add(sink.id, level, PayloadBytes(record));
+            return;
+        }
+
+        // 파일에 기록 (같은 type의 기록은 LogFile 내부의 lock으로 직렬화된다. LogMappedFile은 잠금 없이 자리만 나눠 잡는다)
+        if (WritesText()) {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_TEXT_WRITE, Sampled);
+            WriteText(sink, record.timestamp, text, 1, flushNow);
+        }
+        typeCounters.Add(sink.id, level, WritesText() ? text.size() : PayloadBytes(record));
+
+        // 콘솔 버퍼에 넣기만 한다.
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_CONSOLE, Sampled);
+        console.Submit(sink, level, record.timestamp, text, MessageOffset(record, text, message));
+    }
+
+    // 추가 출력 대상에 나눠준다. 받을 싱크들이 쓰는 형식만 한 번씩 만든다.
+    // line : 이미 만든 줄 (type 별 파일 / 콘솔에 쓸 것). 비어있고 FORMAT_LINE이 필요하면 여기서 만든다.
+    void PublishToSinks(const LogTypeSink& sink, const LogRecord& record, std::string_view message, std::string_view line, bool sampled)
+    {
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_SINKS, sampled);
+        sinks.Publish(sink, record.level, [&](LogSinkRecord& shared, LogSinkFormatMask formats) {
+            shared.timestamp = record.timestamp;
+            shared.index = record.hexDump ? 0 : record.index;
+            shared.hexDump = record.hexDump;
+
+            if (formats & LogSinkFormatBit(LogSinkFormat::FORMAT_LINE)) {
+                shared.text[static_cast<size_t>(LogSinkFormat::FORMAT_LINE)] = line.empty() ? RenderLine(record, message, sampled) : line;
+            }
+
+            if (formats & LogSinkFormatBit(LogSinkFormat::FORMAT_MESSAGE)) {
+                LogUtf8String& text = shared.text[static_cast<size_t>(LogSinkFormat::FORMAT_MESSAGE)];
+                text = message;
+                if (record.hexDump) {
+                    text += '\n';
+                    record.hex.AppendDump(text);
+                    if (!text.empty() && text.back() == '\n') {
+                        text.pop_back();
+                    }
+                }
+            }
+        });
+    }
+
+    // 텍스트를 쓰지 않을 때 LogTypeCounterTable에 남기는 바이트
+    static size_t PayloadBytes(const LogRecord& record)
+    {
+        return record.args.Empty() ? record.text.size() + record.hex.KeptBytes() : record.args.Size();
+    }
+
+    // 콘솔이 반복을 비교할 메시지의 위치. LogHex(완성된 줄)는 비교하지 않는다.
+    static size_t MessageOffset(const LogRecord& record, std::string_view line, std::string_view message)
+    {
+        return record.hexDump ? LogConsoleSink::NO_MESSAGE : line.size() - message.size() - 1;
+    }
+
+    // records : text에 담긴 로그 수 (비동기 모드는 type 별로 모은 여러 건을 한 번에 쓴다)
+    void WriteText(LogTypeSink& sink, LogTimestamp timestamp, std::string_view text, size_t records, bool flushNow)
+    {
+        if (fileWriter == LogFileWriter::WRITER_MAPPED) {
+            sink.mappedFile.Write(GetLogFileName(sink, timestamp), text.data(), text.size(), records, flushNow, flushPolicy, sink.rotation);
+        }
+        else {
+            sink.file.Write(GetLogFileName(sink, timestamp), text.data(), text.size(), records, flushNow, flushPolicy, sink.rotation);
+        }
+    }
+
+    // 보관 기준을 적용할 때 지우면 안 되는 파일 (archiver 스레드에서 호출)
+    void CollectActiveFiles(std::vector<std::wstring>& files)
+    {
+        for (size_t id = 0; id < typeRegistry.Count(); ++id) {
+            LogTypeSink* sink = typeRegistry.GetSink(static_cast<LogTypeId>(id));
+            for (std::wstring fileName : { sink->file.GetFileName(), sink->mappedFile.GetFileName(), sink->binaryFile.GetFileName() }) {
+                if (!fileName.empty()) {
+                    files.push_back(std::move(fileName));
+                }
+            }
+        }
+    }
+
+    bool WritesText(void) const { return fileFormat != LogFileFormat::FORMAT_BINARY; }
+    bool WritesBinary(void) const { return fileFormat != LogFileFormat::FORMAT_TEXT; }
+
+    // 로그 한 건을 type의 바이너리 파일에 기록한다. 지연 포맷된 로그는 포맷 id와 인자 바이트를 그대로 남긴다.
+    void WriteBinary(LogTypeSink& sink, const LogRecord& record, bool flushNow)
+    {
+        LogBinaryEntry entry;
+        entry.level = static_cast<uint8_t>(record.level);
+        entry.index = record.index;
+        entry.timestamp = record.timestamp;
+
+        if (!record.args.Empty()) {
+            entry.format = record.args.Format();
+            entry.formatId = formatIds.GetId(entry.format);
+            entry.args = record.args.Data();
+            entry.argBytes = record.args.Size();
+        }
+        else {
+            entry.text = record.text;
+            entry.hex = record.hexDump ? &record.hex : nullptr;
+        }
+
+        sink.binaryFile.Write(GetLogFileName(sink, record.timestamp, true), sink.name, microTimestamp, entry, flushNow, flushPolicy, sink.rotation);
+    }
+
+    // 로그의 UTF-8 메시지. 지연 포맷된 로그라면 인자로 만들며, 이 스레드에서 다음 MessageText를 부르기 전까지 유효하다.
+    std::string_view MessageText(const LogRecord& record, bool sampled)
+    {
+        if (record.args.Empty()) {
+            return record.text;
+        }
+
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_FORMAT, sampled);
+        static thread_local std::wstring wideMessage;
+        static thread_local std::string message;
+        wideMessage.clear();
+        FormatLogArgs(record.args.Format(), record.args, wideMessage);
+        message.clear();
+        AppendUtf8(message, wideMessage);
+        return message;
+    }
+
+    // 출력할 한 줄을 완성한다. writer / collector 스레드에서는 여기서 포맷이 일어난다.
+    // 결과는 이 스레드에서 다음 RenderLine을 부르기 전까지 유효하다. (스레드마다 버퍼 하나를 재사용)
+    std::string_view RenderLine(const LogRecord& record, std::string_view message, bool sampled)
+    {
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_RENDER, sampled);
+        static thread_local std::string line;
+        line.clear();
+
+        // LogHex는 설명 줄 뒤에 헥스 덤프 (HexDump.h). 바이트는 부호 없는 값으로 출력된다.
+        if (record.hexDump) {
+            AppendLogHexHeader(line, typeRegistry.GetSink(record.typeId)->utf8Name, record.timestamp, record.level, microTimestamp,
+                std::string_view(record.text), RenderTimestampCache());
+            record.hex.AppendDump(line);
+            return line;
+        }
+
+        AppendLogLine(line, typeRegistry.GetSink(record.typeId)->utf8Name, record.timestamp, record.level, microTimestamp,
+            record.index, message, RenderTimestampCache());
+        return line;
+    }
+
+    // 머리말의 시각 문자열 캐시. 스레드마다 하나
+    static LogTimestampCache& RenderTimestampCache(void)
+    {
+        static thread_local LogTimestampCache timestampCache;
+        return timestampCache;
+    }
+
+    static void AppendHexDescription(LogUtf8String& text, std::wstring_view description) { AppendUtf8(text, description); }
+    static void AppendHexDescription(LogUtf8String& text, std::string_view description) { AppendValidUtf8(text, description); }
+
+    // 걸러진 LogHexPinned의 버퍼를 바로 돌려준다.
+    static void ReleasePinned(const char* data, LogHexRelease release, void* context)
+    {
+        if (release != nullptr) {
+            release(context, data);
+        }
+    }
+
+    // Description은 std::wstring_view 또는 UTF-8 std::string_view
+    // 설명과 바이트만 담아서 넘기며, 헥스 문자열은 줄을 만들 때(RenderLine) 만든다. 바이너리 파일에는 바이트 그대로 남는다.
+    // pinned라면 data를 복사하지 않고 가리키며, 로그가 없어질 때 release(context, data)를 부른다.
+    template <typename Description>
+    void LogHex(LogTypeSink& sink, LogLevel level, Description description, const char* data, size_t length,
+        bool pinned = false, LogHexRelease release = nullptr, void* context = nullptr) {
+        const bool sampled = LogStageMetrics::SampleNext();
+        LogRecord record;
+        {
+            LogStageTimer timer(stageMetrics, LogStage::STAGE_CAPTURE, sampled);
+
+            // hexMaxBytes를 넘는 버퍼는 앞 / 뒤만 남긴다.
+            size_t headBytes = 0;
+            size_t tailBytes = 0;
+            HexDumpTruncation(length, hexMaxBytes, headBytes, tailBytes);
+
+            AppendHexDescription(record.text, description);
+            if (pinned) {
+                record.hex.Reference(data, length, headBytes, tailBytes, release, context);
+            }
+            else {
+                // 바이트는 다른 스레드(writer / collector)로 넘어갈 수 있으므로 풀에서 받은 메모리에 복사한다.
+                record.hex.Copy(data, length, headBytes, tailBytes);
+            }
+            record.hexDump = true;
+        }
+        Submit(sink, level, record, sampled);
+    }
+
+private:
+    std::wstring logDirectory;  // 로그가 위치한 경로
+    bool microTimestamp = false;    // 머리말 시각에 마이크로초를 붙일지
+    size_t hexMaxBytes = 64 * 1024; // LogHex가 남길 최대 바이트 (앞 / 뒤)
+    LogFileFormat fileFormat = LogFileFormat::FORMAT_TEXT;  // type 별 로그 파일 형식
+    LogFileWriter fileWriter = LogFileWriter::WRITER_STREAM;    // 텍스트 로그 파일을 쓰는 방식
+    LogArchiver archiver;           // 다 쓴 로그 파일의 압축 / 보관 기준 적용
+    LogFormatIdRegistry formatIds;  // 바이너리 로그의 포맷 문자열 id
+    std::atomic<uint32_t> fileNameGeneration{ 0 };  // logDirectory가 바뀔 때마다 증가. 스레드마다 캐시한 파일 경로를 버리는 기준
+    std::atomic<int64_t> logIndex{ 0 };    // 로그를 기록할 때 마다 1씩 증가하는 값. 이로서 모든 로그가 순서대로 찍힐 수 있음.
+    LogTypeRegistry typeRegistry;   // type 문자열 -> id, type 별 출력 대상(LogTypeSink)
+    LogConsoleSink console;         // 콘솔 출력 (자신의 버퍼와 스레드를 가짐)
+    LogSinkRegistry sinks;          // 추가 출력 대상 (AddSink)
+    LogFilter filter;               // type / 레벨 별로 남길 로그 (기본 레벨 + 설정 파일 + 실행 중에 받은 규칙)
+
+    static constexpr std::wstring_view FILTER_TYPE_NAME = L"LogFilter";        // 필터 설정을 다시 읽은 결과를 남기는 type
+    static constexpr std::chrono::milliseconds FILTER_FILE_POLL_INTERVAL{ 1000 };  // 필터 설정 파일이 바뀌었는지 확인하는 주기
+    std::mutex filterSourceLock;                    // 아래 값들을 보호 (초기화하는 스레드와 maintenance 스레드)
+    LogFilterFileWatcher filterFile;
+    LogControlSocket controlSocket;
+    LogTypeId filterTypeId = INVALID_LOG_TYPE_ID;
+    std::chrono::steady_clock::time_point lastFilterFilePoll;
+
+    static constexpr std::wstring_view CRASH_TYPE_NAME = L"Crash";              // 비상 파일에서 크래시 원인과 헥스 덤프의 type
+    static constexpr std::chrono::milliseconds CRASH_PARK_WAIT{ 200 };         // 크래시 때 writer / collector 스레드가 멈추기를 기다리는 최대 시간
+
+    LogEmergencyFile emergencyFile;                 // 크래시 때 남은 로그를 쓰는 파일 (InitializeCrashHandler)
+    LogCrashRegion crashRegion;                     // 크래시 때 헥스 덤프로 남길 메모리
+    std::atomic<bool> crashing{ false };            // 크래시 핸들러가 남은 로그를 모으는 중. writer / collector 스레드는 다음 차례에 멈춘다.
+    std::atomic<bool> writerParked{ false };
+    std::atomic<bool> collectorParked{ false };
+
+    static constexpr size_t FORMAT_BUFFER_CHARS = 512;                          // LogV가 처음 포맷해보는 버퍼 크기 (wchar_t 수)
+    static constexpr size_t MAX_FORMAT_CHARS = 64 * 1024;                       // LogV 메시지의 최대 길이. 넘는 부분은 잘린다.
+    static constexpr size_t WRITER_BATCH_SIZE = 256;                            // writer 스레드가 한 번에 꺼내서 기록하는 최대 로그 수
+    static constexpr std::chrono::milliseconds WRITER_IDLE_WAIT{ 50 };          // 큐가 비어있을 때 writer 스레드의 최대 대기 시간
+    static constexpr std::chrono::milliseconds BLOCKED_PRODUCER_WAIT{ 5 };      // POLICY_BLOCK 생산자가 깨우기를 기다리는 최대 시간. 지나면 큐를 다시 확인
+
+    std::atomic<bool> asyncEnabled{ false };                    // 비동기 모드 여부
+    QueueFullPolicy fullPolicy = QueueFullPolicy::POLICY_BLOCK; // 큐가 가득 찼을 때의 처리 방식
+    std::unique_ptr<BoundedLogQueue<LogRecord>> logQueue;       // 게임 스레드 -> writer 스레드로 로그를 넘기는 큐
+    std::thread writerThread;
+    std::vector<LogRecord> writerBatch;                         // writer 스레드 전용. 큐에서 꺼내서 기록 중인 로그
+
+    std::mutex writerMutex;                         // 아래 condition_variable 들을 위한 mutex
+    std::condition_variable writerWakeup;           // 큐가 비어서 잠든 writer 스레드를 깨움
+    std::condition_variable queueNotFull;           // 큐가 가득 차서 대기중인 생산자를 깨움
+    bool writerRunning = false;                     // writerMutex로 보호
+    std::atomic<bool> writerSleeping{ false };
+    std::atomic<int> blockedProducers{ 0 };         // POLICY_BLOCK으로 대기중인 생산자 수
+    std::atomic<int> activeProducers{ 0 };          // 비동기 경로에서 큐에 넣는 중인 생산자 수
+
+    std::atomic<int64_t> droppedCount{ 0 };
+    std::atomic<int64_t> overwrittenCount{ 0 };
+    std::atomic<uint64_t> truncatedMessages{ 0 };   // LogV에서 MAX_FORMAT_CHARS를 넘어 잘린 메시지
+
+    LogStageMetrics stageMetrics;                   // 구간 별 사이클 (GetLoggerStats)
+    LogTypeCounterTable typeCounters{ LogTypeRegistry::MAX_TYPES };     // type / 레벨 별 기록 수와 바이트
+    std::atomic<uint64_t> queueDepth{ 0 };          // writer / collector가 마지막으로 본 기록 대기 로그 수
+    std::atomic<uint64_t> peakQueueDepth{ 0 };
+
+    static constexpr std::wstring_view STATS_TYPE_NAME = L"LoggerStats";       // InitializeStatsLog의 type
+    LogTypeId statsTypeId = INVALID_LOG_TYPE_ID;
+    std::chrono::milliseconds statsLogInterval{ 0 };                            // 0이면 남기지 않음
+    LoggerStatsSnapshot lastStatsSnapshot;                                      // maintenance 스레드 전용
+
+    // writer 스레드 전용. type 별로 한 배치 동안 모은 로그 (type id로 접근)
+    struct PendingFileText {
+        std::string text;
+        size_t records = 0;             // text에 담긴 로그 수 (LogRotationPolicy::maxRecords)
+        bool flushNow = false;
+        LogTimestamp timestamp = 0;     // 마지막 로그의 시각. 파일 이름(기간)을 정하는 기준
+    };
+    std::vector<PendingFileText> pendingFileText;
+    std::vector<LogTypeId> pendingTypes;          // 이번 배치에서 로그가 있는 type
+
+    // 스레드 하나가 가진 링 버퍼. 스레드가 끝나면 retired가 되고, collector가 다 비운 뒤 목록에서 뺀다.
+    struct ThreadLogBuffer {
+        explicit ThreadLogBuffer(size_t capacity) : ring(capacity) {}
+
+        static constexpr uint64_t NOT_PENDING = UINT64_MAX;
+        static constexpr uint64_t PENDING_BUSY = UINT64_MAX - 1;
+
+        SpscRing<LogRecord> ring;
+        std::atomic<bool> writing{ false };     // 생산자가 링 버퍼에 넣는 중. ShutdownThreadLocal이 기다린다.
+        std::atomic<bool> retired{ false };
+        std::atomic<uint64_t> pendingTimestamp{ NOT_PENDING };  // 넣는 중인 로그의 시각. 시각을 읽기 전에는 PENDING_BUSY
+    };
+
+    // 각 스레드가 thread_local로 들고 있는 핸들
+    struct ThreadLogHandle {
+        std::shared_ptr<ThreadLogBuffer> buffer;
+        uint32_t generation = 0;
+        SequenceBlockAllocator::ThreadBlock sequenceBlock;
+
+        ~ThreadLogHandle(void)
+        {
+            if (buffer) {
+                buffer->retired.store(true);
+            }
+        }
+    };
+
+    static constexpr std::chrono::milliseconds COLLECT_INTERVAL{ 5 };      // collector 스레드가 링 버퍼를 확인하는 주기
+    static constexpr std::chrono::milliseconds MERGE_WINDOW{ 10 };         // 이보다 최근의 로그는 다른 스레드의 로그가 더 들어올 수 있으므로 다음 차례에 기록
+
+    std::atomic<bool> threadLocalEnabled{ false };                  // 스레드 로컬 모드 여부
+    size_t threadRingCapacity = 0;
+    QueueFullPolicy threadRingPolicy = QueueFullPolicy::POLICY_BLOCK;
+    std::atomic<uint32_t> threadBufferGeneration{ 1 };              // 모드를 다시 시작하면 증가. 이전 버퍼를 가진 스레드는 새 버퍼를 받는다.
+    SequenceBlockAllocator sequenceAllocator;
+
+    std::mutex threadBuffersLock;
+    std::vector<std::shared_ptr<ThreadLogBuffer>> threadBuffers;    // threadBuffersLock으로 보호
+
+    std::thread collectorThread;
+    std::mutex collectorMutex;
+    std::condition_variable collectorWakeup;
+    bool collectorRunning = false;                                  // collectorMutex로 보호
+    bool collectRequested = false;                                  // collectorMutex로 보호. 링 버퍼가 가득 찬 생산자가 바로 비워달라고 요청
+    std::condition_variable ringNotFull;                            // 링 버퍼가 가득 차서 대기중인 생산자를 깨움
+    std::atomic<int> blockedRingProducers{ 0 };                     // 링 버퍼가 가득 차서 대기중인 생산자 수
+    uint64_t collectorCutoff = 0;                                   // collector 스레드 전용. 지금까지 기록한 로그의 시각 상한
+    std::vector<LogRecord> collectorStaging;                          // collector 스레드 전용. 아직 기록하지 않은 로그
+    std::vector<std::shared_ptr<ThreadLogBuffer>> collectorBuffers;   // collector 스레드 전용. 이번에 비울 버퍼 목록
+    std::vector<LogRecord> collectorBatch;                            // collector 스레드 전용. WriteBatch로 넘길 로그
+
+    static constexpr std::chrono::milliseconds MAINTENANCE_INTERVAL{ 100 };    // 시간 기준 플러시 / 유휴 파일 정리 주기
+
+    LogFlushPolicy flushPolicy;
+    LogLevel flushLevel = LogLevel::LEVEL_ERROR;                // 이 레벨 이상의 로그는 바로 파일에 기록
+    std::chrono::milliseconds fileIdleTimeout{ 60 * 1000 };     // 이 시간 동안 쓰이지 않은 파일은 닫음
+
+    std::thread maintenanceThread;                  // 시간 기준 플러시, 유휴 파일 닫기 담당
+    std::mutex maintenanceMutex;
+    std::condition_variable maintenanceWakeup;
+    bool maintenanceRunning = false;                // maintenanceMutex로 보호
+
+
+
+    SystemLogManager() : console(typeRegistry), filter(typeRegistry)
+    {
+        console.Start(LogConsolePolicy());
+    }
+
+    void StartMaintenance(void)
+    {
+        std::lock_guard<std::mutex> lock(maintenanceMutex);
+        if (maintenanceRunning) {
+            return;
+        }
+
+        maintenanceRunning = true;
+        maintenanceThread = std::thread(&SystemLogManager::MaintenanceThreadProc, this);
+    }
+
+    void StopMaintenance(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(maintenanceMutex);
+            if (!maintenanceRunning) {
+                return;
+            }
+            maintenanceRunning = false;
+        }
+
+        maintenanceWakeup.notify_one();
+        maintenanceThread.join();
+    }
+
+    void MaintenanceThreadProc(void)
+    {
+        std::vector<LogFile*> files;
+        std::vector<LogMappedFile*> mappedFiles;
+        std::vector<LogBinaryFile*> binaryFiles;
+        // type이 늘어도 목록이 자라지 않도록 (돌 때마다 할당하지 않음)
+        files.reserve(LogTypeRegistry::MAX_TYPES);
+        mappedFiles.reserve(LogTypeRegistry::MAX_TYPES);
+        binaryFiles.reserve(LogTypeRegistry::MAX_TYPES);
+
+        std::unique_lock<std::mutex> lock(maintenanceMutex);
+        while (maintenanceRunning) {
+            maintenanceWakeup.wait_for(lock, MAINTENANCE_INTERVAL, [&] { return !maintenanceRunning; });
+
+            lock.unlock();
+
+            files.clear();
+            mappedFiles.clear();
+            binaryFiles.clear();
+            for (size_t id = 0; id < typeRegistry.Count(); ++id) {
+                files.push_back(&typeRegistry.GetSink(static_cast<LogTypeId>(id))->file);
+                mappedFiles.push_back(&typeRegistry.GetSink(static_cast<LogTypeId>(id))->mappedFile);
+                binaryFiles.push_back(&typeRegistry.GetSink(static_cast<LogTypeId>(id))->binaryFile);
+            }
+            MaintainLogFiles(files, flushPolicy, fileIdleTimeout);
+            MaintainLogFiles(mappedFiles, flushPolicy, fileIdleTimeout);
+            MaintainLogFiles(binaryFiles, flushPolicy, fileIdleTimeout);
+            typeRegistry.GetOpenFileCache().Trim();
+            sinks.Maintain();
+
+            if (statsLogInterval.count() > 0 && std::chrono::steady_clock::now() - lastStatsSnapshot.time >= statsLogInterval) {
+                WriteStatsLog();
+            }
+
+            PollFilterSources();
+            FlushSiteRepeats();
+
+            lock.lock();
+        }
+    }
+
+    // 스레드 로컬 모드라면 로그를 이 스레드의 링 버퍼에 넣고 true를 반환한다. (POLICY_DROP으로 버려진 경우 포함)
+    bool TryPushThreadLocal(LogRecord& record, bool sampled)
+    {
+        if (!threadLocalEnabled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        static thread_local ThreadLogHandle handle;
+
+        if (!handle.buffer || handle.generation != threadBufferGeneration.load(std::memory_order_relaxed)) {
+            if (!AttachThreadBuffer(handle)) {
+                return false;
+            }
+        }
+
+        ThreadLogBuffer& buffer = *handle.buffer;
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_ENQUEUE, sampled);
+
+        // ShutdownThreadLocal과 경합한 경우 동기 출력으로 넘긴다.
+        buffer.writing.store(true);
+        if (!threadLocalEnabled.load()) {
+            buffer.writing.store(false);
+            return false;
+        }
+
+        // 시각을 읽기 전에 넣는 중임을 먼저 알린다. collector는 이 값을 보고 아직 링 버퍼에 없는 로그보다 늦은 로그를 기록하지 않는다.
+        buffer.pendingTimestamp.store(ThreadLogBuffer::PENDING_BUSY);
+        record.timestamp = LogClockNow();
+        buffer.pendingTimestamp.store(record.timestamp, std::memory_order_release);
+        record.sequence = sequenceAllocator.Next(handle.sequenceBlock);
+
+        while (!buffer.ring.TryPush(std::move(record))) {
+            if (threadRingPolicy != QueueFullPolicy::POLICY_BLOCK) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+
+            // collector에게 바로 비워달라고 하고 잠깐씩 기다린다. 깨우는 신호를 놓쳐도 BLOCKED_PRODUCER_WAIT 뒤에 다시 넣어본다.
+            std::unique_lock<std::mutex> lock(collectorMutex);
+            blockedRingProducers.fetch_add(1);
+            collectRequested = true;
+            collectorWakeup.notify_one();
+            ringNotFull.wait_for(lock, BLOCKED_PRODUCER_WAIT);
+            blockedRingProducers.fetch_sub(1);
+        }
+
+        buffer.pendingTimestamp.store(ThreadLogBuffer::NOT_PENDING, std::memory_order_release);
+        buffer.writing.store(false, std::memory_order_release);
+        return true;
+    }
+
+    bool AttachThreadBuffer(ThreadLogHandle& handle)
+    {
+        std::lock_guard<std::mutex> guard(threadBuffersLock);
+        if (!threadLocalEnabled.load()) {
+            return false;
+        }
+
+        if (handle.buffer) {
+            handle.buffer->retired.store(true);
+        }
+
+        handle.buffer = std::make_shared<ThreadLogBuffer>(threadRingCapacity);
+        handle.generation = threadBufferGeneration.load();
+        threadBuffers.push_back(handle.buffer);
+        return true;
+    }
+
+    void CollectorThreadProc(void)
+    {
+        std::unique_lock<std::mutex> lock(collectorMutex);
+        while (collectorRunning) {
+            lock.unlock();
+            if (crashing.load(std::memory_order_relaxed)) {
+                ParkForCrash(collectorParked);
+            }
+            CollectThreadBuffers(false);
+            lock.lock();
+
+            collectorWakeup.wait_for(lock, COLLECT_INTERVAL, [&] { return !collectorRunning || collectRequested; });
+            collectRequested = false;
+        }
+        lock.unlock();
+
+        // 종료 시에는 기다리지 않고 남은 로그를 모두 기록
+        CollectThreadBuffers(true);
+    }
+
+    // 모든 스레드의 링 버퍼를 비우고, (timestamp, sequence) 순으로 정렬해서 기록한다.
+    // drainAll이 false라면 MERGE_WINDOW보다 최근의 로그와, 아직 링 버퍼에 넣는 중인 로그보다 늦은 로그는 다음 차례로 남겨둔다.
+    // (넣는 중인 로그가 시각을 받은 뒤 오래 멈춰있어도 그보다 늦은 로그가 먼저 인덱스를 받지 않게 하기 위함)
+    void CollectThreadBuffers(bool drainAll)
+    {
+        // 시각은 버퍼 목록보다 먼저 읽는다. 목록에 없는 버퍼(이후에 붙은 스레드)의 로그는 이 시각보다 늦다.
+        uint64_t cutoff = UINT64_MAX;
+        if (!drainAll) {
+            cutoff = LogClockNow() - static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(MERGE_WINDOW).count());
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(threadBuffersLock);
+            collectorBuffers = threadBuffers;
+        }
+
+        // 넣는 중인 로그는 링 버퍼를 비우기 전에 확인한다. 여기서 못 본 로그는 비울 때 링 버퍼에 있거나, 위의 시각보다 늦다.
+        // 시각을 읽기 전(PENDING_BUSY)이라면 그 로그의 시각은 지난번 상한보다 늦다는 것만 알 수 있다.
+        if (!drainAll) {
+            for (auto& buffer : collectorBuffers) {
+                const uint64_t pending = buffer->pendingTimestamp.load();
+                if (pending == ThreadLogBuffer::PENDING_BUSY) {
+                    cutoff = std::min(cutoff, collectorCutoff);
+                }
+                else if (pending != ThreadLogBuffer::NOT_PENDING) {
+                    cutoff = std::min(cutoff, pending - 1);
+                }
+            }
+            collectorCutoff = std::max(collectorCutoff, cutoff);
+        }
+
+        LogRecord record;
+        for (auto& buffer : collectorBuffers) {
+            while (buffer->ring.TryPop(record)) {
+                collectorStaging.push_back(std::move(record));
+            }
+        }
+        collectorBuffers.clear();
+        ObserveQueueDepth(collectorStaging.size());
+
+        // 자리가 났으니 링 버퍼가 가득 차서 대기중인 생산자를 깨운다.
+        if (blockedRingProducers.load() > 0) {
+            std::lock_guard<std::mutex> lock(collectorMutex);
+            ringNotFull.notify_all();
+        }
+
+        // 스레드가 끝났고 다 비운 버퍼는 목록에서 뺀다.
+        {
+            std::lock_guard<std::mutex> guard(threadBuffersLock);
+            std::erase_if(threadBuffers, [](const auto& buffer) { return buffer->retired.load() && buffer->ring.Empty(); });
+        }
+
+        if (collectorStaging.empty()) {
+            return;
+        }
+
+        std::sort(collectorStaging.begin(), collectorStaging.end(), [](const LogRecord& lhs, const LogRecord& rhs) {
+            return lhs.timestamp != rhs.timestamp ? lhs.timestamp < rhs.timestamp : lhs.sequence < rhs.sequence;
+        });
+
+        std::vector<LogRecord>& batch = collectorBatch;
+        size_t emitted = 0;
+        for (; emitted < collectorStaging.size() && collectorStaging[emitted].timestamp <= cutoff; ++emitted) {
+            LogRecord& staged = collectorStaging[emitted];
+
+            // 정렬된 순서대로 인덱스를 붙인다. 메시지 포맷은 WriteBatch에서 한다.
+            if (!staged.hexDump) {
+                staged.index = logIndex.fetch_add(1) + 1;
+            }
+
+            batch.push_back(std::move(staged));
+            if (batch.size() == WRITER_BATCH_SIZE) {
+                WriteBatch(batch);
+                batch.clear();
+            }
+        }
+
+        if (!batch.empty()) {
+            WriteBatch(batch);
+            batch.clear();
+        }
+
+        collectorStaging.erase(collectorStaging.begin(), collectorStaging.begin() + emitted);
+    }
+
+    // 비동기 모드라면 로그를 큐에 넣고 true를 반환한다. (POLICY_DROP으로 버려진 경우 포함)
+    // 동기 모드라면 false를 반환하고, 호출한 쪽에서 직접 출력한다.
+    bool TryEnqueue(LogRecord& record, bool sampled)
+    {
+        if (!asyncEnabled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        LogStageTimer timer(stageMetrics, LogStage::STAGE_ENQUEUE, sampled);
+        activeProducers.fetch_add(1);
+
+        // ShutdownAsync와 경합한 경우 동기 출력으로 넘긴다.
+        if (!asyncEnabled.load()) {
+            activeProducers.fetch_sub(1);
+            return false;
+        }
+
+        if (!logQueue->TryPush(std::move(record))) {
+            switch (fullPolicy) {
+            case QueueFullPolicy::POLICY_DROP:
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                break;
+
+            case QueueFullPolicy::POLICY_OVERWRITE_OLDEST:
+                do {
+                    LogRecord oldest;
+                    if (logQueue->TryPop(oldest)) {
+                        overwrittenCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                } while (!logQueue->TryPush(std::move(record)));
+                break;
+
+            case QueueFullPolicy::POLICY_BLOCK:
+            default:
+            {
+                std::unique_lock<std::mutex> lock(writerMutex);
+                blockedProducers.fetch_add(1);
+                // writer가 blockedProducers를 보기 전에 자리를 비웠다면 깨우는 신호를 놓친다. 잠깐씩만 기다리고 다시 넣어본다.
+                while (!queueNotFull.wait_for(lock, BLOCKED_PRODUCER_WAIT, [&] { return logQueue->TryPush(std::move(record)); })) {
+                    writerWakeup.notify_one();
+                }
+                blockedProducers.fetch_sub(1);
+                break;
+            }
+            }
+        }
+
+        if (writerSleeping.load()) {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writerWakeup.notify_one();
+        }
+
+        activeProducers.fetch_sub(1);
+        return true;
+    }
+
+    void WriterThreadProc(void)
+    {
+        std::vector<LogRecord>& batch = writerBatch;
+        batch.reserve(WRITER_BATCH_SIZE);
+
+        for (;;) {
+            if (crashing.load(std::memory_order_relaxed)) {
+                ParkForCrash(writerParked);
+            }
+
+            ObserveQueueDepth(logQueue->ApproxSize());
+
+            LogRecord record;
+            while (batch.size() < WRITER_BATCH_SIZE && logQueue->TryPop(record)) {
+                batch.push_back(std::move(record));
+            }
+
+            if (!batch.empty()) {
+                // 자리가 났으니 대기중인 생산자를 깨운다.
+                if (blockedProducers.load() > 0) {
+                    std::lock_guard<std::mutex> lock(writerMutex);
+                    queueNotFull.notify_all();
+                }
+
+                WriteBatch(batch);
+                batch.clear();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(writerMutex);
+            if (!writerRunning && logQueue->Empty()) {
+                break;
+            }
+
+            writerSleeping.store(true);
+            writerWakeup.wait_for(lock, WRITER_IDLE_WAIT, [&] { return !writerRunning || !logQueue->Empty(); });
+            writerSleeping.store(false);
+        }
+    }
+
+    // 한 배치의 로그를 파일에는 type 별로 한 번씩 기록하고, 콘솔 버퍼에는 한 줄씩 넣는다.
+    void WriteBatch(std::vector<LogRecord>& batch)
+    {
+        for (auto& record : batch) {
+            LogTypeSink& sink = *typeRegistry.GetSink(record.typeId);
+            const bool flushNow = record.level >= flushLevel;
+            const bool sampled = LogStageMetrics::SampleNext();
+
+            // 바이너리는 인자가 남아있을 때(RenderLine에서 포맷하기 전에) 기록한다.
+            if (WritesBinary()) {
+                LogStageTimer timer(stageMetrics, LogStage::STAGE_BINARY_WRITE, sampled);
+                WriteBinary(sink, record, flushNow);
+            }
+
+            const bool rendersLine = WritesText() || console.IsEnabled(record.level);
+            if (!rendersLine && sinks.Empty()) {
+                typeCounters.Add(record.typeId, record.level, PayloadBytes(record));
+                continue;
+            }
+
+            std::string_view message = MessageText(record, sampled);
+            std::string_view line = rendersLine ? RenderLine(record, message, sampled) : std::string_view();
+            if (!sinks.Empty()) {
+                PublishToSinks(sink, record, message, line, sampled);
+            }
+            if (!rendersLine) {
+                typeCounters.Add(record.typeId, record.level, PayloadBytes(record));
+                continue;
+            }
+            typeCounters.Add(record.typeId, record.level, WritesText() ? line.size() : PayloadBytes(record));
+            {
+                LogStageTimer timer(stageMetrics, LogStage::STAGE_CONSOLE, sampled);
+                console.Submit(sink, record.level, record.timestamp, line, MessageOffset(record, line, message));
+            }
+
+            if (!WritesText()) {
+                continue;
+            }
+
+            if (record.typeId >= pendingFileText.size()) {
+                pendingFileText.resize(record.typeId + 1);
+            }
+
+            PendingFileText& pending = pendingFileText[record.typeId];
+            if (pending.text.empty()) {
+                pendingTypes.push_back(record.typeId);
+            }
+            pending.text += line;
+            pending.records++;
+            pending.timestamp = record.timestamp;
+            pending.flushNow |= flushNow;
+        }
+
+        for (LogTypeId typeId : pendingTypes) {
+            PendingFileText& pending = pendingFileText[typeId];
+            LogTypeSink* sink = typeRegistry.GetSink(typeId);
+
+            {
+                LogStageTimer timer(stageMetrics, LogStage::STAGE_TEXT_WRITE, LogStageMetrics::SampleNext());
+                WriteText(*sink, pending.timestamp, pending.text, pending.records, pending.flushNow);
+            }
+
+            pending.text.clear();
+            pending.records = 0;
+            pending.flushNow = false;
+        }
+        pendingTypes.clear();
+    }
+
+    // writer / collector 스레드가 본 기록 대기 로그 수. (두 스레드는 동시에 돌지 않는다)
+    void ObserveQueueDepth(size_t depth)
+    {
+        if constexpr (LOG_METRICS_ENABLED) {
+            queueDepth.store(depth, std::memory_order_relaxed);
+            if (depth > peakQueueDepth.load(std::memory_order_relaxed)) {
+                peakQueueDepth.store(depth, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 같은 메시지가 더 오지 않아 남지 못한 반복 수를 반복 줄이기 창이 지나면 남긴다. (maintenance 스레드)
+    void FlushSiteRepeats(void)
+    {
+        const LogTimestamp now = LogClockNow();
+        LogSiteRegistry::GetInstance().ForEach([this, now](LogSite& site) {
+            LogTypeId typeId = INVALID_LOG_TYPE_ID;
+            int level = 0;
+            const uint64_t repeats = site.TakeExpiredRepeats(now, typeId, level);
+            if (repeats > 0) {
+                Log(typeId, static_cast<LogLevel>(level), L"last message repeated %llu times (%hs:%d)", repeats, site.FileName(), site.Line());
+            }
+        });
+    }
+
+    // 필터 설정 파일(FILTER_FILE_POLL_INTERVAL마다)과 제어 소켓에 온 규칙을 적용한다. (maintenance 스레드)
+    void PollFilterSources(void)
+    {
+        std::lock_guard<std::mutex> guard(filterSourceLock);
+
+        const auto now = std::chrono::steady_clock::now();
+        if (filterFile.IsWatching() && now - lastFilterFilePoll >= FILTER_FILE_POLL_INTERVAL) {
+            lastFilterFilePoll = now;
+            PollFilterFile();
+        }
+
+        std::string text;
+        while (controlSocket.Poll(text)) {
+            std::string error;
+            if (!ApplyFilterConfig(text, error)) {
+                Log(filterTypeId, LogLevel::LEVEL_SYSTEM, std::string_view("control socket: rules ignored, " + error));
+                continue;
+            }
+            Log(filterTypeId, LogLevel::LEVEL_SYSTEM, L"control socket: %s", filter.Describe());
+        }
+    }
+
+    // 필터 설정 파일이 바뀌었다면 다시 읽는다. 새로 적용했다면 true (filterSourceLock 안에서)
+    bool PollFilterFile(void)
+    {
+        std::string text;
+        if (!filterFile.Poll(text)) {
+            return false;
+        }
+
+        LogFilterConfig config;
+        std::string error;
+        if (!ParseLogFilterConfig(text, config, error)) {
+            Log(filterTypeId, LogLevel::LEVEL_SYSTEM, std::string_view(ToUtf8(filterFile.Path().wstring()) + ": kept the previous rules, " + error));
+            return false;
+        }
+
+        filter.SetFileConfig(config);
+        Log(filterTypeId, LogLevel::LEVEL_SYSTEM, L"%s: %s", filterFile.Path().wstring(), filter.Describe());
+        return true;
+    }
+
+    // 지난 스냅샷 이후의 값을 STATS_TYPE_NAME type으로 남긴다. (maintenance 스레드)
+    void WriteStatsLog(void)
+    {
+        LoggerStatsSnapshot current = GetLoggerStats();
+        if (lastStatsSnapshot.time == std::chrono::steady_clock::time_point{}) {
+            lastStatsSnapshot = std::move(current);
+            return;
+        }
+
+        const LoggerStatsSnapshot& last = lastStatsSnapshot;
+        const double seconds = std::chrono::duration<double>(current.time - last.time).count();
+        auto perSecond = [seconds](uint64_t now, uint64_t before) {
+            return seconds > 0 ? static_cast<uint64_t>(static_cast<double>(now - before) / seconds) : 0;
+        };
+
+        uint64_t records = 0;
+        uint64_t recordsBefore = 0;
+        uint64_t bytes = 0;
+        uint64_t bytesBefore = 0;
+        for (size_t id = 0; id < current.types.size(); ++id) {
+            const LogTypeCounters& counters = current.types[id].counters;
+            const LogTypeCounters before = id < last.types.size() ? last.types[id].counters : LogTypeCounters();
+            for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+                records += counters.records[level];
+                recordsBefore += before.records[level];
+                bytes += counters.bytes[level];
+                bytesBefore += before.bytes[level];
+            }
+        }
+
+        Log(statsTypeId, LogLevel::LEVEL_SYSTEM, L"%llu records/s, %llu bytes/s, queue %llu (peak %llu), dropped %lld, overwritten %lld, truncated %llu, console dropped %llu",
+            perSecond(records, recordsBefore), perSecond(bytes, bytesBefore), current.queueDepth, current.peakQueueDepth,
+            current.droppedRecords - last.droppedRecords, current.overwrittenRecords - last.overwrittenRecords,
+            current.truncatedMessages - last.truncatedMessages, current.consoleDroppedLines - last.consoleDroppedLines);
+
+        // type 별 (이번 간격에 로그가 있었던 type만)
+        for (size_t id = 0; id < current.types.size(); ++id) {
+            const LogTypeStats& type = current.types[id];
+            const LogTypeStats before = id < last.types.size() ? last.types[id] : LogTypeStats();
+
+            uint64_t typeBytes = 0;
+            uint64_t typeBytesBefore = 0;
+            for (size_t level = 0; level < LOG_LEVEL_COUNT; ++level) {
+                typeBytes += type.counters.bytes[level];
+                typeBytesBefore += before.counters.bytes[level];
+            }
+            if (typeBytes == typeBytesBefore && type.counters.records == before.counters.records) {
+                continue;
+            }
+
+            LogWaitStats waits = type.lockWaits;
+            for (size_t bucket = 0; bucket < LOG_WAIT_BUCKETS; ++bucket)
+                waits.buckets[bucket] -= before.lockWaits.buckets[bucket];
+
+            Log(statsTypeId, LogLevel::LEVEL_SYSTEM, L"[%s] DEBUG %llu/s, ERROR %llu/s, SYSTEM %llu/s, %llu bytes/s, lock waited %llu of %llu (p50 %llu, p99 %llu cycles)",
+                type.name,
+                perSecond(type.counters.records[0], before.counters.records[0]),
+                perSecond(type.counters.records[1], before.counters.records[1]),
+                perSecond(type.counters.records[2], before.counters.records[2]),
+                perSecond(typeBytes, typeBytesBefore), waits.Waits(), waits.Acquisitions(), waits.WaitPercentile(0.5), waits.WaitPercentile(0.99));
+        }
+
+        // 구간 별 평균 사이클 (이번 간격에 잰 로그 기준)
+        std::array<uint64_t, LOG_STAGE_COUNT> cycles{};
+        for (size_t stage = 0; stage < LOG_STAGE_COUNT; ++stage) {
+            const uint64_t samples = current.stages[stage].samples - last.stages[stage].samples;
+            cycles[stage] = samples == 0 ? 0 : (current.stages[stage].cycles - last.stages[stage].cycles) / samples;
+        }
+        // 호출 위치 별 (이번 간격에 거른 로그가 있었던 곳만)
+        for (const LogSiteStats& site : current.sites) {
+            LogSiteStats before;
+            for (const LogSiteStats& candidate : last.sites) {
+                if (candidate.label == site.label) {
+                    before = candidate;
+                    break;
+                }
+            }
+            if (site.sampledOut == before.sampledOut && site.rateLimited == before.rateLimited && site.deduplicated == before.deduplicated) {
+                continue;
+            }
+
+            Log(statsTypeId, LogLevel::LEVEL_SYSTEM, L"[%s] passed %llu/s, sampled out %llu/s (1 in %u), rate limited %llu/s (max %u/s), deduplicated %llu/s",
+                site.label, perSecond(site.passed, before.passed), perSecond(site.sampledOut, before.sampledOut), site.policy.sampleEvery,
+                perSecond(site.rateLimited, before.rateLimited), site.policy.maxPerSecond, perSecond(site.deduplicated, before.deduplicated));
+        }
+
+        // 추가 출력 대상 별 (이번 간격에 받은 로그가 있었던 싱크만)
+        for (const LogSinkStats& sinkStats : current.sinks) {
+            LogSinkStats before;
+            for (const LogSinkStats& candidate : last.sinks) {
+                if (candidate.name == sinkStats.name) {
+                    before = candidate;
+                    break;
+                }
+            }
+            if (sinkStats.written == before.written && sinkStats.dropped == before.dropped && sinkStats.failed == before.failed) {
+                continue;
+            }
+
+            Log(statsTypeId, LogLevel::LEVEL_SYSTEM, L"[sink %s] written %llu/s, dropped %llu, failed %llu, pending %llu",
+                sinkStats.name, perSecond(sinkStats.written, before.written), sinkStats.dropped - before.dropped,
+                sinkStats.failed - before.failed, static_cast<uint64_t>(sinkStats.pending));
+        }
+
+        Log(statsTypeId, LogLevel::LEVEL_SYSTEM, L"cycles: capture %llu, enqueue %llu, format %llu, render %llu, text %llu, binary %llu, console %llu, sinks %llu (1 in %u sampled)",
+            cycles[0], cycles[1], cycles[2], cycles[3], cycles[4], cycles[5], cycles[6], cycles[7], LOG_METRICS_SAMPLE_INTERVAL);
+
+        lastStatsSnapshot = std::move(current);
+    }
+
+    // 크래시 핸들러 (LogCrash::Install). 시그널 핸들러 안이므로 lock을 기다리거나 메모리를 할당하지 않는다.
+    static void OnCrash(int signal)
+    {
+        GetInstance().DumpForCrash(signal);
+    }
+
+    // 크래시 핸들러가 남은 로그를 모으는 동안 손대지 않도록 멈춘다. 프로세스는 곧 끝나므로 돌아오지 않는다.
+    static void ParkForCrash(std::atomic<bool>& parked)
+    {
+        parked.store(true);
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+
+    // 다른 스레드에서 난 크래시라면 thread가 다음 차례에 멈출 때까지 잠깐 기다린다.
+    // 멈췄다면 그 스레드가 들고 있던 배치는 비어있다. false라면 (크래시가 그 스레드에서 났거나 멈추지 않음) 배치도 함께 남긴다.
+    static bool WaitForParked(const std::thread& thread, const std::atomic<bool>& parked)
+    {
+        if (!thread.joinable() || thread.get_id() == std::this_thread::get_id()) {
+            return false;
+        }
+
+        const LogTimestamp deadline = LogClockNow() + static_cast<LogTimestamp>(std::chrono::duration_cast<std::chrono::nanoseconds>(CRASH_PARK_WAIT).count());
+        while (!parked.load()) {
+            if (LogClockNow() > deadline) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 아직 파일에 쓰지 못한 로그를 비상 파일에 남긴다. 오래된 것부터
+    // 파일 버퍼(완성된 줄) -> writer / collector가 기록하던 배치 -> collector가 정렬을 기다리던 로그 -> 링 버퍼 -> 큐 -> 등록된 메모리 순이다.
+    // 기록하던 배치의 일부는 파일 버퍼에도 있을 수 있으므로 같은 로그가 두 번 나올 수 있다. (인덱스로 구분)
+    // 스레드 로컬 모드의 링 버퍼와 정렬을 기다리던 로그는 collector가 인덱스를 붙이기 전이라 인덱스가 0이다.
+    // WRITER_MAPPED로 쓰던 줄은 이미 매핑된 파일에 들어가 있고, 바이너리 파일의 버퍼는 텍스트 줄과 같은 로그이므로 따로 남기지 않는다.
+    void DumpForCrash(int signal)
+    {
+        if (!emergencyFile.IsOpen()) {
+            return;
+        }
+
+        crashing.store(true);
+        const bool writerStopped = WaitForParked(writerThread, writerParked);
+        const bool collectorStopped = WaitForParked(collectorThread, collectorParked);
+
+        const LogTimestamp now = LogClockNow();
+        emergencyFile.BeginFile();
+
+        // 어떤 시그널로 끝났는지
+        char reason[64] = "fatal signal ";
+        const size_t prefixLength = std::char_traits<char>::length(reason);
+        const std::to_chars_result number = std::to_chars(reason + prefixLength, reason + sizeof(reason), signal);
+        emergencyFile.BeginSession(CRASH_TYPE_NAME, microTimestamp);
+        emergencyFile.WriteTextRecord(static_cast<uint8_t>(LogLevel::LEVEL_SYSTEM), 0, now, std::string_view(reason, static_cast<size_t>(number.ptr - reason)), false);
+
+        LogTypeId sessionType = INVALID_LOG_TYPE_ID;
+        for (size_t id = 0; id < typeRegistry.Count(); ++id) {
+            LogTypeSink* sink = typeRegistry.GetSink(static_cast<LogTypeId>(id));
+            std::string_view pending = sink->file.PendingTextForCrash();
+            if (!pending.empty()) {
+                emergencyFile.BeginSession(sink->name, microTimestamp);
+                emergencyFile.WriteTextRecord(static_cast<uint8_t>(LogLevel::LEVEL_SYSTEM), 0, now, pending, true);
+                sessionType = sink->id;
+            }
+        }
+
+        auto dumpRecord = [&](const LogRecord& record) { DumpRecordForCrash(record, sessionType); };
+        if (!writerStopped) {
+            std::for_each(writerBatch.begin(), writerBatch.end(), dumpRecord);
+        }
+        if (!collectorStopped) {
+            std::for_each(collectorBatch.begin(), collectorBatch.end(), dumpRecord);
+        }
+        if (threadLocalEnabled.load()) {
+            std::for_each(collectorStaging.begin(), collectorStaging.end(), dumpRecord);
+            for (auto& buffer : threadBuffers) {
+                buffer->ring.PeekUnsafe(dumpRecord);
+            }
+        }
+        if (asyncEnabled.load() && logQueue) {
+            logQueue->PeekUnsafe(dumpRecord);
+        }
+
+        if (const uint8_t* region = crashRegion.Data()) {
+            emergencyFile.BeginSession(CRASH_TYPE_NAME, microTimestamp);
+            emergencyFile.WriteHexDump(static_cast<uint8_t>(LogLevel::LEVEL_SYSTEM), now, crashRegion.Description(), region, crashRegion.Length());
+        }
+
+        emergencyFile.Sync();
+    }
+
+    // 크래시 때 남기는 로그 한 건. type이 sessionType과 다르면 SESSION 블록부터 쓴다.
+    void DumpRecordForCrash(const LogRecord& record, LogTypeId& sessionType)
+    {
+        LogTypeSink* sink = typeRegistry.GetSink(record.typeId);
+        if (sink == nullptr || (record.args.Empty() && record.text.empty() && record.hex.TotalBytes() == 0)) {
+            return;     // 옮겨진 뒤의 빈 로그
+        }
+
+        if (record.typeId != sessionType) {
+            emergencyFile.BeginSession(sink->name, microTimestamp);
+            sessionType = record.typeId;
+        }
+
+        const uint8_t level = static_cast<uint8_t>(record.level);
+        if (!record.args.Empty()) {
+            emergencyFile.WriteFormatRecord(level, record.index, record.timestamp, record.args.Format(), record.args.Data(), record.args.Size());
+        }
+        else if (record.hexDump) {
+            const LogHexBytes& hex = record.hex;
+            emergencyFile.WriteHexRecord(level, record.timestamp, record.text, hex.Head(), hex.HeadBytes(), hex.Tail(), hex.TailBytes(), hex.TotalBytes());
+        }
+        else {
+            emergencyFile.WriteTextRecord(level, record.index, record.timestamp, record.text, false);
+        }
+    }
+
+    // logDirectory/YYYYMM_type.txt (binary라면 .bin). type의 LogRotationPolicy::period에 따라 YYYYMMDD / YYYYMMDD_HH가 된다.
+    // timestamp가 속한 기간 기준이며, 스레드마다 type 별로 캐시해두고 기간이 바뀔 때만 다시 만든다.
+    // 크기 / 기록 수 한도로 나뉜 조각의 번호(.N)는 파일 객체가 붙인다. (LogSegmentTracker)
+    const std::wstring& GetLogFileName(const LogTypeSink& sink, LogTimestamp timestamp, bool binary = false) const
+    {
+        struct CachedFileName {
+            int64_t periodKey = -1;
+            uint32_t generation = 0;
+            std::wstring fileName;
+            std::wstring binaryFileName;
+        };
+        static thread_local LogTimestampCache timestampCache;
+        static thread_local std::vector<CachedFileName> cachedFileNames;
+
+        timestampCache.Format(LogTimestampSeconds(timestamp));
+
+        if (sink.id >= cachedFileNames.size()) {
+            cachedFileNames.resize(sink.id + 1);
+        }
+
+        CachedFileName& cached = cachedFileNames[sink.id];
+        const uint32_t generation = fileNameGeneration.load(std::memory_order_relaxed);
+        int64_t periodKey = timestampCache.MonthKey();
+        const wchar_t* periodText = timestampCache.Month();
+        if (sink.rotation.period == LogRotationPeriod::ROTATE_DAY) {
+            periodKey = timestampCache.DayKey();
+            periodText = timestampCache.Day();
+        }
+        else if (sink.rotation.period == LogRotationPeriod::ROTATE_HOUR) {
+            periodKey = timestampCache.HourKey();
+            periodText = timestampCache.Hour();
+        }
+
+        if (cached.periodKey != periodKey || cached.generation != generation) {
+            cached.periodKey = periodKey;
+            cached.generation = generation;
+            cached.fileName = logDirectory + L"/" + periodText + L"_" + sink.name + L".txt";
+            cached.binaryFileName = cached.fileName.substr(0, cached.fileName.size() - 4) + L".bin";
+        }
+        return binary ? cached.binaryFileName : cached.fileName;
+    }
+};
+
+// 이 레벨보다 낮은 LOG 호출은 컴파일되지 않는다. (포맷 문자열 검사는 그대로 일어남)
+// LOG의 level은 상수여야 하며, 실행 중에 정해지는 레벨은 SystemLogManager::Log를 직접 호출한다.
+// 레벨이 꺼져있다면 LOG의 인자는 평가되지 않는다.
+#ifndef SYSLOG_COMPILE_MIN_LEVEL
+#ifdef NDEBUG
+#define SYSLOG_COMPILE_MIN_LEVEL LogLevel::LEVEL_ERROR
+#else
+#define SYSLOG_COMPILE_MIN_LEVEL LogLevel::LEVEL_DEBUG
+#endif
+#endif
+
+// 매크로 정의
+#define SYSLOG_DIRECTORY(dir)  SystemLogManager::GetInstance().InitializeDirectory(dir)
+#define SYSLOG_LEVEL(level)  SystemLogManager::GetInstance().InitializeLevel(level)
+#define LOG(type, level, ...)  LOG_SITE(LogSitePolicy(), type, level, __VA_ARGS__)
+#define LOG_SAMPLED(every, type, level, ...)  LOG_SITE(LogSitePolicy::Sample(every), type, level, __VA_ARGS__)          // 스레드마다 every번에 한 번
+#define LOG_RATE_LIMITED(perSecond, type, level, ...)  LOG_SITE(LogSitePolicy::RateLimit(perSecond), type, level, __VA_ARGS__)  // 호출 위치 전체에서 1초에 perSecond번까지
+#define LOG_DEDUP(window, type, level, ...)  LOG_SITE(LogSitePolicy::Dedup(window), type, level, __VA_ARGS__)          // window 안에 이어지는 같은 메시지는 수만 셈
+// 호출 위치(__FILE__ / __LINE__)마다 static LogSite를 하나 두고, 거르는 기준은 인자를 평가하기 전에 확인한다.
+// 샘플링은 스레드마다의 카운터만 보며 해시를 찾지 않는다. 기준은 SystemLogManager::SetSitePolicy로 실행 중에도 바꿀 수 있다.
+#define LOG_SITE(policy, type, level, ...)  \
+    do { \
+        if constexpr ((level) >= SYSLOG_COMPILE_MIN_LEVEL) { \
+            if (SystemLogManager::GetInstance().IsLevelEnabled(level)) { \
+                static LogSite logSite_(__FILE__, __LINE__, policy); \
+                static thread_local uint32_t logSiteCalls_ = 0; \
+                if (logSite_.Admit(logSiteCalls_)) { \
+                    LogSiteScope logSiteScope_(logSite_); \
+                    SystemLogManager::GetInstance().Log(type, level, __VA_ARGS__); \
+                } \
+            } \
+        } \
+    } while (0)
+#define LOG_HEX(type, level, description, data, length)  LOG_HEX_SITE(LogSitePolicy(), type, level, description, data, length)
+// LOG_SITE와 같이 거른 뒤에 LogHex를 부른다. (릴리스 빌드에서 DEBUG 덤프는 인자도 평가하지 않는다)
+#define LOG_HEX_SITE(policy, type, level, description, data, length)  \
+    do { \
+        if constexpr ((level) >= SYSLOG_COMPILE_MIN_LEVEL) { \
+            if (SystemLogManager::GetInstance().IsLevelEnabled(level)) { \
+                static LogSite logSite_(__FILE__, __LINE__, policy); \
+                static thread_local uint32_t logSiteCalls_ = 0; \
+                if (logSite_.Admit(logSiteCalls_)) { \
+                    LogSiteScope logSiteScope_(logSite_); \
+                    SystemLogManager::GetInstance().LogHex(type, level, description, data, length); \
+                } \
+            } \
+        } \
+    } while (0)
+#define SYSLOG_ASYNC(queueDepth, policy)  SystemLogManager::GetInstance().InitializeAsync(queueDepth, policy)
+#define SYSLOG_THREAD_LOCAL(ringCapacity, policy)  SystemLogManager::GetInstance().InitializeThreadLocal(ringCapacity, policy)
+#define SYSLOG_FLUSH_POLICY(bytes, interval, level)  SystemLogManager::GetInstance().InitializeFlushPolicy(bytes, interval, level)
+#define SYSLOG_TIMESTAMP_MICROS(enable)  SystemLogManager::GetInstance().InitializeTimestamp(enable)
+#define SYSLOG_FILE_FORMAT(format)  SystemLogManager::GetInstance().InitializeFileFormat(format)
+#define SYSLOG_FILE_WRITER(writer)  SystemLogManager::GetInstance().InitializeFileWriter(writer)
+#define SYSLOG_ROTATION(policy)  SystemLogManager::GetInstance().InitializeRotation(policy)
+#define SYSLOG_TYPE_ROTATION(type, policy)  SystemLogManager::GetInstance().InitializeRotation(type, policy)
+#define SYSLOG_ARCHIVE(policy)  SystemLogManager::GetInstance().InitializeArchive(policy)
+#define SYSLOG_CONSOLE(policy)  SystemLogManager::GetInstance().InitializeConsole(policy)
+#define SYSLOG_STATS_LOG(interval)  SystemLogManager::GetInstance().InitializeStatsLog(interval)
+#define SYSLOG_CRASH_HANDLER(fileName)  SystemLogManager::GetInstance().InitializeCrashHandler(fileName)
+#define SYSLOG_ADD_SINK(sink, threading)  SystemLogManager::GetInstance().AddSink(sink, threading)
+#define SYSLOG_SINK_POOL(threads)  SystemLogManager::GetInstance().InitializeSinkPool(threads)
+#define SYSLOG_HEX_MAX_BYTES(maxBytes)  SystemLogManager::GetInstance().InitializeHexDump(maxBytes)
+#define SYSLOG_FILTER_FILE(fileName)  SystemLogManager::GetInstance().InitializeFilterFile(fileName)
+#define SYSLOG_CONTROL_SOCKET(port)  SystemLogManager::GetInstance().InitializeControlSocket(port)
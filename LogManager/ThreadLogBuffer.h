@@ -0,0 +1,114 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 생산자 하나(로그를 남기는 스레드), 소비자 하나(collector 스레드)만 접근하는 고정 크기 링 버퍼.
+// 두 스레드가 서로의 위치를 매번 읽지 않도록 상대방의 위치를 캐시해두고, 부족할 때만 다시 읽는다.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t requestedCapacity)
+    {
+        size_t capacity = 2;
+        while (capacity < requestedCapacity)
+            capacity <<= 1;
+
+        mask = capacity - 1;
+        slots.reset(new T[capacity]);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 생산자 스레드에서만 호출. 가득 찼다면 false를 반환하고 item은 건드리지 않는다.
+    bool TryPush(T&& item)
+    {
+        const size_t tail = writePos.load(std::memory_order_relaxed);
+        if (tail - cachedReadPos > mask) {
+            cachedReadPos = readPos.load(std::memory_order_acquire);
+            if (tail - cachedReadPos > mask) {
+                return false;
+            }
+        }
+
+        slots[tail & mask] = std::move(item);
+        writePos.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 소비자 스레드에서만 호출. 비어있다면 false
+    bool TryPop(T& out)
+    {
+        const size_t head = readPos.load(std::memory_order_relaxed);
+        if (head == cachedWritePos) {
+            cachedWritePos = writePos.load(std::memory_order_acquire);
+            if (head == cachedWritePos) {
+                return false;
+            }
+        }
+
+        out = std::move(slots[head & mask]);
+        readPos.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 크래시 핸들러 전용. 꺼내지 않고 남아있는 항목을 넣은 순서대로 visit에 넘긴다. 소비자가 멈춰있어야 정확하다.
+    template <typename Visitor>
+    void PeekUnsafe(Visitor&& visit) const
+    {
+        const size_t head = readPos.load(std::memory_order_acquire);
+        const size_t tail = writePos.load(std::memory_order_acquire);
+        for (size_t pos = head; pos != tail && pos - head <= mask; ++pos) {
+            visit(slots[pos & mask]);
+        }
+    }
+
+    bool Empty(void) const
+    {
+        return readPos.load(std::memory_order_acquire) == writePos.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::unique_ptr<T[]> slots;
+    size_t mask = 0;
+
+    // 생산자 전용
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> writePos{ 0 };
+    size_t cachedReadPos = 0;
+
+    // 소비자 전용
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> readPos{ 0 };
+    size_t cachedWritePos = 0;
+};
+
+// 전역 카운터에서 BLOCK_SIZE 개의 번호를 한 번에 받아와 스레드 안에서 나눠 쓴다.
+// 공유 카운터는 BLOCK_SIZE 번에 한 번만 건드리므로 코어가 많아도 캐시 라인 경쟁이 거의 없다.
+// 같은 스레드가 받은 번호는 항상 증가하지만, 스레드 사이의 번호 순서는 시간 순서와 다를 수 있다.
+class SequenceBlockAllocator {
+public:
+    static constexpr uint64_t BLOCK_SIZE = 1024;
+
+    // 각 스레드가 thread_local로 들고 있는 현재 블록
+    struct ThreadBlock {
+        uint64_t next = 0;
+        uint64_t end = 0;
+    };
+
+    uint64_t Next(ThreadBlock& block)
+    {
+        if (block.next == block.end) {
+            block.next = nextBlock.fetch_add(BLOCK_SIZE, std::memory_order_relaxed);
+            block.end = block.next + BLOCK_SIZE;
+        }
+        return block.next++;
+    }
+
+private:
+    std::atomic<uint64_t> nextBlock{ 1 };
+};
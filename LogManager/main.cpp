@@ -1,338 +1,396 @@
-#include <iostream>
+﻿#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <new>
 #include <string>
-#include <sstream>
-#include <ctime>
-#include <mutex>
-#include <iomanip>
-#include <cstdarg>
-#include <filesystem>
+#include <thread>
 #include <vector>
-#include <strsafe.h>
-
-#include <unordered_map>
-#include <Windows.h>
-#include <bitset>
-
-
-enum class LogLevel {
-    LEVEL_DEBUG,
-    LEVEL_ERROR,
-    LEVEL_SYSTEM
-};
-
 
+#include "GameLogManager.h"
+#include "LogBinaryDecode.h"
+#include "SystemLogManager.h"
 
+namespace {
+    // 전역 operator new를 바꿔서 할당 횟수와 바이트를 센다. (할당 점검의 측정 구간에서만 켬)
+    std::atomic<bool> countAllocations{ false };
+    std::atomic<uint64_t> allocationCount{ 0 };
+    std::atomic<uint64_t> allocationBytes{ 0 };
+}
 
-class SystemLogManager {
-public:
-    static SystemLogManager& GetInstance() {
-        static SystemLogManager instance;
-        return instance;
+void* operator new(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
     }
-    ~SystemLogManager(void) {
-
-        for (auto& iter : fileLockMap)
-        {
-            LeaveCriticalSection(&iter.second);
-        }
-
-        fileLockMap.clear();
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
     }
+    throw std::bad_alloc();
+}
 
-    void Initialize(const std::wstring& directory, LogLevel level) {
-        InitializeDirectory(directory);
-        InitializeLevel(level);
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// 크래시 점검. (--crash-drill)
+// 모드(동기 / 비동기 / 스레드 로컬)마다 자식 프로세스(--crash-child 모드)를 띄우고, 자식은 로그를 남기다가 SIGSEGV로 죽는다.
+// 자식이 남긴 로그 파일과 비상 파일(LogDecoder와 같이 복원)을 합쳐서 모든 로그가 빠짐없이 있는지, 헥스 덤프가 남았는지 확인한다.
+constexpr int CRASH_DRILL_RECORDS = 5000;
+constexpr char CRASH_DRILL_REGION[] = "crash drill region";
+
+int RunCrashChild(const char* mode)
+{
+    std::filesystem::create_directory(L"CrashDrill");
+    SYSLOG_DIRECTORY(L"CrashDrill");
+    SYSLOG_LEVEL(LogLevel::LEVEL_DEBUG);
+    SYSLOG_FLUSH_POLICY(4 * 1024 * 1024, std::chrono::milliseconds(60 * 1000), LogLevel::LEVEL_SYSTEM);    // 크래시 전에는 파일에 쓰지 않도록
+    LogConsolePolicy consolePolicy;
+    consolePolicy.enabled = false;
+    SYSLOG_CONSOLE(consolePolicy);
+    if (std::strcmp(mode, "async") == 0) {
+        SYSLOG_ASYNC(8192, QueueFullPolicy::POLICY_BLOCK);
     }
-
-    void InitializeDirectory(const std::wstring& directory)
-    {
-        logDirectory = directory;
-
-        // ڷ   ΰ ִ Ȯ
-        if (!std::filesystem::exists(logDirectory)) {
-            // ٸ ش θ 
-            std::filesystem::create_directory(logDirectory);
-        }
+    else if (std::strcmp(mode, "thread") == 0) {
+        SYSLOG_THREAD_LOCAL(8192, QueueFullPolicy::POLICY_BLOCK);
     }
-
-    void InitializeLevel(LogLevel level)
-    {
-        logLevel = level;
+    if (!SYSLOG_CRASH_HANDLER(L"CrashDrill/Emergency.bin")) {
+        return 1;
     }
 
+    static char region[64];
+    for (size_t i = 0; i < sizeof(region); ++i)
+        region[i] = static_cast<char>(i);
+    std::memcpy(region, CRASH_DRILL_REGION, sizeof(CRASH_DRILL_REGION));
+    SystemLogManager::GetInstance().SetCrashDumpRegion(CRASH_DRILL_REGION, region, sizeof(region));
 
-
-    void Log(const std::wstring& type, LogLevel level, const wchar_t* format, ...) 
-    {
-        if (level < logLevel) {
-            return;
-        }
-
-        // type(ϸ) key  CS ִ ȮѴ. 
-        auto iter = fileLockMap.find(type);
-
-        //  ٸ
-        if (iter == fileLockMap.end())
-        {
-            // CS ߰Ѵ.
-            CRITICAL_SECTION cs;
-            InitializeCriticalSection(&cs);
-
-            fileLockMap.emplace(type, cs);
-
-            iter = fileLockMap.find(type);
-        }
-
-        wchar_t logMessage[512];
-        va_list args;
-        va_start(args, format);
-
-        HRESULT result = StringCchVPrintf(logMessage, sizeof(logMessage) / sizeof(wchar_t), format, args);
-
-        va_end(args);
-
-        if (SUCCEEDED(result)) {
-            // ڿ  ˵Ǿϴ.
-            wprintf(L"Formatted String: %s\n", logMessage);
+    // 지연 포맷된 로그와 UTF-8 메시지를 번갈아 남긴다. (릴리스 빌드에서도 남도록 ERROR)
+    for (int i = 0; i < CRASH_DRILL_RECORDS; ++i) {
+        if (i % 2 == 0) {
+            LOG(L"Drill", LogLevel::LEVEL_ERROR, L"drill record %d", i);
         }
         else {
-            //  ó
-            wprintf(L"Formatting failed with error code: 0x%08X\n", result);
+            LOG("Drill", LogLevel::LEVEL_ERROR, std::string_view("drill record " + std::to_string(i)));
         }
+    }
 
-        auto now = std::time(nullptr);
-        std::tm localTime;
-        localtime_s(&localTime, &now);
-
-        INT64 index = InterlockedIncrement64(&logIndex);
-
-        std::wstringstream logLine;
-        logLine 
-            << L"[" << type << L"] [" << std::put_time(&localTime, L"%Y-%m-%d %H:%M:%S")
-            << L" / " << LogLevelToString(level)
-            << L" / " << std::setw(9) << std::setfill(L'0') << index
-            << L"] " << logMessage << L"\n";
-
-        // ֿܼ 
-        std::wcout << logLine.str();
-
-        // Ͽ 
-        std::wstring fileName = GetLogFileName(type);
-
-
-
-
-
-        EnterCriticalSection(&iter->second);
+    std::raise(SIGSEGV);
+    return 0;
+}
 
-        std::wofstream logFile(fileName, std::ios::app);
-        if (logFile.is_open()) {
-            logFile << logLine.str();
-            logFile.close();
+// text에서 "drill record N"을 모두 찾아 found[N]을 세운다. 새로 찾은 수를 반환한다.
+int MarkDrillRecords(std::string_view text, std::vector<bool>& found)
+{
+    constexpr std::string_view marker = "drill record ";
+
+    int count = 0;
+    for (size_t position = text.find(marker); position != std::string_view::npos; position = text.find(marker, position + 1)) {
+        int number = -1;
+        const char* begin = text.data() + position + marker.size();
+        std::from_chars(begin, text.data() + text.size(), number);
+        if (number >= 0 && number < static_cast<int>(found.size()) && !found[number]) {
+            found[number] = true;
+            count++;
         }
-
-        LeaveCriticalSection(&iter->second);
     }
+    return count;
+}
 
-    void LogHex(const std::wstring& type, LogLevel level, const std::wstring& description, const char* data, size_t length) {
-        if (level < logLevel) {
-            return;
-        }
-
-        auto now = std::time(nullptr);
-        std::tm localTime;
-        localtime_s(&localTime, &now);
-
-        std::wstringstream logLine;
-        logLine << L"[" << type << L"] [" << std::put_time(&localTime, L"%Y-%m-%d %H:%M:%S") << L" / " << LogLevelToString(level) << L" ] " << description << "\n";
-
-
-
+std::string ReadWholeFile(const std::filesystem::path& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
 
-        //for (size_t i = 0; i < length; ++i) {
-        //    if (i % 16 == 0) {
-        //        logLine << L"\n";
-        //    }
-        //    logLine << std::hex << std::setw(2) << std::setfill(L'0') << static_cast<int>(data[i]) << L" ";
-        //}
-        //logLine << L"\n";
- 
+int RunCrashDrill(const char* program)
+{
+    bool passed = true;
 
-        const size_t size = length * sizeof(char); //   ũ (Ʈ )
-        const size_t bytesPerLine = 16; //  ٿ  Ʈ 
+    for (const char* mode : { "sync", "async", "thread" }) {
+        std::error_code error;
+        std::filesystem::remove_all(L"CrashDrill", error);
 
-        for (size_t i = 0; i < size; i += bytesPerLine) {
-            // ּ 
-            logLine << std::setw(8) << std::setfill(L'0') << std::hex << i << L": ";
+        const std::string command = std::string("\"") + program + "\" --crash-child " + mode;
+        const int status = std::system(command.c_str());
 
-            // 16  
-            for (size_t j = 0; j < bytesPerLine; ++j) {
-                if (i + j < size)
-                    logLine << std::setw(2) << static_cast<int>(data[i + j]) << L" ";
-                else
-                    logLine << L"   ";
+        std::vector<bool> found(CRASH_DRILL_RECORDS, false);
+        int fromLogFiles = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(L"CrashDrill", error)) {
+            if (entry.path().extension() == L".txt") {
+                fromLogFiles += MarkDrillRecords(ReadWholeFile(entry.path()), found);
             }
-
-            // ASCII  (wchar_t  ũ  θ ó)
-            logLine << L" | ";
-            for (size_t j = 0; j < bytesPerLine; ++j) {
-                if (i + j < size) {
-                    unsigned char ch = data[i + j];
-                    logLine << (std::isprint(ch) ? static_cast<char>(ch) : '.');
-                }
-                else {
-                    logLine << " ";
-                }
-            }
-            logLine << std::endl;
         }
 
-
-
-
-
-        std::wcout << logLine.str(); // Console output
-
-        std::wstring fileName = GetLogFileName(type);
-        std::wofstream logFile(fileName, std::ios::app);
-        if (logFile.is_open()) {
-            logFile << logLine.str();
-            logFile.close();
+        // 비상 파일을 LogDecoder와 같이 텍스트로 되돌린다.
+        std::string recovered;
+        const std::string emergency = ReadWholeFile(L"CrashDrill/Emergency.bin");
+        if (std::FILE* decoded = std::tmpfile()) {
+            DecodeStats stats;
+            DecodeLogBinary(std::vector<uint8_t>(emergency.begin(), emergency.end()), DecodeFilter(), decoded, stats);
+            std::rewind(decoded);
+            char chunk[4096];
+            for (size_t read; (read = std::fread(chunk, 1, sizeof(chunk), decoded)) > 0;)
+                recovered.append(chunk, read);
+            std::fclose(decoded);
         }
+        const int fromEmergency = MarkDrillRecords(recovered, found);
+        const int missing = static_cast<int>(std::count(found.begin(), found.end(), false));
+        const bool hexDump = recovered.find(CRASH_DRILL_REGION) != std::string::npos && recovered.find("00000030: ") != std::string::npos;
+
+        const bool ok = status != 0 && missing == 0 && hexDump;
+        std::printf("crash drill (%s): %d records, %d from log files, %d from the emergency file, %d missing, hex dump %s -> %s\n",
+            mode, CRASH_DRILL_RECORDS, fromLogFiles, fromEmergency, missing, hexDump ? "found" : "missing", ok ? "OK" : "FAILED");
+        passed &= ok;
+    }
 
+    return passed ? 0 : 1;
+}
 
+// 할당 점검. (--alloc-check)
+// 데워진 뒤에는 로그를 남기는 경로(인자 저장, 큐 / 링 버퍼, writer / collector, 텍스트 / 바이너리 파일, 추가 출력 대상)에서
+// 힙 할당이 없어야 한다. 모드(동기 / 비동기 / 스레드 로컬)마다 같은 로그를 한 번 남겨서 데운 뒤,
+// 모든 스레드의 전역 operator new를 세면서 한 번 더 남긴다. 한 번이라도 할당했다면 실패
+// 풀은 가장 많이 쌓였을 때만큼 커지므로, ALLOC_CHECK_BATCH개마다 싱크가 모두 받을 때까지 기다려서 두 번의 깊이를 맞춘다.
+constexpr int ALLOC_CHECK_RECORDS = 10000;
+constexpr int ALLOC_CHECK_BATCH = 500;
 
+// 받은 로그 수를 세는 파일 싱크. 추가 출력 대상까지 다 나눠줬는지 기다리는 데 쓴다.
+class AllocCheckSink : public LogFileSink {
+public:
+    AllocCheckSink(std::wstring name, std::wstring fileName) : LogFileSink(std::move(name), std::move(fileName)) {}
 
+    uint64_t Received(void) const { return received.load(std::memory_order_relaxed); }
 
-
-
-
-
-        
-
-        //std::wcout << wss.str();
-
-        //return wss.str();
-
-
-
-
-
-
-
-
-
-
-
-
+protected:
+    void Write(const LogSinkRecordPtr& record) override
+    {
+        LogFileSink::Write(record);
+        received.fetch_add(1, std::memory_order_relaxed);
     }
 
 private:
-    std::wstring logDirectory;  // αװ ġ 
-    LogLevel logLevel;          // α 
-    INT64 logIndex = 0;        // α׸    1 ϴ . ̷μ  αװ    .
-    std::unordered_map<std::wstring, CRITICAL_SECTION> fileLockMap;
-
-
-
-
-
-    SystemLogManager() : logLevel(LogLevel::LEVEL_DEBUG) {}
-
-    std::wstring GetLogFileName(const std::wstring& type) {
-        auto now = std::time(nullptr);
-        std::tm localTime;
-        localtime_s(&localTime, &now);
-
-        std::wstringstream fileName;
-        fileName << logDirectory << L"/" << std::put_time(&localTime, L"%Y%m") << L"_" << type << L".txt";
-        //  ϰ ְ ʹٸ std::put_time(localTime, L"%Y%m%d") Ѵ. 
-        //  ð (localTime) "YYYYMMDD"  
-        //  , 2024 12 1̶ "20241201" µȴ.
+    std::atomic<uint64_t> received{ 0 };
+};
 
-        return fileName.str();
+// 점검할 로그를 ALLOC_CHECK_BATCH개 남긴다. (릴리스 빌드에서도 남도록 ERROR)
+void LogAllocCheckRecords(int round)
+{
+    static char packet[64];
+    for (size_t i = 0; i < sizeof(packet); ++i)
+        packet[i] = static_cast<char>(i * 7);
+
+    for (int i = 0; i < ALLOC_CHECK_BATCH; ++i) {
+        switch (i % 4) {
+        case 0:
+            LOG(L"AllocCheck", LogLevel::LEVEL_ERROR, L"player %d moved to (%d, %d) in %s", round, i, i * 3, L"Field");
+            break;
+        case 1:
+            LOG(L"AllocCheck", LogLevel::LEVEL_ERROR, L"%hs %.2f %lld", "한글", i * 0.5, static_cast<long long>(i));
+            break;
+        case 2:
+            LOG("AllocCheckUtf8", LogLevel::LEVEL_ERROR, std::string_view("UTF-8 메시지는 변환 없이 그대로 기록된다."));
+            break;
+        default:
+            LOG_HEX(L"AllocCheckHex", LogLevel::LEVEL_ERROR, L"packet", packet, sizeof(packet));
+            break;
+        }
     }
+}
 
-    std::wstring LogLevelToString(LogLevel level) const {
-        switch (level) {
-        case LogLevel::LEVEL_DEBUG: return L"DEBUG";
-        case LogLevel::LEVEL_ERROR: return L"ERROR";
-        case LogLevel::LEVEL_SYSTEM: return L"SYSTEM";
-        default: return L"UNKNOWN";
+int RunAllocCheck(void)
+{
+    std::error_code error;
+    std::filesystem::remove_all(L"AllocCheck", error);
+    std::filesystem::create_directory(L"AllocCheck");
+
+    SystemLogManager& manager = SystemLogManager::GetInstance();
+    SYSLOG_DIRECTORY(L"AllocCheck");
+    SYSLOG_LEVEL(LogLevel::LEVEL_DEBUG);
+    SYSLOG_FLUSH_POLICY(64 * 1024, std::chrono::milliseconds(1000), LogLevel::LEVEL_SYSTEM);
+    SYSLOG_FILE_FORMAT(LogFileFormat::FORMAT_TEXT_AND_BINARY);
+    SYSLOG_HEX_MAX_BYTES(32);       // 64바이트 패킷의 가운데를 잘라서 "... N bytes omitted ..." 줄을 만드는 경로도 잰다.
+    LogConsolePolicy consolePolicy;
+    consolePolicy.enabled = false;
+    SYSLOG_CONSOLE(consolePolicy);
+
+    auto pooled = std::make_shared<AllocCheckSink>(L"AllocCheckPool", L"AllocCheck/Pool.txt");
+    auto dedicated = std::make_shared<AllocCheckSink>(L"AllocCheckDedicated", L"AllocCheck/Dedicated.txt");
+    SYSLOG_ADD_SINK(pooled, LogSinkThreading::THREAD_POOL);
+    SYSLOG_ADD_SINK(dedicated, LogSinkThreading::THREAD_DEDICATED);
+
+    bool passed = true;
+    int round = 0;
+    for (const char* mode : { "sync", "async", "thread" }) {
+        manager.ShutdownAsync();
+        manager.ShutdownThreadLocal();
+        if (std::strcmp(mode, "async") == 0) {
+            SYSLOG_ASYNC(8192, QueueFullPolicy::POLICY_BLOCK);
+        }
+        else if (std::strcmp(mode, "thread") == 0) {
+            SYSLOG_THREAD_LOCAL(8192, QueueFullPolicy::POLICY_BLOCK);
         }
-    }
-};
 
+        // 배치마다 싱크가 다 받을 때까지 기다린다. (writer / collector와 싱크 스레드의 할당도 측정 구간에 들어가도록)
+        auto logRound = [&] {
+            for (int batch = 0; batch < ALLOC_CHECK_RECORDS / ALLOC_CHECK_BATCH; ++batch) {
+                const uint64_t target = pooled->Received() + ALLOC_CHECK_BATCH;
+                LogAllocCheckRecords(round);
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+                while ((pooled->Received() < target || dedicated->Received() < target) && std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                if (pooled->Received() < target || dedicated->Received() < target) {
+                    return false;
+                }
+            }
+            round++;
+            return true;
+        };
+
+        bool delivered = logRound();
+        // maintenance 스레드(시간 기준 플러시, 싱크 정리)도 데워지도록 한 번 이상 돌 때까지 기다린다.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        allocationCount = 0;
+        allocationBytes = 0;
+        countAllocations = true;
+        delivered &= logRound();
+        countAllocations = false;
+
+        const bool ok = delivered && allocationCount.load() == 0;
+        std::printf("alloc check (%s): %d records, %llu allocations (%llu bytes)%s -> %s\n", mode, ALLOC_CHECK_RECORDS,
+            static_cast<unsigned long long>(allocationCount.load()), static_cast<unsigned long long>(allocationBytes.load()),
+            delivered ? "" : ", sinks did not receive every record", ok ? "OK" : "FAILED");
+        passed &= ok;
+    }
 
-struct GameLog {
-    std::string server;     //  ̸
-    std::string type;       // .  code ȣ   ġ   ٸ ൿ   ִ. BATTLE, CASH_SHOP... 
-    std::string code;       // ൿ,    ȹ  [ ͸ Ƽ  ȹ ], [   ȾƼ  ȹ ], [   ŷ   ȹ ] 
-    uint64_t accountNo;     //  ȣ,     .
-    int32_t param1;         // ൿ  ߰  1 ~ 4, ʿҽ  ߰ϴµ  4 .     ̸ ߰
-    int32_t param2;
-    int32_t param3;
-    int32_t param4;
-    std::string paramStr;   // Ư ġ Ÿ   ڿ ǥ
-
-    GameLog(const std::string& server, const std::string& type, const std::string& code,
-        uint64_t accountNo, int32_t param1, int32_t param2, int32_t param3, int32_t param4,
-        const std::string& paramStr)
-        : server(server), type(type), code(code), accountNo(accountNo), param1(param1),
-        param2(param2), param3(param3), param4(param4), paramStr(paramStr) {}
-};
+    return passed ? 0 : 1;
+}
 
-class GameLogManager {
-public:
-    /*
-        Code :  Ƽ  ȹ / Param1 :   / Param2: 1000 ȹ /  Param3:  231000 
-
-	    ÿ    ؼ  Ͽ,  ,  Ǿ ־  Ͽ
-	    α׸     ߴ,  , ó   Ȯ  ־ Ѵ.
-    */
-    static void SaveToDatabase(const GameLog& log) {
-        // DB     ȯ濡 ° ۼ
-        std::cout << "GameLog Saved: " << log.server << ", " << log.type << ", " << log.code
-            << ", AccountNo: " << log.accountNo << ", Params: (" << log.param1 << ", "
-            << log.param2 << ", " << log.param3 << ", " << log.param4 << "), Str: "
-            << log.paramStr << "\n";
+// 포맷 점검. (--format-check)
+// 지연 포맷된 로그를 메모리 싱크로 받아서 기대한 UTF-8 메시지와 비교한다.
+// char 문자열(%s / %hs / std::string)은 UTF-8로 보므로 한글 같은 문자도 바이트 그대로 남아야 한다.
+int RunFormatCheck(void)
+{
+    std::filesystem::create_directory(L"FormatCheck");
+    SYSLOG_DIRECTORY(L"FormatCheck");
+    SYSLOG_LEVEL(LogLevel::LEVEL_DEBUG);
+    LogConsolePolicy consolePolicy;
+    consolePolicy.enabled = false;
+    SYSLOG_CONSOLE(consolePolicy);
+
+    auto sink = std::make_shared<LogMemorySink>(L"FormatCheck", 64, LogSinkFilter(), LogSinkFormat::FORMAT_MESSAGE);
+    SYSLOG_ADD_SINK(sink, LogSinkThreading::THREAD_INLINE);
+
+    const std::string korean = "한글";
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"%s", "한글");
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"[%hs] [%S]", "한글", "naïve");
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"[%s] [%s]", korean, std::string_view("日本語"));
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"[%4s] [%-4s] [%.1s]", "한글", "é", "한글");
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"[%s] [%s]", L"한글", "😀");
+    LOG(L"FormatCheck", LogLevel::LEVEL_ERROR, L"[%s]", "ab\xFF" "cd");
+
+    const char* expected[] = {
+        "한글",
+        "[한글] [naïve]",
+        "[한글] [日本語]",
+        "[  한글] [é   ] [한]",
+        "[한글] [😀]",
+        "[ab\xEF\xBF\xBD" "cd]",         // 잘못된 바이트는 U+FFFD
+    };
+
+    const std::vector<std::string> lines = sink->Lines();
+    bool passed = lines.size() == std::size(expected);
+    for (size_t i = 0; i < std::size(expected); ++i) {
+        const std::string actual = i < lines.size() ? lines[i] : std::string();
+        const bool ok = actual == expected[i];
+        std::printf("format check %zu: %s -> %s\n", i, actual.c_str(), ok ? "OK" : "FAILED");
+        passed &= ok;
     }
-};
-
-// ũ 
-#define SYSLOG_DIRECTORY(dir)  SystemLogManager::GetInstance().InitializeDirectory(dir)
-#define SYSLOG_LEVEL(level)  SystemLogManager::GetInstance().InitializeLevel(level)
-#define LOG(type, level, format)  SystemLogManager::GetInstance().Log(type, level, format)
-#define LOG_HEX(type, level, format)  SystemLogManager::GetInstance().LogHex(type, level, format,)
+    return passed ? 0 : 1;
+}
 
+// 헥스 덤프 점검. (--hex-check, HexDumpCheck.cpp)
+int RunHexCheck(void);
 
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::strcmp(argv[1], "--crash-drill") == 0) {
+        return RunCrashDrill(argv[0]);
+    }
+    if (argc >= 3 && std::strcmp(argv[1], "--crash-child") == 0) {
+        return RunCrashChild(argv[2]);
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--alloc-check") == 0) {
+        return RunAllocCheck();
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--hex-check") == 0) {
+        return RunHexCheck();
+    }
+    if (argc >= 2 && std::strcmp(argv[1], "--format-check") == 0) {
+        return RunFormatCheck();
+    }
 
-int main() {
-    // ý α ʱȭ
+    // 시스템 로그 초기화
     //SystemLogManager::GetInstance().Initialize(L"Logs", LogLevel::LEVEL_DEBUG);
-    SYSLOG_DIRECTORY(L"Logs");              // α׸    
-    SYSLOG_LEVEL(LogLevel::LEVEL_DEBUG);    // α  
-
-    // ý α 
+    SYSLOG_DIRECTORY(L"Logs");              // 로그를 저장 할 폴더 지정
+    SYSLOG_LEVEL(LogLevel::LEVEL_DEBUG);    // 로그 레벨 지정
+    SYSLOG_ASYNC(8192, QueueFullPolicy::POLICY_BLOCK);  // 비동기 모드 (파일 기록은 writer 스레드가 담당)
+    SYSLOG_FLUSH_POLICY(64 * 1024, std::chrono::milliseconds(1000), LogLevel::LEVEL_ERROR);    // 64KB / 1초 / ERROR 이상이면 파일에 기록
+    SYSLOG_FILE_FORMAT(LogFileFormat::FORMAT_TEXT_AND_BINARY);    // 텍스트와 함께 바이너리(.bin, LogDecoder로 복원)도 남김
+
+    LogRotationPolicy rotation;
+    rotation.maxBytes = 256 * 1024 * 1024;
+    SYSLOG_ROTATION(rotation);              // 월 단위 + 256MB마다 다음 파일로 (YYYYMM_type.1.txt ...)
+
+    LogArchivePolicy archivePolicy;
+    archivePolicy.maxTotalBytes = 10ull * 1024 * 1024 * 1024;
+    SYSLOG_ARCHIVE(archivePolicy);          // 다 쓴 파일은 LZ4로 압축(.lz4), 로그 폴더가 10GB를 넘으면 오래된 파일부터 삭제
+
+    LogConsolePolicy consolePolicy;
+    consolePolicy.maxLinesPerSecond = 100;
+    SYSLOG_CONSOLE(consolePolicy);          // 콘솔은 자신의 스레드에서 출력, type마다 1초에 100줄까지 (릴리스 빌드에서는 기본으로 꺼짐)
+    SYSLOG_STATS_LOG(std::chrono::seconds(60));    // 1분마다 로거 자신의 통계(초당 기록 수, lock 대기, 구간 별 사이클 등)를 LoggerStats type으로 남김
+    SYSLOG_FILTER_FILE(L"LogFilter.cfg");   // type 별 레벨 규칙 ("* = ERROR", "Memory = DEBUG" 등). 실행 중에 고치면 1초 안에 다시 읽음
+    SYSLOG_CRASH_HANDLER(L"Logs/Emergency.bin");   // 크래시 때 아직 쓰지 못한 로그를 남김 (LogDecoder로 복원, 정상 종료하면 지워짐)
+
+    LogSinkFilter errorFilter;
+    errorFilter.levels = LogLevelsFrom(LogLevel::LEVEL_ERROR);
+    SYSLOG_ADD_SINK(std::make_shared<LogFileSink>(L"AllErrors", L"Logs/AllErrors.txt", errorFilter), LogSinkThreading::THREAD_POOL);    // 모든 type의 ERROR 이상을 한 파일에도
+    SYSLOG_ADD_SINK(std::make_shared<LogSyslogSink>(L"Syslog", LogSyslogSink::DEFAULT_PORT, "LogManager", errorFilter), LogSinkThreading::THREAD_DEDICATED);    // 같은 머신의 syslog로 (UDP 514)
+
+    // 시스템 로그 출력
     LOG(L"System", LogLevel::LEVEL_DEBUG, L"System initialized.");
     LOG(L"System", LogLevel::LEVEL_ERROR, L"Hello, %s! Your score is %d.", L"Player1", 100);
+    LOG(u8"System", LogLevel::LEVEL_DEBUG, u8"UTF-8 메시지는 변환 없이 그대로 기록된다.");
 
     //SystemLogManager::GetInstance().Log(L"System", LogLevel::LEVEL_DEBUG, L"System initialized.");
     //SystemLogManager::GetInstance().Log(L"System", LogLevel::LEVEL_ERROR, L"An error occurred.");
     //SystemLogManager::GetInstance().Log(L"System", LogLevel::LEVEL_ERROR, L"Hello, %s! Your score is %d.", L"Player1", 100);
 
-    // ̳ʸ α 
+    // 바이너리 로그 출력
     char sampleData[16] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
                               0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10 };
 
 
-    std::wstring data = L"Hello,  !";
-    SystemLogManager::GetInstance().LogHex(L"Memory", LogLevel::LEVEL_DEBUG, L"Sample binary data", sampleData, sizeof(sampleData));
+    std::wstring data = L"Hello, 헥스 덤프!";
+    LOG_HEX(L"Memory", LogLevel::LEVEL_DEBUG, L"Sample binary data", sampleData, sizeof(sampleData));
+
+    // 게임 로그 저장 (파일 sink로 배치 기록. 보내지 못한 로그는 Logs/GameLogJournal.bin에 모아둔다)
+    GameLogPipelineConfig gameLogConfig;
+    gameLogConfig.journalFileName = L"Logs/GameLogJournal.bin";
+    GameLogManager::Start(std::make_unique<GameLogFileSink>(L"Logs/GameLog.tsv"), gameLogConfig);
 
-    //  α 
     GameLog log("Server1", "Battle", "MonsterKilled", 123456, 1001, 2000, 500, 2500, "MonsterType: Dragon");
     GameLogManager::SaveToDatabase(log);
 
+    GameLogManager::Stop();
+
     return 0;
 }
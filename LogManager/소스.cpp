@@ -9,39 +9,22 @@
 #include <io.h>
 #include <fcntl.h>
 
-// 헥스 덤프 함수
-void HexDump(const std::wstring& data) {
-    const wchar_t* byteData = data.c_str();
-    const size_t size = data.size() * sizeof(wchar_t); // 총 데이터 크기 (바이트 단위)
-    const size_t bytesPerLine = 16; // 한 줄에 출력할 바이트 수
+#include <chrono>
+#include <random>
+#include <cstring>
 
-    const unsigned char* bytePtr = reinterpret_cast<const unsigned char*>(byteData);
+#include "HexDump.h"
+#include "HexDumpParser.h"
 
-    for (size_t i = 0; i < size; i += bytesPerLine) {
-        // 주소 출력
-        std::cout << std::setw(8) << std::setfill('0') << std::hex << i << ": ";
+// 헥스 덤프 함수 (형식과 변환은 HexDump.h에서 LogHex와 함께 쓴다)
+void HexDump(const std::wstring& data) {
+    const size_t size = data.size() * sizeof(wchar_t); // 총 데이터 크기 (바이트 단위)
 
-        // 16진수 데이터 출력
-        for (size_t j = 0; j < bytesPerLine; ++j) {
-            if (i + j < size)
-                std::cout << std::setw(2) << static_cast<int>(bytePtr[i + j]) << " ";
-            else
-                std::cout << "   ";
-        }
+    std::wstring dump;
+    AppendHexDump(dump, data.data(), size);
 
-        // ASCII 출력 (wchar_t는 범위가 크기 때문에 제한적으로만 처리)
-        std::cout << " | ";
-        for (size_t j = 0; j < bytesPerLine; ++j) {
-            if (i + j < size) {
-                unsigned char ch = bytePtr[i + j];
-                std::cout << (std::isprint(ch) ? static_cast<char>(ch) : '.');
-            }
-            else {
-                std::cout << " ";
-            }
-        }
-        std::cout << std::endl;
-    }
+    // 콘솔이 _O_U16TEXT 모드이므로 wcout으로 출력
+    std::wcout << dump << std::flush;
 }
 
 // 헥스 스트링을 wstring으로 변환하는 함수
@@ -85,27 +68,99 @@ std::vector<std::string> ExtractHexFromHexDump(const std::string& hexDump) {
     return hexValues;
 }
 
-int main() {
+// 헥스 덤프 텍스트에서 바이트를 복원 (HexDumpParser.h). 블록이 여러 개라면 이어 붙인다.
+std::vector<unsigned char> ExtractBytesFromHexDump(const std::string& hexDump) {
+    std::vector<unsigned char> bytes;
+
+    HexDumpParser parser([&bytes](const HexDumpBlock& block) {
+        bytes.insert(bytes.end(), block.data, block.data + block.size);
+    });
+    parser.Feed(hexDump.data(), hexDump.size());
+    parser.Finish();
+
+    return bytes;
+}
+
+// LogHex 형식의 로그 텍스트를 megabytes 만큼 만들어서 기존 방식(ExtractHexFromHexDump + HexToWString)과
+// HexDumpParser의 처리량을 비교한다.
+void RunParserBenchmark(size_t megabytes) {
+    std::mt19937 random(12345);
+    std::string logText;
+    size_t expectedBytes = 0;
+    size_t expectedBlocks = 0;
+
+    while (logText.size() < megabytes * 1024 * 1024) {
+        std::vector<unsigned char> packet(64 + random() % 4032);
+        for (auto& byte : packet)
+            byte = static_cast<unsigned char>(random());
+
+        logText += "[Packet] [2024-12-01 12:00:00 / DEBUG ] packet ";
+        logText += std::to_string(expectedBlocks);
+        logText += "\n";
+        AppendHexDump(logText, packet.data(), packet.size());
+
+        expectedBytes += packet.size();
+        expectedBlocks++;
+    }
+
+    const double textMegabytes = static_cast<double>(logText.size()) / (1024.0 * 1024.0);
+
+    // 기존 방식은 마지막 줄의 ASCII 칸까지 헥스로 읽으면서 오류를 출력하므로, 측정하는 동안 cerr를 막아둔다.
+    std::cerr.setstate(std::ios::failbit);
+    auto start = std::chrono::steady_clock::now();
+    std::wstring legacy = HexToWString(ExtractHexFromHexDump(logText));
+    auto legacyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr.clear();
+
+    size_t parsedBytes = 0;
+    size_t parsedBlocks = 0;
+    size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    {
+        HexDumpParser parser([&](const HexDumpBlock& block) {
+            parsedBytes += block.size;
+            parsedBlocks++;
+            mismatches += block.asciiMismatches;
+        });
+
+        // 파일에서 읽는 것처럼 1MB씩 나눠서 넘긴다.
+        constexpr size_t CHUNK_SIZE = 1 << 20;
+        for (size_t offset = 0; offset < logText.size(); offset += CHUNK_SIZE)
+            parser.Feed(logText.data() + offset, std::min(CHUNK_SIZE, logText.size() - offset));
+        parser.Finish();
+    }
+    auto parserTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::wcout << L"input           : " << textMegabytes << L" MB, " << expectedBlocks << L" blocks, " << expectedBytes << L" bytes\n";
+    std::wcout << L"legacy          : " << legacyTime << L" s, " << textMegabytes / legacyTime << L" MB/s (" << legacy.size() * sizeof(wchar_t) << L" bytes)\n";
+    std::wcout << L"HexDumpParser   : " << parserTime << L" s, " << textMegabytes / parserTime << L" MB/s (" << parsedBytes << L" bytes, "
+        << parsedBlocks << L" blocks, " << mismatches << L" ascii mismatches)\n";
+}
+
+int main(int argc, char* argv[]) {
     // 콘솔 출력 모드를 유니코드로 설정
     _setmode(_fileno(stdout), _O_U16TEXT);
 
+    // 소스.exe --bench [MB] : 덤프 파서 처리량 비교
+    if (argc >= 2 && std::strcmp(argv[1], "--bench") == 0) {
+        RunParserBenchmark(argc >= 3 ? std::strtoul(argv[2], nullptr, 10) : 16);
+        return 0;
+    }
+
     std::wstring data = L"Hello, 헥스 덤프!";
 
     // 헥스 덤프 출력
     HexDump(data);
 
-    //// 헥스 덤프를 텍스트로 가져옴
-    //std::string hexDump = hexDumpStream.str();
-
-    //// 헥스 값 추출
-    //std::vector<std::string> hexValues = ExtractHexFromHexDump(hexDump);
+    // 헥스 덤프를 텍스트로 만든 뒤 다시 바이트로 되돌려서 비교
+    std::string hexDump;
+    AppendHexDump(hexDump, data.data(), data.size() * sizeof(wchar_t));
 
-    //// 헥스를 다시 wstring으로 변환
-    //std::wstring restoredData = HexToWString(hexValues);
+    std::vector<unsigned char> bytes = ExtractBytesFromHexDump(hexDump);
+    std::wstring restoredData(reinterpret_cast<const wchar_t*>(bytes.data()), bytes.size() / sizeof(wchar_t));
 
-    //std::wcout << L"Original Data: " << data << std::endl;
-    //std::wcout << L"Restored Data: " << restoredData << std::endl;
+    std::wcout << L"Original Data: " << data << std::endl;
+    std::wcout << L"Restored Data: " << restoredData << std::endl;
 
     return 0;
 }
-